@@ -1,6 +1,7 @@
 #include "application.h"
 #include "offscreenrender.h"
 #include "rendervolume.h"
+#include "renderthread.h"
 #include "logmanager.h"
 #include "filesystem.h"
 #include "gpucapabilities.h"
@@ -11,6 +12,8 @@
 #include "volume.h"
 #include "transfunc1d.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 namespace mivt {
@@ -23,6 +26,10 @@ namespace mivt {
     , volume_(0)
     , transfunc_(0)
     , render_(0)
+    , renderThread_(0)
+    , frameInterval_(16.f)
+    , frameCallback_(0)
+    , numLoaderThreads_(0)
   {
     Initialize(useOffScreenRender);
   }
@@ -79,6 +86,8 @@ namespace mivt {
     ShdrMgr.addPath(tgt::FileSystem::cleanupPath(getBasePath("mivt/glsl")));
     ShdrMgr.addPath(tgt::FileSystem::cleanupPath(getBasePath("mivt/glsl/base")));
     ShdrMgr.addPath(tgt::FileSystem::cleanupPath(getBasePath("mivt/glsl/modules")));
+    // linked programs are restored from their binaries instead of compiling them on every start
+    ShdrMgr.setProgramCacheDir(getUserDataPath("shadercache"));
 
     render_ = new RenderVolume();
     render_->Initialize();
@@ -88,6 +97,9 @@ namespace mivt {
 
   void Application::Deinitialize()
   {
+    // the context is needed on this thread again
+    SetRenderThread(false);
+
     render_->Deinitialize();
     DELPTR(render_);
 
@@ -105,12 +117,111 @@ namespace mivt {
 
   void Application::GetPixels(unsigned char* buffer, int length, bool downsampling)
   {
+    if (renderThread_) {
+      // while downsampling the latest frame is returned meanwhile, the final one of an interaction is waited for
+      size_t request = renderThread_->RequestFrame(length, downsampling);
+      if (!downsampling)
+        renderThread_->WaitForFrame(request);
+      renderThread_->GetLatestFrame(buffer, length);
+      return;
+    }
+
     render_->GetPixels(buffer, length, downsampling);
   }
 
+  void Application::RequestPixels(int length, bool downsampling)
+  {
+    if (renderThread_) {
+      renderThread_->RequestFrame(length, downsampling);
+      return;
+    }
+
+    latestPixels_.resize(std::max(length, 0));
+    if (!latestPixels_.empty())
+      render_->GetPixels(&latestPixels_[0], length, downsampling);
+    if (frameCallback_)
+      frameCallback_();
+  }
+
+  bool Application::GetLatestPixels(unsigned char* buffer, int length)
+  {
+    if (renderThread_)
+      return renderThread_->GetLatestFrame(buffer, length);
+
+    if (latestPixels_.empty() || latestPixels_.size() != static_cast<size_t>(length))
+      return false;
+    memcpy(buffer, &latestPixels_[0], length);
+    return true;
+  }
+
   void Application::Resize(int width, int height) 
   {
-    render_->Resize(glm::ivec2(width, height));
+    post([=]() { render_->Resize(glm::ivec2(width, height)); });
+  }
+
+  void Application::SetRenderThread(bool enable)
+  {
+    if (enable == (renderThread_ != 0))
+      return;
+
+    if (enable) {
+      if (!offscreen_) {
+        LWARNING("A render thread requires the off-screen context");
+        return;
+      }
+
+      offscreen_->MakeUncurrent();
+      renderThread_ = new RenderThread(offscreen_, [this](unsigned char* buffer, size_t length, bool downsampling) {
+        render_->GetPixels(buffer, static_cast<int>(length), downsampling);
+      });
+      renderThread_->SetFrameInterval(frameInterval_);
+      renderThread_->SetFrameCallback(frameCallback_);
+    }
+    else {
+      // stops the thread after the pending commands
+      DELPTR(renderThread_);
+      offscreen_->MakeCurrent();
+    }
+  }
+
+  bool Application::GetRenderThread()
+  {
+    return renderThread_ != 0;
+  }
+
+  void Application::SetFrameInterval(float ms)
+  {
+    frameInterval_ = ms;
+    if (renderThread_)
+      renderThread_->SetFrameInterval(ms);
+  }
+
+  float Application::GetFrameInterval()
+  {
+    return frameInterval_;
+  }
+
+  void Application::SetFrameCallback(FrameCallback callback)
+  {
+    frameCallback_ = callback;
+    if (renderThread_)
+      renderThread_->SetFrameCallback(callback);
+  }
+
+  void Application::post(const std::function<void()>& command)
+  {
+    if (renderThread_)
+      renderThread_->Post(command);
+    else
+      command();
+  }
+
+  void Application::invoke(const std::function<void()>& command)
+  {
+    if (renderThread_)
+      renderThread_->Invoke(command);
+    else
+      command();
   }
 
   std::string Application::getBasePath(const std::string& filename) const {
@@ -160,17 +271,17 @@ namespace mivt {
 
   void Application::Rotate(int newPosX, int newPosY, int lastPosX, int lastPosY)
   {
-    render_->Rotate(glm::ivec2(newPosX, newPosY), glm::ivec2(lastPosX, lastPosY));
+    post([=]() { render_->Rotate(glm::ivec2(newPosX, newPosY), glm::ivec2(lastPosX, lastPosY)); });
   }
 
   void Application::Zoom(int newPosX, int newPosY, int lastPosX, int lastPosY)
   {
-    render_->Zoom(glm::ivec2(newPosX, newPosY), glm::ivec2(lastPosX, lastPosY));
+    post([=]() { render_->Zoom(glm::ivec2(newPosX, newPosY), glm::ivec2(lastPosX, lastPosY)); });
   }
 
   void Application::Pan(int newPosX, int newPosY, int lastPosX, int lastPosY)
   {
-    render_->Pan(glm::ivec2(newPosX, newPosY), glm::ivec2(lastPosX, lastPosY));
+    post([=]() { render_->Pan(glm::ivec2(newPosX, newPosY), glm::ivec2(lastPosX, lastPosY)); });
   }
 
   void Application::LoadVolume(const std::string &fileName,
@@ -182,6 +293,7 @@ namespace mivt {
     float windowWidth,
     float windowCenter)
   {
+    tgt::Volume* volume = 0;
     try {
       tgt::RawVolumeReader reader;
       reader.setReadHints(glm::ivec3(dimension[0], dimension[1], dimension[2]),
@@ -191,11 +303,10 @@ namespace mivt {
         slope,
         windowCenter,
         windowWidth);
-      DELPTR(volume_);
-      volume_ = reader.read(fileName);
-      if (volume_) {
-        tgt::oldVolumePosition(volume_);
-      }
+      reader.setMemoryMapping(true);
+      // volumes beyond the cache budget are read brick by brick and rendered on the CPU
+      reader.setBrickCache(true);
+      volume = reader.read(fileName);
     }
     catch (const tgt::FileException& e) {
       LERROR(e.what());
@@ -204,22 +315,20 @@ namespace mivt {
       LERROR("bad allocation while reading file: " << fileName);
     }
 
-    if (volume_) {
-      render_->SetVolume(volume_);
-    }
+    setVolume(volume);
   }
 
   void Application::LoadVolume(const std::string &fileName, tgt::ProgressCallback callback)
   {
     std::string dictFileName = getResourcePath("dicom") + "/dicts/StandardDictionary.xml";
 
+    tgt::Volume* volume = 0;
     try {
-      DELPTR(volume_);
       tgt::ProgressBar progressbar(callback);
-      volume_ = tgt::GdcmVolumeReader(dictFileName, &progressbar).read(fileName);
-      if (volume_) {
-        tgt::oldVolumePosition(volume_);
-      }
+      tgt::GdcmVolumeReader reader(dictFileName, &progressbar);
+      reader.setIndexCacheDir(getUserDataPath("dicomindex"));
+      reader.setNumWorkerThreads(numLoaderThreads_);
+      volume = reader.read(fileName);
     }
     catch (const tgt::FileException& e) {
       LERROR(e.what());
@@ -228,9 +337,33 @@ namespace mivt {
       LERROR("bad allocation while reading file: " << fileName);
     }
 
-    if (volume_) {
-      render_->SetVolume(volume_);
-    }
+    setVolume(volume);
+  }
+
+  void Application::SetNumLoaderThreads(int numThreads)
+  {
+    numLoaderThreads_ = std::max(numThreads, 0);
+  }
+
+  int Application::GetNumLoaderThreads()
+  {
+    return numLoaderThreads_;
+  }
+
+  void Application::setVolume(tgt::Volume* volume)
+  {
+    if (!volume)
+      return;
+
+    tgt::oldVolumePosition(volume);
+
+    // the renderer keeps using the old volume until it is replaced, which also frees its textures,
+    // so both happen where the context is current
+    invoke([&]() {
+      render_->SetVolume(volume);
+      DELPTR(volume_);
+      volume_ = volume;
+    });
   }
 
   void Application::initTransfunc()
@@ -246,7 +379,8 @@ namespace mivt {
   void Application::SetTransfunc(const std::string& fileName)
   {
     transfuncName_ = fileName;
-    transfunc_->load(getResourcePath("transfuncs") + "\\" + fileName + ".xml");
+    std::string path = getResourcePath("transfuncs") + "\\" + fileName + ".xml";
+    post([=]() { transfunc_->load(path); });
   }
 
   std::string Application::GetTransfunc()
@@ -256,22 +390,98 @@ namespace mivt {
 
   void Application::SetClassificationMode(const std::string& mode)
   {
-    render_->SetClassificationMode(mode);
+    post([=]() { render_->SetClassificationMode(mode); });
   }
 
   std::string Application::GetClassificationMode()
   {
-    return render_->GetClassificationMode();
+    return query<std::string>([this]() { return render_->GetClassificationMode(); });
+  }
+
+  void Application::SetRenderBackend(const std::string& backend)
+  {
+    post([=]() { render_->SetRenderBackend(backend); });
+  }
+
+  std::string Application::GetRenderBackend()
+  {
+    return query<std::string>([this]() { return render_->GetRenderBackend(); });
+  }
+
+  void Application::SetReadbackMode(const std::string& mode)
+  {
+    post([=]() { render_->SetReadbackMode(mode); });
+  }
+
+  std::string Application::GetReadbackMode()
+  {
+    return query<std::string>([this]() { return render_->GetReadbackMode(); });
+  }
+
+  float Application::GetRenderTime()
+  {
+    return query<float>([this]() { return render_->GetRenderTime(); });
+  }
+
+  float Application::GetReadbackTime()
+  {
+    return query<float>([this]() { return render_->GetReadbackTime(); });
+  }
+
+  int Application::GetReadbackLatency()
+  {
+    return query<int>([this]() { return render_->GetReadbackLatency(); });
+  }
+
+  void Application::SetEmptySpaceSkipping(bool enable)
+  {
+    post([=]() { render_->SetEmptySpaceSkipping(enable); });
+  }
+
+  bool Application::GetEmptySpaceSkipping()
+  {
+    return query<bool>([this]() { return render_->GetEmptySpaceSkipping(); });
+  }
+
+  void Application::SetUniformBlocks(bool enable)
+  {
+    post([=]() { render_->SetUniformBlocks(enable); });
+  }
+
+  bool Application::GetUniformBlocks()
+  {
+    return query<bool>([this]() { return render_->GetUniformBlocks(); });
+  }
+
+  void Application::SetProxyMode(const std::string& mode)
+  {
+    post([=]() { render_->SetProxyMode(mode); });
+  }
+
+  std::string Application::GetProxyMode()
+  {
+    return query<std::string>([this]() { return render_->GetProxyMode(); });
+  }
+
+  float Application::GetSamplesPerRay()
+  {
+    return query<float>([this]() { return render_->GetSamplesPerRay(); });
+  }
+
+  size_t Application::GetSculptUploadBytes()
+  {
+    return query<size_t>([this]() { return render_->GetSculptUploadBytes(); });
   }
 
   void Application::SetLightAmbient(const float v[4])
   {
-    render_->SetLightAmbient(glm::vec4(v[0], v[1], v[2], v[3]));
+    glm::vec4 color(v[0], v[1], v[2], v[3]);
+    post([=]() { render_->SetLightAmbient(color); });
   }
 
   void Application::GetLightAmbient(float v[4])
   {
-    glm::vec4 ret = render_->GetLightAmbient();
+    glm::vec4 ret = query<glm::vec4>([this]() { return render_->GetLightAmbient(); });
     v[0] = ret.x;
     v[1] = ret.y;
     v[2] = ret.z;
@@ -280,12 +490,13 @@ namespace mivt {
 
   void Application::SetLightDiffuse(const float v[4])
   {
-    render_->SetLightDiffuse(glm::vec4(v[0], v[1], v[2], v[3]));
+    glm::vec4 color(v[0], v[1], v[2], v[3]);
+    post([=]() { render_->SetLightDiffuse(color); });
   }
 
   void Application::GetLightDiffuse(float v[4])
   {
-    glm::vec4 ret = render_->GetLightDiffuse();
+    glm::vec4 ret = query<glm::vec4>([this]() { return render_->GetLightDiffuse(); });
     v[0] = ret.x;
     v[1] = ret.y;
     v[2] = ret.z;
@@ -294,12 +505,13 @@ namespace mivt {
 
   void Application::SetLightSpecular(const float v[4])
   {
-    render_->SetLightSpecular(glm::vec4(v[0], v[1], v[2], v[3]));
+    glm::vec4 color(v[0], v[1], v[2], v[3]);
+    post([=]() { render_->SetLightSpecular(color); });
   }
 
   void Application::GetLightSpecular(float v[4])
   {
-    glm::vec4 ret = render_->GetLightSpecular();
+    glm::vec4 ret = query<glm::vec4>([this]() { return render_->GetLightSpecular(); });
     v[0] = ret.x;
     v[1] = ret.y;
     v[2] = ret.z;
@@ -308,22 +520,23 @@ namespace mivt {
 
   void Application::SetMaterialShininess(float v)
   {
-    render_->SetMaterialShininess(v);
+    post([=]() { render_->SetMaterialShininess(v); });
   }
 
   float Application::GetMaterialShininess()
   {
-    return render_->GetMaterialShininess();
+    return query<float>([this]() { return render_->GetMaterialShininess(); });
   }
 
   void Application::SetFirstBgColor(const float v[4])
   {
-    render_->SetFirstColor(glm::vec4(v[0], v[1], v[2], v[3]));
+    glm::vec4 color(v[0], v[1], v[2], v[3]);
+    post([=]() { render_->SetFirstColor(color); });
   }
 
   void Application::GetFirstBgColor(float v[4])
   {
-    glm::vec4 ret = render_->GetFirstColor();
+    glm::vec4 ret = query<glm::vec4>([this]() { return render_->GetFirstColor(); });
     v[0] = ret.x;
     v[1] = ret.y;
     v[2] = ret.z;
@@ -332,12 +545,13 @@ namespace mivt {
 
   void Application::SetSecondBgColor(const float v[4])
   {
-    render_->SetSecondColor(glm::vec4(v[0], v[1], v[2], v[3]));
+    glm::vec4 color(v[0], v[1], v[2], v[3]);
+    post([=]() { render_->SetSecondColor(color); });
   }
 
   void Application::GetSecondBgColor(float v[4])
   {
-    glm::vec4 ret = render_->GetSecondColor();
+    glm::vec4 ret = query<glm::vec4>([this]() { return render_->GetSecondColor(); });
     v[0] = ret.x;
     v[1] = ret.y;
     v[2] = ret.z;
@@ -346,17 +560,17 @@ namespace mivt {
 
   void Application::SetBgColorMode(const std::string& mode)
   {
-    render_->SetColorMode(mode);
+    post([=]() { render_->SetColorMode(mode); });
   }
 
   std::string Application::GetBgColorMode()
   {
-    return render_->GetColorMode();
+    return query<std::string>([this]() { return render_->GetColorMode(); });
   }
 
   void Application::SaveToImage(const std::string& filename)
   {
-    render_->SaveToImage(filename);
+    invoke([&]() { render_->SaveToImage(filename); });
   }
 
   void Application::SaveToImage()
@@ -366,7 +580,7 @@ namespace mivt {
 
   void Application::SaveToImage(const std::string& filename, int width, int height)
   {
-    render_->SaveToImage(filename, glm::ivec2(width, height));
+    invoke([&]() { render_->SaveToImage(filename, glm::ivec2(width, height)); });
   }
 
   void Application::SaveToImage(int width, int height)
@@ -376,47 +590,47 @@ namespace mivt {
 
   void Application::ChangeClipRight(float val)
   {
-    render_->ChangeClipRight(val);
+    post([=]() { render_->ChangeClipRight(val); });
   }
 
   void Application::ChangeClipLeft(float val)
   {
-    render_->ChangeClipLeft(val);
+    post([=]() { render_->ChangeClipLeft(val); });
   }
 
   void Application::ChangeClipBack(float val)
   {
-    render_->ChangeClipBack(val);
+    post([=]() { render_->ChangeClipBack(val); });
   }
 
   void Application::ChangeClipFront(float val)
   {
-    render_->ChangeClipFront(val);
+    post([=]() { render_->ChangeClipFront(val); });
   }
 
   void Application::ChangeClipBottom(float val)
   {
-    render_->ChangeClipBottom(val);
+    post([=]() { render_->ChangeClipBottom(val); });
   }
 
   void Application::ChangeClipTop(float val)
   {
-    render_->ChangeClipTop(val);
+    post([=]() { render_->ChangeClipTop(val); });
   }
 
   void Application::resetClipPlanes()
   {
-    render_->resetClipPlanes();
+    post([=]() { render_->resetClipPlanes(); });
   }
 
   void Application::EnableClip(bool flag)
   {
-    render_->EnableClip(flag);
+    post([=]() { render_->EnableClip(flag); });
   }
 
   void Application::getClipMaximum(int v[3])
   {
-    glm::ivec3 ret = render_->getClipMaximum();
+    glm::ivec3 ret = query<glm::ivec3>([this]() { return render_->getClipMaximum(); });
     v[0] = ret.x;
     v[1] = ret.y;
     v[2] = ret.z;
@@ -424,47 +638,78 @@ namespace mivt {
 
   float Application::GetClipRight()
   {
-    return render_->GetClipRight();
+    return query<float>([this]() { return render_->GetClipRight(); });
   }
   float Application::GetClipLeft()
   {
-    return render_->GetClipLeft();
+    return query<float>([this]() { return render_->GetClipLeft(); });
   }
   float Application::GetClipBack()
   {
-    return render_->GetClipBack();
+    return query<float>([this]() { return render_->GetClipBack(); });
   }
   float Application::GetClipFront()
   {
-    return render_->GetClipFront();
+    return query<float>([this]() { return render_->GetClipFront(); });
   }
   float Application::GetClipBottom()
   {
-    return render_->GetClipBottom();
+    return query<float>([this]() { return render_->GetClipBottom(); });
   }
   float Application::GetClipTop()
   {
-    return render_->GetClipTop();
+    return query<float>([this]() { return render_->GetClipTop(); });
   }
   bool Application::IsClipEnabled()
   {
-    return render_->IsClipEnabled();
+    return query<bool>([this]() { return render_->IsClipEnabled(); });
   }
 
   void Application::DoSculpt(const std::vector<glm::vec2> & polygon)
   {
-    return render_->DoSculpt(polygon);
+    post([=]() { render_->DoSculpt(polygon); });
+  }
+
+  bool Application::UndoSculpt()
+  {
+    return query<bool>([this]() { return render_->UndoSculpt(); });
+  }
+
+  bool Application::RedoSculpt()
+  {
+    return query<bool>([this]() { return render_->RedoSculpt(); });
+  }
+
+  bool Application::CanUndoSculpt()
+  {
+    return query<bool>([this]() { return render_->CanUndoSculpt(); });
+  }
+
+  bool Application::CanRedoSculpt()
+  {
+    return query<bool>([this]() { return render_->CanRedoSculpt(); });
+  }
+
+  void Application::SetSculptHistoryLimit(size_t bytes)
+  {
+    post([=]() { render_->SetSculptHistoryLimit(bytes); });
+  }
+
+  size_t Application::GetSculptHistoryLimit()
+  {
+    return query<size_t>([this]() { return render_->GetSculptHistoryLimit(); });
   }
 
   void Application::getWindowingDomain(float val[2])
   {
-    glm::vec2 domain = render_->getWindowingDomain();
+    glm::vec2 domain = query<glm::vec2>([this]() { return render_->getWindowingDomain(); });
     val[0] = domain.x;
     val[1] = domain.y;
   }
 
   void Application::setWindowingDomain(float val[2])
   {
-    render_->setWindowingDomain(glm::vec2(val[0], val[1]));
+    glm::vec2 domain(val[0], val[1]);
+    post([=]() { render_->setWindowingDomain(domain); });
   }
 }
\ No newline at end of file
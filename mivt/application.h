@@ -2,6 +2,7 @@
 
 #include "config.h"
 #include "progressbar.h"
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,11 @@ namespace tgt {
 namespace mivt {
 
   class RenderVolume;
+  class RenderThread;
+
+  /// Called whenever a frame has been finished, on the render thread if there is one, see Application::RequestPixels()
+  typedef void (__stdcall * FrameCallback)();
+
   class Application
   {
   public:
@@ -26,16 +32,39 @@ namespace mivt {
 
     MIVT_API void Deinitialize();
 
+    /// Renders a frame into \p buffer. With the render thread, the latest finished frame is returned
+    /// while downsampling, which may be older or missing right after a resize, the final one is waited for.
     MIVT_API void GetPixels(unsigned char* buffer, int length, bool downsampling = false);
 
+    /// Requests a frame without waiting for it, the frame callback is called once it is finished.
+    MIVT_API void RequestPixels(int length, bool downsampling = false);
+
+    /// Copies the latest finished frame without requesting a new one, e.g. from the frame callback.
+    /// Returns false if there is no frame of \p length. Only one thread may fetch frames.
+    MIVT_API bool GetLatestPixels(unsigned char* buffer, int length);
+
     MIVT_API void Resize(int width, int height);
 
+    /// Renders on a thread of its own that takes over the off-screen context (default off). All calls are
+    /// queued for that thread then, getters wait for it. Camera movements queued between two frames are
+    /// rendered as one frame. The frame callback must not call GetPixels(), which would request the next
+    /// frame, nor wait for the thread that called into the application.
+    MIVT_API void SetRenderThread(bool enable);
+    MIVT_API bool GetRenderThread();
+
+    /// Minimum time between two frames of the render thread in milliseconds (default 16)
+    MIVT_API void SetFrameInterval(float ms);
+    MIVT_API float GetFrameInterval();
+
+    MIVT_API void SetFrameCallback(FrameCallback callback);
+
     MIVT_API void Rotate(int newPosX, int newPosY, int lastPosX, int lastPosY);
 
     MIVT_API void Zoom(int newPosX, int newPosY, int lastPosX, int lastPosY);
 
     MIVT_API void Pan(int newPosX, int newPosY, int lastPosX, int lastPosY);
 
+    /// Volumes larger than 1 GB are read brick by brick on demand and always rendered by the CPU backend.
     MIVT_API void LoadVolume(const std::string &fileName, 
       const std::string& format,
       const int dimension[3], 
@@ -45,14 +74,52 @@ namespace mivt {
       float windowWidth,
       float windowCenter);
 
+    /// The series is read on the calling thread, so \p callback may call into that thread synchronously, e.g. to update a progress bar.
     MIVT_API void LoadVolume(const std::string &fileName, tgt::ProgressCallback callback);
 
+    /// Number of threads decoding the slices of a DICOM series, 0 (default) for one per hardware core, 1 for the calling thread only.
+    MIVT_API void SetNumLoaderThreads(int numThreads);
+    MIVT_API int GetNumLoaderThreads();
+
     MIVT_API void SetTransfunc(const std::string& fileName);
     MIVT_API std::string GetTransfunc();
 
     MIVT_API void SetClassificationMode(const std::string& mode);
     MIVT_API std::string GetClassificationMode();
 
+    /// "gpu" (default) or "cpu", the latter renders without OpenGL 3.3
+    MIVT_API void SetRenderBackend(const std::string& backend);
+    MIVT_API std::string GetRenderBackend();
+
+    /// "latency" (default) reads each frame back after rendering it, "throughput" returns the newest
+    /// frame whose asynchronous download completed while downsampling, usually the previous one
+    MIVT_API void SetReadbackMode(const std::string& mode);
+    MIVT_API std::string GetReadbackMode();
+
+    /// Milliseconds the last GetPixels() spent in rendering and in reading back, and the number of
+    /// frames its image lags behind the rendered one
+    MIVT_API float GetRenderTime();
+    MIVT_API float GetReadbackTime();
+    MIVT_API int GetReadbackLatency();
+
+    /// Skip bricks of the volume that are transparent for the transfer function (default on)
+    MIVT_API void SetEmptySpaceSkipping(bool enable);
+    MIVT_API bool GetEmptySpaceSkipping();
+
+    /// Pass the volume parameters to the shader as std140 uniform blocks in one buffer update each (default on)
+    MIVT_API void SetUniformBlocks(bool enable);
+    MIVT_API bool GetUniformBlocks();
+
+    /// "occupancy" (default) starts the rays at the bricks with visible samples, "cube" at the clipped bounding box
+    MIVT_API void SetProxyMode(const std::string& mode);
+    MIVT_API std::string GetProxyMode();
+
+    /// Average number of samples per ray of the last frame of the "cpu" backend
+    MIVT_API float GetSamplesPerRay();
+
+    /// Mask bytes uploaded to the GPU by the last sculpting on the CPU, only the touched bricks are uploaded
+    MIVT_API size_t GetSculptUploadBytes();
+
     MIVT_API void SetLightAmbient(const float v[4]);
     MIVT_API void GetLightAmbient(float v[4]);
 
@@ -98,6 +165,19 @@ namespace mivt {
 
     MIVT_API void DoSculpt(const std::vector<glm::vec2> & polygon);
 
+    /// Reverts the last sculpt operation, returns false if there is none
+    MIVT_API bool UndoSculpt();
+
+    /// Repeats the last undone sculpt operation, returns false if there is none
+    MIVT_API bool RedoSculpt();
+
+    MIVT_API bool CanUndoSculpt();
+    MIVT_API bool CanRedoSculpt();
+
+    /// Memory for undoing sculpt operations (default 64 MB), the oldest operations are discarded beyond
+    MIVT_API void SetSculptHistoryLimit(size_t bytes);
+    MIVT_API size_t GetSculptHistoryLimit();
+
     MIVT_API void getWindowingDomain(float val[2]);
     MIVT_API void setWindowingDomain(float val[2]);
 
@@ -109,6 +189,23 @@ namespace mivt {
     void initLogging();
     void initTransfunc();
 
+    /// Replaces the rendered volume by \p volume, which is read already, nothing happens if it is null.
+    void setVolume(tgt::Volume* volume);
+
+    /// Runs \p command on the render thread if there is one, without waiting for it.
+    void post(const std::function<void()>& command);
+
+    /// Runs \p command on the render thread if there is one and waits for it.
+    void invoke(const std::function<void()>& command);
+
+    /// Returns the result of \p function, evaluated on the render thread if there is one.
+    template<typename T>
+    T query(const std::function<T()>& function) {
+      T result = T();
+      invoke([&]() { result = function(); });
+      return result;
+    }
+
   private:
     tgt::OffScreenRender    *offscreen_;
     tgt::LogManager         *logManager_;
@@ -117,6 +214,11 @@ namespace mivt {
     std::string             transfuncName_;
 
     RenderVolume            *render_;
+    RenderThread            *renderThread_;
+    float                   frameInterval_;
+    FrameCallback           frameCallback_;
+    int                     numLoaderThreads_;
+    std::vector<unsigned char> latestPixels_;  ///< frame of RequestPixels() without the render thread
 
     std::string             programPath_;
     std::string             basePath_;
@@ -0,0 +1,846 @@
+#include "cpuraycaster.h"
+#include "preintegration.h"
+#include "occupancygrid.h"
+#include "camera.h"
+#include "volume.h"
+#include "volumeatomic.h"
+#include "volumebricked.h"
+#include "volumemask.h"
+#include "transfunc1d.h"
+#include "logmanager.h"
+#include "tgt_string.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+// anonymous namespace
+namespace {
+
+  using mivt::CpuRaycaster;
+
+  /// see RAYCASTING_LOOP_COUNT in mod_raysetup.frag
+  const int RAYCASTING_LOOP_COUNT = 255 * 255;
+
+  /// see EARLY_RAY_TERMINATION_OPACITY in mod_raysetup.frag
+  const float EARLY_RAY_TERMINATION_OPACITY = 0.95f;
+
+  /// see SAMPLING_BASE_INTERVAL_RCP in mod_compositing.frag
+  const float SAMPLING_BASE_INTERVAL_RCP = 200.f;
+
+  const int ALL_LANES = (1 << CpuRaycaster::PACKET_SIZE) - 1;
+
+  enum Classification {
+    CLASSIFICATION_NONE,
+    CLASSIFICATION_TRANSFER_FUNCTION,
+    CLASSIFICATION_PRE_INTEGRATED
+  };
+
+  /// Parameters shared by all rays of a frame, the counterpart of the shader uniforms.
+  struct FrameParameters {
+    glm::mat4 ndcToTexture;             ///< maps normalized device coordinates to texture coordinates
+    glm::vec3 texLlf;                   ///< proxy box in texture coordinates
+    glm::vec3 texUrb;
+    glm::ivec2 size;                    ///< image size
+
+    glm::ivec3 dimensions;              ///< dimensions of the sampled volume
+    glm::vec3 textureToPhysicalScale;   ///< dimensions * spacing
+    glm::vec3 volumeOffset;
+    glm::vec3 gradientScale;            ///< 1 / (2 * spacing), multiplied with the rescale slope
+    float vmScale;                      ///< rescale mapping of the raw voxel values
+    float vmOffset;
+    const tgt::VolumeMask* mask;        ///< null if no voxel is masked
+    glm::ivec3 maskDimensions;          ///< dimensions of the full resolution volume
+
+    glm::vec3 cameraPositionPhysical;   ///< also used as light position, like rc_basic.frag does
+    glm::vec3 lightAmbient;
+    glm::vec3 lightDiffuse;
+    glm::vec3 lightSpecular;
+    glm::vec3 lightAttenuation;
+    bool applyLightAttenuation;
+    float shininess;
+
+    float samplingStepSize;
+    float windowingScale;               ///< maps HU values to [0, 1] like realWorldToTexture()
+    float windowingOffset;
+    Classification classification;
+    const glm::vec4* table;             ///< 1D transfer function or 2D pre-integration table
+    int tableSize;
+
+    bool skipEmptySpace;
+    const uint8_t* occupancy;           ///< one value per brick, zero for transparent bricks, see OccupancyGrid
+    glm::ivec3 occupancyDimensions;     ///< volume dimensions the bricks refer to
+    glm::ivec3 brickDimensions;
+    float brickSize;                    ///< edge length of the bricks in voxels
+  };
+
+  /// Start points, directions and lengths of the rays of one packet in texture coordinates.
+  struct RayPacket {
+    float firstX[CpuRaycaster::PACKET_SIZE];
+    float firstY[CpuRaycaster::PACKET_SIZE];
+    float firstZ[CpuRaycaster::PACKET_SIZE];
+    float dirX[CpuRaycaster::PACKET_SIZE];
+    float dirY[CpuRaycaster::PACKET_SIZE];
+    float dirZ[CpuRaycaster::PACKET_SIZE];
+    float tEnd[CpuRaycaster::PACKET_SIZE];
+    int lanes;                          ///< bit i is set if ray i hits the proxy box
+  };
+
+  //------------------------------------------------------------------------------
+  // SSE helpers
+
+  inline __m128 clampPs(__m128 v, __m128 lo, __m128 hi) {
+    // max() returns its second operand for NaN, so NaN is clamped to lo
+    return _mm_min_ps(_mm_max_ps(v, lo), hi);
+  }
+
+  inline __m128 lerpPs(__m128 a, __m128 b, __m128 f) {
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), f));
+  }
+
+  inline __m128 selectPs(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+  }
+
+  inline int laneCount(int lanes) {
+    int count = 0;
+    for (int i = 0; i < CpuRaycaster::PACKET_SIZE; ++i)
+      count += (lanes >> i) & 1;
+    return count;
+  }
+
+  inline __m128 laneMask(int lanes) {
+    return _mm_castsi128_ps(_mm_set_epi32(
+      (lanes & 8) ? -1 : 0, (lanes & 4) ? -1 : 0, (lanes & 2) ? -1 : 0, (lanes & 1) ? -1 : 0));
+  }
+
+  /// Returns 1 / length(v), or 0 for zero vectors.
+  inline __m128 rcpLength(__m128 x, __m128 y, __m128 z) {
+    __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    __m128 valid = _mm_cmpgt_ps(lengthSq, _mm_setzero_ps());
+    return _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lengthSq)));
+  }
+
+  //------------------------------------------------------------------------------
+
+  /// Lower corners and weights of the trilinear lookups of a packet, see trilinearCoordinates().
+  struct TrilinearCoordinates {
+    int x0[4];
+    int y0[4];
+    int z0[4];
+    __m128 fx;
+    __m128 fy;
+    __m128 fz;
+  };
+
+  /// Converts texture coordinates into voxel coordinates clamped to the volume like GL_CLAMP_TO_EDGE.
+  inline void trilinearCoordinates(__m128 x, __m128 y, __m128 z, const glm::vec3& scale, const glm::vec3& max,
+    TrilinearCoordinates& coords) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    // texel centers are at (i + 0.5) / dimension
+    __m128 cx = clampPs(_mm_sub_ps(_mm_mul_ps(x, _mm_set1_ps(scale.x)), half), zero, _mm_set1_ps(max.x));
+    __m128 cy = clampPs(_mm_sub_ps(_mm_mul_ps(y, _mm_set1_ps(scale.y)), half), zero, _mm_set1_ps(max.y));
+    __m128 cz = clampPs(_mm_sub_ps(_mm_mul_ps(z, _mm_set1_ps(scale.z)), half), zero, _mm_set1_ps(max.z));
+
+    // truncation equals floor for non-negative values
+    __m128i ix = _mm_cvttps_epi32(cx);
+    __m128i iy = _mm_cvttps_epi32(cy);
+    __m128i iz = _mm_cvttps_epi32(cz);
+    coords.fx = _mm_sub_ps(cx, _mm_cvtepi32_ps(ix));
+    coords.fy = _mm_sub_ps(cy, _mm_cvtepi32_ps(iy));
+    coords.fz = _mm_sub_ps(cz, _mm_cvtepi32_ps(iz));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(coords.x0), ix);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(coords.y0), iy);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(coords.z0), iz);
+  }
+
+  /// Interpolates the eight neighbours \p c of every lane, ordered x-fastest.
+  inline __m128 trilinearBlend(const float c[8][4], const TrilinearCoordinates& coords) {
+    __m128 c00 = lerpPs(_mm_loadu_ps(c[0]), _mm_loadu_ps(c[1]), coords.fx);
+    __m128 c01 = lerpPs(_mm_loadu_ps(c[2]), _mm_loadu_ps(c[3]), coords.fx);
+    __m128 c10 = lerpPs(_mm_loadu_ps(c[4]), _mm_loadu_ps(c[5]), coords.fx);
+    __m128 c11 = lerpPs(_mm_loadu_ps(c[6]), _mm_loadu_ps(c[7]), coords.fx);
+    return lerpPs(lerpPs(c00, c01, coords.fy), lerpPs(c10, c11, coords.fy), coords.fz);
+  }
+
+  /// Gathers the eight neighbours of a lookup from a block of voxels with the given strides.
+  template<class T>
+  inline void gatherNeighbours(const T* data, size_t strideY, size_t strideZ,
+    size_t x0, size_t y0, size_t z0, size_t x1, size_t y1, size_t z1, float c[8][4], int lane) {
+    const T* p00 = data + z0 * strideZ + y0 * strideY;
+    const T* p01 = data + z0 * strideZ + y1 * strideY;
+    const T* p10 = data + z1 * strideZ + y0 * strideY;
+    const T* p11 = data + z1 * strideZ + y1 * strideY;
+    c[0][lane] = static_cast<float>(p00[x0]);
+    c[1][lane] = static_cast<float>(p00[x1]);
+    c[2][lane] = static_cast<float>(p01[x0]);
+    c[3][lane] = static_cast<float>(p01[x1]);
+    c[4][lane] = static_cast<float>(p10[x0]);
+    c[5][lane] = static_cast<float>(p10[x1]);
+    c[6][lane] = static_cast<float>(p11[x0]);
+    c[7][lane] = static_cast<float>(p11[x1]);
+  }
+
+  /**
+  * Trilinear lookup of raw voxel values for a packet of positions in texture coordinates,
+  * the equivalent of a GL_LINEAR / GL_CLAMP_TO_EDGE 3D texture.
+  */
+  template<class T>
+  class VoxelSampler {
+  public:
+    VoxelSampler(const T* data, const glm::ivec3& dimensions)
+      : data_(data)
+      , dimensions_(dimensions)
+      , strideY_(static_cast<size_t>(dimensions.x))
+      , strideZ_(static_cast<size_t>(dimensions.x) * dimensions.y)
+      , scale_(glm::vec3(dimensions))
+      , max_(glm::vec3(dimensions - 1))
+    {}
+
+    __m128 sample(__m128 x, __m128 y, __m128 z) const {
+      TrilinearCoordinates coords;
+      trilinearCoordinates(x, y, z, scale_, max_, coords);
+
+      // gather the eight neighbours of every lane
+      float c[8][4];
+      for (int i = 0; i < 4; ++i) {
+        size_t x1 = std::min(coords.x0[i] + 1, dimensions_.x - 1);
+        size_t y1 = std::min(coords.y0[i] + 1, dimensions_.y - 1);
+        size_t z1 = std::min(coords.z0[i] + 1, dimensions_.z - 1);
+        gatherNeighbours(data_, strideY_, strideZ_, coords.x0[i], coords.y0[i], coords.z0[i], x1, y1, z1, c, i);
+      }
+      return trilinearBlend(c, coords);
+    }
+
+  private:
+    const T* data_;
+    glm::ivec3 dimensions_;
+    size_t strideY_;
+    size_t strideZ_;
+    glm::vec3 scale_;
+    glm::vec3 max_;
+  };
+
+  /**
+  * VoxelSampler for volumes that are only available as bricks, see tgt::VolumeBrickedAtomic.
+  * Neighbouring bricks share a layer of voxels, so all neighbours of a lookup lie in the brick of
+  * the lower corner. Every lane keeps the brick of its last lookup, which is why each thread has
+  * to sample with a copy of its own.
+  */
+  template<class T>
+  class BrickedVoxelSampler {
+  public:
+    BrickedVoxelSampler(const tgt::VolumeBrickedAtomic<T>* volume)
+      : volume_(volume)
+      , dimensions_(volume->getDimensions())
+      , scale_(glm::vec3(dimensions_))
+      , max_(glm::vec3(dimensions_ - 1))
+    {
+      for (int i = 0; i < 4; ++i)
+        brickIndex_[i] = std::numeric_limits<size_t>::max();
+    }
+
+    __m128 sample(__m128 x, __m128 y, __m128 z) const {
+      TrilinearCoordinates coords;
+      trilinearCoordinates(x, y, z, scale_, max_, coords);
+
+      float c[8][4];
+      for (int i = 0; i < 4; ++i) {
+        const glm::ivec3 first(coords.x0[i], coords.y0[i], coords.z0[i]);
+        const size_t index = volume_->getBrickIndex(first);
+        if (index != brickIndex_[i]) {
+          bricks_[i] = volume_->getBrick(index);
+          brickIndex_[i] = index;
+        }
+
+        const typename tgt::VolumeBrickedAtomic<T>::Brick& brick = bricks_[i];
+        const glm::ivec3 offset = brick.getOffset();
+        const glm::ivec3 dims = brick.getDimensions();
+        const glm::ivec3 last = glm::min(first + 1, dimensions_ - 1) - offset;
+        const glm::ivec3 local = first - offset;
+        gatherNeighbours(brick.getData(), static_cast<size_t>(dims.x), static_cast<size_t>(dims.x) * dims.y,
+          local.x, local.y, local.z, last.x, last.y, last.z, c, i);
+      }
+      return trilinearBlend(c, coords);
+    }
+
+  private:
+    const tgt::VolumeBrickedAtomic<T>* volume_;
+    glm::ivec3 dimensions_;
+    glm::vec3 scale_;
+    glm::vec3 max_;
+    mutable typename tgt::VolumeBrickedAtomic<T>::Brick bricks_[4];
+    mutable size_t brickIndex_[4];
+  };
+
+  /// Nearest neighbour lookup of the mask, returns a bit per lane whose mask value is zero.
+  int unmaskedLanes(const FrameParameters& params, __m128 x, __m128 y, __m128 z) {
+    if (!params.mask)
+      return ALL_LANES;
+
+    const __m128 zero = _mm_setzero_ps();
+    const glm::vec3 dim(params.maskDimensions);
+    __m128i ix = _mm_cvttps_epi32(clampPs(_mm_mul_ps(x, _mm_set1_ps(dim.x)), zero, _mm_set1_ps(dim.x - 1.f)));
+    __m128i iy = _mm_cvttps_epi32(clampPs(_mm_mul_ps(y, _mm_set1_ps(dim.y)), zero, _mm_set1_ps(dim.y - 1.f)));
+    __m128i iz = _mm_cvttps_epi32(clampPs(_mm_mul_ps(z, _mm_set1_ps(dim.z)), zero, _mm_set1_ps(dim.z - 1.f)));
+
+    int xi[4], yi[4], zi[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(xi), ix);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(yi), iy);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(zi), iz);
+
+    int lanes = 0;
+    for (int i = 0; i < 4; ++i) {
+      if (!params.mask->test(glm::ivec3(xi[i], yi[i], zi[i])))
+        lanes |= 1 << i;
+    }
+    return lanes;
+  }
+
+  /**
+  * Number of sampling steps a ray can skip after samplePos, zero unless samplePos lies in a transparent brick.
+  * The ray continues with the last sample inside the brick, see transparentSteps() in mod_raysetup.frag.
+  */
+  float transparentSteps(const FrameParameters& params, const glm::vec3& samplePos, const glm::vec3& direction) {
+    const glm::vec3 dim(params.occupancyDimensions);
+    glm::vec3 voxelPos = samplePos * dim - 0.5f;
+    glm::ivec3 brick = glm::clamp(glm::ivec3(glm::floor(voxelPos / params.brickSize)),
+      glm::ivec3(0), params.brickDimensions - 1);
+    size_t index = (static_cast<size_t>(brick.z) * params.brickDimensions.y + brick.y) * params.brickDimensions.x + brick.x;
+    if (params.occupancy[index])
+      return 0.f;
+
+    // distance to the brick exit, the bricks at the border extend to infinity like GL_CLAMP_TO_EDGE
+    glm::vec3 voxelDirection = direction * dim;
+    float tExit = std::numeric_limits<float>::max();
+    for (int i = 0; i < 3; ++i) {
+      if (voxelDirection[i] > 0.f && brick[i] < params.brickDimensions[i] - 1)
+        tExit = std::min(tExit, ((brick[i] + 1) * params.brickSize - voxelPos[i]) / voxelDirection[i]);
+      else if (voxelDirection[i] < 0.f && brick[i] > 0)
+        tExit = std::min(tExit, (brick[i] * params.brickSize - voxelPos[i]) / voxelDirection[i]);
+    }
+
+    float steps = std::ceil(tExit / params.samplingStepSize) - 2.f;
+    return std::min(std::max(steps, 0.f), static_cast<float>(RAYCASTING_LOOP_COUNT));
+  }
+
+  /// Texel of a table with GL_CLAMP_TO_BORDER wrapping and a zero border color.
+  inline glm::vec4 tableTexel(const glm::vec4* table, int size, int x, int y) {
+    if (x < 0 || y < 0 || x >= size || y >= size)
+      return glm::vec4(0.f);
+    return table[y * size + x];
+  }
+
+  /// The CPU version of RC_APPLY_CLASSIFICATION, see applyTF() and applyTFpi() in mod_transfunc.frag.
+  glm::vec4 classify(const FrameParameters& params, float intensity, float lastIntensity) {
+    switch (params.classification) {
+    case CLASSIFICATION_TRANSFER_FUNCTION: {
+      // nearest lookup in the 1D texture
+      float x = std::floor((intensity * params.windowingScale + params.windowingOffset) * params.tableSize);
+      if (!(x >= 0.f && x < params.tableSize))
+        return glm::vec4(0.f);
+      return params.table[static_cast<int>(x)];
+    }
+
+    case CLASSIFICATION_PRE_INTEGRATED: {
+      // bilinear lookup in the 2D table, x is the current and y the previous intensity
+      float x = (intensity * params.windowingScale + params.windowingOffset) * params.tableSize - 0.5f;
+      float y = (lastIntensity * params.windowingScale + params.windowingOffset) * params.tableSize - 0.5f;
+      if (!(x > -1.f && x < params.tableSize && y > -1.f && y < params.tableSize))
+        return glm::vec4(0.f);
+      float fx = std::floor(x);
+      float fy = std::floor(y);
+      int x0 = static_cast<int>(fx);
+      int y0 = static_cast<int>(fy);
+      glm::vec4 bottom = glm::mix(tableTexel(params.table, params.tableSize, x0, y0),
+        tableTexel(params.table, params.tableSize, x0 + 1, y0), x - fx);
+      glm::vec4 top = glm::mix(tableTexel(params.table, params.tableSize, x0, y0 + 1),
+        tableTexel(params.table, params.tableSize, x0 + 1, y0 + 1), x - fx);
+      return glm::mix(bottom, top, y - fy);
+    }
+
+    default:
+      return glm::vec4(intensity);
+    }
+  }
+
+  /// Central differences in texture space, see calcGradient() in mod_gradient.frag.
+  template<class Sampler>
+  void calcGradient(const FrameParameters& params, const Sampler& volume,
+    __m128 x, __m128 y, __m128 z, __m128& gx, __m128& gy, __m128& gz)
+  {
+    const __m128 ox = _mm_set1_ps(1.f / params.dimensions.x);
+    const __m128 oy = _mm_set1_ps(1.f / params.dimensions.y);
+    const __m128 oz = _mm_set1_ps(1.f / params.dimensions.z);
+
+    __m128 v0 = volume.sample(_mm_add_ps(x, ox), y, z);
+    __m128 v1 = volume.sample(x, _mm_add_ps(y, oy), z);
+    __m128 v2 = volume.sample(x, y, _mm_add_ps(z, oz));
+    __m128 v3 = volume.sample(_mm_sub_ps(x, ox), y, z);
+    __m128 v4 = volume.sample(x, _mm_sub_ps(y, oy), z);
+    __m128 v5 = volume.sample(x, y, _mm_sub_ps(z, oz));
+
+    gx = _mm_mul_ps(_mm_sub_ps(v3, v0), _mm_set1_ps(params.gradientScale.x));
+    gy = _mm_mul_ps(_mm_sub_ps(v4, v1), _mm_set1_ps(params.gradientScale.y));
+    gz = _mm_mul_ps(_mm_sub_ps(v5, v2), _mm_set1_ps(params.gradientScale.z));
+  }
+
+  /**
+  * Phong shading with ka = kd = color and ks = 1, see phongShading() in mod_shading.frag.
+  * Light and camera are both located at the camera position.
+  */
+  void phongShading(const FrameParameters& params, __m128 gx, __m128 gy, __m128 gz,
+    __m128 x, __m128 y, __m128 z, __m128& r, __m128& g, __m128& b)
+  {
+    __m128 rcpN = rcpLength(gx, gy, gz);
+    __m128 nx = _mm_mul_ps(gx, rcpN);
+    __m128 ny = _mm_mul_ps(gy, rcpN);
+    __m128 nz = _mm_mul_ps(gz, rcpN);
+
+    // sample position in volume physical space
+    __m128 px = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(params.textureToPhysicalScale.x)), _mm_set1_ps(params.volumeOffset.x));
+    __m128 py = _mm_add_ps(_mm_mul_ps(y, _mm_set1_ps(params.textureToPhysicalScale.y)), _mm_set1_ps(params.volumeOffset.y));
+    __m128 pz = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(params.textureToPhysicalScale.z)), _mm_set1_ps(params.volumeOffset.z));
+
+    __m128 lx = _mm_sub_ps(_mm_set1_ps(params.cameraPositionPhysical.x), px);
+    __m128 ly = _mm_sub_ps(_mm_set1_ps(params.cameraPositionPhysical.y), py);
+    __m128 lz = _mm_sub_ps(_mm_set1_ps(params.cameraPositionPhysical.z), pz);
+    __m128 rcpD = rcpLength(lx, ly, lz);
+    lx = _mm_mul_ps(lx, rcpD);
+    ly = _mm_mul_ps(ly, rcpD);
+    lz = _mm_mul_ps(lz, rcpD);
+
+    // V equals L, so the half vector H is L as well
+    __m128 nDotL = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz)),
+      _mm_setzero_ps());
+
+    float nDotH[4];
+    _mm_storeu_ps(nDotH, nDotL);
+    for (int i = 0; i < 4; ++i)
+      nDotH[i] = std::pow(nDotH[i], params.shininess);
+    __m128 specular = _mm_loadu_ps(nDotH);
+
+    // ka * ambient + kd * diffuse * NdotL + ks * specular * NdotH^shininess
+    r = _mm_add_ps(_mm_mul_ps(r, _mm_add_ps(_mm_set1_ps(params.lightAmbient.r), _mm_mul_ps(nDotL, _mm_set1_ps(params.lightDiffuse.r)))),
+      _mm_mul_ps(specular, _mm_set1_ps(params.lightSpecular.r)));
+    g = _mm_add_ps(_mm_mul_ps(g, _mm_add_ps(_mm_set1_ps(params.lightAmbient.g), _mm_mul_ps(nDotL, _mm_set1_ps(params.lightDiffuse.g)))),
+      _mm_mul_ps(specular, _mm_set1_ps(params.lightSpecular.g)));
+    b = _mm_add_ps(_mm_mul_ps(b, _mm_add_ps(_mm_set1_ps(params.lightAmbient.b), _mm_mul_ps(nDotL, _mm_set1_ps(params.lightDiffuse.b)))),
+      _mm_mul_ps(specular, _mm_set1_ps(params.lightSpecular.b)));
+
+    if (params.applyLightAttenuation) {
+      float d[4];
+      _mm_storeu_ps(d, _mm_div_ps(_mm_set1_ps(1.f), rcpD));
+      for (int i = 0; i < 4; ++i) {
+        glm::vec3 att = params.lightAttenuation;
+        d[i] = std::min(1.f / (att.x + att.y * d[i] + att.z * d[i] * d[i]), 1.f);
+      }
+      __m128 attenuation = _mm_loadu_ps(d);
+      r = _mm_mul_ps(r, attenuation);
+      g = _mm_mul_ps(g, attenuation);
+      b = _mm_mul_ps(b, attenuation);
+    }
+  }
+
+  /**
+  * Traverses the rays of a packet, the packet version of rayTraversal() in rc_basic.frag.
+  *
+  * @return the number of samples taken
+  */
+  template<class Sampler>
+  size_t traversePacket(const FrameParameters& params, const Sampler& volume,
+    const RayPacket& packet, glm::vec4* result)
+  {
+    const __m128 firstX = _mm_loadu_ps(packet.firstX);
+    const __m128 firstY = _mm_loadu_ps(packet.firstY);
+    const __m128 firstZ = _mm_loadu_ps(packet.firstZ);
+    const __m128 dirX = _mm_loadu_ps(packet.dirX);
+    const __m128 dirY = _mm_loadu_ps(packet.dirY);
+    const __m128 dirZ = _mm_loadu_ps(packet.dirZ);
+    const __m128 tEnd = _mm_loadu_ps(packet.tEnd);
+    const __m128 tIncr = _mm_set1_ps(params.samplingStepSize);
+    const __m128 one = _mm_set1_ps(1.f);
+    const float opacityExponent = params.samplingStepSize * SAMPLING_BASE_INTERVAL_RCP;
+
+    __m128 t = _mm_setzero_ps();
+    __m128 resultR = _mm_setzero_ps();
+    __m128 resultG = _mm_setzero_ps();
+    __m128 resultB = _mm_setzero_ps();
+    __m128 resultA = _mm_setzero_ps();
+    float lastIntensity[4] = { 0.f, 0.f, 0.f, 0.f };
+    int finished = ~packet.lanes & ALL_LANES;
+    size_t numSamples = 0;
+
+    for (int loop = 0; finished != ALL_LANES && loop < RAYCASTING_LOOP_COUNT; ++loop) {
+      __m128 x = _mm_add_ps(firstX, _mm_mul_ps(t, dirX));
+      __m128 y = _mm_add_ps(firstY, _mm_mul_ps(t, dirY));
+      __m128 z = _mm_add_ps(firstZ, _mm_mul_ps(t, dirZ));
+      numSamples += laneCount(~finished & ALL_LANES);
+
+      int visible = 0;
+      int sampled = unmaskedLanes(params, x, y, z) & ~finished & ALL_LANES;
+      if (sampled) {
+        float intensity[4];
+        _mm_storeu_ps(intensity, _mm_add_ps(_mm_mul_ps(volume.sample(x, y, z),
+          _mm_set1_ps(params.vmScale)), _mm_set1_ps(params.vmOffset)));
+
+        // apply classification
+        float colorR[4] = { 0.f, 0.f, 0.f, 0.f };
+        float colorG[4] = { 0.f, 0.f, 0.f, 0.f };
+        float colorB[4] = { 0.f, 0.f, 0.f, 0.f };
+        float colorA[4] = { 0.f, 0.f, 0.f, 0.f };
+        for (int i = 0; i < 4; ++i) {
+          if (!(sampled & (1 << i)))
+            continue;
+          glm::vec4 color = classify(params, intensity[i], lastIntensity[i]);
+          if (color.a > 0.f) {
+            colorR[i] = color.r;
+            colorG[i] = color.g;
+            colorB[i] = color.b;
+            // apply opacity correction to accomodate for variable sampling intervals
+            colorA[i] = 1.f - std::pow(1.f - color.a, opacityExponent);
+            visible |= 1 << i;
+          }
+          lastIntensity[i] = intensity[i];
+        }
+
+        // if opacity greater zero, apply shading and compositing
+        if (visible) {
+          __m128 r = _mm_loadu_ps(colorR);
+          __m128 g = _mm_loadu_ps(colorG);
+          __m128 b = _mm_loadu_ps(colorB);
+          __m128 a = _mm_loadu_ps(colorA);
+
+          __m128 gx, gy, gz;
+          calcGradient(params, volume, x, y, z, gx, gy, gz);
+          phongShading(params, gx, gy, gz, x, y, z, r, g, b);
+
+          __m128 weight = _mm_and_ps(laneMask(visible), _mm_mul_ps(_mm_sub_ps(one, resultA), a));
+          resultR = _mm_add_ps(resultR, _mm_mul_ps(weight, r));
+          resultG = _mm_add_ps(resultG, _mm_mul_ps(weight, g));
+          resultB = _mm_add_ps(resultB, _mm_mul_ps(weight, b));
+          resultA = _mm_add_ps(resultA, weight);
+        }
+
+        // early ray termination
+        int terminated = _mm_movemask_ps(_mm_cmpge_ps(resultA, _mm_set1_ps(EARLY_RAY_TERMINATION_OPACITY))) & sampled;
+        if (terminated) {
+          resultA = selectPs(laneMask(terminated), one, resultA);
+          finished |= terminated;
+        }
+      }
+
+      // jump over transparent bricks, lanes with a visible sample are inside an occupied brick
+      int skippable = ~visible & ~finished & ALL_LANES;
+      if (params.skipEmptySpace && skippable) {
+        float px[4], py[4], pz[4];
+        float steps[4] = { 0.f, 0.f, 0.f, 0.f };
+        _mm_storeu_ps(px, x);
+        _mm_storeu_ps(py, y);
+        _mm_storeu_ps(pz, z);
+        for (int i = 0; i < 4; ++i) {
+          if (skippable & (1 << i)) {
+            steps[i] = transparentSteps(params, glm::vec3(px[i], py[i], pz[i]),
+              glm::vec3(packet.dirX[i], packet.dirY[i], packet.dirZ[i]));
+          }
+        }
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(steps), tIncr));
+      }
+
+      t = _mm_add_ps(t, tIncr);
+      finished |= _mm_movemask_ps(_mm_cmpgt_ps(t, tEnd));
+    }
+
+    float r[4], g[4], b[4], a[4];
+    _mm_storeu_ps(r, resultR);
+    _mm_storeu_ps(g, resultG);
+    _mm_storeu_ps(b, resultB);
+    _mm_storeu_ps(a, resultA);
+    for (int i = 0; i < CpuRaycaster::PACKET_SIZE; ++i)
+      result[i] = glm::vec4(r[i], g[i], b[i], a[i]);
+
+    return numSamples;
+  }
+
+  /**
+  * Computes entry and exit point of the ray through the center of pixel (x, y), clipped against
+  * the near and far plane like the entry and exit point textures of RenderColorCube.
+  *
+  * @return false if the ray misses the proxy box
+  */
+  bool setupRay(const FrameParameters& params, int x, int y, glm::vec3& first, glm::vec3& direction, float& tEnd) {
+    glm::vec2 ndc((x + 0.5f) / params.size.x * 2.f - 1.f, (y + 0.5f) / params.size.y * 2.f - 1.f);
+    glm::vec4 nearPoint = params.ndcToTexture * glm::vec4(ndc, -1.f, 1.f);
+    glm::vec4 farPoint = params.ndcToTexture * glm::vec4(ndc, 1.f, 1.f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 delta = glm::vec3(farPoint) / farPoint.w - origin;
+
+    // slab test, s runs from the near to the far plane
+    float s0 = 0.f;
+    float s1 = 1.f;
+    for (int i = 0; i < 3; ++i) {
+      if (delta[i] == 0.f) {
+        if (origin[i] < params.texLlf[i] || origin[i] > params.texUrb[i])
+          return false;
+        continue;
+      }
+      float a = (params.texLlf[i] - origin[i]) / delta[i];
+      float b = (params.texUrb[i] - origin[i]) / delta[i];
+      s0 = std::max(s0, std::min(a, b));
+      s1 = std::min(s1, std::max(a, b));
+    }
+    if (!(s0 < s1))
+      return false;
+
+    // ray setup as in raySetup() of mod_raysetup.frag
+    first = origin + s0 * delta;
+    direction = (s1 - s0) * delta;
+    tEnd = glm::length(direction);
+    if (tEnd == 0.f)
+      return false;
+    direction /= tEnd;
+    return true;
+  }
+
+  /**
+  * Renders the image tile by tile, tiles are fetched by one worker thread per core.
+  * Adds the number of rays hitting the volume and the number of samples to \p numRays and \p numSamples.
+  */
+  template<class Sampler>
+  void renderTiles(const FrameParameters& params, const Sampler& volume, std::vector<glm::vec4>& output,
+    size_t& numRays, size_t& numSamples)
+  {
+    const int tilesX = (params.size.x + CpuRaycaster::TILE_SIZE - 1) / CpuRaycaster::TILE_SIZE;
+    const int tilesY = (params.size.y + CpuRaycaster::TILE_SIZE - 1) / CpuRaycaster::TILE_SIZE;
+    const int numTiles = tilesX * tilesY;
+    std::atomic<int> nextTile(0);
+    std::atomic<size_t> totalRays(0);
+    std::atomic<size_t> totalSamples(0);
+
+    auto worker = [&]() {
+      // samplers may cache data per thread
+      const Sampler sampler(volume);
+      size_t rays = 0;
+      size_t samples = 0;
+      for (int tile = nextTile++; tile < numTiles; tile = nextTile++) {
+        int tileX = (tile % tilesX) * CpuRaycaster::TILE_SIZE;
+        int tileY = (tile / tilesX) * CpuRaycaster::TILE_SIZE;
+        int endX = std::min(tileX + CpuRaycaster::TILE_SIZE, params.size.x);
+        int endY = std::min(tileY + CpuRaycaster::TILE_SIZE, params.size.y);
+
+        for (int y = tileY; y < endY; ++y) {
+          for (int x = tileX; x < endX; x += CpuRaycaster::PACKET_SIZE) {
+            RayPacket packet;
+            packet.lanes = 0;
+            for (int i = 0; i < CpuRaycaster::PACKET_SIZE; ++i) {
+              glm::vec3 first(0.f);
+              glm::vec3 direction(0.f);
+              float tEnd = -1.f;
+              if (x + i < endX && setupRay(params, x + i, y, first, direction, tEnd))
+                packet.lanes |= 1 << i;
+              packet.firstX[i] = first.x;
+              packet.firstY[i] = first.y;
+              packet.firstZ[i] = first.z;
+              packet.dirX[i] = direction.x;
+              packet.dirY[i] = direction.y;
+              packet.dirZ[i] = direction.z;
+              packet.tEnd[i] = tEnd;
+            }
+
+            // background needs no raycasting
+            if (!packet.lanes)
+              continue;
+
+            glm::vec4 result[CpuRaycaster::PACKET_SIZE];
+            rays += laneCount(packet.lanes);
+            samples += traversePacket(params, sampler, packet, result);
+            for (int i = 0; i < CpuRaycaster::PACKET_SIZE && x + i < endX; ++i) {
+              if (packet.lanes & (1 << i))
+                output[static_cast<size_t>(y) * params.size.x + x + i] = result[i];
+            }
+          }
+        }
+      }
+      totalRays += rays;
+      totalSamples += samples;
+    };
+
+    std::vector<std::thread> workers;
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 1; i < numThreads; ++i)
+      workers.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+
+    numRays += totalRays;
+    numSamples += totalSamples;
+  }
+
+  template<class T>
+  bool renderVolume(const FrameParameters& params, const tgt::VolumeRAM* volume, std::vector<glm::vec4>& output,
+    size_t& numRays, size_t& numSamples)
+  {
+    const tgt::VolumeAtomic<T>* typed = dynamic_cast<const tgt::VolumeAtomic<T>*>(volume);
+    if (!typed)
+      return false;
+
+    VoxelSampler<T> sampler(static_cast<const T*>(typed->getData()), params.dimensions);
+    renderTiles(params, sampler, output, numRays, numSamples);
+    return true;
+  }
+
+  template<class T>
+  bool renderVolume(const FrameParameters& params, const tgt::VolumeBricked* volume, std::vector<glm::vec4>& output,
+    size_t& numRays, size_t& numSamples)
+  {
+    const tgt::VolumeBrickedAtomic<T>* typed = dynamic_cast<const tgt::VolumeBrickedAtomic<T>*>(volume);
+    if (!typed)
+      return false;
+
+    BrickedVoxelSampler<T> sampler(typed);
+    renderTiles(params, sampler, output, numRays, numSamples);
+    return true;
+  }
+
+  /// Renders with the sampler of the voxel type of \p volume, returns false for unsupported types.
+  template<class V>
+  bool renderVolume(const FrameParameters& params, const V* volume, std::vector<glm::vec4>& output,
+    size_t& numRays, size_t& numSamples)
+  {
+    return renderVolume<uint8_t>(params, volume, output, numRays, numSamples)
+      || renderVolume<int8_t>(params, volume, output, numRays, numSamples)
+      || renderVolume<uint16_t>(params, volume, output, numRays, numSamples)
+      || renderVolume<int16_t>(params, volume, output, numRays, numSamples)
+      || renderVolume<uint32_t>(params, volume, output, numRays, numSamples)
+      || renderVolume<int32_t>(params, volume, output, numRays, numSamples)
+      || renderVolume<float>(params, volume, output, numRays, numSamples)
+      || renderVolume<double>(params, volume, output, numRays, numSamples);
+  }
+
+} // namespace anonymous
+
+namespace mivt {
+
+  const std::string CpuRaycaster::loggerCat_("CpuRaycaster");
+
+  CpuRaycaster::CpuRaycaster()
+    : VolumeRaycaster()
+    , numRays_(0)
+    , numSamples_(0)
+  {
+  }
+
+  CpuRaycaster::~CpuRaycaster()
+  {
+  }
+
+  void CpuRaycaster::Process(tgt::Volume* volume, tgt::Volume* level, tgt::Volume* mask, tgt::TransFunc1D* transfunc,
+    const tgt::Camera* camera, const glm::vec3& texLlf, const glm::vec3& texUrb,
+    const glm::ivec2& size, std::vector<glm::vec4>& output)
+  {
+    output.assign(static_cast<size_t>(std::max(size.x, 0)) * std::max(size.y, 0), glm::vec4(0.f));
+    numRays_ = 0;
+    numSamples_ = 0;
+    if (!volume || !level || !mask || !transfunc || !camera || output.empty())
+      return;
+
+    // volumes exceeding the memory budget are only available as bricks
+    const tgt::VolumeBricked* volumeBricked = level->hasRepresentation<tgt::VolumeRAM>() ? 0 : level->hasRepresentation<tgt::VolumeBricked>();
+    const tgt::VolumeRAM* volumeRAM = volumeBricked ? 0 : level->getRepresentation<tgt::VolumeRAM>();
+    const tgt::VolumeMask* maskBits = mask->hasRepresentation<tgt::VolumeMask>();
+    if (!(volumeRAM || volumeBricked) || !maskBits) {
+      LERROR("Volume or mask not available in RAM");
+      return;
+    }
+    if (maskBits->getDimensions() != volume->getDimensions()) {
+      LERROR("Mask dimensions do not match the volume");
+      return;
+    }
+
+    FrameParameters params;
+    params.ndcToTexture = level->getWorldToTextureMatrix()
+      * glm::inverse(camera->getProjectionMatrix(size) * camera->getViewMatrix());
+    params.texLlf = texLlf;
+    params.texUrb = texUrb;
+    params.size = size;
+
+    // texture coordinates are the same for all levels of the pyramid, so the mask and the
+    // occupancy grid of the full resolution volume are looked up with their own dimensions
+    tgt::ValueMapping rescaleMapping = level->getRescaleMapping();
+    params.dimensions = level->getDimensions();
+    params.textureToPhysicalScale = glm::vec3(params.dimensions) * level->getSpacing();
+    params.volumeOffset = level->getOffset();
+    params.gradientScale = 0.5f / level->getSpacing() * rescaleMapping.getScale();
+    params.vmScale = rescaleMapping.getScale();
+    params.vmOffset = rescaleMapping.getOffset();
+    params.mask = maskBits->isEmpty() ? 0 : maskBits;
+    params.maskDimensions = maskBits->getDimensions();
+
+    params.cameraPositionPhysical = glm::mapPoint(level->getWorldToPhysicalMatrix(), camera->getPosition());
+    params.lightAmbient = glm::vec3(lightAmbient_);
+    params.lightDiffuse = glm::vec3(lightDiffuse_);
+    params.lightSpecular = glm::vec3(lightSpecular_);
+    params.lightAttenuation = lightAttenuation_;
+    params.applyLightAttenuation = applyLightAttenuation_;
+    params.shininess = materialShininess_;
+
+    params.samplingStepSize = CalculateSamplingStepSize(level);
+    glm::vec2 windowing = transfunc->getWindowingDomain();
+    params.windowingScale = 1.f / (windowing.y - windowing.x);
+    params.windowingOffset = -windowing.x * params.windowingScale;
+
+    // pre-integrated classification always uses the table computed on the CPU
+    if (tgt::startsWith(classificationMode_, "pre-integrated")) {
+      params.classification = CLASSIFICATION_PRE_INTEGRATED;
+      params.table = preintegration_->getTable(transfunc, params.samplingStepSize);
+      params.tableSize = static_cast<int>(preintegration_->getResolution());
+    }
+    else if (classificationMode_ == "transfer-function") {
+      updateTransfuncTable(transfunc);
+      params.classification = CLASSIFICATION_TRANSFER_FUNCTION;
+      params.table = &lut_[0];
+      params.tableSize = static_cast<int>(lut_.size());
+    }
+    else {
+      params.classification = CLASSIFICATION_NONE;
+      params.table = 0;
+      params.tableSize = 0;
+    }
+
+    // empty space skipping
+    if (emptySpaceSkipping_)
+      updateOccupancyGrid(volume, transfunc);
+    params.skipEmptySpace = emptySpaceSkipping_;
+    params.occupancy = &occupancyGrid_->GetData()[0];
+    params.occupancyDimensions = occupancyGrid_->GetVolumeDimensions();
+    params.brickDimensions = occupancyGrid_->GetBrickDimensions();
+    params.brickSize = static_cast<float>(occupancyGrid_->GetBrickSize());
+
+    bool rendered = volumeBricked
+      ? renderVolume(params, volumeBricked, output, numRays_, numSamples_)
+      : renderVolume(params, volumeRAM, output, numRays_, numSamples_);
+    if (!rendered)
+      LERROR("Unsupported volume format: " << level->getFormat());
+  }
+
+  float CpuRaycaster::GetSamplesPerRay() const
+  {
+    return numRays_ ? static_cast<float>(numSamples_) / numRays_ : 0.f;
+  }
+
+  void CpuRaycaster::updateTransfuncTable(tgt::TransFunc1D* transfunc)
+  {
+    // same texels as TransFunc1D::updateTexture()
+    int width = transfunc->getDimensions().x;
+    lut_.resize(width);
+    transfunc->evaluate(&lut_[0], width);
+  }
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "volumeraycaster.h"
+#include <vector>
+
+namespace tgt {
+  class Camera;
+  class Volume;
+  class TransFunc1D;
+}
+
+namespace mivt {
+
+  /**
+  * Software implementation of rc_basic.frag for systems without OpenGL 3.3 support.
+  *
+  * Entry and exit points are computed analytically from the camera and the proxy box,
+  * the ray traversal (mask test, classification, gradient, Phong shading, DVR compositing
+  * and early ray termination) follows the fragment shader step by step.
+  *
+  * The image is split into tiles of TILE_SIZE x TILE_SIZE pixels which are processed by
+  * one worker thread per core. Inside a tile, PACKET_SIZE neighbouring rays are traversed
+  * together with SSE instructions, one ray per lane. Rays jump over bricks that are transparent
+  * for the transfer function like rc_basic.frag does with EMPTY_SPACE_SKIPPING.
+  */
+  class CpuRaycaster : public VolumeRaycaster
+  {
+  public:
+    /// Width and height of the image tiles distributed over the worker threads, a multiple of PACKET_SIZE.
+    static const int TILE_SIZE = 16;
+
+    /// Number of rays traversed together.
+    static const int PACKET_SIZE = 4;
+
+    CpuRaycaster();
+    virtual ~CpuRaycaster();
+
+    /**
+    * Renders the volume into a floating point image.
+    *
+    * @param volume the volume to render, the mask and the empty space skipping refer to its voxels
+    * @param level the volume that is sampled, either \p volume or a level of its tgt::VolumePyramid, needs a RAM representation
+    * @param mask mask volume of the same dimensions as \p volume holding a tgt::VolumeMask, set voxels are skipped
+    * @param transfunc the transfer function used for classification
+    * @param camera the scene's camera
+    * @param texLlf lower left front corner of the (clipped) proxy box in texture coordinates
+    * @param texUrb upper right back corner of the (clipped) proxy box in texture coordinates
+    * @param size the image size
+    * @param output receives size.x * size.y RGBA values as written by rc_basic.frag, bottom row first
+    */
+    void Process(tgt::Volume* volume, tgt::Volume* level, tgt::Volume* mask, tgt::TransFunc1D* transfunc,
+      const tgt::Camera* camera, const glm::vec3& texLlf, const glm::vec3& texUrb,
+      const glm::ivec2& size, std::vector<glm::vec4>& output);
+
+    /// Average number of samples taken per ray in the last call of Process(), rays missing the volume are not counted.
+    float GetSamplesPerRay() const;
+
+  private:
+    /// Fills lut_ with the texels of the transfer function texture.
+    void updateTransfuncTable(tgt::TransFunc1D* transfunc);
+
+    std::vector<glm::vec4> lut_;      ///< transfer function table for classification mode "transfer-function"
+    size_t numRays_;                  ///< statistics of the last frame
+    size_t numSamples_;
+
+    static const std::string loggerCat_;
+  };
+
+}
@@ -1,6 +1,11 @@
 #include "cubeproxygeometry.h"
 #include "volume.h"
 #include "trianglemeshgeometry.h"
+#include "volumestatistics.h"
+#include "occupancygrid.h"
+#include "volumerepresentation.h"
+
+#include <algorithm>
 #include "logmanager.h"
 
 namespace mivt {
@@ -15,8 +20,14 @@ namespace mivt {
     , clipBack_(1e5f)
     , clipBottom_(0.f)
     , clipTop_(1e5f)
+    , texLlf_(0.f)
+    , texUrb_(1.f)
     , volume_(0)
     , geometry_(0)
+    , proxyMode_("cube")
+    , occupancyGrid_(0)
+    , gridVersion_(0)
+    , boxesValid_(false)
   {
   }
 
@@ -34,9 +45,37 @@ namespace mivt {
   void CubeProxyGeometry::SetVolume(tgt::Volume *volume)
   {
     volume_ = volume;
+    boxesValid_ = false;
     adjustClipPropertiesRanges();
   }
 
+  void CubeProxyGeometry::SetProxyMode(const std::string& mode)
+  {
+    if (mode != "cube" && mode != "occupancy") {
+      LWARNING("Unknown proxy mode: " << mode);
+      return;
+    }
+    proxyMode_ = mode;
+  }
+
+  std::string CubeProxyGeometry::GetProxyMode()
+  {
+    return proxyMode_;
+  }
+
+  void CubeProxyGeometry::SetOccupancyGrid(const OccupancyGrid* grid)
+  {
+    occupancyGrid_ = grid;
+    boxesValid_ = false;
+  }
+
+  void CubeProxyGeometry::Update()
+  {
+    if (volume_ && proxyMode_ == "occupancy" && occupancyGrid_
+      && (!boxesValid_ || occupancyGrid_->GetVersion() != gridVersion_))
+      Process();
+  }
+
   void CubeProxyGeometry::adjustClipPropertiesRanges()
   {
     if (!volume_) {
@@ -151,16 +190,96 @@ namespace mivt {
       texUrb = noClippingTexUrb;
     }
 
+    tgt::TriangleMeshGeometryVec4Vec3* mesh = 0;
+
+    // the grid may still belong to the previous volume, it is used as soon as it is classified again
+    if (proxyMode_ == "occupancy" && occupancyGrid_ && occupancyGrid_->GetBrickDimensions()
+      == tgt::VolumeStatistics::getBrickDimensions(numSlices, occupancyGrid_->GetBrickSize())) {
+      if (!boxesValid_ || occupancyGrid_->GetVersion() != gridVersion_)
+        mergeBricks();
+
+      // clipping only shrinks the merged boxes
+      glm::ivec3 numBricks = occupancyGrid_->GetBrickDimensions();
+      glm::vec3 boxesLlf(1.f);
+      glm::vec3 boxesUrb(0.f);
+      mesh = new tgt::TriangleMeshGeometryVec4Vec3();
+      for (size_t i = 0; i < boxes_.size(); i += 2) {
+        glm::vec3 boxLlf, boxUrb;
+        for (int axis = 0; axis < 3; ++axis) {
+          boxLlf[axis] = std::max(brickToTexture(boxes_[i][axis], numBricks[axis], numSlices[axis]), texLlf[axis]);
+          boxUrb[axis] = std::min(brickToTexture(boxes_[i + 1][axis], numBricks[axis], numSlices[axis]), texUrb[axis]);
+        }
+        if (glm::any(glm::greaterThanEqual(boxLlf, boxUrb)))
+          continue;
+
+        // the color encodes the texture coordinates of the entry and exit points
+        mesh->addCube(tgt::VertexVec3(boxLlf, boxLlf), tgt::VertexVec3(boxUrb, boxUrb));
+        boxesLlf = glm::min(boxesLlf, boxLlf);
+        boxesUrb = glm::max(boxesUrb, boxUrb);
+      }
+
+      // without visible bricks the clipped cube is kept, the raycaster finds nothing to composite anyway
+      if (mesh->isEmpty()) {
+        DELPTR(mesh);
+      }
+      else {
+        texLlf = boxesLlf;
+        texUrb = boxesUrb;
+      }
+    }
+
+    if (!mesh)
+      mesh = tgt::TriangleMeshGeometryVec4Vec3::createCube(texLlf, texUrb, texLlf, texUrb, 1.0f);
+
+    texLlf_ = texLlf;
+    texUrb_ = texUrb;
+
     DELPTR(geometry_);
-    geometry_ = tgt::TriangleMeshGeometryVec4Vec3::createCube(texLlf, texUrb, texLlf, texUrb, 1.0f);
+    geometry_ = mesh;
     geometry_->transform(volume_->getTextureToWorldMatrix());
   }
 
+  void CubeProxyGeometry::mergeBricks()
+  {
+    // merging clears the flags, so it works on a copy of the grid
+    std::vector<unsigned char> occupied = occupancyGrid_->GetData();
+    std::vector<tgt::VolumeRepresentation::Region> regions = tgt::mergeBricks(occupied, occupancyGrid_->GetBrickDimensions());
+
+    boxes_.clear();
+    for (size_t i = 0; i < regions.size(); ++i) {
+      boxes_.push_back(regions[i].llf_);
+      boxes_.push_back(regions[i].urb_);
+    }
+
+    gridVersion_ = occupancyGrid_->GetVersion();
+    boxesValid_ = true;
+  }
+
+  float CubeProxyGeometry::brickToTexture(int border, int numBricks, int numSlices) const
+  {
+    // brick i covers the samples between the voxel centers i * brickSize and (i + 1) * brickSize
+    if (border <= 0)
+      return 0.f;
+    if (border >= numBricks)
+      return 1.f;
+    return std::min((border * occupancyGrid_->GetBrickSize() + 0.5f) / numSlices, 1.f);
+  }
+
   tgt::Geometry* CubeProxyGeometry::GetGeometry()
   {
     return geometry_;
   }
 
+  glm::vec3 CubeProxyGeometry::GetTexLlf()
+  {
+    return texLlf_;
+  }
+
+  glm::vec3 CubeProxyGeometry::GetTexUrb()
+  {
+    return texUrb_;
+  }
+
   float CubeProxyGeometry::GetClipRight()
   {
     return clipRight_;
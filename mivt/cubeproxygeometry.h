@@ -1,5 +1,7 @@
 #pragma once
+#include "tgt_math.h"
 #include <string>
+#include <vector>
 
 namespace tgt {
   class Volume;
@@ -8,6 +10,15 @@ namespace tgt {
 
 namespace mivt {
 
+  class OccupancyGrid;
+
+  /**
+  * Creates the proxy geometry whose faces are rasterized into the entry and exit points of the raycaster.
+  *
+  * In "cube" mode the proxy is the bounding box of the volume shrunk by the clip planes. In "occupancy" mode
+  * it is the union of the occupied bricks of an OccupancyGrid, merged into as few boxes as possible and
+  * clipped against the same box, so the rays start at the first brick that may contain visible samples.
+  */
   class CubeProxyGeometry
   {
   public:
@@ -18,6 +29,17 @@ namespace mivt {
 
     void Process();
 
+    /**
+    * Selects the proxy geometry, "cube" or "occupancy".
+    * The occupancy grid is only used in "occupancy" mode and has to be classified for the current volume.
+    */
+    void SetProxyMode(const std::string& mode);
+    std::string GetProxyMode();
+    void SetOccupancyGrid(const OccupancyGrid* grid);
+
+    /// Calls Process() if the occupancy grid changed since the geometry was created.
+    void Update();
+
     void ChangeClipRight(float val);
     void ChangeClipLeft(float val);
     void ChangeClipBack(float val);
@@ -38,10 +60,20 @@ namespace mivt {
 
     tgt::Geometry* GetGeometry();
 
+    /// Corners of the proxy box of the last Process() call in texture coordinates.
+    glm::vec3 GetTexLlf();
+    glm::vec3 GetTexUrb();
+
   private:
     /// Adapt ranges of clip plane properties to the input volume's dimensions.
     void adjustClipPropertiesRanges();
 
+    /// Merges the occupied bricks of the grid into boxes, see boxes_.
+    void mergeBricks();
+
+    /// Texture coordinate of the brick border index along one axis, the outer borders map to 0 and 1.
+    float brickToTexture(int border, int numBricks, int numSlices) const;
+
   private:
     bool enableClipping_;    ///< Clipping enable / disable property.
     float clipRight_;        ///< Right clipping plane position (x).
@@ -51,9 +83,18 @@ namespace mivt {
     float clipBottom_;       ///< Bottom clipping plane position property (z).
     float clipTop_;          ///< Top clipping plane position property (-z).
 
+    glm::vec3 texLlf_;       ///< Lower left front corner of the proxy box in texture coordinates.
+    glm::vec3 texUrb_;       ///< Upper right back corner of the proxy box in texture coordinates.
+
     tgt::Volume *volume_;
     tgt::Geometry *geometry_;
 
+    std::string proxyMode_;               ///< "cube" or "occupancy"
+    const OccupancyGrid *occupancyGrid_;
+    unsigned int gridVersion_;            ///< version of occupancyGrid_ boxes_ were merged from
+    bool boxesValid_;
+    std::vector<glm::ivec3> boxes_;       ///< pairs of first and last + 1 brick of the merged boxes
+
     static const std::string loggerCat_;
   };
 
@@ -45,4 +45,43 @@ bool earlyRayTermination(inout float opacity, in float maxOpacity) {
 // Reduced loop count to 255*255 due to NVIDIA hang-up bug with driver version > 275.33 (jsp)
 #define RAYCASTING_LOOP_COUNT 255*255
 #define WHILE(keepGoing) for (int loop=0; keepGoing && loop<RAYCASTING_LOOP_COUNT; loop++) {
-#define END_WHILE }
\ No newline at end of file
+#define END_WHILE }
+
+/**
+* Parameters of the occupancy grid used for empty space skipping, see OccupancyGrid.
+* The occupancy texture holds one texel per brick, which is zero if all
+* samples inside the brick are transparent.
+*/
+struct OccupancyParameters {
+  vec3 volumeDimensions_;         // dimensions of the volume the grid was computed from
+  vec3 brickCount_;               // number of bricks along each axis
+  float brickSize_;               // edge length of a brick in voxels
+  float brickSizeRCP_;
+};
+
+/***
+* Returns the number of sampling steps the ray can skip after samplePos, which is zero
+* unless samplePos lies in a transparent brick. The ray continues with the last sample
+* inside the brick, so lastIntensity is still valid for pre-integrated classification.
+* The bricks are addressed in voxels of the full resolution volume, also while a coarser
+* level of its pyramid is rendered.
+***/
+float transparentSteps(sampler3D occupancy, OccupancyParameters occupancyStruct,
+                       vec3 samplePos, vec3 rayDirection, float tIncr) {
+  vec3 voxelPos = samplePos * occupancyStruct.volumeDimensions_ - 0.5;
+  vec3 brick = clamp(floor(voxelPos * occupancyStruct.brickSizeRCP_), vec3(0.0), occupancyStruct.brickCount_ - 1.0);
+  if (texelFetch(occupancy, ivec3(brick), 0).r > 0.0)
+    return 0.0;
+
+  // distance to the brick exit, the bricks at the border extend to infinity like GL_CLAMP_TO_EDGE
+  vec3 voxelDirection = rayDirection * occupancyStruct.volumeDimensions_;
+  vec3 zeroDirection = vec3(equal(voxelDirection, vec3(0.0)));
+  vec3 positive = step(0.0, voxelDirection);
+  vec3 bound = (brick + positive) * occupancyStruct.brickSize_;
+  vec3 open = mix(vec3(equal(brick, vec3(0.0))), vec3(equal(brick, occupancyStruct.brickCount_ - 1.0)), positive);
+  vec3 tBound = (bound - voxelPos) / (voxelDirection + zeroDirection);
+  tBound = mix(tBound, vec3(1.0e30), max(open, zeroDirection));
+  float tExit = min(min(tBound.x, tBound.y), tBound.z);
+
+  return clamp(ceil(tExit / tIncr) - 2.0, 0.0, float(RAYCASTING_LOOP_COUNT));
+}
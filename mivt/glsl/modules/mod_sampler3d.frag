@@ -46,6 +46,17 @@ float textureLookup3DMapped(sampler3D volume, VolumeParameters volumeStruct, vec
   return result.r;
 }
 
+/*
+* Nearest neighbour lookup of a bit-packed mask, see tgt::VolumeMask::pack().
+* Returns true if the voxel at texCoords is set.
+*/
+bool maskLookup(usampler3D mask, VolumeParameters maskStruct, vec3 texCoords) {
+  ivec3 dims = ivec3(maskStruct.datasetDimensions_);
+  ivec3 voxel = clamp(ivec3(texCoords * maskStruct.datasetDimensions_), ivec3(0), dims - 1);
+  uint word = texelFetch(mask, ivec3(voxel.x >> 5, voxel.yz), 0).r;
+  return ((word >> uint(voxel.x & 31)) & 1u) != 0u;
+}
+
 vec3 texToPhysical(vec3 samplePos, VolumeParameters volumeParams) {
   return ((samplePos*volumeParams.datasetDimensions_)*volumeParams.datasetSpacing_) + volumeParams.volumeOffset_;
 }
@@ -17,16 +17,31 @@ uniform sampler2D exitPointsDepth_;         // ray exit points depth
 uniform TextureParameters exitParameters_;  // ray exit texture parameters
 
 uniform sampler3D volume_;                  // volume texture
+uniform usampler3D mask_;                   // mask texture, 32 voxels per texel
+
+#ifdef VOLUME_PARAMETER_BLOCKS
+// each struct is uploaded in one buffer update, see VolumeRaycaster::setUniformBlock()
+layout(std140) uniform volumeStruct_Block {
+  VolumeParameters volumeStruct_;           // volume texture parameters
+};
+layout(std140) uniform maskStruct_Block {
+  VolumeParameters maskStruct_;             // mask texture parameters
+};
+#else
 uniform VolumeParameters volumeStruct_;     // volume texture parameters
-
-uniform sampler3D mask_;                    // mask texture
 uniform VolumeParameters maskStruct_;       // mask texture parameters
+#endif
 
 uniform TF_SAMPLER_TYPE transFuncTex_;        // transfunc texture
 uniform TransFuncParameters transFuncStruct_; // transfunc texture parameters
 
 uniform float samplingStepSize_;            // sampling step
 
+#ifdef EMPTY_SPACE_SKIPPING
+uniform sampler3D occupancy_;                 // occupancy grid, one texel per brick
+uniform OccupancyParameters occupancyStruct_; // occupancy grid parameters
+#endif
+
 
 vec4 rayTraversal(in vec3 first, in vec3 last, float entryDepth, float exitDepth) {
 
@@ -44,8 +59,7 @@ vec4 rayTraversal(in vec3 first, in vec3 last, float entryDepth, float exitDepth
 
   WHILE(!finished) {
     vec3 samplePos = first + t * rayDirection;
-    float mask = textureLookup3DMapped(mask_, maskStruct_, samplePos);
-    if (mask == 0) {
+    if (!maskLookup(mask_, maskStruct_, samplePos)) {
       float intensity = textureLookup3DMapped(volume_, volumeStruct_, samplePos);
 
       // apply classification
@@ -72,6 +86,11 @@ vec4 rayTraversal(in vec3 first, in vec3 last, float entryDepth, float exitDepth
       lastIntensity = intensity;
     }
 
+#ifdef EMPTY_SPACE_SKIPPING
+    // jump over transparent bricks
+    t += transparentSteps(occupancy_, occupancyStruct_, samplePos, rayDirection, tIncr) * tIncr;
+#endif
+
     t += tIncr;
     finished = finished || (t > tEnd);
   } END_WHILE
@@ -0,0 +1,160 @@
+#include "occupancygrid.h"
+#include "volume.h"
+#include "volumebrickminmax.h"
+#include "volumetexture.h"
+#include "transfunc1d.h"
+
+#include <algorithm>
+
+namespace mivt {
+
+  OccupancyGrid::OccupancyGrid()
+    : bricks_(0)
+    , windowing_(0.f)
+    , vmScale_(1.f)
+    , vmOffset_(0.f)
+    , version_(0)
+    , tex_(0)
+    , texInvalid_(true)
+  {
+    Reset();
+  }
+
+  OccupancyGrid::~OccupancyGrid()
+  {
+    DELPTR(tex_);
+  }
+
+  void OccupancyGrid::Update(tgt::Volume* volume, tgt::TransFunc1D* transfunc, int tableSize)
+  {
+    const tgt::VolumeBrickMinMax* bricks = volume ? volume->getDerivedData<tgt::VolumeBrickMinMax>() : 0;
+    glm::vec2 windowing = transfunc ? transfunc->getWindowingDomain() : glm::vec2(0.f);
+    if (!bricks || tableSize < 2 || !(windowing.y > windowing.x)) {
+      Reset();
+      return;
+    }
+
+    // the same table entries as CpuRaycaster::updateTransfuncTable() and PreIntegration::computeTable()
+    std::vector<glm::vec4> entries(tableSize);
+    transfunc->evaluate(&entries[0], tableSize);
+    std::vector<uint8_t> visibleEntries(tableSize);
+    for (int x = 0; x < tableSize; ++x)
+      visibleEntries[x] = entries[x].a > 0.f ? 1 : 0;
+
+    tgt::ValueMapping rescaleMapping = volume->getRescaleMapping();
+    if (bricks == bricks_ && visibleEntries == visibleEntries_ && windowing == windowing_
+      && rescaleMapping.getScale() == vmScale_ && rescaleMapping.getOffset() == vmOffset_)
+      return;
+
+    bricks_ = bricks;
+    volumeDimensions_ = volume->getDimensions();
+    visibleEntries_.swap(visibleEntries);
+    windowing_ = windowing;
+    vmScale_ = rescaleMapping.getScale();
+    vmOffset_ = rescaleMapping.getOffset();
+
+    // number of visible entries in front of each entry
+    std::vector<int> visibleSum(tableSize + 1, 0);
+    for (int x = 0; x < tableSize; ++x)
+      visibleSum[x + 1] = visibleSum[x] + visibleEntries_[x];
+
+    // maps raw values to table coordinates, entry x is centered at x
+    float scale = vmScale_ / (windowing_.y - windowing_.x) * tableSize;
+    float offset = (vmOffset_ - windowing_.x) / (windowing_.y - windowing_.x) * tableSize - 0.5f;
+
+    const std::vector<float>& minValues = bricks_->getMinValues();
+    const std::vector<float>& maxValues = bricks_->getMaxValues();
+    std::vector<uint8_t> data(bricks_->getNumBricks());
+    for (size_t i = 0; i < data.size(); ++i) {
+      float lower = minValues[i] * scale + offset;
+      float upper = maxValues[i] * scale + offset;
+      if (lower > upper)
+        std::swap(lower, upper);
+
+      // entries outside the table read the zero border color
+      float first = std::max(std::floor(lower), 0.f);
+      float last = std::min(std::floor(upper) + 1.f, tableSize - 1.f);
+      data[i] = (first <= last && visibleSum[static_cast<int>(last) + 1] > visibleSum[static_cast<int>(first)]) ? 1 : 0;
+    }
+
+    // transfer function edits often keep the classification of all bricks
+    if (data != data_ || bricks_->getBrickDimensions() != brickDimensions_) {
+      brickDimensions_ = bricks_->getBrickDimensions();
+      data_.swap(data);
+      ++version_;
+      texInvalid_ = true;
+    }
+  }
+
+  void OccupancyGrid::Reset()
+  {
+    if (bricks_ || data_.size() != 1) {
+      bricks_ = 0;
+      visibleEntries_.clear();
+      volumeDimensions_ = glm::ivec3(1);
+      brickDimensions_ = glm::ivec3(1);
+      data_.assign(1, 1);
+      ++version_;
+      texInvalid_ = true;
+    }
+  }
+
+  glm::ivec3 OccupancyGrid::GetBrickDimensions() const
+  {
+    return brickDimensions_;
+  }
+
+  glm::ivec3 OccupancyGrid::GetVolumeDimensions() const
+  {
+    return volumeDimensions_;
+  }
+
+  int OccupancyGrid::GetBrickSize() const
+  {
+    return tgt::VolumeBrickMinMax::BRICK_SIZE;
+  }
+
+  const std::vector<uint8_t>& OccupancyGrid::GetData() const
+  {
+    return data_;
+  }
+
+  unsigned int OccupancyGrid::GetVersion() const
+  {
+    return version_;
+  }
+
+  float OccupancyGrid::GetOccupancy() const
+  {
+    return static_cast<float>(std::count(data_.begin(), data_.end(), 1)) / data_.size();
+  }
+
+  const tgt::Texture* OccupancyGrid::GetTexture()
+  {
+    if (tex_ && tex_->getDimensions() != brickDimensions_)
+      DELPTR(tex_);
+
+    if (!tex_) {
+      tex_ = new tgt::VolumeTexture(0, brickDimensions_, GL_RED, GL_R8, GL_UNSIGNED_BYTE, tgt::Texture::NEAREST);
+      tex_->setWrapping(tgt::Texture::CLAMP_TO_EDGE);
+      texInvalid_ = true;
+    }
+
+    if (texInvalid_) {
+      // one byte per brick, rows are not padded
+      GLint alignment = 4;
+      glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      tex_->setPixelData(&data_[0]);
+      tex_->uploadTexture();
+      glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+      LGL_ERROR;
+
+      // prevent deleting twice
+      tex_->setPixelData(0);
+      texInvalid_ = false;
+    }
+    return tex_;
+  }
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "tgt_math.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace tgt {
+  class Volume;
+  class VolumeBrickMinMax;
+  class TransFunc1D;
+  class Texture;
+}
+
+namespace mivt {
+
+  /**
+  * Marks the bricks of a volume that may contain visible samples for the current
+  * transfer function, so the raycasters can jump over transparent bricks.
+  *
+  * The grid is derived from the tgt::VolumeBrickMinMax of the volume: a brick is transparent
+  * if the classification table has zero opacity over the brick's value range after rescaling
+  * and windowing. The range is widened by one table entry on both sides, which covers the
+  * nearest lookup of the transfer function as well as the bilinear lookup of the pre-integration table.
+  */
+  class OccupancyGrid
+  {
+  public:
+    OccupancyGrid();
+    ~OccupancyGrid();
+
+    /**
+    * Reclassifies the bricks if the volume, the opacities of the transfer function or the windowing changed.
+    *
+    * @param volume the rendered volume, its brick table is computed if not available yet
+    * @param transfunc the transfer function used for classification
+    * @param tableSize number of entries of the classification table (transfer function width or pre-integration resolution)
+    */
+    void Update(tgt::Volume* volume, tgt::TransFunc1D* transfunc, int tableSize);
+
+    /// Replaces the grid by a single occupied brick, which disables skipping.
+    void Reset();
+
+    /// Number of bricks along each axis.
+    glm::ivec3 GetBrickDimensions() const;
+
+    /**
+    * Dimensions of the volume the grid was computed from. Brick lookups have to use them instead of the
+    * dimensions of the rendered volume, which may be a coarser level of its pyramid during interaction.
+    */
+    glm::ivec3 GetVolumeDimensions() const;
+
+    /// Edge length of the bricks in voxels.
+    int GetBrickSize() const;
+
+    /// One value per brick, x-fastest, non-zero if the brick may contain visible samples.
+    const std::vector<uint8_t>& GetData() const;
+
+    /// Incremented whenever GetData() changes.
+    unsigned int GetVersion() const;
+
+    /// Fraction of occupied bricks.
+    float GetOccupancy() const;
+
+    /// Returns a GL_R8 3D texture with one texel per brick, it is uploaded again after changes of the grid.
+    const tgt::Texture* GetTexture();
+
+  private:
+    const tgt::VolumeBrickMinMax* bricks_;  ///< brick table the grid was computed from
+    std::vector<uint8_t> visibleEntries_;   ///< 1 for classification table entries with opacity > 0
+    glm::vec2 windowing_;
+    float vmScale_;
+    float vmOffset_;
+
+    glm::ivec3 volumeDimensions_;
+    glm::ivec3 brickDimensions_;
+    std::vector<uint8_t> data_;
+    unsigned int version_;
+
+    tgt::Texture* tex_;
+    bool texInvalid_;                       ///< true if data_ changed since the last upload
+  };
+
+}
@@ -4,11 +4,40 @@
 #include "rendertarget.h"
 #include "shadermanager.h"
 
+#include <emmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
 using glm::vec2;
 using glm::vec3;
 using glm::vec4;
 using glm::col3;
 
+namespace {
+
+  /// Runs body(row) for all rows of [0, numRows), handed out one at a time to the calling thread and worker threads.
+  template<class F>
+  void forEachRow(int numRows, const F& body) {
+    std::atomic<int> nextRow(0);
+    auto worker = [&]() {
+      for (int row = nextRow++; row < numRows; row = nextRow++)
+        body(row);
+    };
+
+    std::vector<std::thread> workers;
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 1; i < numThreads; ++i)
+      workers.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+  }
+
+} // namespace anonymous
+
 namespace mivt {
 
   PreIntegration::PreIntegration(size_t resolution, bool computeOnGPU, bool useIntegral)
@@ -19,8 +48,12 @@ namespace mivt {
     , computeOnGPU_(computeOnGPU)
     , table_(0)
     , tex_(0)
+    , texInvalid_(true)
     , renderTarget_(0)
     , program_(0)
+    , tableStepSize_(0)
+    , tableHash_(0)
+    , cacheMemoryLimit_(DEFAULT_CACHE_MEMORY_LIMIT)
   {
     //check values
     if (resolution <= 1)
@@ -35,9 +68,8 @@ namespace mivt {
       program_ = ShdrMgr.loadSeparate("passthrough.vert", "preintegration.frag", "", false);
     }
     else {
+      // the texture is created on first use, so the table alone can be used without OpenGL
       table_ = new vec4[resolution_ * resolution_];
-      tex_ = new tgt::Texture(glm::ivec3(static_cast<int>(resolution_),
-        static_cast<int>(resolution_), 1), GL_RGBA, GL_RGBA32F, GL_FLOAT, tgt::Texture::LINEAR);
     }
   }
 
@@ -54,6 +86,10 @@ namespace mivt {
     else {
       DELARR(table_);
       DELPTR(tex_);
+      for (std::list<CacheEntry>::iterator it = cache_.begin(); it != cache_.end(); ++it) {
+        delete[] it->table_;
+        delete it->tex_;
+      }
     }
   }
 
@@ -65,52 +101,10 @@ namespace mivt {
     //buffer for TF values
     vec4* tfBuffer = new vec4[resolution_];
 
-    vec2 domain = transFunc_->getWindowingDomain();
-    for (int x = 0; x < resolution_; ++x) {
-      float value = (float)x / (resolution_ - 1) * (domain.y - domain.x) + domain.x;
-      col3 color = transFunc_->getMappingForColorValue(value);
-      float alpha = transFunc_->getMappingForAlphaValue(value);
-      tfBuffer[x] = vec4(vec3(color) / 255.f, alpha);
-    }
+    transFunc_->evaluate(tfBuffer, static_cast<int>(resolution_));
 
     if (!useIntegral_) { // Correct (but slow) calculation of PI-table:
-      int lookupindex = 0;
-      for (int sb = 0; sb < static_cast<int>(resolution_); ++sb) {
-        for (int sf = 0; sf < static_cast<int>(resolution_); ++sf) {
-          if (sb != sf) {
-            float scale = 1.0f / fabs(static_cast<float>(sf - sb));
-
-            int incr = 1;
-            if (sf < sb)
-              incr = -1;
-
-            vec4 result = vec4(0.0f);
-            for (int s = sb; (incr == 1 ? s <= sf : s >= sf) && (result.a < 0.95); s += incr) {
-              vec4 curCol = tfBuffer[s];
-
-              if (curCol.a > 0.0f) {
-                // apply opacity correction to accomodate for variable sampling intervals
-                curCol.a = 1.f - pow(1.f - curCol.a, samplingStepSize_ * 200.0f * scale);
-
-                //actual compositing
-                result.x += (1.0f - result.a) * curCol.a * curCol.x;
-                result.y += (1.0f - result.a) * curCol.a * curCol.y;
-                result.z += (1.0f - result.a) * curCol.a * curCol.z;
-                result.a += (1.0f - result.a) * curCol.a;
-              }
-            }
-            result.x /= glm::max(result.a, 0.001f);
-            result.y /= glm::max(result.a, 0.001f);
-            result.z /= glm::max(result.a, 0.001f);
-            result.a = 1.f - pow(1.f - result.a, 1.0f / (samplingStepSize_ * 200.0f));
-            table_[lookupindex] = glm::clamp(result, 0.f, 1.f);
-          }
-          else {
-            table_[lookupindex] = glm::clamp(tfBuffer[sf], 0.f, 1.f);
-          }
-          lookupindex++;
-        }
-      }
+      computeTableSampled(tfBuffer);
     }
     else { //faster version using integral functions, see Real-Time Volume Graphics, p96
       //compute integral functions
@@ -173,23 +167,156 @@ namespace mivt {
     delete[] tfBuffer;
   }
 
+  void PreIntegration::computeTableSampled(const vec4* tfBuffer)
+  {
+    const int resolution = static_cast<int>(resolution_);
+
+    // only the entries integrating over changed TF values [first, last] are recomputed,
+    // all of them if the segment length changed
+    int first = 0;
+    int last = resolution - 1;
+    if (tableStepSize_ == samplingStepSize_ && tfValues_.size() == resolution_) {
+      first = resolution;
+      last = -1;
+      for (int x = 0; x < resolution; ++x) {
+        if (tfValues_[x] != tfBuffer[x]) {
+          first = std::min(first, x);
+          last = x;
+        }
+      }
+      if (first > last)
+        return;
+    }
+
+    // opacity correction of every TF value for every segment length n = |sf - sb|, as done per sample before
+    if (opacityCorrection_.size() != resolution_ * resolution_)
+      opacityCorrection_.assign(resolution_ * resolution_, 0.f);
+    forEachRow(resolution, [&](int n) {
+      if (n == 0)
+        return;
+      float scale = 1.0f / fabs(static_cast<float>(n));
+      float* correction = &opacityCorrection_[static_cast<size_t>(n) * resolution];
+      for (int s = first; s <= last; ++s) {
+        float alpha = tfBuffer[s].a;
+        correction[s] = alpha > 0.0f ? 1.f - pow(1.f - alpha, samplingStepSize_ * 200.0f * scale) : 0.0f;
+      }
+    });
+
+    // an entry integrates the TF values between sb and sf
+    forEachRow(resolution, [&](int sb) {
+      int begin = 0;
+      int end = resolution;
+      if (sb < first)
+        begin = first;
+      else if (sb > last)
+        end = last + 1;
+
+      vec4* row = table_ + static_cast<size_t>(sb) * resolution;
+      compositeSegments(tfBuffer, sb, begin, std::min(end, sb), row);
+      if (begin <= sb && sb < end)
+        row[sb] = glm::clamp(tfBuffer[sb], 0.f, 1.f);
+      compositeSegments(tfBuffer, sb, std::max(begin, sb + 1), end, row);
+    });
+
+    tfValues_.assign(tfBuffer, tfBuffer + resolution);
+    tableStepSize_ = samplingStepSize_;
+  }
+
+  void PreIntegration::compositeSegments(const vec4* tfBuffer, int sb, int sfBegin, int sfEnd, vec4* row) const
+  {
+    const int resolution = static_cast<int>(resolution_);
+    const int incr = sfBegin > sb ? 1 : -1;
+    const __m128 one = _mm_set1_ps(1.0f);
+    // result.a < 0.95 compares in double precision, which is true exactly for the floats <= 0.95f
+    const __m128 opaque = _mm_set1_ps(0.95f);
+    const float alphaExponent = 1.0f / (samplingStepSize_ * 200.0f);
+
+    // four entries sf of the row are composited at once, all of them start at sb and step into the same direction
+    for (int sf = sfBegin; sf < sfEnd; sf += 4) {
+      const int numLanes = std::min(4, sfEnd - sf);
+      int numSamples[4];
+      const float* correction[4];
+      int maxSamples = 0;
+      for (int i = 0; i < 4; ++i) {
+        int n = std::abs(sf + std::min(i, numLanes - 1) - sb);
+        numSamples[i] = i < numLanes ? n + 1 : 0;
+        correction[i] = &opacityCorrection_[static_cast<size_t>(n) * resolution];
+        maxSamples = std::max(maxSamples, numSamples[i]);
+      }
+      const __m128i samples = _mm_setr_epi32(numSamples[0], numSamples[1], numSamples[2], numSamples[3]);
+
+      __m128 resultX = _mm_setzero_ps();
+      __m128 resultY = _mm_setzero_ps();
+      __m128 resultZ = _mm_setzero_ps();
+      __m128 resultA = _mm_setzero_ps();
+      for (int k = 0; k < maxSamples; ++k) {
+        __m128 active = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(samples, _mm_set1_epi32(k))),
+          _mm_cmple_ps(resultA, opaque));
+        if (!_mm_movemask_ps(active))
+          break;
+
+        const int s = sb + k * incr;
+        const vec4& curCol = tfBuffer[s];
+        if (curCol.a > 0.0f) {
+          __m128 alpha = _mm_setr_ps(correction[0][s], correction[1][s], correction[2][s], correction[3][s]);
+          __m128 weight = _mm_mul_ps(_mm_sub_ps(one, resultA), alpha);
+          __m128 x = _mm_add_ps(resultX, _mm_mul_ps(weight, _mm_set1_ps(curCol.x)));
+          __m128 y = _mm_add_ps(resultY, _mm_mul_ps(weight, _mm_set1_ps(curCol.y)));
+          __m128 z = _mm_add_ps(resultZ, _mm_mul_ps(weight, _mm_set1_ps(curCol.z)));
+          __m128 a = _mm_add_ps(resultA, weight);
+          resultX = _mm_or_ps(_mm_and_ps(active, x), _mm_andnot_ps(active, resultX));
+          resultY = _mm_or_ps(_mm_and_ps(active, y), _mm_andnot_ps(active, resultY));
+          resultZ = _mm_or_ps(_mm_and_ps(active, z), _mm_andnot_ps(active, resultZ));
+          resultA = _mm_or_ps(_mm_and_ps(active, a), _mm_andnot_ps(active, resultA));
+        }
+      }
+
+      float x[4], y[4], z[4], a[4];
+      _mm_storeu_ps(x, resultX);
+      _mm_storeu_ps(y, resultY);
+      _mm_storeu_ps(z, resultZ);
+      _mm_storeu_ps(a, resultA);
+      for (int i = 0; i < numLanes; ++i) {
+        vec4 result(x[i], y[i], z[i], a[i]);
+        result.x /= glm::max(result.a, 0.001f);
+        result.y /= glm::max(result.a, 0.001f);
+        result.z /= glm::max(result.a, 0.001f);
+        result.a = 1.f - pow(1.f - result.a, alphaExponent);
+        row[sf + i] = glm::clamp(result, 0.f, 1.f);
+      }
+    }
+  }
+
+  bool PreIntegration::isTableInvalid(tgt::TransFunc1D *transFunc, float d) const
+  {
+    return transFunc != transFunc_ || samplingStepSize_ != d || transFunc->isPreinteTextureInvalid();
+  }
+
   const tgt::Texture* PreIntegration::getTexture(tgt::TransFunc1D *transFunc, float d)
   {
-    if (transFunc != transFunc_ || samplingStepSize_ != d || transFunc->isPreinteTextureInvalid()) 
-    {
-      transFunc_ = transFunc;
-      samplingStepSize_ = d;
-      transFunc->validPreinteTexture();
+    if (computeOnGPU_) {
+      if (isTableInvalid(transFunc, d)) {
+        transFunc_ = transFunc;
+        samplingStepSize_ = d;
+        transFunc->validPreinteTexture();
 
-      if (computeOnGPU_) {
         computeTableGPU();
         LGL_ERROR;
 
         //set output texture
         tex_ = renderTarget_->getColorTexture();
       }
-      else {
-        computeTable();
+    }
+    else {
+      getTable(transFunc, d);
+
+      if (!tex_) {
+        tex_ = new tgt::Texture(glm::ivec3(static_cast<int>(resolution_),
+          static_cast<int>(resolution_), 1), GL_RGBA, GL_RGBA32F, GL_FLOAT, tgt::Texture::LINEAR);
+        texInvalid_ = true;
+      }
+
+      if (texInvalid_) {
         tex_->setWrapping(tgt::Texture::CLAMP_TO_BORDER);
         tex_->setPixelData(reinterpret_cast<GLubyte*>(table_));
         tex_->uploadTexture();
@@ -197,11 +324,101 @@ namespace mivt {
 
         // prevent deleting twice
         tex_->setPixelData(0);
+        texInvalid_ = false;
       }
     }
     return tex_;
   }
 
+  const glm::vec4* PreIntegration::getTable(tgt::TransFunc1D *transFunc, float d)
+  {
+    if (computeOnGPU_)
+      return 0;
+
+    if (isTableInvalid(transFunc, d)) {
+      // another transfer function object or a notified change may still have the content of the current table
+      uint64_t hash = transFunc->getContentHash();
+      bool hadTable = transFunc_ != 0;
+      transFunc_ = transFunc;
+      transFunc->validPreinteTexture();
+
+      if (!hadTable) {
+        samplingStepSize_ = d;
+        tableHash_ = hash;
+        computeTable();
+        texInvalid_ = true;
+      }
+      else if (hash != tableHash_ || d != samplingStepSize_) {
+        selectTable(hash, d);
+      }
+    }
+    return table_;
+  }
+
+  void PreIntegration::selectTable(uint64_t hash, float d)
+  {
+    std::list<CacheEntry>::iterator cached = cache_.begin();
+    while (cached != cache_.end() && (cached->hash_ != hash || cached->stepSize_ != d))
+      ++cached;
+
+    CacheEntry previous = { tableHash_, samplingStepSize_, table_, tex_, texInvalid_ };
+    cache_.push_front(previous);
+    samplingStepSize_ = d;
+    tableHash_ = hash;
+
+    if (cached != cache_.end()) {
+      table_ = cached->table_;
+      tex_ = cached->tex_;
+      texInvalid_ = cached->texInvalid_;
+      cache_.erase(cached);
+
+      // the sampled table has to be computed completely the next time, it is not the last computed one
+      tableStepSize_ = 0;
+    }
+    else {
+      // start from the previous table, the sampled computation only updates the entries of changed TF values
+      table_ = new vec4[resolution_ * resolution_];
+      std::copy(previous.table_, previous.table_ + resolution_ * resolution_, table_);
+      tex_ = 0;
+      computeTable();
+      texInvalid_ = true;
+    }
+
+    shrinkCache();
+  }
+
+  void PreIntegration::shrinkCache()
+  {
+    const size_t tableBytes = resolution_ * resolution_ * sizeof(vec4);
+    size_t numBytes = tex_ ? 2 * tableBytes : tableBytes;
+    for (std::list<CacheEntry>::iterator it = cache_.begin(); it != cache_.end(); ++it)
+      numBytes += it->tex_ ? 2 * tableBytes : tableBytes;
+
+    while (!cache_.empty() && numBytes > cacheMemoryLimit_) {
+      CacheEntry& entry = cache_.back();
+      numBytes -= entry.tex_ ? 2 * tableBytes : tableBytes;
+      delete[] entry.table_;
+      delete entry.tex_;
+      cache_.pop_back();
+    }
+  }
+
+  void PreIntegration::setCacheMemoryLimit(size_t numBytes)
+  {
+    cacheMemoryLimit_ = numBytes;
+    shrinkCache();
+  }
+
+  size_t PreIntegration::getCacheMemoryLimit() const
+  {
+    return cacheMemoryLimit_;
+  }
+
+  size_t PreIntegration::getResolution() const
+  {
+    return resolution_;
+  }
+
   void PreIntegration::computeTableGPU()
   {
     //render pre-integration texture into render target
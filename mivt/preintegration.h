@@ -2,6 +2,10 @@
 
 #include "tgt_math.h"
 
+#include <list>
+#include <vector>
+#include <stdint.h>
+
 namespace tgt {
   class TransFunc1D;
   class Texture;
@@ -14,6 +18,9 @@ namespace mivt {
   class PreIntegration
   {
   public:
+    /// Default limit of the memory used by the current and the cached tables, including their textures.
+    static const size_t DEFAULT_CACHE_MEMORY_LIMIT = 32 << 20;
+
     /**
     * Constructor, automatically calls computeTable at the end.
     *
@@ -34,15 +41,68 @@ namespace mivt {
     */
     const tgt::Texture* getTexture(tgt::TransFunc1D *transFunc, float d);
 
+    /**
+    * Returns the pre-integration table computed on the CPU, without creating a texture.
+    * The table has getResolution() x getResolution() entries in row-major order, the column is
+    * indexed by the current intensity and the row by the previous one. Returns 0 if the table
+    * is computed on the GPU.
+    *
+    * @param transFunc the transfer function for with the pre-integration table is computed
+    * @param d the segment length (= sampling step size) for which the pre-integration table is computed
+    */
+    const glm::vec4* getTable(tgt::TransFunc1D *transFunc, float d);
+
+    size_t getResolution() const;
+
+    /**
+    * Sets the memory limit in bytes for the tables computed on the CPU and their textures. Tables of previously
+    * used transfer function contents and segment lengths are kept and reused until the limit is exceeded,
+    * then the least recently used ones are deleted. The current table is always kept.
+    */
+    void setCacheMemoryLimit(size_t numBytes);
+
+    size_t getCacheMemoryLimit() const;
+
     bool computeOnGPU();
 
   private:
     /// Compute the pre-integrated table for the given transfer function.
     void computeTable();
 
+    /**
+    * Computes the table by compositing the sampled TF values between both intensities, rows are distributed
+    * over threads and four entries of a row are composited at once. Only the entries depending on TF values
+    * that changed since the last computation are updated, unless the segment length changed.
+    */
+    void computeTableSampled(const glm::vec4* tfBuffer);
+
+    /// Computes the entries [sfBegin, sfEnd) of row sb, which all lie on the same side of sb.
+    void compositeSegments(const glm::vec4* tfBuffer, int sb, int sfBegin, int sfEnd, glm::vec4* row) const;
+
     ///  Compute the pre-integrated table on the GPU.
     void computeTableGPU();
 
+    /// Returns true if the table has to be recomputed for the given transfer function and segment length.
+    bool isTableInvalid(tgt::TransFunc1D *transFunc, float d) const;
+
+    /**
+    * Makes the table for the transfer function content \p hash and segment length \p d the current one,
+    * taken from the cache or computed. The previous table is moved to the cache.
+    */
+    void selectTable(uint64_t hash, float d);
+
+    /// Deletes the least recently used cached tables until the memory limit is met.
+    void shrinkCache();
+
+    /// A table that was current before, with its texture if it was created.
+    struct CacheEntry {
+      uint64_t hash_;         ///< content hash of the transfer function
+      float stepSize_;        ///< segment length
+      glm::vec4 *table_;
+      tgt::Texture *tex_;
+      bool texInvalid_;
+    };
+
   private:
     size_t      resolution_;                ///< resolution of the pre-integrated table
     float       samplingStepSize_;          ///< length of the segments
@@ -51,8 +111,17 @@ namespace mivt {
     glm::vec4   *table_;                    ///< the actual pre-integration table in row-major order
     tgt::TransFunc1D  *transFunc_;      ///< the 1D transfer function that is used to compute the pre-integration table
     tgt::Texture      *tex_;            ///< texture for the pre-integration table, is generated internally
+    bool              texInvalid_;      ///< true if the table changed since the last texture upload
     tgt::RenderTarget *renderTarget_;   ///< internal render target for computing the pre-integration table on the gpu
     tgt::Shader       *program_;        ///< shader program to compute the pre-integration table on the gpu
+
+    std::vector<glm::vec4> tfValues_;       ///< TF values the sampled table was computed for
+    std::vector<float> opacityCorrection_;  ///< opacity corrected TF alpha per segment length (row) and TF value
+    float             tableStepSize_;       ///< segment length the sampled table was computed for
+
+    uint64_t tableHash_;                ///< content hash of the transfer function of the current table
+    std::list<CacheEntry> cache_;       ///< previous tables, most recently used first
+    size_t cacheMemoryLimit_;           ///< see setCacheMemoryLimit()
   };
 
 } // end namespace mivt
@@ -4,6 +4,8 @@
 #include "rendertarget.h"
 #include "shadermanager.h"
 
+#include <algorithm>
+
 namespace mivt {
   const std::string RenderBackground::loggerCat_ = "RenderBackground";
 
@@ -273,6 +275,64 @@ namespace mivt {
     LGL_ERROR;
   }
 
+  glm::vec4 RenderBackground::getBackgroundColor(const glm::vec2& ndc) const
+  {
+    if (mode_ == "monochrome") {
+      return firstcolor_;
+    }
+    else if (mode_ == "gradient") {
+      // invert the rotation and scaling of the gradient quad, see renderBackground()
+      float angle = glm::radians(static_cast<float>(angle_));
+      float scale = 1.0f + (45 - abs(angle_ % 90 - 45)) / 45.0f*0.8284271247461900976033774484194f;
+      float y = (-std::sin(angle) * ndc.x + std::cos(angle) * ndc.y) / scale;
+      return glm::mix(firstcolor_, secondcolor_, glm::clamp(0.5f * (y + 1.f), 0.f, 1.f));
+    }
+    else if (mode_ == "radial") {
+      // same radius as in createRadialTexture(), the texture quad is scaled by 1.44
+      float r = glm::clamp(glm::length(ndc / 1.44f), 0.f, 1.f);
+      return glm::round(glm::mix(firstcolor_, secondcolor_, r) * 255.f) / 255.f;
+    }
+    else {
+      // "none" renders an empty texture
+      return glm::vec4(0.f);
+    }
+  }
+
+  void RenderBackground::ProcessCPU(const std::vector<glm::vec4>& input, const glm::ivec2& inputSize,
+    const glm::ivec2& outputSize, unsigned char* buffer, size_t length)
+  {
+    if (!buffer || input.size() < static_cast<size_t>(inputSize.x) * inputSize.y)
+      return;
+
+    size_t numPixels = std::min(length / 4, static_cast<size_t>(outputSize.x) * outputSize.y);
+    glm::vec2 scale = glm::vec2(inputSize) / glm::vec2(outputSize);
+    for (size_t i = 0; i < numPixels; ++i) {
+      int x = static_cast<int>(i % outputSize.x);
+      int y = static_cast<int>(i / outputSize.x);
+      glm::vec2 p(x + 0.5f, y + 0.5f);
+
+      // bilinear lookup with clamp to edge
+      glm::vec2 texel = glm::clamp(p * scale - 0.5f, glm::vec2(0.f), glm::vec2(inputSize - 1));
+      glm::ivec2 t0(texel);
+      glm::ivec2 t1 = glm::min(t0 + 1, inputSize - 1);
+      glm::vec2 f = texel - glm::vec2(t0);
+      glm::vec4 color1 = glm::mix(
+        glm::mix(input[t0.y * inputSize.x + t0.x], input[t0.y * inputSize.x + t1.x], f.x),
+        glm::mix(input[t1.y * inputSize.x + t0.x], input[t1.y * inputSize.x + t1.x], f.x), f.y);
+      glm::vec4 color0 = getBackgroundColor(p / glm::vec2(outputSize) * 2.f - 1.f);
+
+      // same blending as background.frag
+      glm::vec4 fragColor(glm::vec3(color1) * color1.a + glm::vec3(color0) * color0.a * (1.f - color1.a),
+        color1.a + color0.a * (1.f - color1.a));
+
+      glm::col4 pixel(glm::round(glm::clamp(fragColor, 0.f, 1.f) * 255.f));
+      buffer[i * 4 + 0] = pixel.b;
+      buffer[i * 4 + 1] = pixel.g;
+      buffer[i * 4 + 2] = pixel.r;
+      buffer[i * 4 + 3] = pixel.a;
+    }
+  }
+
   tgt::RenderTarget* RenderBackground::GetOutput()
   {
     return output_;
@@ -283,10 +343,9 @@ namespace mivt {
     if (firstcolor_ != color) {
       firstcolor_ = color;
 
-      if (mode_ == "radial") {
+      // the radial texture is recreated on demand
+      if (mode_ == "radial")
         DELPTR(tex_);
-        createRadialTexture();
-      }
     }
   }
 
@@ -300,10 +359,9 @@ namespace mivt {
     if (secondcolor_ != color) {
       secondcolor_ = color;
 
-      if (mode_ == "radial") {
+      // the radial texture is recreated on demand
+      if (mode_ == "radial")
         DELPTR(tex_);
-        createRadialTexture();
-      }
     }
   }
 
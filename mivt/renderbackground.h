@@ -1,6 +1,7 @@
 #pragma once
 #include "tgt_math.h"
 #include "renderbase.h"
+#include <vector>
 
 namespace tgt {
   class Texture;
@@ -21,6 +22,20 @@ namespace mivt {
     void Process(tgt::RenderTarget *input);
     tgt::RenderTarget* GetOutput();
 
+    /**
+    * CPU version of Process(): blends an image over the background and writes the result to
+    * buffer in the layout of RenderTarget::readColorBuffer(), i.e. BGRA bytes, bottom row first.
+    * The input image is scaled to the output size with bilinear filtering.
+    *
+    * @param input RGBA image as written by the raycaster, bottom row first
+    * @param inputSize size of the input image
+    * @param outputSize size of the output image
+    * @param buffer receives outputSize.x * outputSize.y * 4 bytes
+    * @param length size of buffer in bytes
+    */
+    void ProcessCPU(const std::vector<glm::vec4>& input, const glm::ivec2& inputSize,
+      const glm::ivec2& outputSize, unsigned char* buffer, size_t length);
+
     void SetFirstColor(const glm::vec4 color);
     glm::vec4 GetFirstColor();
 
@@ -37,6 +52,12 @@ namespace mivt {
     */
     void renderBackground();
 
+    /**
+    * Returns the background color at a position given in normalized device coordinates,
+    * the CPU counterpart of renderBackground().
+    */
+    glm::vec4 getBackgroundColor(const glm::vec2& ndc) const;
+
     /**
     * load (and create) needed textures
     */
@@ -0,0 +1,285 @@
+#include "renderthread.h"
+#include "offscreenrender.h"
+#include "logmanager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <future>
+
+namespace mivt {
+
+  const std::string RenderThread::loggerCat_("RenderThread");
+
+  RenderThread::RenderThread(tgt::OffScreenRender* context, const RenderFunc& render)
+    : context_(context)
+    , render_(render)
+    , tail_(&stub_)
+    , numQueued_(0)
+    , closed_(false)
+    , sleeping_(false)
+    , running_(true)
+    , frameRequested_(false)
+    , frameBytes_(0)
+    , frameDownsampling_(false)
+    , frameRequest_(0)
+    , numRequests_(0)
+    , publishedRequest_(0)
+    , stopped_(false)
+    , latest_(1)
+    , back_(0)
+    , front_(2)
+    , frameInterval_(16.f)
+    , frameCallback_(0)
+    , numFrames_(0)
+  {
+    stub_.next_.store(0);
+    head_.store(&stub_);
+
+    // start after all members are initialized
+    thread_ = std::thread(&RenderThread::run, this);
+  }
+
+  RenderThread::~RenderThread()
+  {
+    Post([this]() { running_ = false; });
+    thread_.join();
+  }
+
+  bool RenderThread::Post(const Command& command)
+  {
+    Node* node = new Node();
+    node->command_ = command;
+
+    // counted before it is visible, the render thread spins until the push is complete. Counting before
+    // checking closed_ makes sure that the render thread either drains the command or it is rejected here.
+    ++numQueued_;
+    if (closed_.load()) {
+      --numQueued_;
+      delete node;
+      LWARNING("Command posted after the thread stopped");
+      return false;
+    }
+    push(node);
+
+    if (sleeping_.load()) {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      wake_.notify_one();
+    }
+    return true;
+  }
+
+  bool RenderThread::Invoke(const Command& command)
+  {
+    if (std::this_thread::get_id() == thread_.get_id()) {
+      command();
+      return true;
+    }
+
+    std::promise<void> done;
+    std::future<void> result = done.get_future();
+    bool posted = Post([&]() {
+      try {
+        command();
+        done.set_value();
+      }
+      catch (...) {
+        done.set_exception(std::current_exception());
+      }
+    });
+    if (!posted)
+      return false;
+
+    result.get();
+    return true;
+  }
+
+  size_t RenderThread::RequestFrame(size_t numBytes, bool downsampling)
+  {
+    size_t request = ++numRequests_;
+    Post([=]() {
+      frameRequested_ = true;
+      frameBytes_ = numBytes;
+      frameDownsampling_ = downsampling;
+      // requests of several threads may be queued out of order
+      frameRequest_ = std::max(frameRequest_, request);
+    });
+    return request;
+  }
+
+  bool RenderThread::WaitForFrame(size_t request)
+  {
+    if (std::this_thread::get_id() == thread_.get_id())
+      return false;
+
+    std::unique_lock<std::mutex> lock(frameMutex_);
+    while (publishedRequest_ < request && !stopped_)
+      frameDone_.wait(lock);
+    return publishedRequest_ >= request;
+  }
+
+  bool RenderThread::GetLatestFrame(unsigned char* buffer, size_t numBytes)
+  {
+    // take the latest frame if it has not been read yet, handing the read one back to the renderer
+    if (latest_.load() & FRESH)
+      front_ = latest_.exchange(front_) & INDEX_MASK;
+
+    const Frame& frame = frames_[front_];
+    if (frame.pixels_.empty() || frame.pixels_.size() != numBytes)
+      return false;
+
+    memcpy(buffer, &frame.pixels_[0], numBytes);
+    return true;
+  }
+
+  void RenderThread::SetFrameInterval(float ms)
+  {
+    frameInterval_ = std::max(ms, 0.f);
+  }
+
+  float RenderThread::GetFrameInterval() const
+  {
+    return frameInterval_;
+  }
+
+  void RenderThread::SetFrameCallback(FrameCallback callback)
+  {
+    frameCallback_ = callback;
+  }
+
+  size_t RenderThread::GetNumFrames() const
+  {
+    return numFrames_;
+  }
+
+  void RenderThread::push(Node* node)
+  {
+    node->next_.store(0, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next_.store(node, std::memory_order_release);
+  }
+
+  RenderThread::Node* RenderThread::pop()
+  {
+    Node* tail = tail_;
+    Node* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next)
+        return 0;
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+
+    // a producer is between the exchange of head_ and linking its node
+    if (tail != head_.load(std::memory_order_acquire))
+      return 0;
+
+    // tail is the last node, put the stub behind it to be able to take it
+    push(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    return 0;
+  }
+
+  void RenderThread::run()
+  {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    context_->MakeCurrent();
+
+    Clock::time_point lastFrame = Clock::now();
+    while (running_) {
+      waitForCommands();
+      executeCommands();
+
+      if (running_ && frameRequested_) {
+        // render at most once per interval, commands arriving meanwhile go into the same frame
+        Clock::duration interval = std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<float, std::milli>(frameInterval_.load()));
+        std::this_thread::sleep_until(lastFrame + interval);
+        executeCommands();
+
+        if (running_) {
+          lastFrame = Clock::now();
+          renderFrame();
+        }
+      }
+    }
+
+    // commands posted before closing are executed, later ones are rejected
+    closed_ = true;
+    while (numQueued_.load() > 0) {
+      executeCommands();
+      std::this_thread::yield();
+    }
+
+    context_->MakeUncurrent();
+
+    // release threads waiting for frames that will not be rendered anymore
+    {
+      std::lock_guard<std::mutex> lock(frameMutex_);
+      stopped_ = true;
+    }
+    frameDone_.notify_all();
+  }
+
+  void RenderThread::waitForCommands()
+  {
+    if (numQueued_.load() > 0)
+      return;
+
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    sleeping_ = true;
+    while (numQueued_.load() == 0)
+      wake_.wait(lock);
+    sleeping_ = false;
+  }
+
+  void RenderThread::executeCommands()
+  {
+    while (Node* node = pop()) {
+      try {
+        node->command_();
+      }
+      catch (const std::exception& e) {
+        LERROR("Command failed: " << e.what());
+      }
+      delete node;
+      --numQueued_;
+    }
+  }
+
+  void RenderThread::renderFrame()
+  {
+    Frame& frame = frames_[back_];
+    frame.pixels_.resize(frameBytes_);
+    if (!frame.pixels_.empty())
+      render_(&frame.pixels_[0], frameBytes_, frameDownsampling_);
+    frameRequested_ = false;
+
+    // publish the frame and continue with the buffer that is neither read nor latest
+    back_ = latest_.exchange(back_ | FRESH) & INDEX_MASK;
+    ++numFrames_;
+
+    {
+      std::lock_guard<std::mutex> lock(frameMutex_);
+      publishedRequest_ = frameRequest_;
+    }
+    frameDone_.notify_all();
+
+    FrameCallback callback = frameCallback_.load();
+    if (callback)
+      callback();
+  }
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "application.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tgt {
+  class OffScreenRender;
+}
+
+namespace mivt {
+
+  /**
+  * Renders on a thread of its own that owns the OpenGL context.
+  *
+  * Calls are turned into commands and pushed into a lock-free queue, which the render thread empties
+  * before every frame. Frames are only rendered on request and at most once per frame interval, all
+  * commands arriving in the meantime, e.g. a burst of camera movements, end up in the same frame.
+  * Finished frames are published through a triple buffer, so GetLatestFrame() never waits for the
+  * renderer.
+  */
+  class RenderThread
+  {
+  public:
+    typedef std::function<void()> Command;
+
+    /// Renders a frame of numBytes into the buffer, downsampled if requested.
+    typedef std::function<void(unsigned char*, size_t, bool)> RenderFunc;
+
+    /// Starts the thread, which makes \p context current until it is stopped.
+    RenderThread(tgt::OffScreenRender* context, const RenderFunc& render);
+
+    /// Executes the pending commands and stops the thread, the context is not current afterwards.
+    ~RenderThread();
+
+    /// Queues \p command without waiting for it. Returns false if the thread is stopping and the command is dropped.
+    bool Post(const Command& command);
+
+    /**
+    * Queues \p command and waits until it has been executed. Exceptions thrown by the command are
+    * passed on to the caller. Runs the command right away if called on the render thread. Returns
+    * false without waiting if the thread is stopping.
+    */
+    bool Invoke(const Command& command);
+
+    /**
+    * Requests a frame of \p numBytes, requests arriving before it has been rendered are merged.
+    * Returns the number of the request for WaitForFrame().
+    */
+    size_t RequestFrame(size_t numBytes, bool downsampling);
+
+    /**
+    * Waits until a frame has been published for \p request or a later one. Returns false without
+    * waiting if called on the render thread, e.g. from the frame callback, or if the thread stopped.
+    */
+    bool WaitForFrame(size_t request);
+
+    /**
+    * Copies the latest finished frame to \p buffer. Returns false if there is no frame of \p numBytes,
+    * e.g. before the first frame after a resize. Frames may only be fetched by one thread at a time.
+    */
+    bool GetLatestFrame(unsigned char* buffer, size_t numBytes);
+
+    /// Minimum time between two frames in milliseconds, default 16 ms for 60 frames per second.
+    void SetFrameInterval(float ms);
+    float GetFrameInterval() const;
+
+    void SetFrameCallback(FrameCallback callback);
+
+    /// Number of frames rendered so far.
+    size_t GetNumFrames() const;
+
+  private:
+    /// Node of the command queue, see push() and pop().
+    struct Node {
+      std::atomic<Node*> next_;
+      Command command_;
+    };
+
+    /// Appends a node, may be called by any thread.
+    void push(Node* node);
+
+    /// Removes the first node or returns null, only called by the render thread.
+    Node* pop();
+
+    /// Loop of the render thread.
+    void run();
+
+    /// Sleeps until a command has been queued.
+    void waitForCommands();
+
+    /// Executes and deletes all queued commands.
+    void executeCommands();
+
+    /// Renders into the back buffer and publishes it.
+    void renderFrame();
+
+    // not copyable
+    RenderThread(const RenderThread&);
+    RenderThread& operator=(const RenderThread&);
+
+    static const int FRESH = 4;         ///< set in latest_ if the buffer has not been read yet
+    static const int INDEX_MASK = 3;
+
+    struct Frame {
+      std::vector<unsigned char> pixels_;
+    };
+
+    tgt::OffScreenRender* context_;
+    RenderFunc render_;
+    std::thread thread_;
+
+    // command queue, intrusive multi-producer single-consumer list
+    std::atomic<Node*> head_;           ///< last node, producers append behind it
+    Node* tail_;                        ///< first node, owned by the render thread
+    Node stub_;
+    std::atomic<int> numQueued_;
+    std::atomic<bool> closed_;          ///< set when the loop ended, commands are rejected afterwards
+
+    // sleeping while there are no commands
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> sleeping_;
+
+    // state of the render thread, only accessed by commands
+    bool running_;
+    bool frameRequested_;
+    size_t frameBytes_;
+    bool frameDownsampling_;
+    size_t frameRequest_;               ///< latest request merged into the next frame
+
+    // waiting for frames
+    std::atomic<size_t> numRequests_;
+    std::mutex frameMutex_;
+    std::condition_variable frameDone_;
+    size_t publishedRequest_;           ///< latest request a frame has been published for, guarded by frameMutex_
+    bool stopped_;                      ///< set when the loop ended, guarded by frameMutex_
+
+    // triple buffer: the render thread writes to back_, the reader copies from front_
+    Frame frames_[3];
+    std::atomic<int> latest_;           ///< index of the latest frame, | FRESH if not read yet
+    int back_;
+    int front_;
+
+    std::atomic<float> frameInterval_;
+    std::atomic<FrameCallback> frameCallback_;
+    std::atomic<size_t> numFrames_;
+
+    static const std::string loggerCat_;
+  };
+
+}
@@ -13,9 +13,32 @@
 #include "cubeproxygeometry.h"
 #include "volumeatomic.h"
 #include "volumesculpt.h"
+#include "sculpthistory.h"
+#include "cpuraycaster.h"
+#include "gpucapabilities.h"
+#include "volumegl.h"
+#include "volumemask.h"
+#include "volumepyramid.h"
+#include "occupancygrid.h"
+#include "pixelreadback.h"
+#include "logmanager.h"
+
+#include <chrono>
+
+namespace {
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  float elapsedMilliseconds(const Clock::time_point& start, const Clock::time_point& end) {
+    return std::chrono::duration<float, std::milli>(end - start).count();
+  }
+
+} // namespace anonymous
 
 namespace mivt {
 
+  const std::string RenderVolume::loggerCat_("RenderVolume");
+
   RenderVolume::RenderVolume()
     : VolumeRaycaster()
     , privatetarget_(0)
@@ -32,6 +55,16 @@ namespace mivt {
     , renderBackground_(0)
     , renderToScreen_(0)
     , cubeProxyGeometry_(0)
+    , volumeSculpt_(0)
+    , cpuRaycaster_(0)
+    , readback_(0)
+    , renderBackend_("gpu")
+    , gpuSupported_(false)
+    , readbackMode_("latency")
+    , renderTime_(0.f)
+    , readbackTime_(0.f)
+    , readbackLatency_(0)
+    , size_(1)
   {
   }
 
@@ -43,62 +76,94 @@ namespace mivt {
   {
     VolumeRaycaster::Initialize();
 
-    shader_ = ShdrMgr.loadSeparate("passthrough.vert", "rc_basic.frag", generateHeader(), false);
+    // rc_basic.frag needs GLSL 3.30 and render targets, otherwise only the CPU raycaster is used
+    gpuSupported_ = GpuCaps.getShaderVersion() >= tgt::GpuCapabilities::GlVersion::SHADER_VERSION_330
+      && GpuCaps.areFramebufferObjectsSupported();
+    if (!gpuSupported_) {
+      LWARNING("OpenGL 3.3 not available, falling back to CPU raycasting");
+      renderBackend_ = "cpu";
+    }
 
-    output_ = new tgt::RenderTarget();
-    output_->initialize();
+    if (gpuSupported_) {
+      shader_ = ShdrMgr.loadSeparate("passthrough.vert", "rc_basic.frag", generateHeader(), false);
 
-    privatetarget_ = new tgt::RenderTarget();
-    privatetarget_->initialize();
+      output_ = new tgt::RenderTarget();
+      output_->initialize();
 
-    smallprivatetarget_ = new tgt::RenderTarget();
-    smallprivatetarget_->initialize();
+      privatetarget_ = new tgt::RenderTarget();
+      privatetarget_->initialize();
+
+      smallprivatetarget_ = new tgt::RenderTarget();
+      smallprivatetarget_->initialize();
+
+      readback_ = new tgt::PixelReadback();
+      readback_->initialize();
+    }
 
     camera_ = new tgt::Camera(glm::vec3(0.f, 0.f, 3.5f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f));
     trackball_ = new tgt::Trackball(camera_);
     trackball_->setSize(0.7f); // sets trackball sensitivity
 
-    renderColorCube_ = new RenderColorCube();
-    renderColorCube_->Initialize();
-
+    // the background settings are also used by the CPU backend
     renderBackground_ = new RenderBackground();
-    renderBackground_->Initialize();
 
-    renderToScreen_ = new RenderToScreen();
-    renderToScreen_->Initialize();
+    if (gpuSupported_) {
+      renderColorCube_ = new RenderColorCube();
+      renderColorCube_->Initialize();
+
+      renderBackground_->Initialize();
+
+      renderToScreen_ = new RenderToScreen();
+      renderToScreen_->Initialize();
+    }
 
+    // start the rays at the first brick with visible samples
     cubeProxyGeometry_ = new CubeProxyGeometry();
+    cubeProxyGeometry_->SetOccupancyGrid(occupancyGrid_);
+    cubeProxyGeometry_->SetProxyMode("occupancy");
 
-    volumeSculpt_ = new VolumeSculpt(true);
+    volumeSculpt_ = new VolumeSculpt(gpuSupported_);
+
+    cpuRaycaster_ = new CpuRaycaster();
+    cpuRaycaster_->Initialize();
   }
 
   void RenderVolume::Deinitialize()
   {
     VolumeRaycaster::Deinitialize();
 
-    ShdrMgr.dispose(shader_);
-    shader_ = 0;
+    if (gpuSupported_) {
+      ShdrMgr.dispose(shader_);
+      shader_ = 0;
 
-    output_->deinitialize();
-    DELPTR(output_);
+      output_->deinitialize();
+      DELPTR(output_);
 
-    privatetarget_->deinitialize();
-    DELPTR(privatetarget_);
+      privatetarget_->deinitialize();
+      DELPTR(privatetarget_);
 
-    smallprivatetarget_->deinitialize();
-    DELPTR(smallprivatetarget_);
+      smallprivatetarget_->deinitialize();
+      DELPTR(smallprivatetarget_);
 
-    DELPTR(camera_);
-    DELPTR(trackball_);
+      readback_->deinitialize();
+      DELPTR(readback_);
+
+      renderColorCube_->Deinitialize();
+      DELPTR(renderColorCube_);
 
-    renderColorCube_->Deinitialize();
-    DELPTR(renderColorCube_);
+      renderBackground_->Deinitialize();
+
+      renderToScreen_->Deinitialize();
+      DELPTR(renderToScreen_);
+    }
 
-    renderBackground_->Deinitialize();
     DELPTR(renderBackground_);
 
-    renderToScreen_->Deinitialize();
-    DELPTR(renderToScreen_);
+    DELPTR(camera_);
+    DELPTR(trackball_);
+
+    cpuRaycaster_->Deinitialize();
+    DELPTR(cpuRaycaster_);
 
     DELPTR(cubeProxyGeometry_);
 
@@ -113,12 +178,44 @@ namespace mivt {
     if (!buffer)
       return;
 
+    Clock::time_point start = Clock::now();
+
+    if (renderBackend_ == "cpu") {
+      ProcessCPU(downsampling, buffer, length);
+      renderTime_ = elapsedMilliseconds(start, Clock::now());
+      readbackTime_ = 0.f;
+      readbackLatency_ = 0;
+      return;
+    }
+
     Process(downsampling);
-    output_->readColorBuffer<unsigned char>(buffer, length);
+    Clock::time_point rendered = Clock::now();
+
+    if (readbackMode_ == "throughput") {
+      // queue this frame and return the newest one that already arrived, the final frame of an
+      // interaction is waited for, otherwise the view would stay one frame behind
+      readback_->startDownload(output_->getColorTexture());
+      readbackLatency_ = readback_->readPixels(buffer, length, !downsampling);
+    }
+    else {
+      output_->readColorBuffer<unsigned char>(buffer, length);
+      readbackLatency_ = 0;
+    }
+
+    renderTime_ = elapsedMilliseconds(start, rendered);
+    readbackTime_ = elapsedMilliseconds(rendered, Clock::now());
   }
 
   void RenderVolume::Resize(const glm::ivec2& newSize)
   {
+    size_ = newSize;
+
+    if (!gpuSupported_)
+      return;
+
+    // images of the old size do not fit into the buffer of the caller anymore
+    readback_->discard();
+
     privatetarget_->resize(newSize);
     smallprivatetarget_->resize(newSize / interactionCoarseness_);
     output_->resize(newSize);
@@ -127,8 +224,32 @@ namespace mivt {
     renderToScreen_->Resize(newSize);
   }
 
+  void RenderVolume::ProcessCPU(bool downsampling, unsigned char* buffer, size_t length)
+  {
+    const bool renderCoarse = downsampling && interactionCoarseness_ > 1;
+    glm::ivec2 renderSize = glm::max(renderCoarse ? size_ / interactionCoarseness_ : size_, glm::ivec2(1));
+
+    if (volume_ && volume_->IsReady()) {
+      // same level selection as the GPU path, the occupancy grid stays at full resolution
+      tgt::Volume* renderVolume = renderCoarse ? selectInteractionVolume(renderSize) : volume_;
+      updateOccupancy();
+      cpuRaycaster_->CopyParameters(*this);
+      cpuRaycaster_->Process(volume_, renderVolume, mask_, transfunc_, camera_,
+        cubeProxyGeometry_->GetTexLlf(), cubeProxyGeometry_->GetTexUrb(), renderSize, cpuImage_);
+    }
+    else {
+      cpuImage_.assign(static_cast<size_t>(renderSize.x) * renderSize.y, glm::vec4(0.f));
+    }
+
+    // blend with background and write the output
+    renderBackground_->ProcessCPU(cpuImage_, renderSize, size_, buffer, length);
+  }
+
   void RenderVolume::Process(bool downsampling)
   {
+    // classify the bricks before the entry and exit points are rendered
+    updateOccupancy();
+
     // create front & back color cube texture.
     if (cubeProxyGeometry_->GetGeometry())
       renderColorCube_->Process(cubeProxyGeometry_->GetGeometry(), camera_);
@@ -146,12 +267,19 @@ namespace mivt {
       renderDestination = privatetarget_;
     }
 
+    // while interacting, a downsampled level of the volume is sampled with a larger step
+    tgt::Volume* renderVolume = renderCoarse ? selectInteractionVolume(renderSize) : volume_;
+
     // bind transfer function before active shader and target, because it may re-compute 
     // transfer function table use gpu by another shader in PreIntegration.
     if (transfunc_ && volume_ && volume_->IsReady()) {
-      bindTransfuncTexture(classificationMode_, transfunc_, CalculateSamplingStepSize(volume_));
+      bindTransfuncTexture(classificationMode_, transfunc_, CalculateSamplingStepSize(renderVolume));
     }
 
+    // upload the occupancy grid before the target is activated as well
+    if (volume_ && volume_->IsReady() && emptySpaceSkipping_)
+      occupancyGrid_->GetTexture();
+
     renderDestination->activateTarget();
     renderDestination->clearTarget();
 
@@ -176,7 +304,7 @@ namespace mivt {
 
       // bind volume texture and pass it to the shader
       tgt::TextureUnit volUnit;
-      VolumeStruct volumeTexture(volume_, &volUnit, "volume_", "volumeStruct_",
+      VolumeStruct volumeTexture(renderVolume, &volUnit, "volume_", "volumeStruct_",
         GL_CLAMP_TO_EDGE, glm::vec4(0.f), GL_LINEAR);
       bindVolume(shader_, volumeTexture, camera_, lightPosition_);
       LGL_ERROR;
@@ -191,14 +319,21 @@ namespace mivt {
       tgt::TextureUnit transferUnit;
       if (transfunc_) {
         transferUnit.activate();
-        bindTransfuncTexture(classificationMode_, transfunc_, CalculateSamplingStepSize(volume_));
+        bindTransfuncTexture(classificationMode_, transfunc_, CalculateSamplingStepSize(renderVolume));
         transfunc_->setUniform(shader_, "transFuncStruct_", "transFuncTex_", transferUnit.getUnitNumber());
       }
 
+      // pass occupancy grid to the shader
+      tgt::TextureUnit occupancyUnit;
+      if (emptySpaceSkipping_)
+        bindOccupancyGrid(shader_, &occupancyUnit);
+
       // render screen aligned quad
       renderQuad();
 
-      glFinish();
+      // the asynchronous readback relies on the command order instead of draining the pipeline
+      if (readbackMode_ == "latency")
+        glFinish();
 
       // clean up
       shader_->deactivate();
@@ -206,7 +341,8 @@ namespace mivt {
 
     renderDestination->deactivateTarget();
 
-    glFinish();
+    if (readbackMode_ == "latency")
+      glFinish();
 
     // blend with background
     renderBackground_->Process(renderDestination);
@@ -220,28 +356,60 @@ namespace mivt {
     LGL_ERROR;
   }
 
+  void RenderVolume::updateOccupancy()
+  {
+    const bool fittedProxy = cubeProxyGeometry_->GetProxyMode() == "occupancy";
+    if (!volume_ || !volume_->IsReady() || !(emptySpaceSkipping_ || fittedProxy))
+      return;
+
+    updateOccupancyGrid(volume_, transfunc_);
+    if (fittedProxy)
+      cubeProxyGeometry_->Update();
+  }
+
   void RenderVolume::Rotate(const glm::ivec2& newPos, const glm::ivec2& lastPos)
   {
-    glm::vec2 newMouse = scaleMouse(newPos, output_->getSize());
-    glm::vec2 lastMouse = scaleMouse(lastPos, output_->getSize());
+    glm::vec2 newMouse = scaleMouse(newPos, size_);
+    glm::vec2 lastMouse = scaleMouse(lastPos, size_);
     trackball_->rotate(newMouse, lastMouse);
   }
 
   void RenderVolume::Zoom(const glm::ivec2& newPos, const glm::ivec2& lastPos)
   {
     const glm::vec2 zoomInDirection(0.f, 1.f);
-    glm::vec2 newMouse = scaleMouse(newPos, output_->getSize());
-    glm::vec2 lastMouse = scaleMouse(lastPos, output_->getSize());
+    glm::vec2 newMouse = scaleMouse(newPos, size_);
+    glm::vec2 lastMouse = scaleMouse(lastPos, size_);
     trackball_->zoom(newMouse, lastMouse, zoomInDirection);
   }
 
   void RenderVolume::Pan(const glm::ivec2& newPos, const glm::ivec2& lastPos)
   {
-    glm::vec2 newMouse = scaleMouse(newPos, output_->getSize());
-    glm::vec2 lastMouse = scaleMouse(lastPos, output_->getSize());
+    glm::vec2 newMouse = scaleMouse(newPos, size_);
+    glm::vec2 lastMouse = scaleMouse(lastPos, size_);
     trackball_->move(newMouse, lastMouse);
   }
 
+  tgt::Volume* RenderVolume::selectInteractionVolume(const glm::ivec2& renderSize)
+  {
+    if (!volume_ || !volume_->IsReady())
+      return volume_;
+
+    // not available until the background computation has finished
+    tgt::VolumePyramid* pyramid = volume_->hasDerivedData<tgt::VolumePyramid>();
+    int level = pyramid ? pyramid->selectLevel(renderSize) : 0;
+    if (level == 0)
+      return volume_;
+
+    if (!pyramid->isMetaDataCurrent(volume_))
+      pyramid->updateMetaData(volume_);
+    return pyramid->getLevel(level);
+  }
+
+  bool RenderVolume::isOutOfCore() const
+  {
+    return volume_ && !volume_->hasRepresentation<tgt::VolumeRAM>() && volume_->hasRepresentation<tgt::VolumeBricked>();
+  }
+
   glm::vec2 RenderVolume::scaleMouse(const glm::ivec2& coords, const glm::ivec2& viewport) const {
     return glm::vec2(static_cast<float>(coords.x*2.f) / static_cast<float>(viewport.x) - 1.f,
       static_cast<float>(coords.y*2.f) / static_cast<float>(viewport.y) - 1.0f);
@@ -271,11 +439,18 @@ namespace mivt {
     cubeProxyGeometry_->SetVolume(volume);
     cubeProxyGeometry_->Process();
 
-    // create a mask with the same dimension as volume
-    tgt::VolumeRAM* volumeRAM = new tgt::VolumeRAM_UInt8(volume->getDimensions());
-    volumeRAM->clear();
+    // downsampled levels for interaction, built in the background
+    volume->computeDerivedDataAsync<tgt::VolumePyramid>();
+
+    // volumes exceeding the brick cache budget do not fit into a texture either
+    if (isOutOfCore() && renderBackend_ != "cpu") {
+      LINFO("Volume is only available as bricks, switching to the CPU backend");
+      SetRenderBackend("cpu");
+    }
+
+    // create a mask with the same dimension as volume, one bit per voxel
     DELPTR(mask_);
-    mask_ = new tgt::Volume(volumeRAM, glm::vec3(1), glm::vec3(0));
+    mask_ = new tgt::Volume(new tgt::VolumeMask(volume->getDimensions()), glm::vec3(1), glm::vec3(0));
     mask_->setPhysicalToWorldMatrix(volume->getPhysicalToWorldMatrix());
 
     volumeSculpt_->SetMaskVolume(mask_);
@@ -290,11 +465,124 @@ namespace mivt {
   {
     if (classificationMode_ != mode) {
       classificationMode_ = mode;
-      shader_->setFragmentHeader(generateHeader());
-      shader_->rebuild();
+      if (shader_) {
+        shader_->setFragmentHeader(generateHeader());
+        shader_->rebuild();
+      }
+    }
+  }
+
+  void RenderVolume::SetEmptySpaceSkipping(bool enable)
+  {
+    if (emptySpaceSkipping_ != enable) {
+      emptySpaceSkipping_ = enable;
+      if (shader_) {
+        shader_->setFragmentHeader(generateHeader());
+        shader_->rebuild();
+      }
     }
   }
 
+  void RenderVolume::SetUniformBlocks(bool enable)
+  {
+    if (uniformBlocks_ != enable) {
+      uniformBlocks_ = enable;
+      if (shader_) {
+        shader_->setFragmentHeader(generateHeader());
+        shader_->rebuild();
+      }
+    }
+  }
+
+  void RenderVolume::SetProxyMode(const std::string& mode)
+  {
+    cubeProxyGeometry_->SetProxyMode(mode);
+    if (volume_)
+      cubeProxyGeometry_->Process();
+  }
+
+  std::string RenderVolume::GetProxyMode()
+  {
+    return cubeProxyGeometry_->GetProxyMode();
+  }
+
+  float RenderVolume::GetSamplesPerRay()
+  {
+    return cpuRaycaster_->GetSamplesPerRay();
+  }
+
+  size_t RenderVolume::GetSculptUploadBytes()
+  {
+    return mask_ ? mask_->GetSyncedBytes() : 0;
+  }
+
+  void RenderVolume::SetRenderBackend(const std::string& backend)
+  {
+    if (backend != "gpu" && backend != "cpu") {
+      LWARNING("Unknown render backend: " << backend);
+      return;
+    }
+    if (backend == "gpu" && !gpuSupported_) {
+      LWARNING("OpenGL raycasting not supported, keeping the CPU backend");
+      return;
+    }
+    if (backend == "gpu" && isOutOfCore()) {
+      LWARNING("Volume is only available as bricks, keeping the CPU backend");
+      return;
+    }
+
+    if (renderBackend_ != backend) {
+      renderBackend_ = backend;
+
+      // frames of the GPU backend still pending are outdated once it is used again
+      if (readback_)
+        readback_->discard();
+
+      // both backends keep a pre-integration table validated through the same transfer function flag
+      if (transfunc_)
+        transfunc_->invalidateTexture();
+    }
+  }
+
+  void RenderVolume::SetReadbackMode(const std::string& mode)
+  {
+    if (mode != "latency" && mode != "throughput") {
+      LWARNING("Unknown readback mode: " << mode);
+      return;
+    }
+
+    if (readbackMode_ != mode) {
+      readbackMode_ = mode;
+      if (readback_)
+        readback_->discard();
+    }
+  }
+
+  std::string RenderVolume::GetReadbackMode()
+  {
+    return readbackMode_;
+  }
+
+  float RenderVolume::GetRenderTime()
+  {
+    return renderTime_;
+  }
+
+  float RenderVolume::GetReadbackTime()
+  {
+    return readbackTime_;
+  }
+
+  int RenderVolume::GetReadbackLatency()
+  {
+    return readbackLatency_;
+  }
+
+  std::string RenderVolume::GetRenderBackend()
+  {
+    return renderBackend_;
+  }
+
   void RenderVolume::SetFirstColor(const glm::vec4 color)
   {
     renderBackground_->SetFirstColor(color);
@@ -327,11 +615,19 @@ namespace mivt {
 
   void RenderVolume::SaveToImage(const std::string& filename)
   {
+    if (renderBackend_ == "cpu") {
+      LERROR("SaveToImage() is not supported by the CPU backend, use GetPixels() instead");
+      return;
+    }
     output_->saveToImage(filename);
   }
 
   void RenderVolume::SaveToImage(const std::string& filename, const glm::ivec2& newSize)
   {
+    if (renderBackend_ == "cpu") {
+      LERROR("SaveToImage() is not supported by the CPU backend, use GetPixels() instead");
+      return;
+    }
     if (output_->getSize() != newSize) {
       glm::ivec2 oldSize = output_->getSize();
       Resize(newSize);
@@ -430,7 +726,37 @@ namespace mivt {
 
   void RenderVolume::DoSculpt(const std::vector<glm::vec2> & polygon)
   {
-    volumeSculpt_->Process(polygon, camera_, output_->getSize(), volume_->getVoxelToWorldMatrix());
+    volumeSculpt_->Process(polygon, camera_, size_, volume_->getVoxelToWorldMatrix());
+  }
+
+  bool RenderVolume::UndoSculpt()
+  {
+    return volumeSculpt_->Undo();
+  }
+
+  bool RenderVolume::RedoSculpt()
+  {
+    return volumeSculpt_->Redo();
+  }
+
+  bool RenderVolume::CanUndoSculpt()
+  {
+    return volumeSculpt_->GetHistory()->CanUndo();
+  }
+
+  bool RenderVolume::CanRedoSculpt()
+  {
+    return volumeSculpt_->GetHistory()->CanRedo();
+  }
+
+  void RenderVolume::SetSculptHistoryLimit(size_t bytes)
+  {
+    volumeSculpt_->GetHistory()->SetMemoryLimit(bytes);
+  }
+
+  size_t RenderVolume::GetSculptHistoryLimit()
+  {
+    return volumeSculpt_->GetHistory()->GetMemoryLimit();
   }
 
   glm::vec2 RenderVolume::getWindowingDomain() const
@@ -10,6 +10,7 @@ namespace tgt {
   class Geometry;
   class Trackball;
   class Volume;
+  class PixelReadback;
 }
 
 namespace mivt {
@@ -19,6 +20,7 @@ namespace mivt {
   class RenderToScreen;
   class CubeProxyGeometry;
   class VolumeSculpt;
+  class CpuRaycaster;
 
   class RenderVolume : public VolumeRaycaster
   {
@@ -47,6 +49,50 @@ namespace mivt {
 
     void SetClassificationMode(const std::string& mode);
 
+    /// Enables skipping of bricks that are transparent for the current transfer function.
+    void SetEmptySpaceSkipping(bool enable);
+
+    /// Passes the volume parameters to the shader as std140 uniform blocks instead of single uniforms.
+    void SetUniformBlocks(bool enable);
+
+    /**
+    * Selects the proxy geometry of the entry and exit points: "cube" is the clipped bounding box,
+    * "occupancy" the clipped union of the bricks that may contain visible samples.
+    */
+    void SetProxyMode(const std::string& mode);
+    std::string GetProxyMode();
+
+    /// Average number of samples per ray of the last frame rendered by the CPU backend.
+    float GetSamplesPerRay();
+
+    /// Number of mask bytes uploaded to the GPU after the last sculpting on the CPU.
+    size_t GetSculptUploadBytes();
+
+    /**
+    * Selects the renderer: "gpu" raycasts with rc_basic.frag, "cpu" with the CpuRaycaster.
+    * Without OpenGL 3.3 support only "cpu" is available.
+    */
+    void SetRenderBackend(const std::string& backend);
+    std::string GetRenderBackend();
+
+    /**
+    * Selects how GetPixels() reads the image of the GPU backend: "latency" downloads every frame right
+    * after rendering it, "throughput" downloads it asynchronously and returns the newest frame whose
+    * download has completed, usually the previous one, so that consecutive frames overlap. Frames
+    * rendered without downsampling, i.e. outside of interactions, are always returned themselves.
+    */
+    void SetReadbackMode(const std::string& mode);
+    std::string GetReadbackMode();
+
+    /// Milliseconds the last GetPixels() call spent in rendering the frame.
+    float GetRenderTime();
+
+    /// Milliseconds the last GetPixels() call spent in reading an image back.
+    float GetReadbackTime();
+
+    /// Number of frames the image of the last GetPixels() call lags behind the frame it rendered.
+    int GetReadbackLatency();
+
     void SetFirstColor(const glm::vec4 color);
     glm::vec4 GetFirstColor();
 
@@ -80,12 +126,40 @@ namespace mivt {
 
     void DoSculpt(const std::vector<glm::vec2> & polygon);
 
+    /// Reverts the last sculpt operation, returns false if there is none.
+    bool UndoSculpt();
+
+    /// Repeats the last undone sculpt operation, returns false if there is none.
+    bool RedoSculpt();
+
+    bool CanUndoSculpt();
+    bool CanRedoSculpt();
+
+    /// Memory the undo/redo history of the sculpting may take, older operations are discarded beyond.
+    void SetSculptHistoryLimit(size_t bytes);
+    size_t GetSculptHistoryLimit();
+
     glm::vec2 getWindowingDomain() const;
     void setWindowingDomain(glm::vec2 domain);
 
   private:
     void Process(bool downsampling);
 
+    /// Renders with the CpuRaycaster and writes the image directly to buffer.
+    void ProcessCPU(bool downsampling, unsigned char* buffer, size_t length);
+
+    /// Classifies the bricks for empty space skipping and the occupancy proxy geometry.
+    void updateOccupancy();
+
+    /**
+    * Returns the coarsest level of the VolumePyramid that still provides a voxel per pixel
+    * of an image of renderSize, or the volume itself if the pyramid is not available yet.
+    */
+    tgt::Volume* selectInteractionVolume(const glm::ivec2& renderSize);
+
+    /// True if the volume is only available as bricks read from disk, which the GPU backend cannot upload.
+    bool isOutOfCore() const;
+
     /// scale screen-coodinates of mouse to intervall [-1, 1]x[-1, 1]
     glm::vec2 scaleMouse(const glm::ivec2& coords, const glm::ivec2& viewport) const;
 
@@ -106,6 +180,19 @@ namespace mivt {
     RenderToScreen        *renderToScreen_;
     CubeProxyGeometry     *cubeProxyGeometry_;
     VolumeSculpt          *volumeSculpt_;
+    CpuRaycaster          *cpuRaycaster_;
+    tgt::PixelReadback    *readback_;
+
+    std::vector<glm::vec4> cpuImage_;           ///< output of the CpuRaycaster
+    std::string           renderBackend_;       ///< "gpu" or "cpu"
+    bool                  gpuSupported_;        ///< true if rc_basic.frag can be used
+    std::string           readbackMode_;        ///< "latency" or "throughput"
+    float                 renderTime_;          ///< see GetRenderTime()
+    float                 readbackTime_;        ///< see GetReadbackTime()
+    int                   readbackLatency_;     ///< see GetReadbackLatency()
+    glm::ivec2            size_;                ///< viewport size
+
+    static const std::string loggerCat_;
   };
 
 }
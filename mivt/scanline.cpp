@@ -1,5 +1,8 @@
 #include "scanline.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace mivt {
   bool ScanLine::PointInPolygon(const std::vector<glm::vec2> &polygon, const glm::vec2 &point)
   {
@@ -17,4 +20,98 @@ namespace mivt {
     }
     return oddNodes;
   }
+
+  PolygonRaster::PolygonRaster(const std::vector<glm::vec2> &polygon)
+    : polygon_(polygon)
+    , min_(0.f)
+    , max_(0.f)
+    , origin_(0)
+    , size_(0)
+  {
+    if (polygon_.empty())
+      return;
+
+    min_ = max_ = polygon_[0];
+    for (size_t i = 1; i < polygon_.size(); ++i) {
+      min_ = glm::min(min_, polygon_[i]);
+      max_ = glm::max(max_, polygon_[i]);
+    }
+
+    // a margin of two cells, so points outside of the cells are far from every edge
+    origin_ = glm::ivec2(glm::floor(min_)) - 2;
+    size_ = glm::ivec2(glm::ceil(max_)) + 3 - origin_;
+    cells_.assign(static_cast<size_t>(size_.x) * size_.y, CELL_OUTSIDE);
+
+    for (size_t i = 0, j = polygon_.size() - 1; i < polygon_.size(); j = i++)
+      markEdge(polygon_[j], polygon_[i]);
+
+    std::vector<float> crossings;
+    for (int row = 0; row < size_.y; ++row)
+      fillRow(row, crossings);
+  }
+
+  bool PolygonRaster::Contains(const glm::vec2 &point) const
+  {
+    glm::vec2 cell = glm::floor(point) - glm::vec2(origin_);
+    if (!(cell.x >= 0.f && cell.y >= 0.f && cell.x < size_.x && cell.y < size_.y))
+      return false;
+
+    switch (cells_[static_cast<size_t>(cell.y) * size_.x + static_cast<size_t>(cell.x)]) {
+    case CELL_INSIDE:
+      return true;
+    case CELL_BOUNDARY:
+      return ScanLine::PointInPolygon(polygon_, point);
+    default:
+      return false;
+    }
+  }
+
+  glm::vec2 PolygonRaster::GetMin() const
+  {
+    return min_;
+  }
+
+  glm::vec2 PolygonRaster::GetMax() const
+  {
+    return max_;
+  }
+
+  void PolygonRaster::markEdge(const glm::vec2 &a, const glm::vec2 &b)
+  {
+    // samples at most half a pixel apart, every cell the edge passes through is next to
+    // the cell of a sample, and cells without a marked neighbour are a quarter pixel away at least
+    glm::vec2 delta = b - a;
+    int steps = static_cast<int>(std::ceil(2.f * std::max(std::abs(delta.x), std::abs(delta.y)))) + 1;
+    for (int step = 0; step <= steps; ++step) {
+      glm::ivec2 cell = glm::ivec2(glm::floor(a + delta * (static_cast<float>(step) / steps))) - origin_;
+      for (int y = std::max(cell.y - 1, 0); y <= std::min(cell.y + 1, size_.y - 1); ++y) {
+        for (int x = std::max(cell.x - 1, 0); x <= std::min(cell.x + 1, size_.x - 1); ++x)
+          cells_[static_cast<size_t>(y) * size_.x + x] = CELL_BOUNDARY;
+      }
+    }
+  }
+
+  void PolygonRaster::fillRow(int row, std::vector<float> &crossings)
+  {
+    // even-odd rule at the cell centers, with the crossing test of ScanLine::PointInPolygon()
+    float y = origin_.y + row + 0.5f;
+    crossings.clear();
+    for (size_t i = 0, j = polygon_.size() - 1; i < polygon_.size(); j = i++) {
+      const glm::vec2 &pi = polygon_[i];
+      const glm::vec2 &pj = polygon_[j];
+      if (pi.y < y && pj.y >= y || pj.y < y && pi.y >= y)
+        crossings.push_back(pi.x + (y - pi.y) / (pj.y - pi.y) * (pj.x - pi.x));
+    }
+    std::sort(crossings.begin(), crossings.end());
+
+    unsigned char* cells = &cells_[static_cast<size_t>(row) * size_.x];
+    size_t passed = 0;
+    for (int x = 0; x < size_.x; ++x) {
+      float center = origin_.x + x + 0.5f;
+      while (passed < crossings.size() && crossings[passed] < center)
+        ++passed;
+      if (cells[x] != CELL_BOUNDARY)
+        cells[x] = (passed % 2) ? CELL_INSIDE : CELL_OUTSIDE;
+    }
+  }
 }
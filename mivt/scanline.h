@@ -22,6 +22,46 @@ namespace mivt {
     */
     static bool PointInPolygon(const std::vector<glm::vec2> &polygon, const glm::vec2 &point);
   };
-}
 
+  /**
+  * Pixel raster of a polygon for testing many points against it.
+  *
+  * Every pixel cell around the polygon is classified once as inside, outside or boundary.
+  * Cells within a pixel of an edge are boundary cells, only points falling into these
+  * are tested with ScanLine::PointInPolygon(), so Contains() returns exactly the same
+  * results, at constant cost for all other points.
+  */
+  class PolygonRaster
+  {
+  public:
+    PolygonRaster(const std::vector<glm::vec2> &polygon);
+
+    /// Same result as ScanLine::PointInPolygon() for the polygon of the raster.
+    bool Contains(const glm::vec2 &point) const;
+
+    /// Lower left corner of the polygon's bounding box.
+    glm::vec2 GetMin() const;
+
+    /// Upper right corner of the polygon's bounding box.
+    glm::vec2 GetMax() const;
+
+  private:
+    enum CellState {
+      CELL_OUTSIDE = 0,
+      CELL_INSIDE,
+      CELL_BOUNDARY
+    };
+
+    void markEdge(const glm::vec2 &a, const glm::vec2 &b);
+
+    void fillRow(int row, std::vector<float> &crossings);
+
+    std::vector<glm::vec2> polygon_;
+    glm::vec2 min_;
+    glm::vec2 max_;
+    glm::ivec2 origin_;                 ///< pixel coordinates of the first cell
+    glm::ivec2 size_;                   ///< number of cells in x and y
+    std::vector<unsigned char> cells_;  ///< CellState of every cell, x-fastest
+  };
+}
 
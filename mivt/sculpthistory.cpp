@@ -0,0 +1,115 @@
+#include "sculpthistory.h"
+#include "volumemask.h"
+#include "logmanager.h"
+
+#include <algorithm>
+
+namespace mivt {
+
+  const std::string SculptHistory::loggerCat_ = "SculptHistory";
+
+  SculptHistory::SculptHistory(size_t memoryLimit)
+    : numApplied_(0)
+    , numBytes_(0)
+    , memoryLimit_(memoryLimit)
+  {
+  }
+
+  SculptHistory::~SculptHistory()
+  {
+    Clear();
+  }
+
+  void SculptHistory::SetMemoryLimit(size_t bytes)
+  {
+    memoryLimit_ = bytes;
+    shrink();
+  }
+
+  size_t SculptHistory::GetMemoryLimit() const
+  {
+    return memoryLimit_;
+  }
+
+  size_t SculptHistory::GetNumBytes() const
+  {
+    return numBytes_;
+  }
+
+  void SculptHistory::Push(tgt::VolumeMaskDelta* delta)
+  {
+    erase(numApplied_);
+    if (!delta || delta->isEmpty()) {
+      delete delta;
+      return;
+    }
+
+    steps_.push_back(delta);
+    numBytes_ += delta->getNumBytes();
+    ++numApplied_;
+    shrink();
+    if (!CanUndo())
+      LWARNING("Sculpt operation exceeds the memory limit of the history, it cannot be undone");
+  }
+
+  bool SculptHistory::CanUndo() const
+  {
+    return numApplied_ > 0;
+  }
+
+  bool SculptHistory::CanRedo() const
+  {
+    return numApplied_ < steps_.size();
+  }
+
+  bool SculptHistory::Undo(tgt::VolumeMask* mask)
+  {
+    if (!CanUndo() || !mask)
+      return false;
+
+    // a delta records the toggled bits, reverting and repeating it is the same operation
+    mask->applyDelta(*steps_[--numApplied_]);
+    return true;
+  }
+
+  bool SculptHistory::Redo(tgt::VolumeMask* mask)
+  {
+    if (!CanRedo() || !mask)
+      return false;
+
+    mask->applyDelta(*steps_[numApplied_++]);
+    return true;
+  }
+
+  void SculptHistory::Clear()
+  {
+    erase(0);
+  }
+
+  void SculptHistory::erase(size_t first)
+  {
+    while (steps_.size() > first) {
+      numBytes_ -= steps_.back()->getNumBytes();
+      delete steps_.back();
+      steps_.pop_back();
+    }
+    numApplied_ = std::min(numApplied_, first);
+  }
+
+  void SculptHistory::shrink()
+  {
+    // the oldest undo steps go first, then the redo steps farthest from the current state
+    while (numApplied_ > 0 && numBytes_ > memoryLimit_) {
+      numBytes_ -= steps_.front()->getNumBytes();
+      delete steps_.front();
+      steps_.pop_front();
+      --numApplied_;
+    }
+    while (steps_.size() > numApplied_ && numBytes_ > memoryLimit_) {
+      numBytes_ -= steps_.back()->getNumBytes();
+      delete steps_.back();
+      steps_.pop_back();
+    }
+  }
+
+}
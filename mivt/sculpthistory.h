@@ -0,0 +1,66 @@
+#pragma once
+#include <deque>
+#include <string>
+
+namespace tgt {
+  class VolumeMask;
+  class VolumeMaskDelta;
+}
+
+namespace mivt {
+
+  /**
+  * Undo/redo stack of sculpt operations.
+  *
+  * Every step is the tgt::VolumeMaskDelta of one operation, so undo and redo only touch the bricks
+  * changed by it. The oldest steps are discarded when the deltas exceed the memory limit.
+  */
+  class SculptHistory
+  {
+  public:
+    static const size_t DEFAULT_MEMORY_LIMIT = 64 << 20;
+
+    SculptHistory(size_t memoryLimit = DEFAULT_MEMORY_LIMIT);
+    ~SculptHistory();
+
+    /// Discards the oldest steps until the remaining ones fit into \p bytes.
+    void SetMemoryLimit(size_t bytes);
+    size_t GetMemoryLimit() const;
+
+    /// Number of bytes held by the deltas of all steps.
+    size_t GetNumBytes() const;
+
+    /**
+    * Adds the delta of a new operation and takes its ownership. Steps that were undone can no longer
+    * be redone. A delta that exceeds the memory limit on its own clears the history.
+    */
+    void Push(tgt::VolumeMaskDelta* delta);
+
+    bool CanUndo() const;
+    bool CanRedo() const;
+
+    /// Reverts the last operation on \p mask, returns false if there is none.
+    bool Undo(tgt::VolumeMask* mask);
+
+    /// Repeats the last undone operation on \p mask, returns false if there is none.
+    bool Redo(tgt::VolumeMask* mask);
+
+    /// Removes all steps, e.g. when a new mask is created.
+    void Clear();
+
+  private:
+    /// Deletes the steps from index \p first on.
+    void erase(size_t first);
+
+    /// Deletes steps while the history exceeds the memory limit.
+    void shrink();
+
+    std::deque<tgt::VolumeMaskDelta*> steps_;
+    size_t numApplied_;     ///< steps_[0, numApplied_) can be undone, the others redone
+    size_t numBytes_;
+    size_t memoryLimit_;
+
+    static const std::string loggerCat_;
+  };
+
+}
@@ -7,6 +7,9 @@
 #include "textureunit.h"
 #include "transfunc1d.h"
 #include "preintegration.h"
+#include "occupancygrid.h"
+
+#include <cstring>
 
 namespace mivt {
   const std::string VolumeRaycaster::loggerCat_("VolumeRaycaster");
@@ -26,7 +29,10 @@ namespace mivt {
     , shadeMode_("phong")
     , compositingMode_("dvr")
     , maskingMode_("")
+    , emptySpaceSkipping_(true)
+    , uniformBlocks_(true)
     , preintegration_(0)
+    , occupancyGrid_(0)
     , interactionCoarseness_(3) // 1~8
     //, interactionQuality_(1.f)
     //, interactionMode_(false)
@@ -40,16 +46,30 @@ namespace mivt {
 
   void VolumeRaycaster::Initialize() {
     preintegration_ = new PreIntegration(256, false);
+    occupancyGrid_ = new OccupancyGrid();
   }
 
   void VolumeRaycaster::Deinitialize() {
     DELPTR(preintegration_);
+    DELPTR(occupancyGrid_);
+
+    for (std::map<std::string, UniformBuffer>::iterator it = uniformBuffers_.begin(); it != uniformBuffers_.end(); ++it)
+      glDeleteBuffers(1, &it->second.id_);
+    uniformBuffers_.clear();
   }
 
   std::string VolumeRaycaster::GetClassificationMode() {
     return classificationMode_;
   }
 
+  bool VolumeRaycaster::GetEmptySpaceSkipping() {
+    return emptySpaceSkipping_;
+  }
+
+  bool VolumeRaycaster::GetUniformBlocks() {
+    return uniformBlocks_;
+  }
+
   std::string VolumeRaycaster::generateHeader() 
   {
     std::string headerSource = "#version 330\n";
@@ -71,6 +91,12 @@ namespace mivt {
     if (shadeMode_ == "phong")
       headerSource += "phongShading(n, pos, lPos, cPos, ka, kd, ks);\n";
 
+    if (emptySpaceSkipping_)
+      headerSource += "#define EMPTY_SPACE_SKIPPING\n";
+
+    if (uniformBlocks_)
+      headerSource += "#define VOLUME_PARAMETER_BLOCKS\n";
+
     return headerSource;
   }
 
@@ -126,8 +152,15 @@ namespace mivt {
 
     success &= bindVolumeTexture(volumeStruct.volume_, texUnit, volumeStruct.filterMode_, volumeStruct.wrapMode_, volumeStruct.borderColor_);
 
-    // set volume meta-data
-    setUniform(shader, volumeStruct.volumeIdentifier_, volumeStruct.volumeStructIdentifier_, volumeStruct.volume_, texUnit, camera, lightPosition);
+    // set volume meta-data, in one buffer update if the shader declares the struct as uniform block
+    GLuint blockIndex = GL_INVALID_INDEX;
+    if (uniformBlocks_)
+      blockIndex = shader->getUniformBlockIndex(volumeStruct.volumeStructIdentifier_ + "Block");
+    if (blockIndex != GL_INVALID_INDEX)
+      setUniformBlock(shader, blockIndex, volumeStruct.volumeIdentifier_, volumeStruct.volumeStructIdentifier_,
+        volumeStruct.volume_, texUnit, camera, lightPosition);
+    else
+      setUniform(shader, volumeStruct.volumeIdentifier_, volumeStruct.volumeStructIdentifier_, volumeStruct.volume_, texUnit, camera, lightPosition);
 
     shader->setUniform("samplingStepSize_", CalculateSamplingStepSize(volumeStruct.volume_));
 
@@ -178,46 +211,44 @@ namespace mivt {
     return true;
   }
 
-  void VolumeRaycaster::setUniform(tgt::Shader* shader, const std::string& volumeUniform, const std::string& structUniform,
-    tgt::Volume* vh, const tgt::TextureUnit* texUnit, const tgt::Camera* camera, const glm::vec4& lightPosition) 
+  VolumeRaycaster::VolumeParameters VolumeRaycaster::getVolumeParameters(tgt::Volume* vh, const tgt::Camera* camera,
+    const glm::vec4& lightPosition)
   {
-    if (texUnit)
-      shader->setUniform(volumeUniform, texUnit->getUnitNumber());
+    VolumeParameters params;
+    memset(&params, 0, sizeof(params));
 
     // volume size, i.e. dimensions of the proxy geometry in world coordinates
-    shader->setUniform(structUniform + ".datasetDimensions_", glm::vec3(vh->getDimensions()));
-    shader->setUniform(structUniform + ".datasetDimensionsRCP_", glm::vec3(1.f) / glm::vec3(vh->getDimensions()));
+    params.datasetDimensions_ = glm::vec3(vh->getDimensions());
+    params.datasetDimensionsRCP_ = glm::vec3(1.f) / glm::vec3(vh->getDimensions());
 
     // volume spacing, i.e. voxel size
-    shader->setUniform(structUniform + ".datasetSpacing_", vh->getSpacing());
-    shader->setUniform(structUniform + ".datasetSpacingRCP_", glm::vec3(1.f) / vh->getSpacing());
+    params.datasetSpacing_ = vh->getSpacing();
+    params.datasetSpacingRCP_ = glm::vec3(1.f) / vh->getSpacing();
 
     // volume's size in its physical coordinates
-    shader->setUniform(structUniform + ".volumeCubeSize_", vh->getCubeSize());
-    shader->setUniform(structUniform + ".volumeCubeSizeRCP_", glm::vec3(1.f) / vh->getCubeSize());
+    params.volumeCubeSize_ = vh->getCubeSize();
+    params.volumeCubeSizeRCP_ = glm::vec3(1.f) / vh->getCubeSize();
 
-    shader->setUniform(structUniform + ".volumeOffset_", vh->getOffset());
+    params.volumeOffset_ = vh->getOffset();
 
     // volume's transformation matrix
-    shader->setUniform(structUniform + ".physicalToWorldMatrix_", vh->getPhysicalToWorldMatrix());
+    params.physicalToWorldMatrix_ = vh->getPhysicalToWorldMatrix();
 
     glm::mat4 invTm = vh->getWorldToPhysicalMatrix();
-    shader->setUniform(structUniform + ".worldToPhysicalMatrix_", invTm);
+    params.worldToPhysicalMatrix_ = invTm;
 
-    shader->setUniform(structUniform + ".worldToTextureMatrix_", vh->getWorldToTextureMatrix());
-    shader->setUniform(structUniform + ".textureToWorldMatrix_", vh->getTextureToWorldMatrix());
+    params.worldToTextureMatrix_ = vh->getWorldToTextureMatrix();
+    params.textureToWorldMatrix_ = vh->getTextureToWorldMatrix();
 
     // camera position in volume object coords
     if (camera)
-      shader->setUniform(structUniform + ".cameraPositionPhysical_", glm::mapPoint(invTm, camera->getPosition()));
+      params.cameraPositionPhysical_ = glm::mapPoint(invTm, camera->getPosition());
 
     // light position in volume object coords
-    shader->setUniform(structUniform + ".lightPositionPhysical_", (invTm*lightPosition).xyz());
-
-    LGL_ERROR;
+    params.lightPositionPhysical_ = (invTm*lightPosition).xyz();
 
     // bit depth of the volume
-    shader->setUniform(structUniform + ".bitDepth_", (GLint)(vh->getBytesPerVoxel() * 8));
+    params.bitDepth_ = (GLint)(vh->getBytesPerVoxel() * 8);
 
     // construct shader value mapping by combining volume value mapping and pixel transfer mapping
     tgt::ValueMapping rescaleMapping = vh->getRescaleMapping();
@@ -227,8 +258,64 @@ namespace mivt {
     else
       LWARNING("setUniform(): no VolumeGL");
     tgt::ValueMapping shaderMapping = tgt::ValueMapping::combine(transferMapping.getInverseMapping(), rescaleMapping);
-    shader->setUniform(structUniform + ".vmScale_", shaderMapping.getScale());
-    shader->setUniform(structUniform + ".vmOffset_", shaderMapping.getOffset());
+    params.vmScale_ = shaderMapping.getScale();
+    params.vmOffset_ = shaderMapping.getOffset();
+
+    return params;
+  }
+
+  void VolumeRaycaster::setUniform(tgt::Shader* shader, const std::string& volumeUniform, const std::string& structUniform,
+    tgt::Volume* vh, const tgt::TextureUnit* texUnit, const tgt::Camera* camera, const glm::vec4& lightPosition) 
+  {
+    if (texUnit)
+      shader->setUniform(volumeUniform, texUnit->getUnitNumber());
+
+    VolumeParameters params = getVolumeParameters(vh, camera, lightPosition);
+    shader->setUniform(structUniform + ".datasetDimensions_", params.datasetDimensions_);
+    shader->setUniform(structUniform + ".datasetDimensionsRCP_", params.datasetDimensionsRCP_);
+    shader->setUniform(structUniform + ".datasetSpacing_", params.datasetSpacing_);
+    shader->setUniform(structUniform + ".datasetSpacingRCP_", params.datasetSpacingRCP_);
+    shader->setUniform(structUniform + ".volumeCubeSize_", params.volumeCubeSize_);
+    shader->setUniform(structUniform + ".volumeCubeSizeRCP_", params.volumeCubeSizeRCP_);
+    shader->setUniform(structUniform + ".volumeOffset_", params.volumeOffset_);
+    shader->setUniform(structUniform + ".physicalToWorldMatrix_", params.physicalToWorldMatrix_);
+    shader->setUniform(structUniform + ".worldToPhysicalMatrix_", params.worldToPhysicalMatrix_);
+    shader->setUniform(structUniform + ".worldToTextureMatrix_", params.worldToTextureMatrix_);
+    shader->setUniform(structUniform + ".textureToWorldMatrix_", params.textureToWorldMatrix_);
+    if (camera)
+      shader->setUniform(structUniform + ".cameraPositionPhysical_", params.cameraPositionPhysical_);
+    shader->setUniform(structUniform + ".lightPositionPhysical_", params.lightPositionPhysical_);
+    LGL_ERROR;
+
+    shader->setUniform(structUniform + ".bitDepth_", params.bitDepth_);
+    shader->setUniform(structUniform + ".vmScale_", params.vmScale_);
+    shader->setUniform(structUniform + ".vmOffset_", params.vmOffset_);
+  }
+
+  void VolumeRaycaster::setUniformBlock(tgt::Shader* shader, GLuint blockIndex, const std::string& volumeUniform,
+    const std::string& structUniform, tgt::Volume* vh, const tgt::TextureUnit* texUnit,
+    const tgt::Camera* camera, const glm::vec4& lightPosition)
+  {
+    if (texUnit)
+      shader->setUniform(volumeUniform, texUnit->getUnitNumber());
+
+    std::map<std::string, UniformBuffer>::iterator it = uniformBuffers_.find(structUniform);
+    if (it == uniformBuffers_.end()) {
+      UniformBuffer buffer;
+      glGenBuffers(1, &buffer.id_);
+      buffer.binding_ = static_cast<GLuint>(uniformBuffers_.size());
+      it = uniformBuffers_.insert(std::make_pair(structUniform, buffer)).first;
+    }
+    const UniformBuffer& buffer = it->second;
+
+    VolumeParameters params = getVolumeParameters(vh, camera, lightPosition);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer.id_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(params), &params, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, buffer.binding_, buffer.id_);
+    glUniformBlockBinding(shader->getID(), blockIndex, buffer.binding_);
+    LGL_ERROR;
   }
 
   float VolumeRaycaster::CalculateSamplingStepSize(tgt::Volume* vh) {
@@ -279,6 +366,33 @@ namespace mivt {
     }
   }
 
+  void VolumeRaycaster::updateOccupancyGrid(tgt::Volume* volume, tgt::TransFunc1D* tf) {
+    if (!tf)
+      occupancyGrid_->Reset();
+    else if (tgt::startsWith(classificationMode_, "pre-integrated"))
+      occupancyGrid_->Update(volume, tf, static_cast<int>(preintegration_->getResolution()));
+    else if (classificationMode_ == "transfer-function")
+      occupancyGrid_->Update(volume, tf, tf->getDimensions().x);
+    else
+      occupancyGrid_->Reset();
+  }
+
+  void VolumeRaycaster::bindOccupancyGrid(tgt::Shader* shader, const tgt::TextureUnit* texUnit) {
+    texUnit->activate();
+    occupancyGrid_->GetTexture()->bind();
+    LGL_ERROR;
+
+    shader->setIgnoreUniformLocationError(true);
+    shader->setUniform("occupancy_", texUnit->getUnitNumber());
+    shader->setUniform("occupancyStruct_.volumeDimensions_", glm::vec3(occupancyGrid_->GetVolumeDimensions()));
+    shader->setUniform("occupancyStruct_.brickCount_", glm::vec3(occupancyGrid_->GetBrickDimensions()));
+    shader->setUniform("occupancyStruct_.brickSize_", static_cast<float>(occupancyGrid_->GetBrickSize()));
+    shader->setUniform("occupancyStruct_.brickSizeRCP_", 1.f / occupancyGrid_->GetBrickSize());
+    shader->setIgnoreUniformLocationError(false);
+
+    texUnit->setZeroUnit();
+  }
+
   void VolumeRaycaster::SetLightAmbient(const glm::vec4& v) {
     lightAmbient_ = v;
   }
@@ -311,6 +425,25 @@ namespace mivt {
     return materialShininess_;
   }
 
+  void VolumeRaycaster::CopyParameters(const VolumeRaycaster& raycaster) {
+    lightPosition_ = raycaster.lightPosition_;
+    lightAmbient_ = raycaster.lightAmbient_;
+    lightDiffuse_ = raycaster.lightDiffuse_;
+    lightSpecular_ = raycaster.lightSpecular_;
+    lightAttenuation_ = raycaster.lightAttenuation_;
+    applyLightAttenuation_ = raycaster.applyLightAttenuation_;
+    materialShininess_ = raycaster.materialShininess_;
+    samplingRate_ = raycaster.samplingRate_;
+    gradientMode_ = raycaster.gradientMode_;
+    classificationMode_ = raycaster.classificationMode_;
+    shadeMode_ = raycaster.shadeMode_;
+    compositingMode_ = raycaster.compositingMode_;
+    maskingMode_ = raycaster.maskingMode_;
+    emptySpaceSkipping_ = raycaster.emptySpaceSkipping_;
+    uniformBlocks_ = raycaster.uniformBlocks_;
+    interactionCoarseness_ = raycaster.interactionCoarseness_;
+  }
+
   //------------------------------------------------------------------------------
 
   VolumeRaycaster::VolumeStruct::VolumeStruct()
@@ -3,6 +3,8 @@
 #include "tgt_gl.h"
 #include "renderbase.h"
 
+#include <map>
+
 namespace tgt {
   class Volume;
   class TextureUnit;
@@ -12,6 +14,7 @@ namespace tgt {
 namespace mivt {
 
   class PreIntegration;
+  class OccupancyGrid;
 
   /**
   * All processors that access volume data in shaders
@@ -35,6 +38,12 @@ namespace mivt {
 
     std::string GetClassificationMode();
 
+    /// Returns true if transparent bricks of the volume are skipped during ray traversal.
+    bool GetEmptySpaceSkipping();
+
+    /// Returns true if the volume parameter structs are passed as uniform blocks instead of single uniforms.
+    bool GetUniformBlocks();
+
     void SetLightAmbient(const glm::vec4& v);
     glm::vec4 GetLightAmbient();
 
@@ -47,6 +56,12 @@ namespace mivt {
     void SetMaterialShininess(float v);
     float GetMaterialShininess();
 
+    /**
+    * Takes over light, material, sampling and mode settings of another raycaster,
+    * e.g. to render the same scene with a different backend.
+    */
+    void CopyParameters(const VolumeRaycaster& raycaster);
+
   protected:
     /**
     * This struct contains information about a volume. It is exclusively used
@@ -112,7 +127,65 @@ namespace mivt {
     /// Calculate sampling step size for a given volume using the current sampling rate
     float CalculateSamplingStepSize(tgt::Volume* vh);
 
+    /**
+    * Classifies the bricks of the volume with the transfer function for the current
+    * classification mode. Without empty space skipping, the grid holds a single occupied brick.
+    */
+    void updateOccupancyGrid(tgt::Volume* volume, tgt::TransFunc1D* tf);
+
+    /// Binds the occupancy grid texture and passes it to the shader, see transparentSteps() in mod_raysetup.frag.
+    void bindOccupancyGrid(tgt::Shader* shader, const tgt::TextureUnit* texUnit);
+
   private:
+    /**
+    * The volume parameter struct of mod_sampler3d.frag in std140 layout, as uploaded into the uniform
+    * buffer of a "<structIdentifier>Block" uniform block. Scalars following a vec3 share its 16 bytes.
+    */
+    struct VolumeParameters {
+      glm::vec3 datasetDimensions_;
+      float padding0_;
+      glm::vec3 datasetDimensionsRCP_;
+      float padding1_;
+      glm::vec3 datasetSpacing_;
+      float padding2_;
+      glm::vec3 datasetSpacingRCP_;
+      float padding3_;
+      glm::vec3 volumeCubeSize_;
+      float padding4_;
+      glm::vec3 volumeCubeSizeRCP_;
+      float padding5_;
+      glm::vec3 volumeOffset_;
+      GLint bitDepth_;
+      float vmScale_;
+      float vmOffset_;
+      float padding6_[2];
+      glm::mat4 physicalToWorldMatrix_;
+      glm::mat4 worldToPhysicalMatrix_;
+      glm::mat4 worldToTextureMatrix_;
+      glm::mat4 textureToWorldMatrix_;
+      glm::vec3 cameraPositionPhysical_;
+      float padding7_;
+      glm::vec3 lightPositionPhysical_;
+      float padding8_;
+    };
+
+    /// Uniform buffer of a volume parameter struct and the binding point it is bound to.
+    struct UniformBuffer {
+      GLuint id_;
+      GLuint binding_;
+    };
+
+    /// Computes the volume parameters of \p vh, the camera position stays zero without \p camera.
+    static VolumeParameters getVolumeParameters(tgt::Volume* vh, const tgt::Camera* camera,
+      const glm::vec4& lightPosition);
+
+    /**
+    * Uploads the volume parameters into the uniform buffer of \p structUniform and binds it to the
+    * block \p blockIndex, instead of setting the struct members one by one as setUniform() does.
+    */
+    void setUniformBlock(tgt::Shader* shader, GLuint blockIndex, const std::string& volumeUniform,
+      const std::string& structUniform, tgt::Volume* vh, const tgt::TextureUnit* texUnit,
+      const tgt::Camera* camera, const glm::vec4& lightPosition);
 
     static bool bindVolumeTexture(tgt::Volume* vh, const tgt::TextureUnit* texUnit,
       GLint filterMode = GL_LINEAR, GLint wrapMode = GL_CLAMP_TO_EDGE, glm::vec4 borderColor = glm::vec4(0.f));
@@ -169,12 +242,16 @@ namespace mivt {
     std::string shadeMode_;                   ///< What shading method should be applied
     std::string compositingMode_;             ///< What compositing mode should be applied
     std::string maskingMode_;                 ///< What masking should be applied
+    bool emptySpaceSkipping_;                 ///< Skip bricks that are transparent for the transfer function
+    bool uniformBlocks_;                      ///< Pass the volume parameters as std140 uniform blocks
 
     int interactionCoarseness_;               ///< RenderPorts are resized to size_/interactionCoarseness_ in interactionmode
     //float interactionQuality_;
     //bool interactionMode_;
 
     PreIntegration *preintegration_;     ///< compute and cache pre-integration table
+    OccupancyGrid  *occupancyGrid_;      ///< transparent bricks for empty space skipping
+    std::map<std::string, UniformBuffer> uniformBuffers_; ///< per volume parameter struct, see setUniformBlock()
 
     static const std::string loggerCat_;
   };
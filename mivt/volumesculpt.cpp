@@ -1,18 +1,71 @@
 #include "volumesculpt.h"
 #include "logmanager.h"
-#include "volumeatomic.h"
+#include "volumemask.h"
 #include "volume.h"
 #include "camera.h"
 #include "scanline.h"
+#include "sculpthistory.h"
 #include "shadermanager.h"
 #include "volumegl.h"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
 namespace mivt {
 
+  namespace {
+
+    /// Culls boxes of voxels against the bounding box of the lasso in window coordinates.
+    class LassoCull {
+    public:
+      LassoCull(const glm::mat4& volume2ClipCoord, const glm::ivec2& viewSize,
+        const glm::vec2& lassoMin, const glm::vec2& lassoMax)
+        : volume2ClipCoord_(volume2ClipCoord)
+        , halfViewSize_(glm::vec2(viewSize) * 0.5f)
+        , lassoMin_(lassoMin - 1.f)
+        , lassoMax_(lassoMax + 1.f)
+      {
+      }
+
+      /// Window coordinates as computed by sculpt.comp.
+      glm::vec2 toWindow(const glm::vec4& clip) const {
+        glm::vec4 point = clip / clip.w;
+        return glm::vec2(point.x * halfViewSize_.x + halfViewSize_.x, point.y * halfViewSize_.y + halfViewSize_.y);
+      }
+
+      /// A box misses the lasso if the projection of its corners misses the bounding box of the lasso,
+      /// which is only valid if all corners are in front of the camera.
+      bool misses(const glm::ivec3& first, const glm::ivec3& last) const {
+        glm::vec2 windowMin(std::numeric_limits<float>::max());
+        glm::vec2 windowMax(-std::numeric_limits<float>::max());
+        for (int i = 0; i < 8; ++i) {
+          glm::vec3 corner((i & 1) ? last.x : first.x, (i & 2) ? last.y : first.y, (i & 4) ? last.z : first.z);
+          glm::vec4 clip = volume2ClipCoord_ * glm::vec4(corner, 1.f);
+          if (!(clip.w > 0.f))
+            return false;
+          glm::vec2 window = toWindow(clip);
+          windowMin = glm::min(windowMin, window);
+          windowMax = glm::max(windowMax, window);
+        }
+        return glm::any(glm::lessThan(windowMax, lassoMin_)) || glm::any(glm::greaterThan(windowMin, lassoMax_));
+      }
+
+    private:
+      glm::mat4 volume2ClipCoord_;
+      glm::vec2 halfViewSize_;
+      glm::vec2 lassoMin_;
+      glm::vec2 lassoMax_;
+    };
+
+  }
+
   const std::string VolumeSculpt::loggerCat_ = "VolumeSculpt";
 
   VolumeSculpt::VolumeSculpt(bool computeOnGPU)
     : maskVolume_(0)
+    , history_(new SculptHistory())
     , computeOnGPU_(computeOnGPU)
   {
     if (computeOnGPU_) {
@@ -33,78 +86,167 @@ namespace mivt {
 
       glDeleteBuffers(1, &polygonBufferId_);
     }
+
+    DELPTR(history_);
   }
 
   void VolumeSculpt::SetMaskVolume(tgt::Volume *volume)
   {
     maskVolume_ = volume;
+    history_->Clear();
   }
 
   void VolumeSculpt::Process(const std::vector<glm::vec2> &polygon,
     tgt::Camera *cam, const glm::ivec2 viewSize,
     const glm::mat4& voxelToWorld)
   {
-    if (computeOnGPU_)
-      SculptGPU(polygon, cam, viewSize, voxelToWorld);
+    // the mask only has a texture while the GPU backend renders, e.g. not for out-of-core volumes
+    tgt::VolumeMaskDelta* delta = new tgt::VolumeMaskDelta();
+    bool successful = computeOnGPU_ && maskVolume_ && maskVolume_->hasRepresentation<tgt::VolumeGL>()
+      ? SculptGPU(polygon, cam, viewSize, voxelToWorld, *delta)
+      : SculptCPU(polygon, cam, viewSize, voxelToWorld, *delta);
+    if (successful)
+      history_->Push(delta);
     else
-      SculptCPU(polygon, cam, viewSize, voxelToWorld);
+      delete delta;
+  }
+
+  bool VolumeSculpt::Undo()
+  {
+    tgt::VolumeMask* mask = maskVolume_ ? maskVolume_->hasRepresentation<tgt::VolumeMask>() : 0;
+    if (!history_->Undo(mask))
+      return false;
+
+    syncMask();
+    return true;
+  }
+
+  bool VolumeSculpt::Redo()
+  {
+    tgt::VolumeMask* mask = maskVolume_ ? maskVolume_->hasRepresentation<tgt::VolumeMask>() : 0;
+    if (!history_->Redo(mask))
+      return false;
+
+    syncMask();
+    return true;
+  }
+
+  SculptHistory* VolumeSculpt::GetHistory() const
+  {
+    return history_;
+  }
+
+  void VolumeSculpt::syncMask()
+  {
+    // without OpenGL raycasting the mask is only used in RAM
+    if (maskVolume_->hasRepresentation<tgt::VolumeGL>())
+      maskVolume_->SyncData();
   }
 
   bool VolumeSculpt::SculptCPU(const std::vector<glm::vec2> &polygon,
-    tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld)
+    tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld,
+    tgt::VolumeMaskDelta& delta)
   {
     if (polygon.size() < 3) {
       LERROR("polygon points less than 3");
       return false;
     }
 
-    unsigned char* data = reinterpret_cast<uint8_t*>(maskVolume_->getRepresentation<tgt::VolumeRAM>()->getData());
-    if (!data) {
+    tgt::VolumeMask* mask = maskVolume_->hasRepresentation<tgt::VolumeMask>();
+    if (!mask) {
       LERROR("mask volume not allocated.");
       return false;
     }
 
-    glm::ivec3 volume_dim = maskVolume_->getDimensions();
-    glm::mat4 volume2ClipCoord = cam->getProjectionMatrix(viewSize)
+    const glm::ivec3 volume_dim = maskVolume_->getDimensions();
+    const glm::mat4 volume2ClipCoord = cam->getProjectionMatrix(viewSize)
       * cam->getViewMatrix()
       * voxelToWorld;
-    float zNear = cam->getNearDist();
-    float zFar = cam->getFarDist();
 
-    for (int idz = 0; idz < volume_dim.z; ++idz) {
-      for (int idy = 0; idy < volume_dim.y; ++idy) {
-        for (int idx = 0; idx < volume_dim.x; ++idx) {
-          glm::vec4 point = glm::vec4(idx, idy, idz, 1);
-          point = volume2ClipCoord * point;
+    const PolygonRaster raster(polygon);
+    const LassoCull cull(volume2ClipCoord, viewSize, raster.GetMin(), raster.GetMax());
 
-          // NDC
-          point /= point.w;
+    // the bricks of the mask are culled against the lasso and distributed over the threads,
+    // so every brick is modified by one thread only
+    const int brickSize = tgt::VolumeMask::BRICK_SIZE;
+    const int numBricks = static_cast<int>(glm::hmul(mask->getNumBricks()));
+    std::atomic<int> nextBrick(0);
 
-          // Window Coordinate
-          point.x = point.x * viewSize.x * 0.5f + viewSize.x * 0.5f;
-          point.y = point.y * viewSize.y * 0.5f + viewSize.y * 0.5f;
-          point.z = point.z * (zFar - zNear) * 0.5f + (zFar + zNear) * 0.5f;
+    // every thread records the bricks it modified, the deltas are joined afterwards
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<tgt::VolumeMaskDelta> deltas(numThreads);
 
-          if (ScanLine::PointInPolygon(polygon, glm::dvec2(point))) {
-            data[idz * volume_dim.y * volume_dim.x + idy * volume_dim.x + idx] = 255;
+    auto worker = [&](tgt::VolumeMaskDelta* threadDelta) {
+      std::vector<uint32_t> xorRows(brickSize * brickSize);
+      for (int brick = nextBrick++; brick < numBricks; brick = nextBrick++) {
+        const tgt::VolumeMask::BrickState state = mask->getBrickState(brick);
+        if (state == tgt::VolumeMask::FULL)
+          continue;
+        glm::ivec3 first = mask->getBrickOffset(brick);
+        glm::ivec3 end = glm::min(first + brickSize, volume_dim);
+        if (cull.misses(first, end - 1))
+          continue;
+
+        // the rows of the brick are only expanded once the first voxel is removed
+        const uint32_t* rows = mask->getBrickRows(brick);
+        uint32_t* editedRows = 0;
+        std::fill(xorRows.begin(), xorRows.end(), 0);
+        for (int idz = first.z; idz < end.z; ++idz) {
+          for (int idy = first.y; idy < end.y; ++idy) {
+            const int row = (idz - first.z) * brickSize + idy - first.y;
+            const uint32_t previous = rows ? rows[row] : 0;
+            uint32_t bits = previous;
+            // the projection is advanced along the row by adding multiples of the first column
+            glm::vec4 rowStart = volume2ClipCoord * glm::vec4(0.f, static_cast<float>(idy), static_cast<float>(idz), 1.f);
+            for (int idx = first.x; idx < end.x; ++idx) {
+              const uint32_t bit = 1u << (idx - first.x);
+              if (!(bits & bit) && raster.Contains(cull.toWindow(rowStart + volume2ClipCoord[0] * static_cast<float>(idx))))
+                bits |= bit;
+            }
+            if (bits != previous) {
+              if (!editedRows)
+                rows = editedRows = mask->editBrickRows(brick);
+              editedRows[row] = bits;
+              xorRows[row] = bits ^ previous;
+            }
           }
         }
+
+        if (editedRows) {
+          mask->compactBrick(brick);
+          if (state == tgt::VolumeMask::EMPTY && mask->getBrickState(brick) == tgt::VolumeMask::FULL)
+            threadDelta->addInvertedBrick(brick);
+          else
+            threadDelta->addBrick(brick, &xorRows[0]);
+        }
       }
-    }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < numThreads; ++i)
+      workers.push_back(std::thread(worker, &deltas[i]));
+    worker(&deltas[0]);
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+
+    for (size_t i = 0; i < deltas.size(); ++i)
+      delta.append(deltas[i]);
 
-    maskVolume_->SyncData();
+    // SyncData() uploads the bricks modified by editBrickRows()
+    syncMask();
     return true;
   }
 
   bool VolumeSculpt::SculptGPU(const std::vector<glm::vec2> &polygon,
-    tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld)
+    tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld,
+    tgt::VolumeMaskDelta& delta)
   {
     bool successful = true;
 
     // mask
     shaderProgram_->activate();
     int maskid = maskVolume_->getRepresentation<tgt::VolumeGL>()->getTexture()->getId();
-    glBindImageTexture(0, maskid, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
+    glBindImageTexture(0, maskid, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
 
     // pack polygon data
     int poly_number = (int)polygon.size();
@@ -139,11 +281,54 @@ namespace mivt {
     glDispatchCompute((volume_dim.x + 15) / 16, (volume_dim.y + 15) / 16, volume_dim.z);
 
     // cleanup
-    glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
+    glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
     shaderProgram_->deactivate();
 
     glFinish();
+
+    // read the bricks the lasso can reach back to keep the mask in RAM for the CPU backend and to
+    // record the change, the texture is up to date already
+    tgt::VolumeMask* mask = maskVolume_->hasRepresentation<tgt::VolumeMask>();
+    glm::vec2 lassoMin(std::numeric_limits<float>::max());
+    glm::vec2 lassoMax(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < polygon.size(); ++i) {
+      lassoMin = glm::min(lassoMin, polygon[i]);
+      lassoMax = glm::max(lassoMax, polygon[i]);
+    }
+    const LassoCull cull(volume2ClipCoord, viewSize, lassoMin, lassoMax);
+
+    const int brickSize = tgt::VolumeMask::BRICK_SIZE;
+    const glm::ivec3 numBricks = mask->getNumBricks();
+    glm::ivec3 firstBrick = numBricks;
+    glm::ivec3 endBrick(0);
+    for (int bz = 0; bz < numBricks.z; ++bz) {
+      for (int by = 0; by < numBricks.y; ++by) {
+        for (int bx = 0; bx < numBricks.x; ++bx) {
+          glm::ivec3 first = glm::ivec3(bx, by, bz) * brickSize;
+          glm::ivec3 end = glm::min(first + brickSize, volume_dim);
+          if (cull.misses(first, end - 1))
+            continue;
+          firstBrick = glm::min(firstBrick, glm::ivec3(bx, by, bz));
+          endBrick = glm::max(endBrick, glm::ivec3(bx, by, bz) + 1);
+        }
+      }
+    }
+
+    if (glm::all(glm::lessThan(firstBrick, endBrick))) {
+      // one texel holds a row of a brick
+      const tgt::VolumeTexture* texture = maskVolume_->getRepresentation<tgt::VolumeGL>()->getTexture();
+      const glm::ivec3 wordOffset(firstBrick.x, firstBrick.y * brickSize, firstBrick.z * brickSize);
+      const glm::ivec3 wordEnd(endBrick.x, std::min(endBrick.y * brickSize, volume_dim.y),
+        std::min(endBrick.z * brickSize, volume_dim.z));
+      const glm::ivec3 wordDimensions = wordEnd - wordOffset;
+      std::vector<uint32_t> words(glm::hmul(wordDimensions));
+      texture->downloadTextureRegion(reinterpret_cast<GLubyte*>(&words[0]), wordOffset, wordDimensions);
+      mask->unpackBricks(&words[0], wordDimensions, firstBrick, endBrick, &delta);
+    }
+    mask->takeDirtyRegions();
+    LGL_ERROR;
+
     return successful;
   }
 }
@@ -4,32 +4,51 @@
 
 namespace tgt {
   class Volume;
+  class VolumeMaskDelta;
   class Camera;
   class Shader;
 }
 
 namespace mivt {
+  class SculptHistory;
+
   class VolumeSculpt
   {
   public:
     VolumeSculpt(bool computeOnGPU = false);
     ~VolumeSculpt();
 
+    /// Sets the volume holding the tgt::VolumeMask to sculpt and clears the history.
     void SetMaskVolume(tgt::Volume *maskVolume);
 
+    /// Removes the voxels inside the polygon and records the change in the history.
     void Process(const std::vector<glm::vec2> &polygon,
       tgt::Camera *cam, const glm::ivec2 viewSize, 
       const glm::mat4& voxelToWorld);
 
+    /// Reverts the last sculpt operation, returns false if there is none.
+    bool Undo();
+
+    /// Repeats the last undone sculpt operation, returns false if there is none.
+    bool Redo();
+
+    SculptHistory* GetHistory() const;
+
   private:
     bool SculptCPU(const std::vector<glm::vec2> &polygon,
-      tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld);
+      tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld,
+      tgt::VolumeMaskDelta& delta);
 
     bool SculptGPU(const std::vector<glm::vec2> &polygon,
-      tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld);
+      tgt::Camera *cam, const glm::ivec2 viewSize, const glm::mat4& voxelToWorld,
+      tgt::VolumeMaskDelta& delta);
+
+    /// Uploads the bricks modified in RAM, if the mask is used by OpenGL.
+    void syncMask();
 
   private:
     tgt::Volume *maskVolume_;
+    SculptHistory *history_;
     tgt::Shader *shaderProgram_;
     uint32_t polygonBufferId_;
     bool computeOnGPU_;
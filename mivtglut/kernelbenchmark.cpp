@@ -0,0 +1,107 @@
+#include "kernelbenchmark.h"
+#include "volumeatomic.h"
+#include "volumekernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+using tgt::VolumeKernels;
+
+namespace {
+
+  const int VOLUME_SIZE = 512;
+  const int NUM_RUNS = 3;
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  // returns the best throughput of NUM_RUNS runs in GB/s
+  double measure(const std::function<void()>& kernel, size_t numBytes) {
+    double best = 0.0;
+    for (int run = 0; run < NUM_RUNS; ++run) {
+      Clock::time_point start = Clock::now();
+      kernel();
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (seconds > 0.0)
+        best = std::max(best, numBytes / seconds / 1e9);
+    }
+    return best;
+  }
+
+  template<class T>
+  void benchmarkVolume(const char* typeName) {
+    tgt::VolumeAtomic<T>* volume = 0;
+    try {
+      volume = new tgt::VolumeAtomic<T>(glm::ivec3(VOLUME_SIZE));
+    }
+    catch (std::bad_alloc&) {
+      printf("%-18s skipped, not enough memory\n", typeName);
+      return;
+    }
+
+    unsigned char* data = static_cast<unsigned char*>(volume->getData());
+    const size_t numBytes = volume->getNumBytes();
+    const size_t rowSize = VOLUME_SIZE * sizeof(T);
+    const size_t sliceSize = rowSize * VOLUME_SIZE;
+    for (size_t i = 0; i < numBytes; ++i)
+      data[i] = static_cast<unsigned char>(i * 7);
+
+    VolumeKernels::InstructionSet previous = VolumeKernels::getInstructionSet();
+    for (int set = VolumeKernels::SCALAR; set <= VolumeKernels::getSupportedInstructionSet(); ++set) {
+      VolumeKernels::setInstructionSet(static_cast<VolumeKernels::InstructionSet>(set));
+
+      double swap = measure([&]() {
+        volume->swapEndianness();
+      }, numBytes);
+
+      double rows = measure([&]() {
+        for (size_t row = 0; row < numBytes / rowSize; ++row)
+          VolumeKernels::reverse(data + row * rowSize, VOLUME_SIZE, sizeof(T));
+      }, numBytes);
+
+      // swaps the rows of each slice like VolumeReader::reverseYSliceOrder()
+      double columns = measure([&]() {
+        for (int z = 0; z < VOLUME_SIZE; ++z) {
+          unsigned char* slice = data + z * sliceSize;
+          for (int y = 0; y < VOLUME_SIZE / 2; ++y)
+            VolumeKernels::swapRanges(slice + y * rowSize, slice + (VOLUME_SIZE - 1 - y) * rowSize, rowSize);
+        }
+      }, numBytes);
+
+      double planes = measure([&]() {
+        for (int z = 0; z < VOLUME_SIZE / 2; ++z)
+          VolumeKernels::swapRanges(data + z * sliceSize, data + (VOLUME_SIZE - 1 - z) * sliceSize, sliceSize);
+      }, numBytes);
+
+      if (sizeof(T) > 1)
+        printf("%-18s %-7s %12.2f %12.2f %12.2f %12.2f\n", typeName,
+          VolumeKernels::getInstructionSetName(VolumeKernels::getInstructionSet()), swap, rows, columns, planes);
+      else
+        printf("%-18s %-7s %12s %12.2f %12.2f %12.2f\n", typeName,
+          VolumeKernels::getInstructionSetName(VolumeKernels::getInstructionSet()), "-", rows, columns, planes);
+    }
+    VolumeKernels::setInstructionSet(previous);
+
+    delete volume;
+  }
+
+} // namespace anonymous
+
+int KernelBenchmark::run(int, char*[])
+{
+  printf("\nVolume kernels on %d^3 volumes, best of %d runs, GB/s\n\n", VOLUME_SIZE, NUM_RUNS);
+  printf("%-18s %-7s %12s %12s %12s %12s\n", "type", "isa", "byte swap", "reverse x", "reverse y", "reverse z");
+
+  benchmarkVolume<uint8_t>("VolumeRAM_UInt8");
+  benchmarkVolume<int8_t>("VolumeRAM_Int8");
+  benchmarkVolume<uint16_t>("VolumeRAM_UInt16");
+  benchmarkVolume<int16_t>("VolumeRAM_Int16");
+  benchmarkVolume<uint32_t>("VolumeRAM_UInt32");
+  benchmarkVolume<int32_t>("VolumeRAM_Int32");
+  benchmarkVolume<uint64_t>("VolumeRAM_UInt64");
+  benchmarkVolume<int64_t>("VolumeRAM_Int64");
+  benchmarkVolume<float>("VolumeRAM_Float");
+  benchmarkVolume<double>("VolumeRAM_Double");
+
+  return 0;
+}
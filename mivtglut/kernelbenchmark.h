@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+* Measures the throughput of the VolumeKernels byte swap and axis reversal kernels
+* on 512^3 volumes of every VolumeRAM type, once for each supported instruction set.
+*/
+class KernelBenchmark
+{
+public:
+  static int run(int argc, char* argv[]);
+};
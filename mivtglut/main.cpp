@@ -1,6 +1,8 @@
 #include "vrtest.h"
 #include "opengltransformation.h"
 #include "computeshadertest.h"
+#include "kernelbenchmark.h"
+#include "skippingbenchmark.h"
 
 #include <iostream>
 
@@ -10,6 +12,8 @@ int main(int argc, char* argv[])
     "1. VR \n" 
     "2. OpenGL Transformation \n" 
     "3. Compute Shader \n"
+    "4. Volume Kernel Benchmark \n"
+    "5. Empty Space Skipping Benchmark \n"
     "\nPlease input an index \n");
 
   char c = (char)getchar();
@@ -21,6 +25,10 @@ int main(int argc, char* argv[])
     return OpenGLTransformation::run(argc, argv);
   case '3':
     return ComputeShaderTest::run(argc, argv);
+  case '4':
+    return KernelBenchmark::run(argc, argv);
+  case '5':
+    return SkippingBenchmark::run(argc, argv);
   default:
     return 0;
   }
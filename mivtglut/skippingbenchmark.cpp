@@ -0,0 +1,106 @@
+#include "skippingbenchmark.h"
+#include "application.h"
+
+#include <GL/glew.h>
+#include <GL/glut.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+  const int IMAGE_SIZE = 512;
+  const int NUM_VIEWS = 8;
+
+  const char* const TRANSFUNCS[] = {
+    "NeuroCTA_shaded_vessels",
+    "NeuroCTA_Transparent_Subtraction",
+    "Vascular_Carotid_Shaded",
+    "Vascular_Leg_Runoff",
+    "Osseous_Shaded"
+  };
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  void __stdcall ignoreProgress(const char*) {}
+
+  // renders one frame with the CPU backend, returns the frame time in ms
+  double renderFrame(mivt::Application* app, std::vector<unsigned char>& buffer) {
+    Clock::time_point start = Clock::now();
+    app->GetPixels(&buffer[0], static_cast<int>(buffer.size()));
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  void benchmarkVolume(mivt::Application* app, const char* name) {
+    printf("\n%s\n", name);
+
+    std::vector<unsigned char> reference(IMAGE_SIZE * IMAGE_SIZE * 4);
+    std::vector<unsigned char> skipped(reference.size());
+
+    for (size_t tf = 0; tf < sizeof(TRANSFUNCS) / sizeof(TRANSFUNCS[0]); ++tf) {
+      app->SetTransfunc(TRANSFUNCS[tf]);
+
+      double samplesOff = 0.0, samplesOn = 0.0;
+      double timeOff = 0.0, timeOn = 0.0;
+      int maxDifference = 0;
+      for (int view = 0; view < NUM_VIEWS; ++view) {
+        // turn the volume around the vertical axis
+        app->Rotate(IMAGE_SIZE / 2 + IMAGE_SIZE / NUM_VIEWS, IMAGE_SIZE / 2, IMAGE_SIZE / 2, IMAGE_SIZE / 2);
+
+        app->SetEmptySpaceSkipping(false);
+        timeOff += renderFrame(app, reference);
+        samplesOff += app->GetSamplesPerRay();
+
+        app->SetEmptySpaceSkipping(true);
+        timeOn += renderFrame(app, skipped);
+        samplesOn += app->GetSamplesPerRay();
+
+        for (size_t i = 0; i < reference.size(); ++i)
+          maxDifference = std::max(maxDifference, std::abs(reference[i] - skipped[i]));
+      }
+
+      printf("%-34s %10.1f %10.1f %8.2fx %10.1f %10.1f %8d\n", TRANSFUNCS[tf],
+        samplesOff / NUM_VIEWS, samplesOn / NUM_VIEWS, samplesOn > 0.0 ? samplesOff / samplesOn : 0.0,
+        timeOff / NUM_VIEWS, timeOn / NUM_VIEWS, maxDifference);
+    }
+  }
+
+} // namespace anonymous
+
+int SkippingBenchmark::run(int argc, char* argv[])
+{
+  // the application needs an OpenGL context, although only the CPU backend is measured
+  glutInit(&argc, argv);
+  glutInitWindowSize(IMAGE_SIZE, IMAGE_SIZE);
+  glutInitDisplayMode(GLUT_DOUBLE | GLUT_DEPTH | GLUT_RGBA | GLUT_ALPHA);
+  glutCreateWindow("empty space skipping benchmark");
+  glewInit();
+
+  mivt::Application* app = new mivt::Application();
+  app->SetRenderBackend("cpu");
+  app->Resize(IMAGE_SIZE, IMAGE_SIZE);
+
+  printf("\nEmpty space skipping, %dx%d pixels, average of %d views\n", IMAGE_SIZE, IMAGE_SIZE, NUM_VIEWS);
+  printf("%-34s %10s %10s %9s %10s %10s %8s\n", "transfer function",
+    "samples", "skipping", "ratio", "ms", "skipping", "max diff");
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      app->LoadVolume(argv[i], ignoreProgress);
+      benchmarkVolume(app, argv[i]);
+    }
+  }
+  else {
+    const std::string fileName = "E:/raw/CT-Head/CT-Head.img";
+    const int dimension[3] = { 512, 512, 393 };
+    const float spacing[3] = { 0.47f, 0.47f, 0.63f };
+    app->LoadVolume(fileName, "SHORT", dimension, spacing, -1024.f, 1.f, 300.f, 30.f);
+    benchmarkVolume(app, fileName.c_str());
+  }
+
+  delete app;
+  return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+* Compares the CPU raycaster with and without empty space skipping on CTA datasets:
+* samples per ray, frame time and the largest pixel difference, averaged over several views
+* for a set of CTA transfer functions.
+*
+* Every command line argument is loaded as a DICOM series, without arguments the CT-Head
+* raw volume of VRTest is used.
+*/
+class SkippingBenchmark
+{
+public:
+  static int run(int argc, char* argv[]);
+};
@@ -119,6 +119,36 @@ void VRTest::key(unsigned char k, int, int)
     sculptMode = !sculptMode;
     printf("Scult is " + sculptMode ? "On\n" : "Off\n");
     break;
+  case 'c':
+    app->SetRenderBackend(app->GetRenderBackend() == "cpu" ? "gpu" : "cpu");
+    printf("Render backend: %s\n", app->GetRenderBackend().c_str());
+    break;
+  case 'e':
+    app->SetEmptySpaceSkipping(!app->GetEmptySpaceSkipping());
+    printf("Empty space skipping: %s\n", app->GetEmptySpaceSkipping() ? "on" : "off");
+    break;
+  case 'z':
+    printf(app->UndoSculpt() ? "Sculpt undone\n" : "Nothing to undo\n");
+    break;
+  case 'y':
+    printf(app->RedoSculpt() ? "Sculpt redone\n" : "Nothing to redo\n");
+    break;
+  case 'u':
+    app->SetUniformBlocks(!app->GetUniformBlocks());
+    printf("Volume parameter uniform blocks: %s\n", app->GetUniformBlocks() ? "on" : "off");
+    break;
+  case 'p':
+    app->SetProxyMode(app->GetProxyMode() == "cube" ? "occupancy" : "cube");
+    printf("Proxy geometry: %s\n", app->GetProxyMode().c_str());
+    break;
+  case 'r':
+    app->SetReadbackMode(app->GetReadbackMode() == "latency" ? "throughput" : "latency");
+    printf("Readback mode: %s\n", app->GetReadbackMode().c_str());
+    break;
+  case 't':
+    printf("Render %.2f ms, readback %.2f ms, latency %d frames\n",
+      app->GetRenderTime(), app->GetReadbackTime(), app->GetReadbackLatency());
+    break;
   default:
     break;
   }
@@ -43,10 +43,49 @@ namespace mivtmanaged {
     local_->GetPixels(pinned_buffer, buffer->Length);
   }
 
+  void Application::RequestPixels(int length, bool downsampling) {
+    local_->RequestPixels(length, downsampling);
+  }
+
+  bool Application::GetLatestPixels(array<unsigned char>^ buffer) {
+    pin_ptr<unsigned char> pinned_buffer = &buffer[0];
+    return local_->GetLatestPixels(pinned_buffer, buffer->Length);
+  }
+
   void Application::Resize(int width, int height) {
     local_->Resize(width, height);
   }
 
+  void Application::SetRenderThread(bool enable) {
+    local_->SetRenderThread(enable);
+  }
+
+  bool Application::GetRenderThread() {
+    return local_->GetRenderThread();
+  }
+
+  void Application::SetFrameInterval(float ms) {
+    local_->SetFrameInterval(ms);
+  }
+
+  float Application::GetFrameInterval() {
+    return local_->GetFrameInterval();
+  }
+
+  void Application::SetFrameCallback(FrameDelegate^ callback) {
+    using System::IntPtr;
+    using System::Runtime::InteropServices::Marshal;
+
+    frameCallback_ = callback;
+    if (callback) {
+      IntPtr pointer = Marshal::GetFunctionPointerForDelegate(callback);
+      local_->SetFrameCallback(static_cast<mivt::FrameCallback>(pointer.ToPointer()));
+    }
+    else {
+      local_->SetFrameCallback(0);
+    }
+  }
+
   void Application::Rotate(int newPosX, int newPosY, int lastPosX, int lastPosY) {
     local_->Rotate(newPosX, newPosY, lastPosX, lastPosY);
   }
@@ -88,6 +127,16 @@ namespace mivtmanaged {
     local_->LoadVolume(naviteFileName, static_cast<tgt::ProgressCallback>(pointer.ToPointer()));
   }
 
+  void Application::SetNumLoaderThreads(int numThreads)
+  {
+    local_->SetNumLoaderThreads(numThreads);
+  }
+
+  int Application::GetNumLoaderThreads()
+  {
+    return local_->GetNumLoaderThreads();
+  }
+
   void Application::SetTransfunc(String^ fileName)
   {
     local_->SetTransfunc(FromManaged(fileName));
@@ -294,6 +343,26 @@ namespace mivtmanaged {
     local_->DoSculpt(vec);
   }
 
+  bool Application::UndoSculpt()
+  {
+    return local_->UndoSculpt();
+  }
+
+  bool Application::RedoSculpt()
+  {
+    return local_->RedoSculpt();
+  }
+
+  bool Application::CanUndoSculpt()
+  {
+    return local_->CanUndoSculpt();
+  }
+
+  bool Application::CanRedoSculpt()
+  {
+    return local_->CanRedoSculpt();
+  }
+
   void Application::getWindowingDomain(array<float>^ val)
   {
     pin_ptr<float> pinned_v = &val[0];
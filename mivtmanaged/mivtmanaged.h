@@ -23,8 +23,23 @@ namespace mivtmanaged {
 
     void GetPixels(array<unsigned char>^ buffer);
 
+    void RequestPixels(int length, bool downsampling);
+
+    bool GetLatestPixels(array<unsigned char>^ buffer);
+
     void Resize(int width, int height);
 
+    void SetRenderThread(bool enable);
+    bool GetRenderThread();
+
+    void SetFrameInterval(float ms);
+    float GetFrameInterval();
+
+    delegate void FrameDelegate();
+
+    /// The callback is invoked on the render thread, fetch the frame with GetLatestPixels().
+    void SetFrameCallback(FrameDelegate^ callback);
+
     void Rotate(int newPosX, int newPosY, int lastPosX, int lastPosY);
 
     void Zoom(int newPosX, int newPosY, int lastPosX, int lastPosY);
@@ -44,6 +59,9 @@ namespace mivtmanaged {
 
     void LoadVolume(String^ fileName, NativeDelegate^ callback);
 
+    void SetNumLoaderThreads(int numThreads);
+    int GetNumLoaderThreads();
+
     void SetTransfunc(String^ fileName);
     String^ GetTransfunc();
 
@@ -94,11 +112,16 @@ namespace mivtmanaged {
     bool IsClipEnabled();
 
     void DoSculpt(array<float>^ polygon);
+    bool UndoSculpt();
+    bool RedoSculpt();
+    bool CanUndoSculpt();
+    bool CanRedoSculpt();
 
     void getWindowingDomain(array<float>^ val);
     void setWindowingDomain(array<float>^ val);
 
   private:
     mivt::Application *local_;
+    FrameDelegate^ frameCallback_;    ///< keeps the delegate alive while native code holds its pointer
 	};
 }
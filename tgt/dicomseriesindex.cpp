@@ -0,0 +1,374 @@
+#include "dicomseriesindex.h"
+#include "filesystem.h"
+#include "logmanager.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+// anonymous namespace
+namespace {
+
+  const uint32_t INDEX_MAGIC = 0x58444944; // "DIDX"
+  const uint32_t INDEX_VERSION = 5;
+
+  template<typename T>
+  void writeValue(std::ostream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  bool readValue(std::istream& stream, T& value) {
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return stream.good();
+  }
+
+  void writeString(std::ostream& stream, const std::string& value) {
+    writeValue(stream, static_cast<uint32_t>(value.size()));
+    stream.write(value.data(), value.size());
+  }
+
+  bool readString(std::istream& stream, std::string& value) {
+    uint32_t length = 0;
+    if (!readValue(stream, length) || length > (1u << 20))
+      return false;
+    value.resize(length);
+    if (length > 0)
+      stream.read(&value[0], length);
+    return stream.good();
+  }
+
+  void writeRecord(std::ostream& stream, const tgt::DicomSliceRecord& record) {
+    writeString(stream, record.seriesInstanceUID_);
+    writeString(stream, record.studyInstanceUID_);
+    writeString(stream, record.seriesDescription_);
+    writeString(stream, record.studyDescription_);
+    writeString(stream, record.modality_);
+    writeString(stream, record.patientName_);
+    writeString(stream, record.patientId_);
+    writeString(stream, record.rescaleType_);
+
+    writeValue(stream, record.dimensions_);
+    writeValue(stream, static_cast<int32_t>(record.numberOfDimensions_));
+    writeValue(stream, record.spacing_);
+    writeValue(stream, record.spacingBetweenSlices_);
+    writeValue(stream, record.imagePositionPatient_);
+    writeValue(stream, static_cast<uint32_t>(record.framePositions_.size()));
+    for (size_t i = 0; i < record.framePositions_.size(); ++i)
+      writeValue(stream, record.framePositions_[i]);
+    writeValue(stream, record.xOrientationPatient_);
+    writeValue(stream, record.yOrientationPatient_);
+    writeValue(stream, record.intercept_);
+    writeValue(stream, record.slope_);
+    writeValue(stream, static_cast<uint8_t>(record.frameRescaleDiffers_));
+
+    writeValue(stream, record.pixelFormat_.GetSamplesPerPixel());
+    writeValue(stream, record.pixelFormat_.GetBitsAllocated());
+    writeValue(stream, record.pixelFormat_.GetBitsStored());
+    writeValue(stream, record.pixelFormat_.GetHighBit());
+    writeValue(stream, record.pixelFormat_.GetPixelRepresentation());
+    writeValue(stream, static_cast<int32_t>(record.pixelFormat_.GetScalarType()));
+
+    writeValue(stream, static_cast<uint8_t>(record.dicomDir_));
+    writeValue(stream, static_cast<uint8_t>(record.explicitVR_));
+    writeValue(stream, record.pixelDataOffset_);
+  }
+
+  bool readRecord(std::istream& stream, tgt::DicomSliceRecord& record) {
+    bool ok = readString(stream, record.seriesInstanceUID_)
+      && readString(stream, record.studyInstanceUID_)
+      && readString(stream, record.seriesDescription_)
+      && readString(stream, record.studyDescription_)
+      && readString(stream, record.modality_)
+      && readString(stream, record.patientName_)
+      && readString(stream, record.patientId_)
+      && readString(stream, record.rescaleType_);
+
+    int32_t numberOfDimensions = 0;
+    uint32_t numFramePositions = 0;
+    ok = ok && readValue(stream, record.dimensions_)
+      && readValue(stream, numberOfDimensions)
+      && readValue(stream, record.spacing_)
+      && readValue(stream, record.spacingBetweenSlices_)
+      && readValue(stream, record.imagePositionPatient_)
+      && readValue(stream, numFramePositions)
+      && (numFramePositions <= static_cast<uint32_t>(record.dimensions_.z));
+    record.framePositions_.resize(ok ? numFramePositions : 0);
+    for (size_t i = 0; ok && i < record.framePositions_.size(); ++i)
+      ok = readValue(stream, record.framePositions_[i]);
+    ok = ok && readValue(stream, record.xOrientationPatient_)
+      && readValue(stream, record.yOrientationPatient_)
+      && readValue(stream, record.intercept_)
+      && readValue(stream, record.slope_);
+    record.numberOfDimensions_ = numberOfDimensions;
+
+    uint8_t frameRescaleDiffers = 0;
+    ok = ok && readValue(stream, frameRescaleDiffers);
+    record.frameRescaleDiffers_ = (frameRescaleDiffers != 0);
+
+    unsigned short samplesPerPixel = 0, bitsAllocated = 0, bitsStored = 0, highBit = 0, pixelRepresentation = 0;
+    int32_t scalarType = 0;
+    ok = ok && readValue(stream, samplesPerPixel)
+      && readValue(stream, bitsAllocated)
+      && readValue(stream, bitsStored)
+      && readValue(stream, highBit)
+      && readValue(stream, pixelRepresentation)
+      && readValue(stream, scalarType)
+      && (scalarType >= 0) && (scalarType <= static_cast<int32_t>(gdcm::PixelFormat::UNKNOWN));
+    record.pixelFormat_ = gdcm::PixelFormat(samplesPerPixel, bitsAllocated, bitsStored, highBit, pixelRepresentation);
+
+    //a scalar type set explicitly does not follow from the fields above, the scalar type has to be set first
+    if (ok && record.pixelFormat_.GetScalarType() != static_cast<gdcm::PixelFormat::ScalarType>(scalarType)) {
+      record.pixelFormat_.SetScalarType(static_cast<gdcm::PixelFormat::ScalarType>(scalarType));
+      record.pixelFormat_.SetSamplesPerPixel(samplesPerPixel);
+      record.pixelFormat_.SetBitsStored(bitsStored);
+      record.pixelFormat_.SetHighBit(highBit);
+    }
+
+    uint8_t dicomDir = 0, explicitVR = 0;
+    ok = ok && readValue(stream, dicomDir)
+      && readValue(stream, explicitVR)
+      && readValue(stream, record.pixelDataOffset_);
+    record.dicomDir_ = (dicomDir != 0);
+    record.explicitVR_ = (explicitVR != 0);
+
+    return ok;
+  }
+
+} // namespace anonymous
+
+namespace tgt {
+
+  const std::string DicomSeriesIndex::loggerCat_ = "DicomSeriesIndex";
+
+  DicomSeriesIndex::DicomSeriesIndex()
+    : modified_(false)
+  {
+  }
+
+  std::string DicomSeriesIndex::getIndexFileName(const std::string& cacheDir, const std::string& directory) {
+    //64 bit FNV-1a, the name has to stay the same across toolchains and runs
+    const std::string path = FileSystem::cleanupPath(directory, false);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < path.size(); ++i) {
+      hash ^= static_cast<unsigned char>(path[i]);
+      hash *= 1099511628211ULL;
+    }
+
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".idx";
+    return FileSystem::cleanupPath(cacheDir + "/" + name.str());
+  }
+
+  void DicomSeriesIndex::clear() {
+    directory_.clear();
+    entries_.clear();
+    sliceOrders_.clear();
+    modified_ = false;
+  }
+
+  bool DicomSeriesIndex::isModified() const {
+    return modified_;
+  }
+
+  bool DicomSeriesIndex::load(const std::string& indexFileName, const std::string& directory) {
+    clear();
+    directory_ = FileSystem::cleanupPath(directory, false);
+
+    std::ifstream stream(indexFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      return false;
+
+    uint32_t magic = 0, version = 0;
+    std::string indexDirectory;
+    if (!readValue(stream, magic) || !readValue(stream, version) || (magic != INDEX_MAGIC) || (version != INDEX_VERSION)
+      || !readString(stream, indexDirectory) || (indexDirectory != directory_)) {
+      LWARNING("Ignoring outdated or foreign index file " << indexFileName);
+      return false;
+    }
+
+    uint32_t numEntries = 0;
+    bool ok = readValue(stream, numEntries);
+    for (uint32_t i = 0; ok && i < numEntries; ++i) {
+      std::string fileName;
+      Entry entry;
+      uint8_t readable = 0;
+      ok = readString(stream, fileName)
+        && readValue(stream, entry.fileSize_)
+        && readValue(stream, entry.fileTime_)
+        && readValue(stream, readable);
+      entry.readable_ = (readable != 0);
+      if (ok && entry.readable_) {
+        ok = readRecord(stream, entry.record_);
+        entry.record_.fileName_ = fileName;
+      }
+      if (ok)
+        entries_[fileName] = entry;
+    }
+
+    uint32_t numSeries = 0;
+    ok = ok && readValue(stream, numSeries);
+    for (uint32_t i = 0; ok && i < numSeries; ++i) {
+      std::string uid;
+      uint32_t numSlices = 0;
+      ok = readString(stream, uid) && readValue(stream, numSlices);
+      std::vector<std::string>& order = sliceOrders_[uid];
+      for (uint32_t j = 0; ok && j < numSlices; ++j) {
+        std::string fileName;
+        ok = readString(stream, fileName);
+        order.push_back(fileName);
+      }
+    }
+
+    if (!ok) {
+      LWARNING("Index file " << indexFileName << " is corrupt, rescanning directory");
+      clear();
+      directory_ = FileSystem::cleanupPath(directory, false);
+      return false;
+    }
+
+    prune();
+
+    LINFO("Read index of " << entries_.size() << " files from " << indexFileName);
+    return true;
+  }
+
+  void DicomSeriesIndex::prune() {
+    std::set<std::string> removed;
+    std::map<std::string, Entry>::iterator it = entries_.begin();
+    while (it != entries_.end()) {
+      if (!FileSystem::fileExists(it->first) || (FileSystem::fileSize(it->first) != it->second.fileSize_)
+        || (static_cast<int64_t>(FileSystem::fileTime(it->first)) != it->second.fileTime_)) {
+        removed.insert(it->first);
+        entries_.erase(it++);
+      }
+      else
+        ++it;
+    }
+
+    if (removed.empty())
+      return;
+
+    //the stored order of a series is of no use once one of its files changed
+    std::map<std::string, std::vector<std::string> >::iterator orderIt = sliceOrders_.begin();
+    while (orderIt != sliceOrders_.end()) {
+      bool stale = false;
+      for (size_t i = 0; i < orderIt->second.size() && !stale; ++i)
+        stale = (removed.count(orderIt->second[i]) != 0);
+      if (stale)
+        sliceOrders_.erase(orderIt++);
+      else
+        ++orderIt;
+    }
+
+    LINFO("Removed " << removed.size() << " deleted or changed files from the index");
+    modified_ = true;
+  }
+
+  bool DicomSeriesIndex::save(const std::string& indexFileName) {
+    std::string dir = FileSystem::dirName(indexFileName);
+    if (!dir.empty() && !FileSystem::dirExists(dir))
+      FileSystem::createDirectoryRecursive(dir);
+
+    std::ofstream stream(indexFileName.c_str(), std::ios::trunc | std::ios::binary);
+    if (!stream.is_open()) {
+      LWARNING("Could not write index file " << indexFileName);
+      return false;
+    }
+
+    writeValue(stream, INDEX_MAGIC);
+    writeValue(stream, INDEX_VERSION);
+    writeString(stream, directory_);
+
+    writeValue(stream, static_cast<uint32_t>(entries_.size()));
+    std::map<std::string, Entry>::const_iterator it;
+    for (it = entries_.begin(); it != entries_.end(); ++it) {
+      writeString(stream, it->first);
+      writeValue(stream, it->second.fileSize_);
+      writeValue(stream, it->second.fileTime_);
+      writeValue(stream, static_cast<uint8_t>(it->second.readable_));
+      if (it->second.readable_)
+        writeRecord(stream, it->second.record_);
+    }
+
+    writeValue(stream, static_cast<uint32_t>(sliceOrders_.size()));
+    std::map<std::string, std::vector<std::string> >::const_iterator orderIt;
+    for (orderIt = sliceOrders_.begin(); orderIt != sliceOrders_.end(); ++orderIt) {
+      writeString(stream, orderIt->first);
+      writeValue(stream, static_cast<uint32_t>(orderIt->second.size()));
+      for (size_t i = 0; i < orderIt->second.size(); ++i)
+        writeString(stream, orderIt->second[i]);
+    }
+
+    if (!stream.good()) {
+      LWARNING("Failed to write index file " << indexFileName);
+      return false;
+    }
+
+    modified_ = false;
+    return true;
+  }
+
+  bool DicomSeriesIndex::lookup(const std::string& fileName, uint64_t fileSize, time_t fileTime,
+    DicomSliceRecord& record, bool& readable) const
+  {
+    std::map<std::string, Entry>::const_iterator it = entries_.find(fileName);
+    if (it == entries_.end())
+      return false;
+
+    if ((it->second.fileSize_ != fileSize) || (it->second.fileTime_ != static_cast<int64_t>(fileTime)))
+      return false;
+
+    readable = it->second.readable_;
+    if (readable)
+      record = it->second.record_;
+    return true;
+  }
+
+  void DicomSeriesIndex::insert(const std::string& fileName, uint64_t fileSize, time_t fileTime,
+    const DicomSliceRecord* record)
+  {
+    Entry& entry = entries_[fileName];
+    entry.fileSize_ = fileSize;
+    entry.fileTime_ = static_cast<int64_t>(fileTime);
+    entry.readable_ = (record != 0);
+    entry.record_ = record ? *record : DicomSliceRecord();
+    modified_ = true;
+  }
+
+  void DicomSeriesIndex::setSliceOrder(const std::string& seriesInstanceUID, const std::vector<DicomSliceRecord>& sortedSlices) {
+    std::vector<std::string> order(sortedSlices.size());
+    for (size_t i = 0; i < sortedSlices.size(); ++i)
+      order[i] = sortedSlices[i].fileName_;
+
+    std::vector<std::string>& stored = sliceOrders_[seriesInstanceUID];
+    if (stored != order) {
+      stored.swap(order);
+      modified_ = true;
+    }
+  }
+
+  bool DicomSeriesIndex::applySliceOrder(const std::string& seriesInstanceUID, std::vector<DicomSliceRecord>& slices) const {
+    std::map<std::string, std::vector<std::string> >::const_iterator it = sliceOrders_.find(seriesInstanceUID);
+    if (it == sliceOrders_.end() || it->second.size() != slices.size())
+      return false;
+
+    std::map<std::string, size_t> position;
+    for (size_t i = 0; i < it->second.size(); ++i)
+      position[it->second[i]] = i;
+
+    std::vector<DicomSliceRecord> ordered(slices.size());
+    std::vector<bool> used(slices.size(), false);
+    for (size_t i = 0; i < slices.size(); ++i) {
+      std::map<std::string, size_t>::const_iterator pos = position.find(slices[i].fileName_);
+      if (pos == position.end() || used[pos->second])
+        return false;
+      ordered[pos->second] = slices[i];
+      used[pos->second] = true;
+    }
+
+    slices.swap(ordered);
+    return true;
+  }
+
+} // end namespace tgt
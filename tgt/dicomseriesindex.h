@@ -0,0 +1,100 @@
+#pragma once
+
+#include "dicomslicerecord.h"
+#include "config.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <ctime>
+
+namespace tgt {
+
+  /**
+  * Persistent index of the DICOM headers found in one directory, used by GdcmVolumeReader
+  * to skip header parsing when a series is opened again.
+  *
+  * For every scanned file the index stores its size, modification time and the DicomSliceRecord
+  * (or that the file is not a readable DICOM file), as well as the sorted slice order of every
+  * series that has been loaded. An entry is only used while size and mtime of the file still match.
+  * The index is kept as a compact binary file.
+  */
+  class DicomSeriesIndex
+  {
+  public:
+    TGT_API DicomSeriesIndex();
+
+    /**
+    * Returns the index file of a DICOM directory inside the given cache directory.
+    */
+    TGT_API static std::string getIndexFileName(const std::string& cacheDir, const std::string& directory);
+
+    /**
+    * Reads the index from disk. The index is cleared before,
+    * it stays empty if the file does not exist, is corrupt or belongs to another directory.
+    * Entries of files deleted or changed since they were indexed are dropped.
+    *
+    * @return true, if the index was read successfully
+    */
+    TGT_API bool load(const std::string& indexFileName, const std::string& directory);
+
+    /**
+    * Writes the index to disk, creating the parent directory if necessary.
+    *
+    * @return true, if the index was written successfully
+    */
+    TGT_API bool save(const std::string& indexFileName);
+
+    TGT_API void clear();
+
+    /// Returns true, if the index has been changed since it was loaded or saved.
+    TGT_API bool isModified() const;
+
+    /**
+    * Looks up a file in the index.
+    *
+    * @param readable set to false, if the file has been found to be no readable DICOM file
+    * @return true, if the file is in the index and its size and modification time still match
+    */
+    TGT_API bool lookup(const std::string& fileName, uint64_t fileSize, time_t fileTime,
+      DicomSliceRecord& record, bool& readable) const;
+
+    /**
+    * Adds or replaces the entry of a file. Pass a null record for files that are no readable DICOM files.
+    */
+    TGT_API void insert(const std::string& fileName, uint64_t fileSize, time_t fileTime,
+      const DicomSliceRecord* record);
+
+    /**
+    * Stores the sorted slice order of a series.
+    */
+    TGT_API void setSliceOrder(const std::string& seriesInstanceUID, const std::vector<DicomSliceRecord>& sortedSlices);
+
+    /**
+    * Rearranges the records according to the stored slice order of the series.
+    * Nothing is changed if there is no stored order or it does not cover exactly the given records.
+    *
+    * @return true, if the records have been rearranged
+    */
+    TGT_API bool applySliceOrder(const std::string& seriesInstanceUID, std::vector<DicomSliceRecord>& slices) const;
+
+  private:
+    /// Removes the entries of deleted or changed files and the slice orders of series containing them.
+    void prune();
+
+    struct Entry {
+      uint64_t fileSize_;         ///< file size at scan time
+      int64_t fileTime_;          ///< modification time at scan time
+      bool readable_;             ///< file is a readable DICOM file
+      DicomSliceRecord record_;   ///< scanned header, only valid if readable_
+    };
+
+    std::string directory_;       ///< directory the index belongs to
+    std::map<std::string, Entry> entries_;
+    std::map<std::string, std::vector<std::string> > sliceOrders_;  ///< SeriesInstanceUID -> sorted file names
+    bool modified_;
+
+    static const std::string loggerCat_;
+  };
+
+} // end namespace tgt
@@ -0,0 +1,23 @@
+#include "dicomslicerecord.h"
+
+namespace tgt {
+
+  DicomSliceRecord::DicomSliceRecord()
+    : dimensions_(0)
+    , numberOfDimensions_(0)
+    , spacing_(1.0)
+    , spacingBetweenSlices_(0.0)
+    , imagePositionPatient_(0.0)
+    , xOrientationPatient_(1.0, 0.0, 0.0)
+    , yOrientationPatient_(0.0, 1.0, 0.0)
+    , intercept_(0.0)
+    , slope_(1.0)
+    , frameRescaleDiffers_(false)
+    , dicomDir_(false)
+    , explicitVR_(false)
+    , pixelDataOffset_(-1)
+    , distance_(0.0)
+  {
+  }
+
+} // end namespace tgt
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "tgt_math.h"
+#include "config.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <gdcm/gdcmPixelFormat.h>
+
+namespace tgt {
+
+  /**
+  * Compact per-file record built by the series scanning stage of GdcmVolumeReader.
+  * Each DICOM file header is parsed exactly once (up to the pixel data element), and sorting,
+  * validation, rescale computation and pixel loading are all driven from these records.
+  */
+  struct DicomSliceRecord {
+    TGT_API DicomSliceRecord();
+
+    std::string fileName_;              ///< path of the DICOM file
+    std::string seriesInstanceUID_;     ///< DICOM(0020 000E), trimmed
+    std::string studyInstanceUID_;      ///< DICOM(0020 000D)
+    std::string seriesDescription_;     ///< DICOM(0008 103E)
+    std::string studyDescription_;      ///< DICOM(0008 1030)
+    std::string modality_;              ///< DICOM(0008 0060)
+    std::string patientName_;           ///< DICOM(0010 0010)
+    std::string patientId_;             ///< DICOM(0010 0020)
+    std::string rescaleType_;           ///< DICOM(0028 1054)
+
+    glm::ivec3 dimensions_;             ///< columns, rows and number of frames
+    int numberOfDimensions_;            ///< 2 for single frame images, 3 for multiframe images
+    glm::dvec3 spacing_;                ///< pixel spacing (x, y) and gdcm's z spacing
+    double spacingBetweenSlices_;       ///< DICOM(0018 0088), 0 if not present
+    glm::dvec3 imagePositionPatient_;   ///< DICOM(0020 0032)
+    std::vector<glm::dvec3> framePositions_; ///< per-frame DICOM(0020 0032) of multiframe images, from the functional groups
+    glm::dvec3 xOrientationPatient_;    ///< row direction cosines of DICOM(0020 0037)
+    glm::dvec3 yOrientationPatient_;    ///< column direction cosines of DICOM(0020 0037)
+    double intercept_;                  ///< DICOM(0028 1052), of the first frame for multiframe images
+    double slope_;                      ///< DICOM(0028 1053), of the first frame for multiframe images
+    bool frameRescaleDiffers_;          ///< the frames of a multiframe image use different rescale values
+    gdcm::PixelFormat pixelFormat_;     ///< samples per pixel, bits allocated/stored, pixel representation
+
+    bool dicomDir_;                     ///< file is a DICOMDIR
+    bool explicitVR_;                   ///< data set uses an explicit VR transfer syntax
+    int64_t pixelDataOffset_;           ///< file offset of the pixel data element header, -1 if the pixel data has to be decoded by gdcm
+
+    double distance_;                   ///< distance along the slice normal, set while sorting
+  };
+
+} // end namespace tgt
@@ -3,7 +3,6 @@
 #include "volumefactory.h"
 #include "volumegl.h"
 #include "tgt_string.h"
-#include "primitivemetadata.h"
 
 #include <gdcm/gdcmFile.h>
 #include <gdcm/gdcmDirectory.h>
@@ -11,16 +10,39 @@
 #include <gdcm/gdcmImageReader.h>
 #include <gdcm/gdcmStringFilter.h>
 #include <gdcm/gdcmRescaler.h>
+#include <gdcm/gdcmImageHelper.h>
+#include <gdcm/gdcmMediaStorage.h>
+#include <gdcm/gdcmSequenceOfItems.h>
+#include <gdcm/gdcmAttribute.h>
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <set>
 
 #pragma warning(disable:4702)
 
 namespace tgt {
   const std::string GdcmVolumeReader::loggerCat_ = "GdcmVolumeReader";
 
+  typedef std::chrono::high_resolution_clock LoadClock;
+
+  /*
+  * Returns the seconds elapsed since start, used for the load time breakdown
+  */
+  static double secondsSince(LoadClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::duration<double> >(LoadClock::now() - start).count();
+  }
+
   GdcmVolumeReader::GdcmVolumeReader(const std::string& standardDictFileName, ProgressBar* progress)
     throw (FileException)
     : VolumeReader(progress)
     , dict_(0)
+    , numWorkerThreads_(0)
+    , numParsedHeaders_(0)
+    , numRawFallbacks_(0)
   {
     protocols_.push_back("dcm");
 
@@ -47,6 +69,22 @@ namespace tgt {
     return 0;
   }
 
+  void GdcmVolumeReader::setNumWorkerThreads(int numThreads) {
+    numWorkerThreads_ = std::max(numThreads, 0);
+  }
+
+  int GdcmVolumeReader::getNumWorkerThreads() const {
+    return numWorkerThreads_;
+  }
+
+  void GdcmVolumeReader::setIndexCacheDir(const std::string& dir) {
+    indexCacheDir_ = dir;
+  }
+
+  std::string GdcmVolumeReader::getIndexCacheDir() const {
+    return indexCacheDir_;
+  }
+
   VolumeList* GdcmVolumeReader::read_2(const std::string& fileName)
     throw (IOException, CorruptedFileException, std::bad_alloc)
   {
@@ -60,17 +98,31 @@ namespace tgt {
 
     std::string searchSeriesInstanceUID;
 
+    //files may have changed since the last data set was read
+    sliceRecordBuffer_.clear();
+    numParsedHeaders_ = 0;
+
+    //read the persistent index of the directory, if enabled
+    seriesIndex_.clear();
+    indexFileName_.clear();
+    if (!indexCacheDir_.empty()) {
+      std::string directory = FileSystem::dirExists(fileName) ? fileName : FileSystem::dirName(fileName);
+      indexFileName_ = DicomSeriesIndex::getIndexFileName(indexCacheDir_, directory);
+      seriesIndex_.load(indexFileName_, directory);
+    }
+
     //check if fileName is a file or a directory
     if (FileSystem::dirExists(fileName)) {
       //fileName is a directory
       collection = selectAndLoadDicomFiles(getFileNamesInDir(fileName), fileName, searchSeriesInstanceUID);
     }
     else if (FileSystem::fileExists(fileName)) {
-      //fileName is a file -> check if it is a Dicom file
-      if (!isDicomFile(fileName)) {
+      //fileName is a file -> check if it is a Dicom file (the record is buffered for the series scan)
+      DicomSliceRecord record;
+      if (!scanSliceRecord(fileName, record)) {
         throw FileAccessException("Selected file is not a DICOM file or it is broken!", fileName);
       }
-      else if (isDicomDir(fileName)) {
+      else if (record.dicomDir_) {
         //file is a DICOMDIR
         //collection = readDicomDir(fileName);
       }
@@ -78,18 +130,8 @@ namespace tgt {
         //file ist NOT a DICOMDIR -> read files in Directory
         LINFO("Loading files in " << FileSystem::dirName(fileName));
 
-        //read SeriesInstanceUID from file if possible
-        gdcm::Reader reader;
-        reader.SetFileName(fileName.c_str());
-        if (!reader.Read())
-          throw FileAccessException("Could not read Dicom File", fileName);
-
-        gdcm::StringFilter sf = gdcm::StringFilter();
-        sf.SetFile(reader.GetFile());
-        std::string seriesInstanceUID = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SeriesInstanceUID")));
-        seriesInstanceUID = tgt::trim(seriesInstanceUID, " ");
-
-        searchSeriesInstanceUID = seriesInstanceUID;
+        //use SeriesInstanceUID of the selected file
+        searchSeriesInstanceUID = record.seriesInstanceUID_;
         collection = selectAndLoadDicomFiles(getFileNamesInDir(FileSystem::dirName(fileName)),
           FileSystem::dirName(fileName), searchSeriesInstanceUID);
       }
@@ -117,56 +159,79 @@ namespace tgt {
     return dir.GetFilenames();
   }
 
-  bool GdcmVolumeReader::isDicomFile(const std::string &path) const {
-    gdcm::Reader reader;
-    reader.SetFileName(path.c_str());
-    return reader.Read();
+  gdcm::Tag GdcmVolumeReader::getTagFromDictEntry(const DicomDictEntry &entry) {
+    return gdcm::Tag(entry.getGroupTagUint16(), entry.getElementTagUint16());
   }
 
-  bool GdcmVolumeReader::isDicomDir(const std::string &path) const {
-    if (!isDicomFile(path)) return false;
+  VolumeList* GdcmVolumeReader::selectAndLoadDicomFiles(
+    const std::vector<std::string> &fileNames,
+    const std::string& origin,
+    std::string& searchSeriesInstanceUID)
+    throw (FileException, std::bad_alloc)
+  {
+    if (fileNames.empty())
+      throw FileNotFoundException("Directory is empty!", origin);
 
-    gdcm::Reader reader;
-    reader.SetFileName(path.c_str());
-    reader.Read();
+    //scan all headers once, so that only readable DICOM files with one SeriesInstanceUID remain
+    LoadClock::time_point scanStart = LoadClock::now();
+    std::vector<DicomSliceRecord> slices = scanSeries(fileNames, searchSeriesInstanceUID);
+    LINFO("Scanned " << fileNames.size() << " file headers in " << secondsSince(scanStart) << " s ("
+      << numParsedHeaders_ << " parsed), " << slices.size() << " files belong to the series");
 
-    gdcm::MediaStorage ms;
-    ms.SetFromFile(reader.GetFile());
+    //keep the parsed headers, even if loading the series fails later on
+    if (!indexFileName_.empty() && seriesIndex_.isModified())
+      seriesIndex_.save(indexFileName_);
+
+    //reuse the slice order of the last time this series was loaded
+    if (!indexFileName_.empty() && seriesIndex_.applySliceOrder(searchSeriesInstanceUID, slices))
+      LINFO("Using slice order from series index");
 
-    return (ms == gdcm::MediaStorage::MediaStorageDirectoryStorage);
+    //now all records in slices belong to the same SeriesInstanceUID
+    if (slices.empty())
+      throw FileNotFoundException("No file with corresponding SeriesInstanceUID could be found!", origin);
+
+    return subdivideAndLoadDicomFiles(slices, origin);
   }
 
-  std::vector<std::string> GdcmVolumeReader::getFilesInSeries(std::vector<std::string> filenames,
-    std::string seriesInstanceUID)
+  std::vector<DicomSliceRecord> GdcmVolumeReader::scanSeries(const std::vector<std::string>& fileNames,
+    std::string& searchSeriesInstanceUID)
   {
-    //show Progress Bar
-    if (getProgressBar() && !filenames.empty())
-      getProgressBar()->setTitle("Assigning files to SeriesInstanceUID: " + seriesInstanceUID);
+    std::vector<DicomSliceRecord> result;
+    result.reserve(fileNames.size());
 
-    int progress = 1;
+    if (getProgressBar())
+      getProgressBar()->setTitle("Preselecting files");
+
+    int itemused = 1;
 
-    std::vector<std::string> result;
+    std::vector<std::string>::const_iterator i;
+    for (i = fileNames.begin(); i != fileNames.end(); i++) {
 
-    //iterate over files
-    std::vector<std::string>::iterator fileIterator;
-    for (fileIterator = filenames.begin(); fileIterator != filenames.end(); fileIterator++) {
       if (getProgressBar()) {
-        getProgressBar()->setProgressMessage("Reading files...");
-        getProgressBar()->setProgress(static_cast<float>(progress) / static_cast<float>(filenames.size()));
-        progress++;
+        getProgressBar()->setProgressMessage("Scanning DICOM headers...");
+        getProgressBar()->setProgress(static_cast<float>(itemused) / static_cast<float>(fileNames.size()));
+        itemused++;
       }
 
-      //check SeriesInstanceUID of the file
-      //if it fits: add this file to result
-      try {
-        std::string series = getMetaDataFromFile(*fileIterator, *dict_, "SeriesInstanceUID");
-        if (series == seriesInstanceUID)
-          result.push_back(*fileIterator);
+      DicomSliceRecord record;
+      if (!scanSliceRecord(*i, record)) {
+        LINFO("Skipping file: " + (*i));
+        continue;
       }
-      catch (FileException) {
-        //file is not a DICOM file... just ignore it
-        LINFO("Ignoring file " + (*fileIterator) + " because it is not a DICOM file...");
+
+      if (searchSeriesInstanceUID.empty()) {
+        //if there is no SeriesInstanceUID until now, get it from the first file
+        if (record.seriesInstanceUID_.empty()) {
+          LERROR("File has no SeriesInstanceUID: " << (*i));
+          continue;
+        }
+        searchSeriesInstanceUID = record.seriesInstanceUID_;
+        LINFO("Using first SeriesInstanceUID found: " + searchSeriesInstanceUID);
       }
+
+      //check if this file belongs to the given series
+      if (record.seriesInstanceUID_ == searchSeriesInstanceUID)
+        result.push_back(record);
     }
 
     if (getProgressBar())
@@ -175,273 +240,143 @@ namespace tgt {
     return result;
   }
 
-  std::string GdcmVolumeReader::getMetaDataFromFile(const std::string& filename,
-    const DicomDict& dict,
-    const std::string& keyword)
-    throw (FileException)
+  bool GdcmVolumeReader::scanSliceRecord(const std::string& fileName, DicomSliceRecord& record)
   {
-    std::map<std::string, MetaDataContainer>::iterator mapIterator;
-    mapIterator = fileInfoBuffer_.find(filename);
-
-    //if the file is not already present in the file buffer: create a new entry and add the meta information from the DicomDict
-    if (mapIterator == fileInfoBuffer_.end()) {
-      //put file and corresponding dict meta info into the buffer
-      std::pair<std::string, MetaDataContainer> newPair;
-      newPair.first = filename;
-      //MetaDataContainer c;
-      //newPair.second = c;
-      setMetaDataFromDict(&newPair.second, &dict, filename, true);
-      fileInfoBuffer_.insert(newPair);
-      mapIterator = fileInfoBuffer_.find(filename);
-    }
-    else if (!(mapIterator->second.hasMetaData(keyword))) {
-      //if the filename is present, but does not have the right meta data: add the meta information from the DicomDict
-      setMetaDataFromDict(&mapIterator->second, &dict, filename, true);
+    std::map<std::string, DicomSliceRecord>::const_iterator bufferIterator = sliceRecordBuffer_.find(fileName);
+    if (bufferIterator != sliceRecordBuffer_.end()) {
+      record = bufferIterator->second;
+      return true;
     }
 
-    //now the filename is present, the meta information is added and the iterator is set to the right position
-    //extract the meta data and return it
-    if (mapIterator->second.hasMetaData(keyword))
-      return mapIterator->second.getMetaData(keyword)->toString();
-    else
-      return "";
-  }
-
-  void GdcmVolumeReader::setMetaDataFromDict(MetaDataContainer* container,
-    const DicomDict* dict,
-    const std::string& file,
-    bool setAll)
-    throw (FileException)
-  {
-    if ((!container) || (!dict))
-      return;
-
-    gdcm::Reader reader;
-    reader.SetFileName(file.c_str());
-    if ((!reader.Read()) || (!reader.GetFile().GetHeader().IsValid()))
-      throw FileException("Cannot extract meta data from file " + file, file);
-
-    gdcm::StringFilter sf;
-    sf.SetFile(reader.GetFile());
-
-    const std::vector<std::string> keys = dict->getKeywordVector();
-
-    std::vector<std::string>::const_iterator keywordIterator;
-
-    for (keywordIterator = keys.begin(); keywordIterator != keys.end(); ++keywordIterator) {
-      //get entry and check if it should be set as MetaData
-      DicomDictEntry entry = dict->getDictEntryByKeyword(*keywordIterator);
-      if (entry.isMetaData() || setAll) {
-        //get the value
-        std::string s = trim(sf.ToString(getTagFromDictEntry(entry)), " ");
-        if (!s.empty()) {
-          //if value is not empty: construct MetaData and add to MetaDataContainer
-          MetaDataBase* m = constructMetaData(entry, s);
-
-          if (container->hasMetaData(*keywordIterator))
-            container->removeMetaData(*keywordIterator);
-          container->addMetaData(*keywordIterator, m);
-        }
-      }
+    if (indexFileName_.empty()) {
+      if (!parseSliceRecord(fileName, record))
+        return false;
+      sliceRecordBuffer_[fileName] = record;
+      return true;
     }
-  }
-
-  gdcm::Tag GdcmVolumeReader::getTagFromDictEntry(const DicomDictEntry &entry) {
-    return gdcm::Tag(entry.getGroupTagUint16(), entry.getElementTagUint16());
-  }
 
-  MetaDataBase* GdcmVolumeReader::constructMetaData(const DicomDictEntry &entry, const std::string &valueString) {
-
-    std::string vr = entry.getValueRepresentation();
-    std::string vm = entry.getValueMultiplicity();
-    std::string value = valueString;
-    value = trim(value, " ");
-    vr = trim(vr, " ");
-    vm = trim(vm, " ");
-
-    //select by ValueRepresentation and ValueMultiplicity
-    if ((vr == "IS") && (vm == "1")) {
-      //string to int
-      IntMetaData* m = new IntMetaData();
-      int i = stoi(value);
-      m->setValue(i);
-      return m;
-    }
-    else if ((vr == "IS") && (vm == "2")) {
-      //string to glm::ivec2
-      IVec2MetaData* m = new IVec2MetaData();
-      std::vector<std::string> values = strSplit(value, '\\');
-      glm::ivec2 v;
-      v.x = stoi(values[0]);
-      v.y = stoi(values[1]);
-      m->setValue(v);
-      return m;
-    }
-    else if ((vr == "IS") && (vm == "3")) {
-      //string to glm::ivec3
-      IVec3MetaData* m = new IVec3MetaData();
-      std::vector<std::string> values = strSplit(value, '\\');
-      glm::ivec3 v;
-      v.x = stoi(values[0]);
-      v.y = stoi(values[1]);
-      v.z = stoi(values[2]);
-      m->setValue(v);
-      return m;
-    }
-    else if (((vr == "FL") || (vr == "DS") || (vr == "OF")) && (vm == "1")) {
-      //string to float
-      FloatMetaData* m = new FloatMetaData();
-      float f = stof(value);
-      m->setValue(f);
-      return m;
-    }
-    else if (((vr == "FL") || (vr == "DS") || (vr == "OF")) && (vm == "2")) {
-      //string to glm::vec2
-      Vec2MetaData* m = new Vec2MetaData();
-      std::vector<std::string> values = strSplit(value, '\\');
-      glm::vec2 v;
-      v.x = stof(values[0]);
-      v.y = stof(values[1]);
-      m->setValue(v);
-      return m;
-    }
-    else if (((vr == "FL") || (vr == "DS") || (vr == "OF")) && (vm == "3")) {
-      //string to glm::vec3
-      Vec3MetaData* m = new Vec3MetaData();
-      std::vector<std::string> values = strSplit(value, '\\');
-      glm::vec3 v;
-      v.x = stof(values[0]);
-      v.y = stof(values[1]);
-      v.z = stof(values[2]);
-      m->setValue(v);
-      return m;
-    }
-    else if ((vr == "FD") && (vm == "1")) {
-      //string to double
-      DoubleMetaData* m = new DoubleMetaData();
-      value = trim(value, " ");
-      double d = stof(value);
-      m->setValue(d);
-      return m;
-    }
-    else if ((vr == "FD") && (vm == "2")) {
-      //string to glm::dvec2
-      DVec2MetaData* m = new DVec2MetaData();
-      std::vector<std::string> values = strSplit(value, '\\');
-      glm::dvec2 v;
-      v.x = stod(values[0]);
-      v.y = stod(values[1]);
-      m->setValue(v);
-      return m;
-    }
-    else if ((vr == "FD") && (vm == "3")) {
-      //string to glm::dvec3
-      DVec3MetaData* m = new DVec3MetaData();
-      std::vector<std::string> values = strSplit(value, '\\');
-      glm::dvec3 v;
-      v.x = stod(values[0]);
-      v.y = stod(values[1]);
-      v.z = stod(values[2]);
-      m->setValue(v);
-      return m;
-    }
-    else {
-      //other type: just use the string
-      StringMetaData* m = new StringMetaData();
-      m->setValue(value);
-      return m;
+    //use the series index as long as the file has not been touched
+    uint64_t fileSize = FileSystem::fileSize(fileName);
+    time_t fileTime = FileSystem::fileTime(fileName);
+    bool readable = false;
+    if (!seriesIndex_.lookup(fileName, fileSize, fileTime, record, readable)) {
+      readable = parseSliceRecord(fileName, record);
+      seriesIndex_.insert(fileName, fileSize, fileTime, readable ? &record : 0);
     }
+
+    if (readable)
+      sliceRecordBuffer_[fileName] = record;
+    return readable;
   }
 
-  VolumeList* GdcmVolumeReader::selectAndLoadDicomFiles(
-    const std::vector<std::string> &fileNames,
-    const std::string& origin,
-    std::string& searchSeriesInstanceUID)
-    throw (FileException, std::bad_alloc)
+  bool GdcmVolumeReader::parseSliceRecord(const std::string& fileName, DicomSliceRecord& record)
   {
-    if (fileNames.empty())
-      throw FileNotFoundException("Directory is empty!", origin);
+    numParsedHeaders_++;
 
-    //filter the given files, so that only readable DICOM files with one SeriesInstanceUID remain
-    bool filter;
-    if (searchSeriesInstanceUID.empty())
-      filter = false;
-    else
-      filter = true;
-
-    std::vector<std::string> useFiles; //selected files to be used
-
-    std::vector<std::string>::const_iterator i;
-    int itemused = 1;
-
-    if (getProgressBar())
-      getProgressBar()->setTitle("Preselecting files");
-
-    for (i = fileNames.begin(); i != fileNames.end(); i++) {
+    //parse everything in front of the pixel data, the pixel data itself is skipped and read when loading
+    const gdcm::Tag pixelData(0x7fe0, 0x0010);
+    std::set<gdcm::Tag> skipTags;
+    skipTags.insert(pixelData);
+    gdcm::Reader reader;
+    reader.SetFileName(fileName.c_str());
+    if (!reader.ReadUpToTag(pixelData, skipTags))
+      return false;
 
-      if (getProgressBar()) {
-        getProgressBar()->setProgressMessage("Checking SeriesInstanceUID of files...");
-        getProgressBar()->setProgress(static_cast<float>(itemused) / static_cast<float>(fileNames.size()));
-        itemused++;
-      }
+    const gdcm::File& file = reader.GetFile();
+    if (!file.GetHeader().IsValid()) {
+      LWARNING("File Header not valid: " << fileName);
+      return false;
+    }
 
-      if (!isDicomFile(*i)) {
-        LINFO("Skipping file: " + (*i));
-      }
-      else {
-        gdcm::Reader iReader;
-
-        if (!filter) {
-          //if there is no SeriesInstanceUID until now, get it from the first file
-          //Read file
-          iReader.SetFileName((*i).c_str());
-          iReader.Read();
-
-          //check if meta information is valid
-          if (!iReader.GetFile().GetHeader().IsValid())
-            throw FileAccessException("GdcmVolumeReader: File Header not valid! ", (*i));
-
-          //get SeriesInstanceUID
-          std::string seriesInstanceUID = getMetaDataFromFile(*i, *dict_, "SeriesInstanceUID");
-
-          if (seriesInstanceUID.empty())
-            LERROR("File has no SeriesInstanceUID: " << (*i));
-          else {
-            seriesInstanceUID = trim(seriesInstanceUID, " ");
-            searchSeriesInstanceUID = seriesInstanceUID;
-            filter = true;
-            useFiles.push_back(*i);
-            LINFO("Using first SeriesInstanceUID found: " + seriesInstanceUID);
-          }
-        }
-        else {
-          //check if this file belongs to the given series
-          std::string seriesInstanceUID = getMetaDataFromFile(*i, *dict_, "SeriesInstanceUID");
+    gdcm::StringFilter sf;
+    sf.SetFile(file);
+
+    record = DicomSliceRecord();
+    record.fileName_ = fileName;
+    record.seriesInstanceUID_ = trim(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SeriesInstanceUID"))), " ");
+    record.studyInstanceUID_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("StudyInstanceUID")));
+    record.seriesDescription_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SeriesDescription")));
+    record.studyDescription_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("StudyDescription")));
+    record.modality_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("Modality")));
+    record.patientName_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("PatientName")));
+    record.patientId_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("PatientID")));
+    record.rescaleType_ = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("RescaleType")));
 
-          if (seriesInstanceUID == searchSeriesInstanceUID)
-            useFiles.push_back(*i);
+    gdcm::MediaStorage ms;
+    ms.SetFromFile(file);
+    record.dicomDir_ = (ms == gdcm::MediaStorage::MediaStorageDirectoryStorage);
+    if (record.dicomDir_)
+      return true;
+
+    //image related information, computed the same way gdcm::ImageReader does
+    std::vector<unsigned int> dimensions = gdcm::ImageHelper::GetDimensionsValue(file);
+    record.dimensions_ = glm::ivec3(static_cast<int>(dimensions[0]), static_cast<int>(dimensions[1]),
+      (dimensions.size() > 2) ? std::max(static_cast<int>(dimensions[2]), 1) : 1);
+    record.numberOfDimensions_ = (record.dimensions_.z > 1) ? 3 : 2;
+
+    std::vector<double> spacing = gdcm::ImageHelper::GetSpacingValue(file);
+    record.spacing_ = glm::dvec3(spacing[0], spacing[1], spacing[2]);
+
+    std::string sliceSpacing = trim(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SpacingBetweenSlices"))), " ");
+    if (!sliceSpacing.empty())
+      record.spacingBetweenSlices_ = stod(sliceSpacing);
+
+    std::vector<double> position = gdcm::ImageHelper::GetOriginValue(file);
+    record.imagePositionPatient_ = glm::dvec3(position[0], position[1], position[2]);
+    if (record.dimensions_.z > 1)
+      record.framePositions_ = getFramePositions(file.GetDataSet(), record.dimensions_.z);
+
+    std::vector<double> directions = gdcm::ImageHelper::GetDirectionCosinesValue(file);
+    record.xOrientationPatient_ = glm::dvec3(directions[0], directions[1], directions[2]);
+    record.yOrientationPatient_ = glm::dvec3(directions[3], directions[4], directions[5]);
+
+    std::vector<double> interceptSlope = gdcm::ImageHelper::GetRescaleInterceptSlopeValue(file);
+    record.intercept_ = interceptSlope[0];
+    record.slope_ = interceptSlope[1];
+
+    //the frames of a multiframe image may carry rescale values of their own
+    if (record.dimensions_.z > 1) {
+      std::vector<glm::dvec2> frameRescales = getFrameRescales(file.GetDataSet(), record.dimensions_.z);
+      if (!frameRescales.empty()) {
+        record.intercept_ = frameRescales[0].x;
+        record.slope_ = frameRescales[0].y;
+        for (size_t i = 1; i < frameRescales.size(); ++i) {
+          if (frameRescales[i] != frameRescales[0])
+            record.frameRescaleDiffers_ = true;
         }
       }
     }
 
-    if (getProgressBar())
-      getProgressBar()->hide();
-
-    //now all files in useFiles belong to the same SeriesInstanceUID
-    if (useFiles.empty())
-      throw FileNotFoundException("No file with corresponding SeriesInstanceUID could be found!", origin);
+    record.pixelFormat_ = gdcm::ImageHelper::GetPixelFormatValue(file);
+
+    //uncompressed little endian grayscale data without unused bits can be read straight from the file later on,
+    //the reader stops right behind the header of the skipped pixel data element: tag, VR and reserved bytes
+    //for explicit VR, 32 bit value length
+    const gdcm::TransferSyntax& ts = file.GetHeader().GetDataSetTransferSyntax();
+    record.explicitVR_ = ts.IsExplicit();
+    gdcm::PhotometricInterpretation pi = gdcm::ImageHelper::GetPhotometricInterpretationValue(file);
+    bool rawLittleEndian = (ts == gdcm::TransferSyntax::ImplicitVRLittleEndian) || (ts == gdcm::TransferSyntax::ExplicitVRLittleEndian);
+    bool monochrome = (pi == gdcm::PhotometricInterpretation::MONOCHROME1) || (pi == gdcm::PhotometricInterpretation::MONOCHROME2);
+    if (rawLittleEndian && monochrome && (record.pixelFormat_.GetSamplesPerPixel() == 1)
+      && (record.pixelFormat_.GetBitsAllocated() == record.pixelFormat_.GetBitsStored())
+      && (record.pixelFormat_.GetBitsAllocated() % 8 == 0)) {
+      int64_t headerLength = record.explicitVR_ ? 12 : 8;
+      int64_t valueOffset = static_cast<int64_t>(reader.GetStreamCurrentPosition());
+      if (valueOffset >= headerLength)
+        record.pixelDataOffset_ = valueOffset - headerLength;
+    }
 
-    return subdivideAndLoadDicomFiles(useFiles, origin);
+    return true;
   }
 
   VolumeList* GdcmVolumeReader::subdivideAndLoadDicomFiles(
-    const std::vector<std::string> &fileNames,
+    const std::vector<DicomSliceRecord> &slices,
     const std::string& origin)
     throw (FileException, std::bad_alloc)
   {
     VolumeList* vc = new VolumeList(); //the VolumeCollection to be returned
 
-    Volume* vh = readDicomFiles(fileNames, origin);
+    Volume* vh = readDicomFiles(slices, origin);
     if (vh) {
       vh->setOrigin(origin);
       vh->SetReady();
@@ -452,40 +387,39 @@ namespace tgt {
   }
 
   /*
-  * Sorts strings according to a double value interpreted as the distance of the Image Origin to the Volume Origin
+  * Sorts slice records according to their distance of the Image Origin to the Volume Origin
   */
-  bool slices_cmp_dist(std::pair<std::string, double> a, std::pair<std::string, double> b) {
-    return a.second < b.second;
+  bool slices_cmp_dist(const DicomSliceRecord& a, const DicomSliceRecord& b) {
+    return a.distance_ < b.distance_;
   }
 
   Volume* GdcmVolumeReader::readDicomFiles(
-    const std::vector<std::string> &fileNames,
+    const std::vector<DicomSliceRecord> &records,
     const std::string& origin)
     throw (FileException, std::bad_alloc)
   {
-    std::vector<std::pair<std::string, double> > slices; //filename, distance
+    if (records.empty())
+      throw CorruptedFileException("Path does not contain any DICOM slices");
+
+    LoadClock::time_point phaseStart = LoadClock::now();
 
     //take first file as reference, since all files belong to the same SeriesInstanceUID
-    gdcm::ImageReader reader;
-    reader.SetFileName(fileNames.begin()->c_str());
-    reader.Read();
-    gdcm::StringFilter sf;
-    sf.SetFile(reader.GetFile());
+    const DicomSliceRecord& reference = records.front();
 
     //Get Meta Information
-    info_.setSeriesInstanceUID(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SeriesInstanceUID"))));
-    info_.setStudyInstanceUID(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("StudyInstanceUID"))));
-    info_.setSeriesDescription(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SeriesDescription"))));
-    info_.setStudyDescription(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("StudyDescription"))));
-    info_.setModality(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("Modality"))));
-    info_.setPatientName(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("PatientName"))));
-    info_.setPatientId(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("PatientID"))));
+    info_.setSeriesInstanceUID(reference.seriesInstanceUID_);
+    info_.setStudyInstanceUID(reference.studyInstanceUID_);
+    info_.setSeriesDescription(reference.seriesDescription_);
+    info_.setStudyDescription(reference.studyDescription_);
+    info_.setModality(reference.modality_);
+    info_.setPatientName(reference.patientName_);
+    info_.setPatientId(reference.patientId_);
 
-    info_.setIntercept(static_cast<float>(reader.GetImage().GetIntercept()));
-    info_.setSlope(static_cast<float>(reader.GetImage().GetSlope()));
-    info_.setRescaleType(sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("RescaleType"))));
+    info_.setIntercept(static_cast<float>(reference.intercept_));
+    info_.setSlope(static_cast<float>(reference.slope_));
+    info_.setRescaleType(reference.rescaleType_);
 
-    gdcm::PixelFormat::ScalarType scalarType = reader.GetImage().GetPixelFormat().GetScalarType();
+    gdcm::PixelFormat::ScalarType scalarType = reference.pixelFormat_.GetScalarType();
 
     //for checks, if pixel data needs to be rescaled
     bool slopeDiffers = false;
@@ -493,124 +427,64 @@ namespace tgt {
 
     //get image related information
     //get image dimensions
-    const unsigned int* dimensions = reader.GetImage().GetDimensions();
-
-    if (dimensions) {
-      info_.setDx(dimensions[0]);
-      info_.setDy(dimensions[1]);
+    if (reference.dimensions_.x > 0 && reference.dimensions_.y > 0) {
+      info_.setDx(reference.dimensions_.x);
+      info_.setDy(reference.dimensions_.y);
     }
     else
-      throw FileException("No Dimensions found in Image File.", *fileNames.begin());
+      throw FileException("No Dimensions found in Image File.", reference.fileName_);
 
     //get bits stored
-    info_.setBitsStored(reader.GetImage().GetPixelFormat().GetBitsStored());
+    info_.setBitsStored(reference.pixelFormat_.GetBitsStored());
     //get samples per pixel
-    info_.setSamplesPerPixel(reader.GetImage().GetPixelFormat().GetSamplesPerPixel());
+    info_.setSamplesPerPixel(reference.pixelFormat_.GetSamplesPerPixel());
 
     LINFO("    Size: " << info_.getDx() << "x" << info_.getDy() << ", " << info_.getBitsStored()* info_.getSamplesPerPixel() << " bits");
 
     //get spacing for x and y
-    const double* spacing = reader.GetImage().GetSpacing();
-    info_.setXSpacing(spacing[0]);
-    info_.setYSpacing(spacing[1]);
+    info_.setXSpacing(reference.spacing_.x);
+    info_.setYSpacing(reference.spacing_.y);
 
     //get ImageOrientation
-    glm::dvec3 xOrientationPatient;
-    glm::dvec3 yOrientationPatient;
-    const double* directions = reader.GetImage().GetDirectionCosines();
-    xOrientationPatient.x = directions[0];
-    xOrientationPatient.y = directions[1];
-    xOrientationPatient.z = directions[2];
-    yOrientationPatient.x = directions[3];
-    yOrientationPatient.y = directions[4];
-    yOrientationPatient.z = directions[5];
-
-    info_.setXOrientationPatient(xOrientationPatient);
-    info_.setYOrientationPatient(yOrientationPatient);
+    info_.setXOrientationPatient(reference.xOrientationPatient_);
+    info_.setYOrientationPatient(reference.yOrientationPatient_);
 
     //calculate slice normal
-    glm::dvec3 sliceNormal = glm::cross(xOrientationPatient, yOrientationPatient);
+    glm::dvec3 sliceNormal = glm::cross(reference.xOrientationPatient_, reference.yOrientationPatient_);
 
     info_.setSliceNormal(sliceNormal);
 
-    //Read ImagePositionPatient from all files and calculate distance along slice normal
-    std::vector<std::string>::const_iterator it_files = fileNames.begin();
-    int i = 0;
-    if (getProgressBar() && !fileNames.empty())
+    if (getProgressBar())
       getProgressBar()->setTitle("Loading DICOM Data Set");
 
-    while (it_files != fileNames.end()) {
-      if (getProgressBar()) {
-        getProgressBar()->setProgressMessage("Reading slice '" + FileSystem::fileName(*it_files) + "' ...");
-        getProgressBar()->setProgress(static_cast<float>(i) / static_cast<float>(fileNames.size()));
-      }
-      i++;
-
-      //Read file
-      gdcm::ImageReader reader;
-      reader.SetFileName((*it_files).c_str());
-
-      //check if file could be read -> should always be the case due to earlier checks
-      if (!reader.Read()){
-        if (getProgressBar())
-          getProgressBar()->hide();
-        throw FileAccessException("Could not read File which should be readable!", (*it_files));
-      }
-
-      //check if meta information is valid -> should always be the case due to earlier checks
-      if (!reader.GetFile().GetHeader().IsValid()){
-        if (getProgressBar())
-          getProgressBar()->hide();
-        throw FileAccessException("GdcmVolumeReader: File Header not valid! ", (*it_files));
-      }
-
-      gdcm::StringFilter sf = gdcm::StringFilter();
-      sf.SetFile(reader.GetFile());
-
-      //get position of image
-      glm::dvec3 imagePositionPatient;
-      const double* origin = reader.GetImage().GetOrigin();
-      imagePositionPatient.x = origin[0];
-      imagePositionPatient.y = origin[1];
-      imagePositionPatient.z = origin[2];
-
-      //calculate distance
-      double dist = glm::dot(info_.getSliceNormal(), imagePositionPatient);
-
-      //add image
-      slices.push_back(make_pair(*it_files, dist));
-
-      it_files++;
-    }
+    //calculate distance of every ImagePositionPatient along slice normal
+    std::vector<DicomSliceRecord> slices(records);
+    for (size_t i = 0; i < slices.size(); ++i)
+      slices[i].distance_ = glm::dot(info_.getSliceNormal(), slices[i].imagePositionPatient_);
 
-    if (slices.size() == 0) {
-      if (getProgressBar())
-        getProgressBar()->hide();
-      throw CorruptedFileException("Path does not contain any DICOM slices");
-    }
-    else if (slices.size() == 1) {
+    if (slices.size() == 1) {
       //check, if this file is a multiframe image
-      if (reader.GetImage().GetNumberOfDimensions() == 3) {
-        //get number of frames in this image
-        std::string frames = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("NumberOfFrames")));
-        if (!frames.empty())
-          info_.setDz(stoi(frames));
-        else {
-          info_.setDz(1);
+      if (reference.numberOfDimensions_ == 3) {
+        //the frames are read as one block and share the rescale values of the volume
+        if (reference.frameRescaleDiffers_) {
+          if (getProgressBar())
+            getProgressBar()->hide();
+          throw FileException("Frames of the multiframe image use different Rescale Intercept/Slope values (Not supported)", reference.fileName_);
         }
 
+        //get number of frames in this image
+        info_.setDz(reference.dimensions_.z);
         info_.setNumberOfFrames(info_.getDz());
 
         //get Z Spacing
-        std::string sliceSpacing = sf.ToString(getTagFromDictEntry(dict_->getDictEntryByKeyword("SpacingBetweenSlices")));
-        if (!sliceSpacing.empty())
-          info_.setZSpacing(stod(sliceSpacing));
+        if (reference.spacingBetweenSlices_ != 0.0)
+          info_.setZSpacing(reference.spacingBetweenSlices_);
         else {
           info_.setZSpacing(1.0);
         }
 
       }
-      else if (reader.GetImage().GetNumberOfDimensions() == 2){
+      else if (reference.numberOfDimensions_ == 2){
         //not a multiframe image
         info_.setDz(1);
         info_.setZSpacing(1.0);
@@ -619,7 +493,7 @@ namespace tgt {
       else {
         if (getProgressBar())
           getProgressBar()->hide();
-        throw FileException("Unexpected Number of Dimensions in Image File (Not supported): " + reader.GetImage().GetNumberOfDimensions(), slices.begin()->first);
+        throw FileException("Unexpected Number of Dimensions in Image File (Not supported): " + itos(reference.numberOfDimensions_), reference.fileName_);
       }
     }
     else
@@ -627,42 +501,37 @@ namespace tgt {
 
     //sort slices by their distance from the origin, calculate Z spacing and do some additional checks
     if (slices.size() > 1) {
-      //sort slices by distance from origin
-      std::sort(slices.begin(), slices.end(), slices_cmp_dist);
+      //sort slices by distance from origin (nothing to do if they come in the order stored in the series index)
+      if (!std::is_sorted(slices.begin(), slices.end(), slices_cmp_dist))
+        std::sort(slices.begin(), slices.end(), slices_cmp_dist);
 
       //check, if all images files are of dimension 2
       //also check if rescale intercept and slope are uniform and samples per pixel = 1 in all images
       int samplesPerPixel = 1;
       for (unsigned int i = 0; i < slices.size(); i++) {
-        gdcm::ImageReader imR;
-        imR.SetFileName(slices[i].first.c_str());
-        imR.Read();
-        if (imR.GetImage().GetNumberOfDimensions() != 2) {
+        if (slices[i].numberOfDimensions_ != 2) {
           if (getProgressBar())
             getProgressBar()->hide();
-          throw FileException("Image file has unexpected Dimensions (Multiple slices are required to have Dimension 2): " + imR.GetImage().GetNumberOfDimensions(), slices[i].first);
+          throw FileException("Image file has unexpected Dimensions (Multiple slices are required to have Dimension 2): " + itos(slices[i].numberOfDimensions_), slices[i].fileName_);
         }
 
         //check if PixelRepresentation is uniform
-        if (imR.GetImage().GetPixelFormat().GetScalarType() != scalarType) {
+        if (slices[i].pixelFormat_.GetScalarType() != scalarType) {
           if (getProgressBar())
             getProgressBar()->hide();
           throw FileException("Image files do not have uniform scalar type!");
         }
 
         //check if rescale slope and intercept are the same for alle images, otherwise: warning
-        if (info_.getIntercept() != static_cast<float>(imR.GetImage().GetIntercept())) {
+        if (info_.getIntercept() != static_cast<float>(slices[i].intercept_))
           interceptDiffers = true;
-          //LERROR("Intercept: " + ftos(static_cast<float>(imR.GetImage().GetIntercept())));
-        }
-        if (info_.getSlope() != static_cast<float>(imR.GetImage().GetSlope())) {
+        if (info_.getSlope() != static_cast<float>(slices[i].slope_))
           slopeDiffers = true;
-          //LERROR("Slope: " + ftos(static_cast<float>(imR.GetImage().GetSlope())));
-        }
 
         //check if samples per pixel are uniformly = 1
-        if ((imR.GetImage().GetPixelFormat().GetSamplesPerPixel() != samplesPerPixel) && (imR.GetImage().GetPixelFormat().GetSamplesPerPixel() != 1)) {
-          samplesPerPixel = imR.GetImage().GetPixelFormat().GetSamplesPerPixel();
+        int sliceSamplesPerPixel = slices[i].pixelFormat_.GetSamplesPerPixel();
+        if ((sliceSamplesPerPixel != samplesPerPixel) && (sliceSamplesPerPixel != 1)) {
+          samplesPerPixel = sliceSamplesPerPixel;
           LWARNING("Found image files with unsupported Pixel Format: " + itos(samplesPerPixel) + " Samples per Pixel instead of 1! Might lead to unexpected results.");
           info_.setSamplesPerPixel(samplesPerPixel);
         }
@@ -675,7 +544,7 @@ namespace tgt {
         LWARNING("Rescale Slope differs within the image files!");
 
       //calculate Z-Spacing
-      info_.setZSpacing(slices[1].second - slices[0].second);
+      info_.setZSpacing(slices[1].distance_ - slices[0].distance_);
       if (info_.getZSpacing() == 0){
         if (getProgressBar())
           getProgressBar()->hide();
@@ -684,8 +553,9 @@ namespace tgt {
 
       //check, if slice spacing remains constant (with 10% tolerance)
       for (unsigned int i = 0; i < slices.size() - 1; i++) {
-        if (((slices[i + 1].second - slices[i].second) < 0.9*info_.getZSpacing()) || ((slices[i + 1].second - slices[i].second) > 1.1*info_.getZSpacing())) {
-          if ((slices[i + 1].second - slices[i].second) == 0) {
+        double sliceDistance = slices[i + 1].distance_ - slices[i].distance_;
+        if ((sliceDistance < 0.9*info_.getZSpacing()) || (sliceDistance > 1.1*info_.getZSpacing())) {
+          if (sliceDistance == 0) {
             if (getProgressBar())
               getProgressBar()->hide();
             throw FileException("Slice Spacing is 0: Found two or more Slices with the same Position! (Either not a Volume or Slices have to be subdivided by additional Attributes)");
@@ -703,21 +573,10 @@ namespace tgt {
     }
 
     //get position of first image to calculate offset
-    gdcm::ImageReader yar;
-    yar.SetFileName(slices[0].first.c_str());
-    yar.Read();
-    sf.SetFile(yar.GetFile()); //set file to gdcm::StringFilter for later use
-
-    glm::dvec3 offset;
-    const double* volumeOrigin = yar.GetImage().GetOrigin();
-    offset.x = volumeOrigin[0];
-    offset.y = volumeOrigin[1];
-    offset.z = volumeOrigin[2];
-
-    info_.setOffset(offset);
+    info_.setOffset(slices[0].imagePositionPatient_);
 
     //get pixel representation
-    info_.setPixelRepresentation(yar.GetImage().GetPixelFormat().GetPixelRepresentation());
+    info_.setPixelRepresentation(slices[0].pixelFormat_.GetPixelRepresentation());
 
     LINFO("We have " << info_.getDz() << " slices. [" << info_.getDx() << "x" << info_.getDy() << "]");
     LINFO("Spacing: (" << info_.getXSpacing() << "; " << info_.getYSpacing() << "; " << info_.getZSpacing() << ")");
@@ -775,6 +634,16 @@ namespace tgt {
       }
     }
 
+    //remember headers and slice order for the next time this series is opened
+    if (!indexFileName_.empty()) {
+      seriesIndex_.setSliceOrder(info_.getSeriesInstanceUID(), slices);
+      if (seriesIndex_.isModified())
+        seriesIndex_.save(indexFileName_);
+    }
+
+    double validateSeconds = secondsSince(phaseStart);
+    phaseStart = LoadClock::now();
+
     bool rwmDiffers = slopeDiffers || interceptDiffers;
     info_.setRwmDiffers(rwmDiffers);
 
@@ -834,20 +703,21 @@ namespace tgt {
     VolumeFactory volumeFac;
     info_.setBytesPerVoxel(volumeFac.getBytesPerVoxel(info_.getFormat()));
 
-    //copy slices into new vector for disk representation
-    std::vector<std::string> sliceFilenamesOnly(slices.size());
-    for (size_t i = 0; i < slices.size(); ++i)
-      sliceFilenamesOnly.at(i) = slices.at(i).first;
+    double rescaleSeconds = secondsSince(phaseStart);
+    phaseStart = LoadClock::now();
 
     Volume* vh = 0;
 
     if (info_.getNumberOfFrames() > 1) {
-      throw Exception("Multiframe DICOM file not supported yet");
+      //build volume raw representation from the frames of a single file
+      VolumeRAM* volumeRAM = loadDicomMultiframe(slices[0]);
 
+      vh = new Volume(volumeRAM,
+        glm::vec3(static_cast<float>(info_.getXSpacing()), static_cast<float>(info_.getYSpacing()), static_cast<float>(info_.getZSpacing())), glm::vec3(0.f));
     }
     else {
       //build volume raw representation
-      VolumeRAM* volumeRAM = loadDicomSlices(info_, sliceFilenamesOnly);
+      VolumeRAM* volumeRAM = loadDicomSlices(info_, slices);
 
       //build: VolumeDisk -> Volume
       vh = new Volume(volumeRAM,
@@ -873,13 +743,16 @@ namespace tgt {
     //VolumeGL* vgl = new VolumeGL(vh->getRepresentation<VolumeRAM>());
     //vh->addRepresentation(vgl);
 
+    LINFO("Load time: sort/validate " << validateSeconds << " s, rescale " << rescaleSeconds
+      << " s, pixel data " << secondsSince(phaseStart) << " s");
+
     if (getProgressBar())
       getProgressBar()->hide();
 
     return vh;
   }
 
-  void GdcmVolumeReader::computeCorrectRescaleValues(std::vector<std::pair<std::string, double> > slices) {
+  void GdcmVolumeReader::computeCorrectRescaleValues(const std::vector<DicomSliceRecord>& slices) {
     //for every slice, it is assumed that the whole domain of the scalar type values is used
     float rwmMin = std::numeric_limits<float>::max();
     float rwmMax = std::numeric_limits<float>::min();
@@ -887,31 +760,21 @@ namespace tgt {
     float dataTypeMin = 0, dataTypeMax = 0;
 
     //get max and min real world values
-    std::vector<std::pair<std::string, double> >::iterator it_slices = slices.begin();
-
-    int i = 0;
-    while (it_slices != slices.end()) {
-      if (getProgressBar()) {
-        getProgressBar()->setProgressMessage("Calculating pixel rescaling...");
-        getProgressBar()->setProgress(static_cast<float>(i) / static_cast<float>(slices.size()));
-      }
-      i++;
+    if (getProgressBar())
+      getProgressBar()->setProgressMessage("Calculating pixel rescaling...");
 
-      gdcm::ImageReader reader;
-      reader.SetFileName(it_slices->first.c_str());
-      reader.Read();
-      float slope = static_cast<float>(reader.GetImage().GetSlope());
-      float intercept = static_cast<float>(reader.GetImage().GetIntercept());
+    std::vector<DicomSliceRecord>::const_iterator it_slices;
+    for (it_slices = slices.begin(); it_slices != slices.end(); it_slices++) {
+      float slope = static_cast<float>(it_slices->slope_);
+      float intercept = static_cast<float>(it_slices->intercept_);
 
-      dataTypeMin = static_cast<float>(reader.GetImage().GetPixelFormat().GetMin());
-      dataTypeMax = static_cast<float>(reader.GetImage().GetPixelFormat().GetMax());
+      dataTypeMin = static_cast<float>(it_slices->pixelFormat_.GetMin());
+      dataTypeMax = static_cast<float>(it_slices->pixelFormat_.GetMax());
       float sliceMin = dataTypeMin * slope + intercept;
       float sliceMax = dataTypeMax * slope + intercept;
 
       rwmMin = std::min(rwmMin, sliceMin);
       rwmMax = std::max(rwmMax, sliceMax);
-
-      it_slices++;
     }
 
     //Calculate correct global slope and intercept values
@@ -925,11 +788,11 @@ namespace tgt {
       getProgressBar()->hide();
   }
 
-  VolumeRAM* GdcmVolumeReader::loadDicomSlices(DicomInfo info, std::vector<std::string> sliceFiles)
+  VolumeRAM* GdcmVolumeReader::loadDicomSlices(DicomInfo info, const std::vector<DicomSliceRecord>& slices)
     throw (FileException)
   {
 
-    if (sliceFiles.size() < 1)
+    if (slices.size() < 1)
       throw FileException("No slice files to build volume!");
 
     LINFO("Building volume...");
@@ -939,7 +802,7 @@ namespace tgt {
     VolumeRAM* dataset = 0;
     try {
       //create data set for the slices
-      dataset = volumeFac.create(info.getFormat(), glm::ivec3(info.getDx(), info.getDy(), sliceFiles.size()));
+      dataset = volumeFac.create(info.getFormat(), glm::ivec3(info.getDx(), info.getDy(), slices.size()));
     }
     catch (std::exception& e) {
       LERROR(e.what());
@@ -948,66 +811,330 @@ namespace tgt {
       throw e;
     }
 
-    LINFO("Reading slice data from " << sliceFiles.size() << " files...");
+    resetSliceProblems();
 
-    size_t posScalar = 0;
+    int numThreads = numWorkerThreads_;
+    if (numThreads == 0)
+      numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    numThreads = std::max(1, std::min(numThreads, static_cast<int>(slices.size())));
 
-    std::vector<std::string>::iterator it_slices = sliceFiles.begin();
-    size_t i = 0;
-    while (it_slices != sliceFiles.end()) {
-      if (getProgressBar()) {
-        getProgressBar()->setProgressMessage("Loading slice '" + FileSystem::fileName(*it_slices) + "' ...");
-        getProgressBar()->setProgress(static_cast<float>(i) / static_cast<float>(sliceFiles.size()));
-        i++;
+    LINFO("Reading slice data from " << slices.size() << " files using " << numThreads << " thread(s)...");
+
+    char* dataStorage = reinterpret_cast<char*>(dataset->getData());
+    size_t failedSlice = slices.size();
+
+    if (numThreads > 1) {
+      failedSlice = loadDicomSlicesParallel(dataStorage, info, slices, numThreads);
+    }
+    else {
+      size_t posScalar = 0;
+      for (size_t i = 0; i < slices.size(); ++i) {
+        if (getProgressBar()) {
+          getProgressBar()->setProgressMessage("Loading slice '" + FileSystem::fileName(slices[i].fileName_) + "' ...");
+          getProgressBar()->setProgress(static_cast<float>(i) / static_cast<float>(slices.size()));
+        }
+
+        int slicesize = loadSlice(dataStorage, slices[i], posScalar, info);
+        if (slicesize == 0) {
+          //obviously an error in loadSlice method
+          failedSlice = i;
+          break;
+        }
+
+        posScalar += slicesize;
       }
+    }
+
+    if (getProgressBar())
+      getProgressBar()->hide();
+
+    reportSliceProblems(slices.size());
+
+    if (failedSlice < slices.size()) {
+      delete dataset;
+      throw FileException("Failed to read Pixel data.", slices[failedSlice].fileName_);
+    }
+
+    LINFO("Building volume complete.");
+
+    return dataset;
+  }
+
+  VolumeRAM* GdcmVolumeReader::loadDicomMultiframe(const DicomSliceRecord& slice)
+    throw (FileException)
+  {
+    const int numFrames = info_.getNumberOfFrames();
+
+    LINFO("Building volume from " << numFrames << " frames...");
+
+    VolumeFactory volumeFac;
+    VolumeRAM* dataset = 0;
+    try {
+      dataset = volumeFac.create(info_.getFormat(), glm::ivec3(info_.getDx(), info_.getDy(), numFrames));
+    }
+    catch (std::exception& e) {
+      LERROR(e.what());
+      if (getProgressBar())
+        getProgressBar()->hide();
+      throw e;
+    }
+
+    resetSliceProblems();
+
+    if (getProgressBar()) {
+      getProgressBar()->setProgressMessage("Loading frames of '" + FileSystem::fileName(slice.fileName_) + "' ...");
+      getProgressBar()->setProgress(0.f);
+    }
 
-      int slicesize = loadSlice(reinterpret_cast<char*>(dataset->getData()), *it_slices, posScalar, info);
+    //the pixel data element holds all frames: read it in one go (straight from the file if uncompressed)
+    char* dataStorage = reinterpret_cast<char*>(dataset->getData());
+    int numVoxels = loadSlice(dataStorage, slice, 0, info_);
+    reportSliceProblems(1);
+    if (numVoxels == 0) {
+      delete dataset;
+      if (getProgressBar())
+        getProgressBar()->hide();
+      throw FileException("Failed to read Pixel data.", slice.fileName_);
+    }
+
+    //frame positions from the functional groups, equidistant frames along the normal otherwise
+    std::vector<glm::dvec3> positions = slice.framePositions_;
+    if (static_cast<int>(positions.size()) != numFrames) {
+      LWARNING("No per-frame positions found, assuming equidistant frames");
+      positions.resize(numFrames);
+      for (int i = 0; i < numFrames; ++i)
+        positions[i] = slice.imagePositionPatient_ + static_cast<double>(i) * info_.getZSpacing() * info_.getSliceNormal();
+    }
 
-      if (slicesize == 0) {
-        //obviously an error in loadSlice method
-        delete[] dataset;
+    std::vector<std::pair<double, int> > frames(numFrames); //distance, frame index
+    for (int i = 0; i < numFrames; ++i)
+      frames[i] = std::make_pair(glm::dot(info_.getSliceNormal(), positions[i]), i);
+    std::stable_sort(frames.begin(), frames.end());
+
+    //move frames into slice order: slice i receives frame frames[i].second
+    const size_t frameBytes = static_cast<size_t>(info_.getDx()) * static_cast<size_t>(info_.getDy())
+      * static_cast<size_t>(info_.getBytesPerVoxel());
+    std::vector<bool> done(numFrames, false);
+    std::vector<char> frameBuffer;
+    for (int start = 0; start < numFrames; ++start) {
+      if (done[start] || frames[start].second == start)
+        continue;
+
+      if (frameBuffer.empty())
+        frameBuffer.resize(frameBytes);
+      std::memcpy(&frameBuffer[0], dataStorage + start * frameBytes, frameBytes);
+
+      int current = start;
+      while (frames[current].second != start) {
+        int source = frames[current].second;
+        std::memcpy(dataStorage + current * frameBytes, dataStorage + source * frameBytes, frameBytes);
+        done[current] = true;
+        current = source;
+      }
+      std::memcpy(dataStorage + current * frameBytes, &frameBuffer[0], frameBytes);
+      done[current] = true;
+    }
+
+    //calculate Z-Spacing and check, if it remains constant (with 10% tolerance)
+    if (numFrames > 1) {
+      double zSpacing = frames[1].first - frames[0].first;
+      if (zSpacing == 0) {
+        delete dataset;
         if (getProgressBar())
           getProgressBar()->hide();
-        throw FileException("Failed to read Pixel data.", *it_slices);
+        throw FileException("Frame Spacing is 0: Found two or more Frames with the same Position!", slice.fileName_);
       }
+      info_.setZSpacing(zSpacing);
 
-      posScalar += slicesize;
-      it_slices++;
+      for (int i = 0; i < numFrames - 1; i++) {
+        double frameDistance = frames[i + 1].first - frames[i].first;
+        if ((frameDistance < 0.9*zSpacing) || (frameDistance > 1.1*zSpacing)) {
+          LWARNING("Frame Spacing is not steady (differs > 10% Tolerance)! The data set might be missing one or more frames!");
+          break;
+        }
+      }
     }
+
+    info_.setOffset(positions[frames[0].second]);
+
+    LINFO("Frame spacing: " << info_.getZSpacing());
+
     if (getProgressBar())
       getProgressBar()->hide();
 
-    LINFO("Building volume complete.");
-
     return dataset;
   }
 
-  int GdcmVolumeReader::loadSlice(char* dataStorage, const std::string& fileName, size_t posScalar, DicomInfo info)
+  std::vector<glm::dvec3> GdcmVolumeReader::getFramePositions(const gdcm::DataSet& ds, int numberOfFrames)
   {
+    std::vector<glm::dvec3> positions;
+
+    //PerFrameFunctionalGroupsSequence -> PlanePositionSequence -> ImagePositionPatient
+    const gdcm::Tag perFrameFunctionalGroups(0x5200, 0x9230);
+    const gdcm::Tag planePosition(0x0020, 0x9113);
+    if (!ds.FindDataElement(perFrameFunctionalGroups))
+      return positions;
+
+    gdcm::SmartPointer<gdcm::SequenceOfItems> frameSequence = ds.GetDataElement(perFrameFunctionalGroups).GetValueAsSQ();
+    if (!frameSequence || static_cast<int>(frameSequence->GetNumberOfItems()) != numberOfFrames)
+      return positions;
+
+    for (gdcm::SequenceOfItems::SizeType i = 1; i <= frameSequence->GetNumberOfItems(); ++i) {
+      const gdcm::DataSet& frameDs = frameSequence->GetItem(i).GetNestedDataSet();
+      if (!frameDs.FindDataElement(planePosition))
+        return std::vector<glm::dvec3>();
+
+      gdcm::SmartPointer<gdcm::SequenceOfItems> positionSequence = frameDs.GetDataElement(planePosition).GetValueAsSQ();
+      if (!positionSequence || positionSequence->GetNumberOfItems() == 0)
+        return std::vector<glm::dvec3>();
+
+      gdcm::Attribute<0x0020, 0x0032> imagePositionPatient;
+      imagePositionPatient.SetFromDataSet(positionSequence->GetItem(1).GetNestedDataSet());
+      positions.push_back(glm::dvec3(imagePositionPatient[0], imagePositionPatient[1], imagePositionPatient[2]));
+    }
+
+    return positions;
+  }
+
+  std::vector<glm::dvec2> GdcmVolumeReader::getFrameRescales(const gdcm::DataSet& ds, int numberOfFrames)
+  {
+    std::vector<glm::dvec2> rescales;
+
+    //PerFrameFunctionalGroupsSequence -> PixelValueTransformationSequence -> RescaleIntercept, RescaleSlope
+    const gdcm::Tag perFrameFunctionalGroups(0x5200, 0x9230);
+    const gdcm::Tag pixelValueTransformation(0x0028, 0x9145);
+    if (!ds.FindDataElement(perFrameFunctionalGroups))
+      return rescales;
+
+    gdcm::SmartPointer<gdcm::SequenceOfItems> frameSequence = ds.GetDataElement(perFrameFunctionalGroups).GetValueAsSQ();
+    if (!frameSequence || static_cast<int>(frameSequence->GetNumberOfItems()) != numberOfFrames)
+      return rescales;
+
+    for (gdcm::SequenceOfItems::SizeType i = 1; i <= frameSequence->GetNumberOfItems(); ++i) {
+      const gdcm::DataSet& frameDs = frameSequence->GetItem(i).GetNestedDataSet();
+      if (!frameDs.FindDataElement(pixelValueTransformation))
+        return std::vector<glm::dvec2>();
+
+      gdcm::SmartPointer<gdcm::SequenceOfItems> transformationSequence = frameDs.GetDataElement(pixelValueTransformation).GetValueAsSQ();
+      if (!transformationSequence || transformationSequence->GetNumberOfItems() == 0)
+        return std::vector<glm::dvec2>();
+
+      const gdcm::DataSet& transformationDs = transformationSequence->GetItem(1).GetNestedDataSet();
+      gdcm::Attribute<0x0028, 0x1052> rescaleIntercept;
+      gdcm::Attribute<0x0028, 0x1053> rescaleSlope;
+      rescaleIntercept.SetFromDataSet(transformationDs);
+      rescaleSlope.SetFromDataSet(transformationDs);
+      double slope = transformationDs.FindDataElement(rescaleSlope.GetTag()) ? rescaleSlope.GetValue() : 1.0;
+      double intercept = transformationDs.FindDataElement(rescaleIntercept.GetTag()) ? rescaleIntercept.GetValue() : 0.0;
+      rescales.push_back(glm::dvec2(intercept, slope));
+    }
+
+    return rescales;
+  }
+
+  size_t GdcmVolumeReader::loadDicomSlicesParallel(char* dataStorage, const DicomInfo& info,
+    const std::vector<DicomSliceRecord>& slices, int numThreads)
+  {
+    //every slice has the same size, so each one can be decoded straight into its final position
+    const size_t voxelsPerSlice = static_cast<size_t>(info.getDx()) * static_cast<size_t>(info.getDy())
+      * static_cast<size_t>(info.getNumberOfFrames());
+
+    std::atomic<size_t> nextSlice(0);
+    std::atomic<bool> failed(false);
+
+    std::mutex mutex;
+    std::condition_variable sliceLoaded;
+    size_t numLoaded = 0;
+    int numFinished = 0;
+    size_t failedSlice = slices.size();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; ++t) {
+      workers.push_back(std::thread([&]() {
+        for (size_t i = nextSlice++; (i < slices.size()) && !failed; i = nextSlice++) {
+          int slicesize = 0;
+          try {
+            slicesize = loadSlice(dataStorage, slices[i], i * voxelsPerSlice, info);
+          }
+          catch (...) {
+            addSliceError("Unexpected exception while loading file " + slices[i].fileName_);
+            slicesize = 0;
+          }
+
+          std::lock_guard<std::mutex> lock(mutex);
+          if (slicesize == 0) {
+            failed = true;
+            failedSlice = std::min(failedSlice, i);
+          }
+          numLoaded++;
+          sliceLoaded.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        numFinished++;
+        sliceLoaded.notify_one();
+      }));
+    }
+
+    //the progress bar is not thread-safe, so only the calling thread reports
+    if (getProgressBar())
+      getProgressBar()->setProgressMessage("Loading slices...");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t reported = 0;
+    while (numFinished < numThreads) {
+      sliceLoaded.wait(lock, [&]() { return (numLoaded != reported) || (numFinished == numThreads); });
+      reported = numLoaded;
+
+      lock.unlock();
+      if (getProgressBar())
+        getProgressBar()->setProgress(static_cast<float>(reported) / static_cast<float>(slices.size()));
+      lock.lock();
+    }
+    lock.unlock();
+
+    for (size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+
+    return failedSlice;
+  }
+
+  int GdcmVolumeReader::loadSlice(char* dataStorage, const DicomSliceRecord& slice, size_t posScalar, DicomInfo info)
+  {
+    const std::string& fileName = slice.fileName_;
+
+    size_t dataLength = (static_cast<size_t>(info.getDx()) * static_cast<size_t>(info.getDy())
+      * static_cast<size_t>(info.getBytesPerVoxel()) * static_cast<size_t>(info.getNumberOfFrames()));
+
+    gdcm::PixelFormat scalarType = baseTypeStringToGdcm(info.getBaseType());
+    bool rescale = info.rwmDiffers() && (scalarType != gdcm::PixelFormat::UNKNOWN) && (info.getSamplesPerPixel() == 1);
+
+    //uncompressed pixel data that needs no rescaling is copied straight from the file, without parsing it again
+    if (!rescale && slice.pixelDataOffset_ >= 0) {
+      if (readRawPixelData(&dataStorage[posScalar * info.getBytesPerVoxel()], slice, dataLength))
+        return info.getDx() * info.getDy() * info.getNumberOfFrames();
+      //reported by the calling thread once all slices are loaded, see reportSliceProblems()
+      numRawFallbacks_++;
+    }
 
     gdcm::ImageReader reader;
     reader.SetFileName(fileName.c_str());
 
     if (!reader.Read()){
-      LERROR("Error loading file " << fileName);
+      addSliceError("Error loading file " + fileName);
       return 0;
     }
 
-    size_t dataLength = (static_cast<size_t>(info.getDx()) * static_cast<size_t>(info.getDy())
-      * static_cast<size_t>(info.getBytesPerVoxel()) * static_cast<size_t>(info.getNumberOfFrames()));
-
     if (reader.GetImage().GetBufferLength() != dataLength){
-      LERROR("Failed to read Pixel data from file " << fileName << " because of unexpected Buffer Length!");
+      addSliceError("Failed to read Pixel data from file " + fileName + " because of unexpected Buffer Length!");
       return 0;
     }
 
-    gdcm::PixelFormat scalarType = baseTypeStringToGdcm(info.getBaseType());
-
     //get pixel data
-    if (info.rwmDiffers() && (scalarType != gdcm::PixelFormat::UNKNOWN) && (info.getSamplesPerPixel() == 1)) {
+    if (rescale) {
       //if rescale intercept and slope differ: recalculate the scalar values so that these fit the correct rescaling
-      float slope = static_cast<float>(reader.GetImage().GetSlope());
-      float intercept = static_cast<float>(reader.GetImage().GetIntercept());
+      float slope = static_cast<float>(slice.slope_);
+      float intercept = static_cast<float>(slice.intercept_);
 
       float nSlope = slope / info.getSlope();
       float nIntercept = intercept - info.getIntercept();
@@ -1132,7 +1259,7 @@ namespace tgt {
         }
           break;
         default:
-          LERROR("Unexpected datatype while rescaling... no rescaling applied!");
+          addSliceError("Unexpected datatype while rescaling " + fileName + "... no rescaling applied!");
         }
 
         //copy the rescaled values into the scalar buffer
@@ -1149,6 +1276,61 @@ namespace tgt {
     return info.getDx() * info.getDy() * info.getNumberOfFrames();
   }
 
+  void GdcmVolumeReader::addSliceError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(sliceErrorMutex_);
+    sliceErrors_.push_back(message);
+  }
+
+  void GdcmVolumeReader::resetSliceProblems() {
+    std::lock_guard<std::mutex> lock(sliceErrorMutex_);
+    sliceErrors_.clear();
+    numRawFallbacks_ = 0;
+  }
+
+  void GdcmVolumeReader::reportSliceProblems(size_t numFiles) {
+    //the log manager is not thread-safe, so the workers only collect their messages
+    std::vector<std::string> errors;
+    {
+      std::lock_guard<std::mutex> lock(sliceErrorMutex_);
+      errors.swap(sliceErrors_);
+    }
+    for (size_t i = 0; i < errors.size(); ++i)
+      LERROR(errors[i]);
+
+    if (numRawFallbacks_ > 0)
+      LWARNING("Pixel data of " << numRawFallbacks_ << " of " << numFiles
+        << " file(s) not found at the scanned offset, decoded with gdcm instead");
+  }
+
+  bool GdcmVolumeReader::readRawPixelData(char* dataStorage, const DicomSliceRecord& slice, size_t dataLength)
+  {
+#pragma warning(push)
+#pragma warning(disable:4996)
+    FILE* fin = fopen(slice.fileName_.c_str(), "rb");
+#pragma warning(pop)
+    if (!fin)
+      return false;
+
+    //element header: tag (7FE0,0010), VR and reserved bytes for explicit VR, 32 bit value length
+    unsigned char header[12];
+    size_t headerLength = slice.explicitVR_ ? 12 : 8;
+    bool valid = (_fseeki64(fin, slice.pixelDataOffset_, SEEK_SET) == 0)
+      && (fread(header, 1, headerLength, fin) == headerLength)
+      && (header[0] == 0xe0) && (header[1] == 0x7f) && (header[2] == 0x10) && (header[3] == 0x00);
+
+    if (valid) {
+      const unsigned char* vl = &header[headerLength - 4];
+      uint32_t valueLength = vl[0] | (vl[1] << 8) | (vl[2] << 16) | (static_cast<uint32_t>(vl[3]) << 24);
+      //undefined length means encapsulated data, odd lengths are padded to even size
+      valid = (valueLength != 0xffffffff) && (valueLength >= dataLength)
+        && (fread(dataStorage, 1, dataLength, fin) == dataLength);
+    }
+
+    fclose(fin);
+
+    return valid;
+  }
+
   gdcm::PixelFormat GdcmVolumeReader::baseTypeStringToGdcm(const std::string& type) {
     if (type == "uint8")
       return gdcm::PixelFormat::UINT8;
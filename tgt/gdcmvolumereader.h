@@ -4,11 +4,19 @@
 #include "volumelist.h"
 #include "dicomdict.h"
 #include "dicominfo.h"
-#include "metadatacontainer.h"
+#include "dicomslicerecord.h"
+#include "dicomseriesindex.h"
 
 #include <gdcm/gdcmTag.h>
 #include <gdcm/gdcmPixelFormat.h>
 
+#include <atomic>
+#include <mutex>
+
+namespace gdcm {
+  class DataSet;
+}
+
 namespace tgt {
 
   class GdcmVolumeReader : public VolumeReader
@@ -24,58 +32,25 @@ namespace tgt {
     TGT_API virtual VolumeList* read_2(const std::string& fileName)
       throw (IOException, CorruptedFileException, std::bad_alloc);
 
-  private:
     /**
-    * Helper method that returns all filenames contained in a given directory.
+    * Sets the number of threads used for decoding the slices of a series.
+    * 0 (default) uses one thread per hardware core, 1 decodes all slices on the calling thread.
     */
-    std::vector<std::string> getFileNamesInDir(const std::string& dirName) const;
+    TGT_API void setNumWorkerThreads(int numThreads);
+    TGT_API int getNumWorkerThreads() const;
 
     /**
-    * Helper method that determines if a file exists and is a readable Dicom file.
-    *
-    * @param path the path to the file that should be tested
-    * @return true, if the file is a Dicom File, false else
+    * Sets the directory for the persistent series index files (see DicomSeriesIndex).
+    * Reopening an unchanged series then skips all header parsing. An empty string (default) disables the index.
     */
-    bool isDicomFile(const std::string &path) const;
-
-    /**
-    * Helper method that determines if a file is a DICOMDIR.
-    *
-    * @param path the path to the file that should be tested
-    * @return true, if the file is a DICOMDIR, false else
-    */
-    bool isDicomDir(const std::string &path) const;
-
-    /**
-    * Helper method that filters the files by the given SeriesInstanceUID.
-    * All files have to be readable DICOM files and StandardDictionary has to be already loaded!
-    */
-    std::vector<std::string> getFilesInSeries(std::vector<std::string> filenames,
-      std::string seriesInstanceUID);
-
-    /**
-    * Returns meta data from a DICOM file, which is specified by a DicomDict and a keyword for the DictEntry.
-    * If the file and the corresponding tag are already found in the internal file info buffer, it is read from there.
-    * Else all meta information specified in the DicomDict for this file is put into the buffer first.
-    * If there is no such MetaData, an empty string is returned.
-    * If the file is not a valid DICOM file, a FileException is thrown.
-    */
-    std::string getMetaDataFromFile(const std::string& filename,
-      const DicomDict& dict,
-      const std::string& keyword)
-      throw (FileException);
+    TGT_API void setIndexCacheDir(const std::string& dir);
+    TGT_API std::string getIndexCacheDir() const;
 
+  private:
     /**
-    * Extracts the meta data of the file to the MetaDataContainer.
-    * The DicomDict specifies, which meta data is extracted.
-    * If the file is not a valid DICOM file, a FileException is thrown
-    * If setAll is true, also dict entries which are not marked as meta data are set
+    * Helper method that returns all filenames contained in a given directory.
     */
-    static void setMetaDataFromDict(MetaDataContainer* container,
-      const DicomDict* dict,
-      const std::string& file,
-      bool setAll = false)
-      throw (FileException);
+    std::vector<std::string> getFileNamesInDir(const std::string& dirName) const;
 
     /**
     * Helper function that gets the filenames and a VolumeURL.
@@ -94,17 +69,45 @@ namespace tgt {
       std::string& searchSeriesInstanceUID)
       throw (FileException, std::bad_alloc);
 
+    /**
+    * Series scanning stage: parses the header of every given file once and returns the records of all
+    * readable files that belong to the given SeriesInstanceUID.
+    * If searchSeriesInstanceUID is empty, the SeriesInstanceUID of the first readable file is used and written back.
+    *
+    * @param fileNames the files that should be scanned
+    * @param searchSeriesInstanceUID filtered series instance uid
+    *
+    * @return the records of the files belonging to the series, in the order of fileNames
+    */
+    std::vector<DicomSliceRecord> scanSeries(const std::vector<std::string>& fileNames,
+      std::string& searchSeriesInstanceUID);
+
+    /**
+    * Returns the record of a single file. Records are buffered, so every file is parsed at most once while a data set is loaded.
+    * If the series index is enabled, files whose size and modification time did not change are not parsed at all.
+    *
+    * @return false, if the file is not a readable DICOM file
+    */
+    bool scanSliceRecord(const std::string& fileName, DicomSliceRecord& record);
+
+    /**
+    * Parses the header of a single file up to the pixel data element and fills the record.
+    *
+    * @return false, if the file is not a readable DICOM file
+    */
+    bool parseSliceRecord(const std::string& fileName, DicomSliceRecord& record);
+
     /**
     * Helper function before the actual loading (using readDicomFiles): Checks, if any available CustomDicomDict fits the given files (that already should all have the same SeriesInstanceUID).
     * Subdivides and selects the files according to that CustomDicomDict and loads every group by calling readDicomFiles.
     *
-    * @param fileNames the files that should be loaded
+    * @param slices the scanned records of the files that should be loaded
     * @param origin VolumeURL containing at least the path and also the SeriesInstanceUID of the files
     *
     * @return a collection of Volumes constructed out of the given files
     */
     virtual VolumeList* subdivideAndLoadDicomFiles(
-      const std::vector<std::string> &fileNames,
+      const std::vector<DicomSliceRecord> &slices,
       const std::string& origin)
       throw (FileException, std::bad_alloc);
 
@@ -112,13 +115,13 @@ namespace tgt {
     * Helper function that does the actual loading of all files given.
     * Awaits files of one SeriesInstanceUID that belong to one Volume (should only be called by subdivideAndLoadDicomFiles).
     *
-    * @param fileNames vector with the fileNames of the files to load
+    * @param records the scanned records of the files to load
     * @param origin the VolumeURL of the Volume to be loaded
     *
     * @return if reading was succesful, a Volume* constructed of the DICOM slices will be returned
     */
     virtual Volume* readDicomFiles(
-      const std::vector<std::string> &fileNames,
+      const std::vector<DicomSliceRecord> &records,
       const std::string& origin)
       throw (FileException, std::bad_alloc);
 
@@ -126,40 +129,89 @@ namespace tgt {
     * Helper method that finds the correct rescale slope and intercept values for a list of slices where these differ.
     * The correct values are set to info_
     *
-    * @param slices a vector of pairs of a filename and the distance from the origin position of the volume
+    * @param slices the records of the slices, sorted by their distance from the origin position of the volume
     */
-    void computeCorrectRescaleValues(std::vector<std::pair<std::string, double> > slices);
+    void computeCorrectRescaleValues(const std::vector<DicomSliceRecord>& slices);
 
     /**
     * Load several dicom slices of a volume.
     * Does not support multiframe files, only one slice per file.
     *
     * @param info the DicomInfo object containing the necessary meta information (e.g. what the GdcmVolumeReader returns in a VolumeDiskDicom object)
-    * @param sliceFiles the list of (correctly ordered!) slices (e.g. what the GdcmVolumeReader returns in a VolumeDiskDicom object)
+    * @param slices the list of (correctly ordered!) slice records
+    */
+    VolumeRAM* loadDicomSlices(DicomInfo info, const std::vector<DicomSliceRecord>& slices) throw (FileException);
+
+    /**
+    * Loads a multiframe (e.g. enhanced CT/MR) file. The pixel data element is read into the volume at once,
+    * the frames are ordered along the slice normal by their per-frame positions and the z spacing and offset
+    * in info_ are updated accordingly.
+    *
+    * @param slice the record of the multiframe file
+    */
+    VolumeRAM* loadDicomMultiframe(const DicomSliceRecord& slice) throw (FileException);
+
+    /**
+    * Helper function that reads the per-frame ImagePositionPatient of a multiframe image
+    * from the PerFrameFunctionalGroupsSequence.
+    *
+    * @return an empty vector, if the data set has no (complete) per-frame plane positions
+    */
+    static std::vector<glm::dvec3> getFramePositions(const gdcm::DataSet& ds, int numberOfFrames);
+
+    /**
+    * Helper function that reads the per-frame RescaleIntercept (x) and RescaleSlope (y) of a multiframe image
+    * from the PixelValueTransformationSequence of the PerFrameFunctionalGroupsSequence.
+    *
+    * @return an empty vector, if the data set has no (complete) per-frame rescale values
     */
-    VolumeRAM* loadDicomSlices(DicomInfo info, std::vector<std::string> sliceFiles) throw (FileException);
+    static std::vector<glm::dvec2> getFrameRescales(const gdcm::DataSet& ds, int numberOfFrames);
+
+    /**
+    * Decodes the slices on several worker threads, straight into their final position in dataStorage.
+    * Progress is reported through the ProgressBar from the calling thread.
+    *
+    * @return index of the first slice that could not be loaded, slices.size() on success
+    */
+    size_t loadDicomSlicesParallel(char* dataStorage, const DicomInfo& info,
+      const std::vector<DicomSliceRecord>& slices, int numThreads);
 
     /**
     * Helper function that reads a single slice.
     *
     * @param dataStorage pointer to an array in which the data should be stored
-    * @param fileName name of the file to be loaded
+    * @param slice record of the file to be loaded
     * @param posScalar offset into the dataStorage array where this particular slice's pixel data should begin
     * @param info DicomInfo object containig meta information about the volume (e.g. for rescaling)
     *
     * @return returns the number of voxels rendered
     */
-    virtual int loadSlice(char* dataStorage, const std::string& fileName, size_t posScalar, DicomInfo info);
+    virtual int loadSlice(char* dataStorage, const DicomSliceRecord& slice, size_t posScalar, DicomInfo info);
 
     /**
-    * Helper function that returns a Gdcm::Tag constructed by the information of the DicomDictEntry given.
+    * Reads uncompressed little endian pixel data directly from the offset stored in the record,
+    * without parsing the file again.
+    *
+    * @return false, if the pixel data element is not found at the expected position; the caller has to fall back to gdcm then
     */
-    static gdcm::Tag getTagFromDictEntry(const DicomDictEntry& entry);
+    static bool readRawPixelData(char* dataStorage, const DicomSliceRecord& slice, size_t dataLength);
+
+    /// Collects an error of a slice loaded on a worker thread, see reportSliceProblems().
+    void addSliceError(const std::string& message);
+
+    /// Clears the errors and raw read fallbacks collected while loading the slices.
+    void resetSliceProblems();
+
+    /**
+    * Logs the collected slice errors and warns about the files whose pixel data had to be decoded by gdcm
+    * although the record promised a raw read. Called on the calling thread after loading.
+    */
+    void reportSliceProblems(size_t numFiles);
 
     /**
-    * Helper function that constructs the correct type of MetaData Object by knowing its type from a DictEntry and its value
+    * Helper function that returns a Gdcm::Tag constructed by the information of the DicomDictEntry given.
     */
-    static MetaDataBase* constructMetaData(const DicomDictEntry &entry, const std::string &value);
+    static gdcm::Tag getTagFromDictEntry(const DicomDictEntry& entry);
 
     /**
     * Helper method that takes a data type string and converts it to the gdcm representation of the pixel format.
@@ -171,8 +223,18 @@ namespace tgt {
 
     DicomInfo info_; ///< Object containing all relevant meta information about the volume
 
-    ///< used to buffer information about files to reduce file I/Os, buffer is cleared when reading a new dataset
-    std::map<std::string, MetaDataContainer> fileInfoBuffer_;
+    int numWorkerThreads_; ///< number of slice decoding threads, 0 for one per hardware core
+
+    ///< header records of the scanned files, buffer is cleared when reading a new dataset
+    std::map<std::string, DicomSliceRecord> sliceRecordBuffer_;
+
+    std::string indexCacheDir_;       ///< directory of the persistent series index files, empty if disabled
+    std::string indexFileName_;       ///< index file of the directory currently read
+    DicomSeriesIndex seriesIndex_;    ///< persistent index of the directory currently read
+    size_t numParsedHeaders_;         ///< number of headers actually parsed for the current data set
+    std::atomic<size_t> numRawFallbacks_; ///< files of the current data set whose raw pixel data read failed
+    std::vector<std::string> sliceErrors_;  ///< errors of the slice loading threads, guarded by sliceErrorMutex_
+    std::mutex sliceErrorMutex_;
 
     static const std::string loggerCat_;
   };
@@ -0,0 +1,90 @@
+#include "mappedfile.h"
+#include "logmanager.h"
+#include "tgt_string.h"
+
+#include <windows.h>
+
+namespace tgt {
+
+  const std::string MappedFile::loggerCat_("MappedFile");
+
+  MappedFile::MappedFile()
+    : file_(0)
+    , mapping_(0)
+    , view_(0)
+    , data_(0)
+    , size_(0)
+  {}
+
+  MappedFile::~MappedFile() {
+    close();
+  }
+
+  void MappedFile::open(const std::string& fileName, uint64_t offset, size_t length)
+    throw (IOException)
+  {
+    close();
+
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+      throw IOException("Unable to open file for mapping", fileName);
+    file_ = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || (static_cast<uint64_t>(fileSize.QuadPart) < offset + length)) {
+      close();
+      throw IOException("File is smaller than the requested region", fileName);
+    }
+
+    // a copy-on-write mapping keeps the data writable without ever touching the file
+    mapping_ = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+    if (!mapping_) {
+      close();
+      throw IOException("Unable to create file mapping (error " + itos(GetLastError()) + ")", fileName);
+    }
+
+    // views have to start at a multiple of the allocation granularity
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    uint64_t viewOffset = offset - (offset % systemInfo.dwAllocationGranularity);
+    size_t delta = static_cast<size_t>(offset - viewOffset);
+
+    view_ = MapViewOfFile(mapping_, FILE_MAP_COPY,
+      static_cast<DWORD>(viewOffset >> 32), static_cast<DWORD>(viewOffset & 0xffffffff), length + delta);
+    if (!view_) {
+      close();
+      throw IOException("Unable to map view of file (error " + itos(GetLastError()) + ")", fileName);
+    }
+
+    data_ = static_cast<char*>(view_) + delta;
+    size_ = length;
+  }
+
+  void MappedFile::close() {
+    if (view_)
+      UnmapViewOfFile(view_);
+    if (mapping_)
+      CloseHandle(mapping_);
+    if (file_)
+      CloseHandle(file_);
+
+    file_ = 0;
+    mapping_ = 0;
+    view_ = 0;
+    data_ = 0;
+    size_ = 0;
+  }
+
+  bool MappedFile::isOpen() const {
+    return view_ != 0;
+  }
+
+  void* MappedFile::getData() const {
+    return data_;
+  }
+
+  size_t MappedFile::getSize() const {
+    return size_;
+  }
+
+} // end namespace tgt
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "exception.h"
+#include "config.h"
+
+#include <string>
+#include <stdint.h>
+
+namespace tgt {
+
+  /**
+  * Copy-on-write memory mapping of a file region.
+  *
+  * Pages are read from the file when they are touched for the first time. Writing to the
+  * mapped memory creates private copies of the affected pages, the file itself is never modified.
+  */
+  class MappedFile {
+  public:
+    TGT_API MappedFile();
+
+    /// Unmaps the view and closes the file.
+    TGT_API ~MappedFile();
+
+    /**
+    * Maps \p length bytes of the file, starting at \p offset.
+    * The offset does not need to be aligned to the allocation granularity.
+    *
+    * @throw IOException if the file could not be opened or is smaller than offset + length
+    */
+    TGT_API void open(const std::string& fileName, uint64_t offset, size_t length)
+      throw (IOException);
+
+    TGT_API void close();
+
+    TGT_API bool isOpen() const;
+
+    /// Returns a pointer to the first mapped byte at the requested offset.
+    TGT_API void* getData() const;
+
+    /// Returns the number of bytes requested in open().
+    TGT_API size_t getSize() const;
+
+  private:
+    // not copyable
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    void* file_;      ///< file handle
+    void* mapping_;   ///< file mapping object
+    void* view_;      ///< start of the mapped view, aligned to the allocation granularity
+    char* data_;      ///< start of the requested region inside the view
+    size_t size_;     ///< size of the requested region
+
+    static const std::string loggerCat_;
+  };
+
+} // end namespace tgt
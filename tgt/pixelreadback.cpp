@@ -0,0 +1,160 @@
+#include "pixelreadback.h"
+#include "texture.h"
+#include "logmanager.h"
+
+#include <cstring>
+
+namespace tgt {
+
+  const std::string PixelReadback::loggerCat_("PixelReadback");
+
+  PixelReadback::PixelReadback()
+    : next_(0)
+    , numPending_(0)
+  {
+    for (int i = 0; i < NUM_BUFFERS; ++i) {
+      slots_[i].pbo_ = 0;
+      slots_[i].fence_ = 0;
+      slots_[i].capacity_ = 0;
+      slots_[i].numBytes_ = 0;
+    }
+  }
+
+  PixelReadback::~PixelReadback() {
+    if (slots_[0].pbo_) {
+      LERROR("~PixelReadback(): not deinitialized before destruction");
+    }
+  }
+
+  void PixelReadback::initialize() {
+    if (slots_[0].pbo_)
+      return;
+
+    for (int i = 0; i < NUM_BUFFERS; ++i)
+      glGenBuffers(1, &slots_[i].pbo_);
+    LGL_ERROR;
+  }
+
+  void PixelReadback::deinitialize() {
+    discard();
+    for (int i = 0; i < NUM_BUFFERS; ++i) {
+      glDeleteBuffers(1, &slots_[i].pbo_);
+      slots_[i].pbo_ = 0;
+      slots_[i].capacity_ = 0;
+    }
+  }
+
+  void PixelReadback::startDownload(const Texture* texture) {
+    assert(texture && slots_[0].pbo_);
+
+    // all buffers in use: the oldest download is not going to be read anymore
+    if (numPending_ == NUM_BUFFERS) {
+      Slot& oldest = slots_[getFirstPending()];
+      waitFor(oldest);
+      release(oldest);
+      --numPending_;
+    }
+
+    Slot& slot = slots_[next_];
+    slot.numBytes_ = static_cast<size_t>(texture->getWidth()) * texture->getHeight() * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo_);
+    if (slot.capacity_ != slot.numBytes_) {
+      glBufferData(GL_PIXEL_PACK_BUFFER, slot.numBytes_, 0, GL_STREAM_READ);
+      slot.capacity_ = slot.numBytes_;
+    }
+
+    // with a pack buffer bound, the pixels are written to offset 0 of the buffer without waiting
+    texture->bind();
+    glGetTexImage(texture->getType(), 0, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // make sure the fence reaches the GPU, otherwise waiting for it may never return
+    glFlush();
+    LGL_ERROR;
+
+    next_ = (next_ + 1) % NUM_BUFFERS;
+    ++numPending_;
+  }
+
+  int PixelReadback::readPixels(uint8_t* buffer, size_t numBytesAllocated, bool waitForNewest) {
+    if (numPending_ == 0)
+      return -1;
+
+    // find the newest completed download
+    int newest = -1;
+    if (waitForNewest) {
+      newest = numPending_ - 1;
+      waitFor(slots_[(getFirstPending() + newest) % NUM_BUFFERS]);
+    }
+    else {
+      for (int i = 0; i < numPending_; ++i) {
+        int index = (getFirstPending() + i) % NUM_BUFFERS;
+        GLenum state = glClientWaitSync(slots_[index].fence_, 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+          break;
+        newest = i;
+      }
+    }
+
+    if (newest < 0) {
+      newest = 0;
+      waitFor(slots_[getFirstPending()]);
+    }
+
+    const int latency = numPending_ - 1 - newest;
+    Slot& slot = slots_[(getFirstPending() + newest) % NUM_BUFFERS];
+
+    if (numBytesAllocated < slot.numBytes_) {
+      LWARNING("readPixels: allocated buffer is too small");
+    }
+    else {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo_);
+      const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.numBytes_, GL_MAP_READ_BIT);
+      if (pixels) {
+        memcpy(buffer, pixels, slot.numBytes_);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+      else {
+        LERROR("readPixels: failed to map the pixel buffer");
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      LGL_ERROR;
+    }
+
+    // the older downloads are superseded
+    for (int i = 0; i <= newest; ++i)
+      release(slots_[(getFirstPending() + i) % NUM_BUFFERS]);
+    numPending_ -= newest + 1;
+
+    return latency;
+  }
+
+  int PixelReadback::getNumPending() const {
+    return numPending_;
+  }
+
+  void PixelReadback::discard() {
+    for (int i = 0; i < NUM_BUFFERS; ++i)
+      release(slots_[i]);
+    numPending_ = 0;
+  }
+
+  int PixelReadback::getFirstPending() const {
+    return (next_ - numPending_ + NUM_BUFFERS) % NUM_BUFFERS;
+  }
+
+  void PixelReadback::waitFor(Slot& slot) {
+    if (slot.fence_)
+      glClientWaitSync(slot.fence_, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  }
+
+  void PixelReadback::release(Slot& slot) {
+    if (slot.fence_) {
+      glDeleteSync(slot.fence_);
+      slot.fence_ = 0;
+    }
+  }
+
+} // end namespace tgt
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "tgt_gl.h"
+#include "tgt_math.h"
+
+#include <string>
+#include <stdint.h>
+
+namespace tgt {
+
+  class Texture;
+
+  /**
+  * Downloads a texture asynchronously through a ring of pixel pack buffers.
+  *
+  * startDownload() only queues the copy of the texture into the next buffer followed by a fence,
+  * so the GPU transfers the pixels while the application goes on with the next frame. readPixels()
+  * returns the newest download whose fence has signaled and only blocks if none has completed yet.
+  * The pixels are BGRA bytes, bottom row first, as returned by RenderTarget::readColorBuffer().
+  */
+  class PixelReadback {
+  public:
+    /// Number of buffers, i.e. downloads that may be pending at the same time.
+    static const int NUM_BUFFERS = 3;
+
+    TGT_API PixelReadback();
+
+    TGT_API ~PixelReadback();
+
+    /// Creates the buffers, requires OpenGL 3.2 or GL_ARB_sync and GL_ARB_pixel_buffer_object.
+    TGT_API void initialize();
+
+    TGT_API void deinitialize();
+
+    /**
+    * Queues the download of level 0 of the 2D \p texture. If all buffers are pending, the oldest
+    * download is waited for and dropped.
+    */
+    TGT_API void startDownload(const Texture* texture);
+
+    /**
+    * Copies the newest completed download into \p buffer and releases it along with all older ones.
+    * If no download has completed yet, waits for the oldest pending one, or for the newest one if
+    * \p waitForNewest is set, e.g. for the last frame of an interaction. Returns the number of downloads
+    * started after the copied one, i.e. its latency in frames, or -1 if no download was pending.
+    */
+    TGT_API int readPixels(uint8_t* buffer, size_t numBytesAllocated, bool waitForNewest = false);
+
+    /// Number of downloads started but not read yet.
+    TGT_API int getNumPending() const;
+
+    /// Drops all pending downloads, e.g. after the texture was resized.
+    TGT_API void discard();
+
+  private:
+    struct Slot {
+      GLuint pbo_;
+      GLsync fence_;
+      size_t capacity_;   ///< bytes allocated for the buffer
+      size_t numBytes_;   ///< bytes of the pending download
+    };
+
+    /// Index of the oldest pending download.
+    int getFirstPending() const;
+
+    /// Waits for the fence of \p slot without a timeout.
+    void waitFor(Slot& slot);
+
+    /// Deletes the fence of \p slot and marks it as free.
+    void release(Slot& slot);
+
+    // not copyable
+    PixelReadback(const PixelReadback&);
+    PixelReadback& operator=(const PixelReadback&);
+
+    Slot slots_[NUM_BUFFERS];
+    int next_;          ///< slot of the next download
+    int numPending_;
+
+    static const std::string loggerCat_;
+  };
+
+} // end namespace tgt
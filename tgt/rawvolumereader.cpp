@@ -2,7 +2,14 @@
 #include "logmanager.h"
 #include "volume.h"
 #include "volumeatomic.h"
+#include "volumebricked.h"
 #include "volumegl.h"
+#include "volumekernels.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
 
 #pragma warning(disable:4996)
 
@@ -24,8 +31,50 @@ namespace tgt {
     sliceOrder_("+z")
   {}
 
+  /*
+  * Creates the volume for voxel type T, either heap allocated or backed by a mapping of the file region at offset.
+  * Volumes larger than a non-zero brickBudget are bricked, their bricks are read from the file on demand.
+  */
+  template<class T>
+  VolumeRepresentation* createRawVolume(const glm::ivec3& dimensions, const std::string& fileName, uint64_t offset,
+    bool mapped, size_t brickBudget)
+  {
+    if (brickBudget > 0 && static_cast<uint64_t>(dimensions.x) * dimensions.y * dimensions.z * sizeof(T) > brickBudget)
+      return new VolumeBrickedAtomic<T>(fileName, offset, dimensions, VolumeBricked::DEFAULT_BRICK_SIZE, brickBudget);
+
+    if (!mapped)
+      return new VolumeAtomic<T>(dimensions);
+
+    MappedFile* mapping = new MappedFile();
+    try {
+      mapping->open(fileName, offset, glm::hmul(dimensions) * sizeof(T));
+    }
+    catch (...) {
+      delete mapping;
+      throw;
+    }
+    return new VolumeAtomic<T>(mapping, dimensions);
+  }
+
+  /*
+  * Copies numVoxels voxels of one row, mirroring them if reverse is set,
+  * and converts each voxel from big endian to little endian byte order if swap is set
+  */
+  void placeRow(unsigned char* dst, const unsigned char* src, size_t numVoxels, size_t bytesPerVoxel, bool reverse, bool swap) {
+    if (reverse)
+      VolumeKernels::reverseCopy(dst, src, numVoxels, bytesPerVoxel);
+    else
+      memcpy(dst, src, numVoxels * bytesPerVoxel);
+
+    if (swap)
+      VolumeKernels::swapBytes(dst, numVoxels, bytesPerVoxel);
+  }
+
   RawVolumeReader::RawVolumeReader()
     : VolumeReader()
+    , memoryMapping_(false)
+    , brickCache_(false)
+    , brickCacheBytes_(DEFAULT_BRICK_CACHE_BYTES)
   {
     protocols_.push_back("raw");
   }
@@ -41,6 +90,23 @@ namespace tgt {
     hints_ = hints;
   }
 
+  void RawVolumeReader::setMemoryMapping(bool enable) {
+    memoryMapping_ = enable;
+  }
+
+  bool RawVolumeReader::getMemoryMapping() const {
+    return memoryMapping_;
+  }
+
+  void RawVolumeReader::setBrickCache(bool enable, size_t memoryBudget) {
+    brickCache_ = enable;
+    brickCacheBytes_ = memoryBudget;
+  }
+
+  bool RawVolumeReader::getBrickCache() const {
+    return brickCache_;
+  }
+
   Volume* RawVolumeReader::read(const std::string& fileName)
     throw (IOException, CorruptedFileException, std::bad_alloc)
   {
@@ -54,103 +120,110 @@ namespace tgt {
 
     std::string info = "Loading raw file " + fileName + " ";
 
-    FILE* fin;
-    fin = fopen(fileName.c_str(), "rb");
+    // byte swapping and slice reordering touch every voxel and need a private copy anyway
+    bool mapped = memoryMapping_ && !h.bigEndianByteOrder_ && (h.sliceOrder_.empty() || h.sliceOrder_[0] != '-');
+    if (memoryMapping_ && !mapped)
+      LINFO("Data set needs byte swapping or slice reordering, reading it into memory instead of mapping");
 
-    if (fin == 0)
-      throw IOException("Unable to open raw file for reading", fileName);
+    FILE* fin = 0;
+    if (!mapped) {
+      fin = fopen(fileName.c_str(), "rb");
+
+      if (fin == 0)
+        throw IOException("Unable to open raw file for reading", fileName);
+    }
 
-    VolumeRAM* volumeRAM;
+    size_t brickBudget = brickCache_ ? brickCacheBytes_ : 0;
+    VolumeRepresentation* representation;
 
     if (h.format_ == "UCHAR") {
       LINFO(info << "(8 bit dataset)");
-      VolumeRAM_UInt8* v = new VolumeRAM_UInt8(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<uint8_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "CHAR") {
       LINFO(info << "(8 bit signed dataset)");
-      VolumeRAM_Int8* v = new VolumeRAM_Int8(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<int8_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "USHORT" || h.format_ == "USHORT_12") {
       LINFO(info << "(16 bit dataset)");
-      VolumeRAM_UInt16* v = new VolumeRAM_UInt16(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<uint16_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "SHORT") {
       LINFO(info << "(16 bit signed dataset)");
-      VolumeRAM_Int16* v = new VolumeRAM_Int16(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<int16_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "UINT") {
       LINFO(info << "(32 bit dataset)");
-      VolumeRAM_UInt32* v = new VolumeRAM_UInt32(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<uint32_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "INT") {
       LINFO(info << "(32 bit signed dataset)");
-      VolumeRAM_Int32* v = new VolumeRAM_Int32(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<int32_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "UINT64") {
       LINFO(info << "(64 bit dataset)");
-      VolumeRAM_UInt64* v = new VolumeRAM_UInt64(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<uint64_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "INT64") {
       LINFO(info << "(64 bit signed dataset)");
-      VolumeRAM_Int64* v = new VolumeRAM_Int64(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<int64_t>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "FLOAT") {
       LINFO(info << "(32 bit float dataset)");
-      VolumeRAM_Float* v = new VolumeRAM_Float(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<float>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else if (h.format_ == "DOUBLE") {
       LINFO(info << "(64 bit double dataset)");
-      VolumeRAM_Double* v = new VolumeRAM_Double(h.dimensions_);
-      volumeRAM = v;
+      representation = createRawVolume<double>(h.dimensions_, fileName, h.headerskip_, mapped, brickBudget);
     }
     else {
-      fclose(fin);
+      if (fin)
+        fclose(fin);
       throw CorruptedFileException("Format '" + h.format_ + "' not supported", fileName);
     }
 
-    // now add that to the headerskip we might have received
-    uint64_t offset = h.headerskip_;
+    bool reverseX = (h.sliceOrder_ == "-x");
+    bool reverseY = (h.sliceOrder_ == "-y");
+    bool reverseZ = (h.sliceOrder_ == "-z");
+
+    VolumeRAM* volumeRAM = dynamic_cast<VolumeRAM*>(representation);
+    if (!volumeRAM) {
+      // bricks are read on demand, reordering and byte swapping are applied to each brick
+      LINFO("Volume exceeds the brick cache budget of " << brickBudget / (1024 * 1024) << " MB, reading bricks on demand");
+      static_cast<VolumeBricked*>(representation)->setReadTransform(reverseX, reverseY, reverseZ, h.bigEndianByteOrder_);
+      if (fin)
+        fclose(fin);
+    }
+    else if (!mapped) {
+      // now add that to the headerskip we might have received
+      uint64_t offset = h.headerskip_;
 
 #ifdef _MSC_VER
-    _fseeki64(fin, offset, SEEK_SET);
+      _fseeki64(fin, offset, SEEK_SET);
 #else
-    fseek(fin, offset, SEEK_SET);
+      fseek(fin, offset, SEEK_SET);
 #endif
 
-    volumeRAM->clear();
-
-    VolumeReader::read(volumeRAM, fin);
-
-    fclose(fin);
+      if (reverseX)
+        LINFO("slice order is -x, reversing order to +x...\n");
+      else if (reverseY)
+        LINFO("slice order is -y, reversing order to +y...\n");
+      else if (reverseZ)
+        LINFO("slice order is -z, reversing order to +z...\n");
 
-    if (h.sliceOrder_ == "-x") {
-      LINFO("slice order is -x, reversing order to +x...\n");
-      reverseXSliceOrder(volumeRAM);
-    }
-    else if (h.sliceOrder_ == "-y") {
-      LINFO("slice order is -y, reversing order to +y...\n");
-      reverseYSliceOrder(volumeRAM);
-    }
-    else if (h.sliceOrder_ == "-z") {
-      LINFO("slice order is -z, reversing order to +z...\n");
-      reverseZSliceOrder(volumeRAM);
-    }
+      if (reverseX || reverseY || reverseZ || h.bigEndianByteOrder_) {
+        readStreamed(volumeRAM, fin, reverseX, reverseY, reverseZ, h.bigEndianByteOrder_);
+      }
+      else {
+        volumeRAM->clear();
+        VolumeReader::read(volumeRAM, fin);
+      }
 
-    if (h.bigEndianByteOrder_) {
-      volumeRAM->swapEndianness();
+      fclose(fin);
     }
 
     glm::vec3 offs(0.0f);
-    Volume* volumeHandle = new Volume(volumeRAM, h.spacing_, offs);
+    Volume* volumeHandle = new Volume(representation, h.spacing_, offs);
     volumeHandle->setOrigin(fileName);
     volumeHandle->setPhysicalToWorldMatrix(h.transformation_);
     volumeHandle->setRescaleIntercept(h.rescaleIntercept_);
@@ -165,4 +238,71 @@ namespace tgt {
     return volumeHandle;
   }
 
+  void RawVolumeReader::readStreamed(VolumeRAM* volume, FILE* fin,
+    bool reverseX, bool reverseY, bool reverseZ, bool swap) const
+  {
+    const glm::ivec3 dim = volume->getDimensions();
+    const size_t bytesPerVoxel = volume->getBytesPerVoxel();
+    const size_t rowBytes = dim.x * bytesPerVoxel;
+    const size_t sliceBytes = rowBytes * dim.y;
+    const int slabSlices = std::max(1, std::min(dim.z, static_cast<int>(STREAMING_SLAB_BYTES / sliceBytes)));
+    const int numSlabs = (dim.z + slabSlices - 1) / slabSlices;
+    const int numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    unsigned char* data = static_cast<unsigned char*>(volume->getData());
+
+    // slab n is read into buffer n % 2 while the other one is being placed
+    std::vector<unsigned char> buffers[2];
+    buffers[0].resize(slabSlices * sliceBytes);
+    buffers[1].resize(numSlabs > 1 ? slabSlices * sliceBytes : 0);
+
+    auto readSlab = [&](int slab) -> bool {
+      int numSlices = std::min(slabSlices, dim.z - slab * slabSlices);
+      size_t numBytes = numSlices * sliceBytes;
+      unsigned char* buffer = &buffers[slab % 2][0];
+      size_t bytesRead = fread(buffer, 1, numBytes, fin);
+      if (bytesRead < numBytes) {
+        // missing data is zero, as in VolumeReader::read()
+        memset(buffer + bytesRead, 0, numBytes - bytesRead);
+        return false;
+      }
+      return true;
+    };
+
+    // every row of the slab is copied to its final position, the rows are split among the workers
+    auto placeRows = [&](int slab, size_t firstRow, size_t endRow) {
+      const unsigned char* buffer = &buffers[slab % 2][0];
+      for (size_t row = firstRow; row < endRow; ++row) {
+        int z = slab * slabSlices + static_cast<int>(row / dim.y);
+        int y = static_cast<int>(row % dim.y);
+        size_t dstZ = reverseZ ? dim.z - 1 - z : z;
+        size_t dstY = reverseY ? dim.y - 1 - y : y;
+        placeRow(data + (dstZ * dim.y + dstY) * rowBytes, buffer + row * rowBytes, dim.x, bytesPerVoxel, reverseX, swap);
+      }
+    };
+
+    bool complete = readSlab(0);
+    for (int slab = 0; slab < numSlabs; ++slab) {
+      std::future<bool> nextRead;
+      if (complete && slab + 1 < numSlabs)
+        nextRead = std::async(std::launch::async, readSlab, slab + 1);
+      else if (slab + 1 < numSlabs)
+        memset(&buffers[(slab + 1) % 2][0], 0, buffers[(slab + 1) % 2].size());
+
+      size_t numRows = static_cast<size_t>(std::min(slabSlices, dim.z - slab * slabSlices)) * dim.y;
+      size_t rowsPerThread = (numRows + numThreads - 1) / numThreads;
+      std::vector<std::thread> workers;
+      for (size_t first = rowsPerThread; first < numRows; first += rowsPerThread)
+        workers.push_back(std::thread(placeRows, slab, first, std::min(numRows, first + rowsPerThread)));
+      placeRows(slab, 0, std::min(numRows, rowsPerThread));
+      for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+      if (nextRead.valid() && !nextRead.get())
+        complete = false;
+    }
+
+    if (!complete)
+      LWARNING("fread() failed, file is smaller than the volume");
+  }
+
 } // end namespace tgt
\ No newline at end of file
@@ -71,11 +71,40 @@ namespace tgt {
     */
     TGT_API void setReadHints(const ReadHints& hints);
 
+    /**
+    * If enabled, the voxel data is not read but backed by a copy-on-write memory mapping of the file,
+    * so only the pages that are actually accessed are loaded. Data sets that need byte swapping or
+    * slice reordering are still read into memory, since these would touch every page anyway.
+    */
+    TGT_API void setMemoryMapping(bool enable);
+    TGT_API bool getMemoryMapping() const;
+
+    /**
+    * If enabled, volumes larger than memoryBudget are not read at once but returned as VolumeBricked,
+    * which loads bricks on demand and keeps at most memoryBudget bytes of them in memory.
+    * Smaller volumes are read as before. Takes precedence over the memory mapping.
+    */
+    TGT_API void setBrickCache(bool enable, size_t memoryBudget = DEFAULT_BRICK_CACHE_BYTES);
+    TGT_API bool getBrickCache() const;
+
     TGT_API virtual Volume* read(const std::string& fileName)
       throw (IOException, CorruptedFileException, std::bad_alloc);
 
   private:
+    /**
+    * Reads the voxel data in slabs of whole slices. While the next slab is read from disk,
+    * the current one is byte swapped and copied to its final, reordered position by worker threads,
+    * so no additional passes over the whole volume are needed.
+    */
+    void readStreamed(VolumeRAM* volume, FILE* fin, bool reverseX, bool reverseY, bool reverseZ, bool swap) const;
+
+    static const size_t STREAMING_SLAB_BYTES = 32 * 1024 * 1024;  ///< approximate size of one slab
+    static const size_t DEFAULT_BRICK_CACHE_BYTES = 1024 * 1024 * 1024;
+
     ReadHints hints_;
+    bool memoryMapping_;  ///< back the volume by a file mapping instead of reading it
+    bool brickCache_;     ///< return large volumes as VolumeBricked
+    size_t brickCacheBytes_;
 
     static const std::string loggerCat_;
   };
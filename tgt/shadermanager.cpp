@@ -3,6 +3,8 @@
 #include "logmanager.h"
 #include "gpucapabilities.h"
 
+#include <fstream>
+
 using std::string;
 using glm::vec2;
 using glm::vec3;
@@ -17,6 +19,35 @@ using glm::mat4;
 // anonymous namespace
 namespace {
 
+  const uint32_t PROGRAM_BINARY_MAGIC = 0x4e494250; // "PBIN"
+  const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+  template<typename T>
+  void writeValue(std::ostream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  bool readValue(std::istream& stream, T& value) {
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return stream.good();
+  }
+
+  /// FNV-1a hash of \p size bytes at \p data, continuing \p hash.
+  uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  template<typename T>
+  uint64_t hashValue(const T& value, uint64_t hash) {
+    return hashBytes(&value, sizeof(T), hash);
+  }
+
   /**
   * Resolve the line number to take into account the include directives.
   * Returns a string containing file name and line number in that file.
@@ -321,9 +352,7 @@ namespace tgt {
     glProgramParameteriEXT(id, GL_GEOMETRY_VERTICES_OUT_EXT, verticesOut_);
   }
 
-  bool ShaderObject::compileShader() {
-    isCompiled_ = false;
-
+  void ShaderObject::preprocess() {
     ShaderPreprocessor p(this);
     source_ = p.getResult();
 
@@ -335,7 +364,15 @@ namespace tgt {
       if (p.getGeomShaderVerticesOut())
         verticesOut_ = p.getGeomShaderVerticesOut();
     }
+  }
 
+  bool ShaderObject::compileShader() {
+    preprocess();
+    return compileSource();
+  }
+
+  bool ShaderObject::compileSource() {
+    isCompiled_ = false;
     uploadSource();
 
     glCompileShader(id_);
@@ -409,10 +446,15 @@ namespace tgt {
   Shader::Shader()
     : isLinked_(false)
     , ignoreError_(false)
+    , sourceHash_(0)
   {
     id_ = glCreateProgram();
     if (id_ == 0)
       LERROR("Shader(): glCreateProgram() returned 0");
+
+    // the binary can only be retrieved if the hint is set before linking
+    if (Singleton<ShaderManager>::isInited() && ShdrMgr.areProgramBinariesSupported())
+      glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   }
 
   Shader::~Shader() {
@@ -486,6 +528,7 @@ namespace tgt {
     }
 
     isLinked_ = false;
+    clearLocationCache();
     glLinkProgram(id_);
     GLint check = 0;
     glGetProgramiv(id_, GL_LINK_STATUS, &check);
@@ -515,11 +558,14 @@ namespace tgt {
 
   bool Shader::rebuild() {
     if (isLinked_) {
+      // variants built before, e.g. with another header, are restored without compiling
+      if (restoreProgram())
+        return true;
+
       // program is already linked: detach and re-attach everything
       for (ShaderObjects::iterator iter = objects_.begin(); iter != objects_.end(); ++iter) {
         glDetachShader(id_, (*iter)->id_);
-        (*iter)->uploadSource();
-        if (!(*iter)->compileShader()) {
+        if (!(*iter)->compileSource()) {
           LERROR("Failed to compile shader object.");
           LERROR("Compiler Log: \n" << (*iter)->getCompilerLog());
           return false;
@@ -528,13 +574,19 @@ namespace tgt {
         glAttachShader(id_, (*iter)->id_);
       }
     }
+    else {
+      // the objects were compiled elsewhere, their sources are unknown
+      sourceHash_ = 0;
+    }
     isLinked_ = false;
+    clearLocationCache();
     glLinkProgram(id_);
     GLint check = 0;
     glGetProgramiv(id_, GL_LINK_STATUS, &check);
 
     if (check) {
       isLinked_ = true;
+      storeProgram();
       return true;
     }
     else {
@@ -602,15 +654,6 @@ namespace tgt {
         delete vert;
         throw Exception("Failed to load vertex shader " + vert_filename + ": " + e.what());
       }
-
-      vert->uploadSource();
-
-      if (!vert->compileShader()) {
-        LERROR("Failed to compile vertex shader " << vert_filename);
-        LERROR("Compiler Log: \n" << vert->getCompilerLog());
-        delete vert;
-        throw Exception("Failed to compile vertex shader: " + vert_filename);
-      }
     }
 
     if (!geom_filename.empty()) {
@@ -629,15 +672,6 @@ namespace tgt {
         delete geom;
         throw Exception("Failed to load geometry shader " + geom_filename + ": " + e.what());
       }
-
-      geom->uploadSource();
-      if (!geom->compileShader()) {
-        LERROR("Failed to compile geometry shader " << geom_filename);
-        LERROR("Compiler Log: \n" << geom->getCompilerLog());
-        delete vert;
-        delete geom;
-        throw Exception("Failed to compile geometry shader: " + geom_filename);
-      }
     }
 
     if (!frag_filename.empty()) {
@@ -660,17 +694,6 @@ namespace tgt {
 
       if (GpuCaps.getShaderVersion() >= GpuCapabilities::GlVersion::SHADER_VERSION_130)
         bindFragDataLocation(0, "FragData0");
-
-      frag->uploadSource();
-
-      if (!frag->compileShader()) {
-        LERROR("Failed to compile fragment shader " << frag_filename);
-        LERROR("Compiler Log: \n" << frag->getCompilerLog());
-        delete vert;
-        delete geom;
-        delete frag;
-        throw Exception("Failed to compile fragment shader: " + frag_filename);
-      }
     }
 
     // Attach ShaderObjects, dtor will take care of freeing them
@@ -681,6 +704,29 @@ namespace tgt {
     if (geom)
       attachObject(geom);
 
+    if (restoreProgram()) {
+      LDEBUG("Restored program (" << vert_filename << "," << frag_filename << "," << geom_filename << ")");
+      return;
+    }
+
+    if (vert && !vert->compileSource()) {
+      LERROR("Failed to compile vertex shader " << vert_filename);
+      LERROR("Compiler Log: \n" << vert->getCompilerLog());
+      throw Exception("Failed to compile vertex shader: " + vert_filename);
+    }
+
+    if (geom && !geom->compileSource()) {
+      LERROR("Failed to compile geometry shader " << geom_filename);
+      LERROR("Compiler Log: \n" << geom->getCompilerLog());
+      throw Exception("Failed to compile geometry shader: " + geom_filename);
+    }
+
+    if (frag && !frag->compileSource()) {
+      LERROR("Failed to compile fragment shader " << frag_filename);
+      LERROR("Compiler Log: \n" << frag->getCompilerLog());
+      throw Exception("Failed to compile fragment shader: " + frag_filename);
+    }
+
     if (!linkProgram()) {
       LERROR("Failed to link shader (" << vert_filename << "," << frag_filename << "," << geom_filename << ")");
       if (vert) {
@@ -703,6 +749,8 @@ namespace tgt {
       throw Exception("Failed to link shader (" + vert_filename + "," + frag_filename + "," + geom_filename + ")");
     }
 
+    storeProgram();
+
 
     if (vert && vert->getCompilerLog().size() > 1) {
       LDEBUG("Vertex shader compiler log for file '" << vert_filename
@@ -739,21 +787,23 @@ namespace tgt {
         delete comp;
         throw Exception("Failed to load compute shader " + filename + ": " + e.what());
       }
-
-      comp->uploadSource();
-
-      if (!comp->compileShader()) {
-        LERROR("Failed to compile compute shader " << filename);
-        LERROR("Compiler Log: \n" << comp->getCompilerLog());
-        delete comp;
-        throw Exception("Failed to compile compute shader: " + filename);
-      }
     }
 
     // Attach ShaderObjects, dtor will take care of freeing them
     if (comp)
       attachObject(comp);
 
+    if (restoreProgram()) {
+      LDEBUG("Restored program (" << filename << ")");
+      return;
+    }
+
+    if (comp && !comp->compileSource()) {
+      LERROR("Failed to compile compute shader " << filename);
+      LERROR("Compiler Log: \n" << comp->getCompilerLog());
+      throw Exception("Failed to compile compute shader: " + filename);
+    }
+
     if (!linkProgram()) {
       LERROR("Failed to link shader (" << filename << ")");
       if (comp) {
@@ -766,6 +816,8 @@ namespace tgt {
       throw Exception("Failed to link shader (" + filename + ")");
     }
 
+    storeProgram();
+
 
     if (comp && comp->getCompilerLog().size() > 1) {
       LDEBUG("Compute shader compiler log for file '" << filename
@@ -779,12 +831,66 @@ namespace tgt {
 
   GLint Shader::getUniformLocation(const string& name) {
     GLint l;
-    l = glGetUniformLocation(id_, name.c_str());
+    std::map<std::string, GLint>::const_iterator it = uniformLocations_.find(name);
+    if (it != uniformLocations_.end())
+      l = it->second;
+    else {
+      l = glGetUniformLocation(id_, name.c_str());
+      uniformLocations_[name] = l;
+    }
     if (l == -1 && !ignoreError_)
       LWARNING("Failed to locate uniform Location: " << name);
     return l;
   }
 
+  GLuint Shader::getUniformBlockIndex(const string& name) {
+    GLuint index;
+    std::map<std::string, GLuint>::const_iterator it = uniformBlockIndices_.find(name);
+    if (it != uniformBlockIndices_.end())
+      index = it->second;
+    else {
+      index = glGetUniformBlockIndex(id_, name.c_str());
+      uniformBlockIndices_[name] = index;
+    }
+    if (index == GL_INVALID_INDEX && !ignoreError_)
+      LWARNING("Failed to locate uniform block: " << name);
+    return index;
+  }
+
+  void Shader::clearLocationCache() {
+    uniformLocations_.clear();
+    uniformBlockIndices_.clear();
+  }
+
+  bool Shader::restoreProgram() {
+    uint64_t hash = hashBytes(0, 0);
+    for (ShaderObjects::iterator iter = objects_.begin(); iter != objects_.end(); ++iter) {
+      ShaderObject* obj = *iter;
+      obj->preprocess();
+      hash = hashValue(obj->shaderType_, hash);
+      hash = hashValue(obj->source_.size(), hash);
+      hash = hashBytes(obj->source_.data(), obj->source_.size(), hash);
+      if (obj->shaderType_ == ShaderObject::GEOMETRY_SHADER) {
+        hash = hashValue(obj->inputType_, hash);
+        hash = hashValue(obj->outputType_, hash);
+        hash = hashValue(obj->verticesOut_, hash);
+      }
+    }
+    sourceHash_ = hash;
+
+    if (!Singleton<ShaderManager>::isInited() || !ShdrMgr.loadProgramBinary(id_, sourceHash_))
+      return false;
+
+    isLinked_ = true;
+    clearLocationCache();
+    return true;
+  }
+
+  void Shader::storeProgram() {
+    if (sourceHash_ != 0 && Singleton<ShaderManager>::isInited())
+      ShdrMgr.storeProgramBinary(id_, sourceHash_);
+  }
+
   void Shader::setIgnoreUniformLocationError(bool ignoreError) {
     ignoreError_ = ignoreError;
   }
@@ -1249,7 +1355,14 @@ namespace tgt {
 
   ShaderManager::ShaderManager()
     : ResourceManager<Shader>(false)
+    , programBinariesSupported_(false)
   {
+    GLint numFormats = 0;
+    if (GpuCaps.isExtensionSupported("GL_ARB_get_program_binary"))
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    programBinariesSupported_ = (numFormats > 0);
+
+    driver_ = GpuCaps.getGlVendorString() + "#" + GpuCaps.getGlRendererString() + "#" + GpuCaps.getGlVersionString();
   }
 
   ShaderManager::~ShaderManager() {
@@ -1377,4 +1490,115 @@ namespace tgt {
     return result;
   }
 
+  void ShaderManager::setProgramCacheDir(const std::string& dir) {
+    programCacheDir_ = dir;
+  }
+
+  const std::string& ShaderManager::getProgramCacheDir() const {
+    return programCacheDir_;
+  }
+
+  bool ShaderManager::areProgramBinariesSupported() const {
+    return programBinariesSupported_;
+  }
+
+  uint64_t ShaderManager::getProgramKey(uint64_t sourceHash) const {
+    return hashValue(sourceHash, hashBytes(driver_.data(), driver_.size()));
+  }
+
+  std::string ShaderManager::getProgramBinaryFileName(uint64_t key) const {
+    std::ostringstream name;
+    name << std::hex << key << ".bin";
+    return FileSystem::cleanupPath(programCacheDir_ + "/" + name.str());
+  }
+
+  bool ShaderManager::loadProgramBinary(GLuint program, uint64_t sourceHash) {
+    if (!programBinariesSupported_)
+      return false;
+
+    const uint64_t key = getProgramKey(sourceHash);
+    std::map<uint64_t, ProgramBinary>::iterator it = programBinaries_.find(key);
+
+    if (it == programBinaries_.end() && !programCacheDir_.empty()) {
+      std::string fileName = getProgramBinaryFileName(key);
+      std::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+      if (stream.is_open()) {
+        uint32_t magic = 0, version = 0, format = 0, size = 0;
+        uint64_t fileKey = 0;
+        if (!readValue(stream, magic) || !readValue(stream, version) || (magic != PROGRAM_BINARY_MAGIC)
+          || (version != PROGRAM_BINARY_VERSION) || !readValue(stream, fileKey) || (fileKey != key)
+          || !readValue(stream, format) || !readValue(stream, size) || (size == 0) || (size > (64u << 20))) {
+          LWARNING("Ignoring outdated or foreign program binary " << fileName);
+        }
+        else {
+          ProgramBinary binary;
+          binary.format_ = format;
+          binary.data_.resize(size);
+          stream.read(&binary.data_[0], size);
+          if (stream.gcount() == static_cast<std::streamsize>(size))
+            it = programBinaries_.insert(std::make_pair(key, binary)).first;
+          else
+            LWARNING("Truncated program binary " << fileName);
+        }
+      }
+    }
+
+    if (it == programBinaries_.end())
+      return false;
+
+    const ProgramBinary& binary = it->second;
+    glProgramBinary(program, binary.format_, &binary.data_[0], static_cast<GLsizei>(binary.data_.size()));
+    GLint check = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &check);
+    if (!check) {
+      // e.g. after a driver update that kept the version string
+      LDEBUG("Driver rejected program binary " << std::hex << key);
+      programBinaries_.erase(it);
+      return false;
+    }
+
+    return true;
+  }
+
+  void ShaderManager::storeProgramBinary(GLuint program, uint64_t sourceHash) {
+    if (!programBinariesSupported_)
+      return;
+
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0)
+      return;
+
+    const uint64_t key = getProgramKey(sourceHash);
+    ProgramBinary& binary = programBinaries_[key];
+    binary.data_.resize(size);
+    GLsizei length = 0;
+    glGetProgramBinary(program, size, &length, &binary.format_, &binary.data_[0]);
+    if (length <= 0) {
+      programBinaries_.erase(key);
+      return;
+    }
+    binary.data_.resize(length);
+
+    if (programCacheDir_.empty())
+      return;
+
+    if (!FileSystem::dirExists(programCacheDir_))
+      FileSystem::createDirectoryRecursive(programCacheDir_);
+
+    std::string fileName = getProgramBinaryFileName(key);
+    std::ofstream stream(fileName.c_str(), std::ios::trunc | std::ios::binary);
+    if (!stream.is_open()) {
+      LWARNING("Could not write program binary " << fileName);
+      return;
+    }
+
+    writeValue(stream, PROGRAM_BINARY_MAGIC);
+    writeValue(stream, PROGRAM_BINARY_VERSION);
+    writeValue(stream, key);
+    writeValue(stream, static_cast<uint32_t>(binary.format_));
+    writeValue(stream, static_cast<uint32_t>(binary.data_.size()));
+    stream.write(&binary.data_[0], binary.data_.size());
+  }
+
 } // end namespace tgt
\ No newline at end of file
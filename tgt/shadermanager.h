@@ -8,6 +8,8 @@
 #include <vector>
 #include <sstream>
 #include <list>
+#include <map>
+#include <stdint.h>
 
 namespace tgt {
 
@@ -130,6 +132,12 @@ namespace tgt {
   protected:
     void uploadSource();
 
+    /// Runs the ShaderPreprocessor on header and source, sets source_ and the geometry shader directives.
+    void preprocess();
+
+    /// Uploads and compiles the preprocessed source, see compileShader().
+    bool compileSource();
+
     std::string filename_;
     ShaderType shaderType_;
 
@@ -221,10 +229,17 @@ namespace tgt {
     //
 
     /**
-    * Returns uniform location, or -1 on failure
+    * Returns uniform location, or -1 on failure.
+    * Locations are looked up once per name and cached until the program is linked again.
     */
     TGT_API GLint getUniformLocation(const std::string& name);
 
+    /**
+    * Returns the index of the uniform block \p name, or GL_INVALID_INDEX on failure.
+    * Cached like the uniform locations.
+    */
+    TGT_API GLuint getUniformBlockIndex(const std::string& name);
+
     TGT_API void setIgnoreUniformLocationError(bool ignoreError);
     TGT_API bool getIgnoreUniformLocationError();
 
@@ -356,12 +371,29 @@ namespace tgt {
     void loadCompute(const std::string& filename)
       throw (Exception);
 
+    /// Forgets the cached uniform locations and block indices, which are invalid after linking.
+    void clearLocationCache();
+
+    /**
+    * Preprocesses the attached objects and restores the program from the binary cached by the
+    * ShaderManager for their sources, without compiling them. Returns false if there is no such
+    * binary, the objects have to be compiled and linked then, followed by storeProgram().
+    */
+    bool restoreProgram();
+
+    /// Passes the binary of the linked program to the ShaderManager, see restoreProgram().
+    void storeProgram();
+
     typedef std::list<ShaderObject*> ShaderObjects;
     ShaderObjects objects_;
 
     GLuint id_;
     bool isLinked_;
     bool ignoreError_;
+    uint64_t sourceHash_;   ///< hash of the preprocessed sources, set by restoreProgram()
+
+    std::map<std::string, GLint> uniformLocations_;     ///< see getUniformLocation()
+    std::map<std::string, GLuint> uniformBlockIndices_; ///< see getUniformBlockIndex()
 
     static const std::string loggerCat_;
   };
@@ -504,7 +536,43 @@ namespace tgt {
     TGT_API Shader* loadCompute(const std::string& filename, bool activate = true)
       throw (Exception);
 
+    /**
+    * Sets the directory in which the binaries of linked programs are stored, so that later runs restore
+    * them instead of compiling the shaders again. Empty keeps the binaries in memory only, which still
+    * avoids recompiling variants that were built before, e.g. when switching back to a rendering mode.
+    */
+    TGT_API void setProgramCacheDir(const std::string& dir);
+    TGT_API const std::string& getProgramCacheDir() const;
+
+    /// Returns whether the driver can retrieve and restore the binaries of linked programs.
+    TGT_API bool areProgramBinariesSupported() const;
+
+    /**
+    * Restores \p program from the binary cached for the preprocessed sources with hash \p sourceHash
+    * and the current driver, looking into memory first and then into the cache directory.
+    * Returns false if no binary is cached or the driver rejects it.
+    */
+    TGT_API bool loadProgramBinary(GLuint program, uint64_t sourceHash);
+
+    /// Caches the binary of the linked \p program in memory and in the cache directory.
+    TGT_API void storeProgramBinary(GLuint program, uint64_t sourceHash);
+
   protected:
+    struct ProgramBinary {
+      GLenum format_;
+      std::vector<char> data_;
+    };
+
+    /// Combines \p sourceHash with the driver, binaries are only valid for the driver that created them.
+    uint64_t getProgramKey(uint64_t sourceHash) const;
+
+    std::string getProgramBinaryFileName(uint64_t key) const;
+
+    std::map<uint64_t, ProgramBinary> programBinaries_;   ///< binaries of the programs linked so far, by key
+    std::string programCacheDir_;
+    std::string driver_;                ///< vendor, renderer and version of the driver
+    bool programBinariesSupported_;
+
     static const std::string loggerCat_;
   };
 
@@ -2,6 +2,9 @@
 #include "logmanager.h"
 #include "gpucapabilities.h"
 
+#include <cstring>
+#include <vector>
+
 namespace tgt {
 
   const std::string Texture::loggerCat_ = "Texture";
@@ -337,6 +340,32 @@ namespace tgt {
     }
   }
 
+  size_t Texture::uploadTextureRegion(const GLubyte* data, const glm::ivec3& dataDimensions,
+    const glm::ivec3& offset, const glm::ivec3& size, const glm::ivec3& textureOffset)
+  {
+    assert(type_ == GL_TEXTURE_3D);
+    if (glm::any(glm::lessThanEqual(size, glm::ivec3(0))))
+      return 0;
+
+    bind();
+
+    // rows and slices of the box are strided by the dimensions of the whole buffer
+    GLint alignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, dataDimensions.x);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, dataDimensions.y);
+    size_t first = (static_cast<size_t>(offset.z) * dataDimensions.y + offset.y) * dataDimensions.x + offset.x;
+    glTexSubImage3D(GL_TEXTURE_3D, 0,
+      offset.x + textureOffset.x, offset.y + textureOffset.y, offset.z + textureOffset.z,
+      size.x, size.y, size.z, format_, dataType_, data + first * bpp_);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+    return static_cast<size_t>(size.x) * size.y * size.z * bpp_;
+  }
+
   void Texture::downloadTexture() const {
     bind();
 
@@ -390,6 +419,36 @@ namespace tgt {
     }
   }
 
+  size_t Texture::downloadTextureRegion(GLubyte* pixels, const glm::ivec3& offset, const glm::ivec3& size) const {
+    if (glm::any(glm::lessThanEqual(size, glm::ivec3(0))))
+      return 0;
+
+    bind();
+
+    const size_t numBytes = static_cast<size_t>(size.x) * size.y * size.z * bpp_;
+    GLint alignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    if (GpuCaps.isExtensionSupported("GL_ARB_get_texture_sub_image")) {
+      glGetTextureSubImage(id_, 0, offset.x, offset.y, offset.z, size.x, size.y, size.z,
+        format_, dataType_, static_cast<GLsizei>(numBytes), pixels);
+      glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+      return numBytes;
+    }
+
+    std::vector<GLubyte> texture(glm::hmul(dimensions_) * bpp_);
+    glGetTexImage(type_, 0, format_, dataType_, &texture[0]);
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    const size_t rowBytes = static_cast<size_t>(size.x) * bpp_;
+    for (int z = 0; z < size.z; ++z) {
+      for (int y = 0; y < size.y; ++y) {
+        size_t first = (static_cast<size_t>(offset.z + z) * dimensions_.y + offset.y + y) * dimensions_.x + offset.x;
+        memcpy(pixels + (static_cast<size_t>(z) * size.y + y) * rowBytes, &texture[first * bpp_], rowBytes);
+      }
+    }
+    return texture.size();
+  }
+
   bool Texture::isTextureRectangle() const {
 #ifdef GL_TEXTURE_RECTANGLE_ARB
     return (type_ == GL_TEXTURE_RECTANGLE_ARB);
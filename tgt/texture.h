@@ -244,6 +244,17 @@ namespace tgt {
     */
     TGT_API void uploadTexture();
 
+    /**
+    * Uploads the box [offset, offset + size) of a 3D buffer with the dimensions \p dataDimensions
+    * into the 3D texture at \p offset + \p textureOffset using glTexSubImage3D. Binds the texture.
+    *
+    * format_ and dataType_ have to match the buffer.
+    *
+    * @return the number of bytes uploaded
+    */
+    TGT_API size_t uploadTextureRegion(const GLubyte* data, const glm::ivec3& dataDimensions,
+      const glm::ivec3& offset, const glm::ivec3& size, const glm::ivec3& textureOffset = glm::ivec3(0));
+
     /**
     * Download Texture from graphics-card. Binds the texture.
     *
@@ -281,6 +292,15 @@ namespace tgt {
     */
     TGT_API void downloadTextureToBuffer(GLint format, GLenum dataType, GLubyte* pixels, size_t numBytesAllocated) const;
 
+    /**
+    * Downloads the box [offset, offset + size) of level 0 into \p pixels, whose rows and slices are
+    * stored consecutively. Uses glGetTextureSubImage if available, otherwise the whole texture is
+    * downloaded and the box copied out of it. Binds the texture.
+    *
+    * @return the number of bytes transferred from the GPU
+    */
+    TGT_API size_t downloadTextureRegion(GLubyte* pixels, const glm::ivec3& offset, const glm::ivec3& size) const;
+
     /**
     * Returns, wether texture is a texture rectangle (GL_TEXTURE_RECTANGLE_ARB)
     */
@@ -9,13 +9,16 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
 
 namespace tgt {
 
   const std::string TransFunc1D::loggerCat_("TransFunc1D");
 
   TransFunc1D::TransFunc1D(int width)
-    : TransFunc(width, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Texture::NEAREST)
+    : TransFunc(width, 1, 1, GL_RGBA, GL_FLOAT, Texture::NEAREST)
     , dataDomain_(0.f, 255.f)
     , windowingDomain_(0.f, 255.f)
   {
@@ -149,18 +152,106 @@ namespace tgt {
     return alpha;
   }
 
+  void TransFunc1D::evaluate(glm::vec4* lut, int numEntries) const {
+    int numThreads = 1;
+    if (numEntries >= PARALLEL_THRESHOLD)
+      numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    // one contiguous range per thread, each sweeps the keys on its own
+    int chunkSize = (numEntries + numThreads - 1) / numThreads;
+    std::vector<std::thread> workers;
+    for (int i = 1; i < numThreads; ++i) {
+      int begin = std::min(numEntries, i * chunkSize);
+      int end = std::min(numEntries, begin + chunkSize);
+      workers.push_back(std::thread(&TransFunc1D::evaluateRange, this, lut, numEntries, begin, end));
+    }
+    evaluateRange(lut, numEntries, 0, std::min(numEntries, chunkSize));
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+  }
+
+  void TransFunc1D::evaluateRange(glm::vec4* lut, int numEntries, int begin, int end) const {
+    // first keys with an intensity not below the value, as found by the scans of the single value mappings
+    size_t colorKey = 0;
+    size_t alphaKey = 0;
+    float previous = -std::numeric_limits<float>::infinity();
+
+    for (int x = begin; x < end; ++x) {
+      float value = (float)x / (numEntries - 1) * (windowingDomain_.y - windowingDomain_.x) + windowingDomain_.x;
+      if (value < windowingDomain_.x || value > windowingDomain_.y) {
+        lut[x] = glm::vec4(0.f);
+        continue;
+      }
+
+      //use gamma correction
+      if (gammaValue_ != 1.f) {
+        value = powf(value, gammaValue_);
+      }
+
+      // the values only increase, unless gamma correction of negative intensities is involved
+      if (!(value >= previous)) {
+        colorKey = 0;
+        alphaKey = 0;
+      }
+      previous = value;
+
+      while (colorKey < colorKeys_.size() && value > colorKeys_[colorKey]->getIntensity())
+        ++colorKey;
+      while (alphaKey < alphaKeys_.size() && value > alphaKeys_[alphaKey]->getIntensity())
+        ++alphaKey;
+
+      glm::vec4 result(0.f);
+      if (!colorKeys_.empty()) {
+        glm::vec3 color;
+        if (colorKey == 0)
+          color = glm::vec3(colorKeys_.front()->getColor());
+        else if (colorKey == colorKeys_.size())
+          color = glm::vec3(colorKeys_.back()->getColor());
+        else {
+          TransFuncColorKey* leftKey = colorKeys_[colorKey - 1];
+          TransFuncColorKey* rightKey = colorKeys_[colorKey];
+          float fraction = (value - leftKey->getIntensity()) / (rightKey->getIntensity() - leftKey->getIntensity());
+          glm::vec3 leftDest(leftKey->getColor());
+          glm::vec3 rightDest(rightKey->getColor());
+          color = leftDest + (rightDest - leftDest) * fraction;
+        }
+        result = glm::vec4(color / 255.f, 0.f);
+      }
+
+      if (!alphaKeys_.empty()) {
+        if (alphaKey == 0)
+          result.a = alphaKeys_.front()->getAlpha();
+        else if (alphaKey == alphaKeys_.size())
+          result.a = alphaKeys_.back()->getAlpha();
+        else {
+          TransFuncAlphaKey* leftKey = alphaKeys_[alphaKey - 1];
+          TransFuncAlphaKey* rightKey = alphaKeys_[alphaKey];
+          float fraction = (value - leftKey->getIntensity()) / (rightKey->getIntensity() - leftKey->getIntensity());
+          float leftDest = leftKey->getAlpha();
+          float rightDest = rightKey->getAlpha();
+          result.a = leftDest + (rightDest - leftDest) * fraction;
+        }
+      }
+
+      lut[x] = result;
+    }
+  }
+
+  void TransFunc1D::createTex() {
+    DELPTR(tex_);
+
+    tex_ = new Texture(dimensions_, GL_RGBA, GL_RGBA32F, GL_FLOAT, filter_);
+    tex_->setWrapping(Texture::CLAMP_TO_BORDER);
+    LGL_ERROR;
+  }
+
   void TransFunc1D::updateTexture() {
 
     if (!tex_ || (tex_->getDimensions() != dimensions_))
       createTex();
     assert(tex_);
 
-    for (int x = 0; x < dimensions_.x; ++ x) {
-      float value = (float)x / (dimensions_.x - 1) * (windowingDomain_.y - windowingDomain_.x) + windowingDomain_.x;
-      glm::col3 color = getMappingForColorValue(value);
-      float alpha = getMappingForAlphaValue(value);
-      tex_->texel<glm::col4>(x) = glm::col4(color, static_cast<uint8_t>(alpha * 255.f));
-    }
+    evaluate(reinterpret_cast<glm::vec4*>(tex_->getPixelData()), dimensions_.x);
 
     tex_->uploadTexture();
     LGL_ERROR;
@@ -337,6 +428,35 @@ namespace tgt {
     return alphaKeys_.empty() || colorKeys_.empty();
   }
 
+  uint64_t TransFunc1D::getContentHash() const {
+    // 64 bit FNV-1a over the values of the mapping
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](const void* data, size_t size) {
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    };
+
+    add(&windowingDomain_, sizeof(windowingDomain_));
+    add(&gammaValue_, sizeof(gammaValue_));
+    size_t numKeys = colorKeys_.size();
+    add(&numKeys, sizeof(numKeys));
+    for (size_t i = 0; i < colorKeys_.size(); ++i) {
+      float intensity = colorKeys_[i]->getIntensity();
+      add(&intensity, sizeof(intensity));
+      add(&colorKeys_[i]->getColor(), sizeof(glm::col3));
+    }
+    numKeys = alphaKeys_.size();
+    add(&numKeys, sizeof(numKeys));
+    for (size_t i = 0; i < alphaKeys_.size(); ++i) {
+      float intensity = alphaKeys_[i]->getIntensity();
+      float alpha = alphaKeys_[i]->getAlpha();
+      add(&intensity, sizeof(intensity));
+      add(&alpha, sizeof(alpha));
+    }
+    return hash;
+  }
+
   bool TransFunc1D::save(const std::string& filename) const {
     //look for fileExtension
     std::string fileExtension;
@@ -3,6 +3,7 @@
 #include "transfunc.h"
 
 #include <vector>
+#include <stdint.h>
 
 namespace tgt {
 
@@ -13,16 +14,22 @@ namespace tgt {
   /**
   * One dimensional, piece-wise linear transfer function based on key values.
   *
-  * Internally, it is represented by a one-dimensional RGBA texture of type GL_UNSIGNED_BYTE.
+  * Internally, it is represented by a one-dimensional RGBA texture of type GL_FLOAT, filled by evaluate().
   */
   class TransFunc1D : public TransFunc {
   public:
+    /// Default texture width, fine enough for windows of 12 bit CT data.
+    static const int DEFAULT_WIDTH = 4096;
+
+    /// Tables with at least this number of entries are evaluated by several threads.
+    static const int PARALLEL_THRESHOLD = 1 << 16;
+
     /**
     * Constructor
     *
     * @param width desired width of the transfer function
     */
-    TGT_API TransFunc1D(int width = 256);
+    TGT_API TransFunc1D(int width = DEFAULT_WIDTH);
 
     /**
     * Destructor - deletes the keys of the transfer function
@@ -64,6 +71,15 @@ namespace tgt {
 
     TGT_API float getMappingForAlphaValue(float value) const;
 
+    /**
+    * Evaluates the mapping at \p numEntries intensities evenly spaced over the windowing domain, entry x at
+    * x / (numEntries - 1) of the domain, into RGBA values in [0, 1]. The alpha values equal
+    * getMappingForAlphaValue(), the colors are interpolated in floating point instead of bytes.
+    *
+    * The keys are swept once along with the entries instead of being searched for every entry.
+    */
+    TGT_API void evaluate(glm::vec4* lut, int numEntries) const;
+
     /**
     * Returns the number of keys in this transfer function.
     *
@@ -147,6 +163,13 @@ namespace tgt {
     */
     TGT_API bool isEmpty() const;
 
+    /**
+    * Returns a hash of everything the mapping depends on: the keys, the windowing domain and the
+    * gamma value. Transfer functions with equal mappings have equal hashes, e.g. to cache tables
+    * derived from the mapping across transfer function objects.
+    */
+    TGT_API uint64_t getContentHash() const;
+
     TGT_API  virtual int getNumDimensions() const { return 1; }
 
     TGT_API virtual glm::vec2 getDataDomain(int dimension = 0) const;
@@ -166,7 +189,14 @@ namespace tgt {
     TGT_API virtual void serialize(XmlSerializer& s) const;
     TGT_API virtual void deserialize(XmlDeserializer& s);
 
+  protected:
+    /// Creates a floating point texture.
+    virtual void createTex();
+
   private:
+    /// Evaluates the entries [begin, end) of a table with \p numEntries entries, see evaluate().
+    void evaluateRange(glm::vec4* lut, int numEntries, int begin, int end) const;
+
     /**
     * Saves transfer function to a XML file. The extension of the file is xml.
     *
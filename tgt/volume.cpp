@@ -1,15 +1,119 @@
 #include "volume.h"
 #include "volumeram.h"
+#include "volumebricked.h"
+#include "volumemask.h"
 #include "logmanager.h"
 #include "volumepreview.h"
 #include "volumegl.h"
 #include "volumeminmax.h"
 #include "volumehistogram.h"
+#include "volumebrickminmax.h"
+#include "volumepyramid.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
 
 namespace tgt {
 
+  /**
+  * Background computation of one derived data item. It is run by whoever claims it first,
+  * a worker of the pool or a thread asking for the data before a worker got to it.
+  */
+  class DerivedDataTask {
+  public:
+    DerivedDataTask(const std::function<void()>& compute)
+      : compute_(compute)
+      , claimed_(false)
+      , done_(promise_.get_future().share())
+    {}
+
+    /// Runs the computation unless it has been claimed already.
+    void run() {
+      if (claimed_.exchange(true))
+        return;
+      try {
+        compute_();
+      }
+      catch (...) {
+      }
+      promise_.set_value();
+    }
+
+    /// Drops the computation unless it has been claimed already.
+    void cancel() {
+      if (!claimed_.exchange(true))
+        promise_.set_value();
+    }
+
+    void wait() const {
+      done_.wait();
+    }
+
+    bool isDone() const {
+      return done_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+  private:
+    std::function<void()> compute_;
+    std::atomic<bool> claimed_;
+    std::promise<void> promise_;
+    std::shared_future<void> done_;
+  };
+
+  // anonymous namespace
+  namespace {
+
+    /**
+    * Workers shared by all volumes. The derived data computations are parallel themselves,
+    * so a few workers suffice. Workers are started on demand and end when the queue is empty.
+    */
+    class DerivedDataPool {
+    public:
+      static const int MAX_WORKERS = 2;
+
+      DerivedDataPool() : numWorkers_(0) {}
+
+      void submit(const std::shared_ptr<DerivedDataTask>& task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(task);
+        if (numWorkers_ < MAX_WORKERS) {
+          ++numWorkers_;
+          std::thread(&DerivedDataPool::work, this).detach();
+        }
+      }
+
+    private:
+      void work() {
+        for (;;) {
+          std::shared_ptr<DerivedDataTask> task;
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) {
+              --numWorkers_;
+              return;
+            }
+            task = queue_.front();
+            queue_.pop_front();
+          }
+          task->run();
+        }
+      }
+
+      std::mutex mutex_;
+      std::deque<std::shared_ptr<DerivedDataTask> > queue_;
+      int numWorkers_;
+    };
+
+    // never deleted, detached workers may still leave it while the process exits
+    DerivedDataPool* derivedDataPool = new DerivedDataPool();
+
+  } // namespace anonymous
+
   Volume::Volume()
-    : spacing_(0), offset_(0), origin_("")
+    : spacing_(0), offset_(0), origin_(""), ready_(false), syncedBytes_(0)
   {}
 
   Volume::Volume(VolumeRepresentation* const volume, 
@@ -30,11 +134,14 @@ namespace tgt {
     , windowCenter_(windowCenter)
     , windowWidth_(windowWidth)
     , ready_(false)
+    , syncedBytes_(0)
   {
     addRepresentationInternal(volume);
   }
 
   Volume::~Volume() {
+    // background computations still access the volume
+    cancelPendingDerivedData();
     clearRepresentation();
     clearDerivedData();
   }
@@ -72,6 +179,11 @@ namespace tgt {
   }
 
   std::string Volume::getFormat() {
+    // volumes that do not fit into memory are only available as bricks
+    VolumeBricked* volumeBricked = hasRepresentation<VolumeBricked>();
+    if (volumeBricked && !hasRepresentation<VolumeRAM>())
+      return volumeBricked->getFormat();
+
     VolumeRAM* volumeRam = getRepresentation<VolumeRAM>();
     assert(volumeRam);
 
@@ -247,7 +359,11 @@ namespace tgt {
     VolumeRepresentation* result = 0;
     // now we only have one Representation data created auto, that's VolumeGL.
     if (typeid(T) == typeid(VolumeGL)) {
-      result = new VolumeGL(getRepresentation<VolumeRAM>());
+      VolumeMask* volumeMask = hasRepresentation<VolumeMask>();
+      if (volumeMask)
+        result = new VolumeGL(volumeMask);
+      else
+        result = new VolumeGL(getRepresentation<VolumeRAM>());
     }
     else if (typeid(T) == typeid(VolumeRAM)) {
       LERRORC("Volume", "VolumeRAM data should read first");
@@ -263,6 +379,7 @@ namespace tgt {
   template<class T>
   T* Volume::hasRepresentation() const
   {
+    std::lock_guard<std::recursive_mutex> lock(representationMutex_);
     for (std::vector<VolumeRepresentation*>::const_iterator it = representations_.begin(); 
       it != representations_.end(); ++it) {
       if (dynamic_cast<T*>(*it)) {
@@ -280,6 +397,7 @@ namespace tgt {
       throw std::invalid_argument("passed data item is not of type VolumeRepresentation");
     }
 
+    std::lock_guard<std::recursive_mutex> lock(representationMutex_);
     if (hasRepresentation<T>())
       removeRepresentationInternal<T>();
 
@@ -289,6 +407,7 @@ namespace tgt {
   template<class T>
   void Volume::removeRepresentationInternal()
   {
+    std::lock_guard<std::recursive_mutex> lock(representationMutex_);
     if (!hasRepresentation<T>())
       return;
 
@@ -304,6 +423,7 @@ namespace tgt {
 
   void Volume::clearRepresentation()
   {
+      std::lock_guard<std::recursive_mutex> lock(representationMutex_);
       while (!representations_.empty()) {
         delete representations_.back();
         representations_.pop_back();
@@ -314,23 +434,30 @@ namespace tgt {
 
   template <class T>
   T* Volume::getDerivedData() {
-    T* test = hasDerivedData<T>();
+    T* test = waitDerivedData<T>();
     if (test)
       return test;
 
     // if not have, create a new one.
+    return createDerivedDataInternal<T>();
+  }
+
+  template<class T>
+  T* Volume::createDerivedDataInternal() {
     T dummy;
     VolumeDerivedData* result = 0;
     result = dummy.createFrom(this);
 
+    // another thread may have been faster
     if (result)
-      addDerivedDataInternal<T>(dynamic_cast<T*>(result));
+      addMissingDerivedDataInternal<T>(dynamic_cast<T*>(result));
 
     return hasDerivedData<T>();
   }
 
   template<class T>
   T* Volume::hasDerivedData() const {
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
     for (std::vector<VolumeDerivedData*>::const_iterator it = derivedData_.begin(); it != derivedData_.end(); ++it) {
       if (typeid(**it) == typeid(T)) {
         T* tmp = dynamic_cast<T*>(*it);
@@ -340,6 +467,52 @@ namespace tgt {
     return 0;
   }
 
+  template<class T>
+  void Volume::computeDerivedDataAsync() {
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+    if (hasDerivedData<T>() || isDerivedDataPending<T>())
+      return;
+
+    // the data may have come out of the sweep of another item in the meantime
+    std::shared_ptr<DerivedDataTask> task(new DerivedDataTask([this]() {
+      if (!hasDerivedData<T>())
+        createDerivedDataInternal<T>();
+    }));
+    pendingDerivedData_[std::type_index(typeid(T))] = task;
+    derivedDataPool->submit(task);
+  }
+
+  template<class T>
+  bool Volume::isDerivedDataPending() const {
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+    std::map<std::type_index, std::shared_ptr<DerivedDataTask> >::const_iterator it = pendingDerivedData_.find(std::type_index(typeid(T)));
+    if (it == pendingDerivedData_.end())
+      return false;
+    return !it->second->isDone();
+  }
+
+  template<class T>
+  T* Volume::waitDerivedData() {
+    std::shared_ptr<DerivedDataTask> pending;
+    {
+      std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+      T* test = hasDerivedData<T>();
+      if (test)
+        return test;
+
+      std::map<std::type_index, std::shared_ptr<DerivedDataTask> >::const_iterator it = pendingDerivedData_.find(std::type_index(typeid(T)));
+      if (it == pendingDerivedData_.end())
+        return 0;
+      pending = it->second;
+    }
+
+    // the lock must not be held here, the computation adds its result under the lock.
+    // A computation still queued is run right here instead of waiting for a free worker.
+    pending->run();
+    pending->wait();
+    return hasDerivedData<T>();
+  }
+
   template<class T>
   void Volume::addDerivedDataInternal(T* data) {
     if (!dynamic_cast<VolumeDerivedData*>(data)) {
@@ -347,6 +520,7 @@ namespace tgt {
       throw std::invalid_argument("passed data item is not of type VolumeDerivedData");
     }
 
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
     if (hasDerivedData<T>())
       removeDerivedDataInternal<T>();
 
@@ -354,8 +528,21 @@ namespace tgt {
 
   }
 
+  template<class T>
+  bool Volume::addMissingDerivedDataInternal(T* data) {
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+    if (hasDerivedData<T>()) {
+      delete data;
+      return false;
+    }
+
+    addDerivedDataInternal<T>(data);
+    return true;
+  }
+
   template<class T>
   void Volume::removeDerivedDataInternal() {
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
     if (!hasDerivedData<T>())
       return;
 
@@ -369,15 +556,54 @@ namespace tgt {
   }
 
   void Volume::clearDerivedData() {
+    cancelPendingDerivedData();
+
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+    pendingDerivedData_.clear();
     while (!derivedData_.empty()) {
       delete derivedData_.back();
       derivedData_.pop_back();
     }
   }
 
+  void Volume::cancelPendingDerivedData() {
+    std::vector<std::shared_ptr<DerivedDataTask> > pending;
+    {
+      std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+      std::map<std::type_index, std::shared_ptr<DerivedDataTask> >::const_iterator it;
+      for (it = pendingDerivedData_.begin(); it != pendingDerivedData_.end(); ++it)
+        pending.push_back(it->second);
+    }
+
+    // queued computations are dropped, running ones are waited for
+    for (size_t i = 0; i < pending.size(); ++i) {
+      pending[i]->cancel();
+      pending[i]->wait();
+    }
+  }
+
   void Volume::SetReady(bool flag)
   {
     ready_ = flag;
+
+    if (!flag)
+      return;
+
+    // sweeping a mapped or bricked volume reads the whole file, its derived data is computed on first access
+    VolumeRAM* volumeRam = hasRepresentation<VolumeRAM>();
+    if (!volumeRam || volumeRam->isMemoryMapped())
+      return;
+
+    // queue the derived data the first frames need, so nobody stalls on first access.
+    // The histogram comes last, usually it has come out of the min/max sweep by then (see VolumeMinMax::createFrom)
+    std::lock_guard<std::recursive_mutex> lock(derivedDataMutex_);
+    computeDerivedDataAsync<VolumeMinMax>();
+    computeDerivedDataAsync<VolumePreview>();
+
+    // needed by the raycasters for empty space skipping
+    computeDerivedDataAsync<VolumeBrickMinMax>();
+
+    computeDerivedDataAsync<VolumeHistogramIntensity>();
   }
 
   bool Volume::IsReady()
@@ -385,15 +611,53 @@ namespace tgt {
     return ready_;
   }
 
-  void Volume::SyncData()
+  size_t Volume::SyncData()
   {
-    VolumeRAM* volumeRam = getRepresentation<VolumeRAM>();
-    assert(volumeRam);
     VolumeGL* volumeGl = getRepresentation<VolumeGL>();
     assert(volumeGl);
-    volumeGl->getTexture()->setPixelData(reinterpret_cast<GLubyte*>(volumeRam->getData()));
-    volumeGl->getTexture()->uploadTexture();
-    volumeGl->getTexture()->setPixelData(0);
+    VolumeTexture* texture = volumeGl->getTexture();
+    syncedBytes_ = 0;
+
+    // masks are uploaded as 32 voxels per texel, regions start at brick borders and thus at whole texels
+    VolumeMask* volumeMask = hasRepresentation<VolumeMask>();
+    if (volumeMask) {
+      std::vector<VolumeMask::Region> regions = volumeMask->takeDirtyRegions();
+      std::vector<uint32_t> words;
+      for (size_t i = 0; i < regions.size(); ++i) {
+        const VolumeMask::Region& region = regions[i];
+        volumeMask->pack(region.llf_, region.urb_, words);
+        const glm::ivec3 wordDims(VolumeMask::getNumWords(region.urb_.x - region.llf_.x),
+          region.urb_.y - region.llf_.y, region.urb_.z - region.llf_.z);
+        syncedBytes_ += texture->uploadTextureRegion(reinterpret_cast<const GLubyte*>(&words[0]), wordDims,
+          glm::ivec3(0), wordDims, glm::ivec3(region.llf_.x / VolumeMask::BRICK_SIZE, region.llf_.y, region.llf_.z));
+      }
+      LGL_ERROR;
+      return syncedBytes_;
+    }
+
+    VolumeRAM* volumeRam = getRepresentation<VolumeRAM>();
+    assert(volumeRam);
+
+    const GLubyte* data = reinterpret_cast<const GLubyte*>(volumeRam->getData());
+    const glm::ivec3 dims = volumeRam->getDimensions();
+    std::vector<VolumeRAM::Region> regions = volumeRam->takeDirtyRegions();
+
+    for (size_t i = 0; i < regions.size(); ++i) {
+      const VolumeRAM::Region& region = regions[i];
+      syncedBytes_ += texture->uploadTextureRegion(data, dims, region.llf_, region.urb_ - region.llf_);
+
+      // single slices are doubled in the texture, see VolumeGL::generateTexture()
+      if (texture->getDepth() > dims.z)
+        syncedBytes_ += texture->uploadTextureRegion(data, dims, region.llf_, region.urb_ - region.llf_, glm::ivec3(0, 0, 1));
+    }
+    LGL_ERROR;
+
+    return syncedBytes_;
+  }
+
+  size_t Volume::GetSyncedBytes() const
+  {
+    return syncedBytes_;
   }
 
   //------------------------------------------------------------------------------
@@ -5,12 +5,17 @@
 
 #include <vector>
 #include <set>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <typeindex>
 
 namespace tgt {
 
   class VolumeRepresentation;
   class VolumeDerivedData;
   class VolumeRAM;
+  class DerivedDataTask;
 
   class Volume {
   public:
@@ -80,16 +85,47 @@ namespace tgt {
     TGT_API glm::mat4 getPhysicalToTextureMatrix();
 
 
-    /// derived data
+    /**
+    * derived data
+    *
+    * Derived data is computed on first access. If a background computation of the
+    * requested type is running, getDerivedData() waits for it instead of starting another one,
+    * a computation still queued is run on the calling thread. All derived data functions are thread-safe.
+    */
     template <class T>
     T* getDerivedData();
 
+    /// Returns the derived data of type T if it is available, without blocking or computing it.
     template<class T>
     T* hasDerivedData() const;
 
+    /**
+    * Queues computing the derived data of type T on the workers shared by all volumes, unless it is
+    * available or pending already. SetReady() queues VolumeMinMax, VolumePreview, VolumeBrickMinMax
+    * and VolumeHistogramIntensity this way, except for memory mapped or bricked volumes.
+    */
+    template<class T>
+    void computeDerivedDataAsync();
+
+    /// Returns true while a background computation of T is running.
+    template<class T>
+    bool isDerivedDataPending() const;
+
+    /**
+    * Waits for a pending background computation of T.
+    *
+    * @return the derived data, or null if it is neither available nor pending
+    */
+    template<class T>
+    T* waitDerivedData();
+
     template<class T>
     void addDerivedDataInternal(T* data);
 
+    /// Adds the data item unless there is one of the same type already, in which case \p data is deleted.
+    template<class T>
+    bool addMissingDerivedDataInternal(T* data);
+
     template<class T>
     void removeDerivedDataInternal();
 
@@ -113,12 +149,35 @@ namespace tgt {
     TGT_API void SetReady(bool flag = true);
     TGT_API bool IsReady();
 
-    /// sync cpu data to gpu
-    TGT_API void SyncData();
+    /**
+    * Sync cpu data to gpu: uploads the regions of the VolumeRAM recorded by VolumeRAM::markDirty()
+    * into the VolumeGL texture and clears the record. Volumes holding a VolumeMask upload the
+    * modified bricks of the mask instead.
+    *
+    * @return the number of bytes uploaded
+    */
+    TGT_API size_t SyncData();
+
+    /// Number of bytes uploaded by the last call of SyncData().
+    TGT_API size_t GetSyncedBytes() const;
 
   private:
+    // not copyable
+    Volume(const Volume&);
+    Volume& operator=(const Volume&);
+
+    /// Computes the derived data in the calling thread and adds it.
+    template<class T>
+    T* createDerivedDataInternal();
+
+    /// Drops the queued background computations of derived data and waits for the running ones.
+    void cancelPendingDerivedData();
+
     std::vector<VolumeRepresentation*> representations_;
     std::vector<VolumeDerivedData*> derivedData_;
+    std::map<std::type_index, std::shared_ptr<DerivedDataTask> > pendingDerivedData_;  ///< background computations by derived data type
+    mutable std::recursive_mutex representationMutex_;
+    mutable std::recursive_mutex derivedDataMutex_;
     glm::vec3 spacing_;
     glm::vec3 offset_;
     glm::mat4 physical2world_;
@@ -130,22 +189,62 @@ namespace tgt {
     float windowWidth_;
 
     bool ready_;
+    size_t syncedBytes_;  ///< bytes uploaded by the last SyncData()
   };
 
   class VolumePreview;
   template TGT_API VolumePreview* Volume::getDerivedData<VolumePreview>();
+  template TGT_API VolumePreview* Volume::hasDerivedData<VolumePreview>() const;
+  template TGT_API void Volume::computeDerivedDataAsync<VolumePreview>();
+  template TGT_API bool Volume::isDerivedDataPending<VolumePreview>() const;
+  template TGT_API VolumePreview* Volume::waitDerivedData<VolumePreview>();
+  template TGT_API bool Volume::addMissingDerivedDataInternal<VolumePreview>(VolumePreview*);
 
   class VolumeMinMax;
   template TGT_API VolumeMinMax* Volume::getDerivedData<VolumeMinMax>();
+  template TGT_API VolumeMinMax* Volume::hasDerivedData<VolumeMinMax>() const;
+  template TGT_API void Volume::computeDerivedDataAsync<VolumeMinMax>();
+  template TGT_API bool Volume::isDerivedDataPending<VolumeMinMax>() const;
+  template TGT_API VolumeMinMax* Volume::waitDerivedData<VolumeMinMax>();
+  template TGT_API bool Volume::addMissingDerivedDataInternal<VolumeMinMax>(VolumeMinMax*);
 
   class VolumeHistogramIntensity;
   template TGT_API VolumeHistogramIntensity* Volume::getDerivedData<VolumeHistogramIntensity>();
+  template TGT_API VolumeHistogramIntensity* Volume::hasDerivedData<VolumeHistogramIntensity>() const;
+  template TGT_API void Volume::computeDerivedDataAsync<VolumeHistogramIntensity>();
+  template TGT_API bool Volume::isDerivedDataPending<VolumeHistogramIntensity>() const;
+  template TGT_API VolumeHistogramIntensity* Volume::waitDerivedData<VolumeHistogramIntensity>();
+  template TGT_API bool Volume::addMissingDerivedDataInternal<VolumeHistogramIntensity>(VolumeHistogramIntensity*);
+
+  class VolumeBrickMinMax;
+  template TGT_API VolumeBrickMinMax* Volume::getDerivedData<VolumeBrickMinMax>();
+  template TGT_API VolumeBrickMinMax* Volume::hasDerivedData<VolumeBrickMinMax>() const;
+  template TGT_API void Volume::computeDerivedDataAsync<VolumeBrickMinMax>();
+  template TGT_API bool Volume::isDerivedDataPending<VolumeBrickMinMax>() const;
+  template TGT_API VolumeBrickMinMax* Volume::waitDerivedData<VolumeBrickMinMax>();
+  template TGT_API bool Volume::addMissingDerivedDataInternal<VolumeBrickMinMax>(VolumeBrickMinMax*);
+
+  class VolumePyramid;
+  template TGT_API VolumePyramid* Volume::getDerivedData<VolumePyramid>();
+  template TGT_API VolumePyramid* Volume::hasDerivedData<VolumePyramid>() const;
+  template TGT_API void Volume::computeDerivedDataAsync<VolumePyramid>();
+  template TGT_API bool Volume::isDerivedDataPending<VolumePyramid>() const;
+  template TGT_API VolumePyramid* Volume::waitDerivedData<VolumePyramid>();
+  template TGT_API bool Volume::addMissingDerivedDataInternal<VolumePyramid>(VolumePyramid*);
 
   class VolumeGL;
   template TGT_API VolumeGL* Volume::getRepresentation<VolumeGL>();
+  template TGT_API VolumeGL* Volume::hasRepresentation<VolumeGL>() const;
 
   class VolumeRAM;
   template TGT_API VolumeRAM* Volume::getRepresentation<VolumeRAM>();
+  template TGT_API VolumeRAM* Volume::hasRepresentation<VolumeRAM>() const;
+
+  class VolumeBricked;
+  template TGT_API VolumeBricked* Volume::hasRepresentation<VolumeBricked>() const;
+
+  class VolumeMask;
+  template TGT_API VolumeMask* Volume::hasRepresentation<VolumeMask>() const;
 
   //------------------------------------------------------------------------------
 
@@ -1,9 +1,14 @@
 #pragma once
 #include "volumeram.h"
 #include "volumeelement.h"
+#include "mappedfile.h"
+#include "volumekernels.h"
+#include "volumestatistics.h"
 #include "logmanager.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 #pragma warning(disable:4290)
 
@@ -33,9 +38,19 @@ namespace tgt {
     */
     VolumeAtomic(T* data, const glm::ivec3& dimensions);
 
-    /// Deletes the \a data_ array
+    /**
+    * While using this constructor the class will use the memory mapped file region given
+    * in \p mapping as voxel data, so only the pages actually touched are read from disk.
+    * The mapping will be deleted by this class.
+    */
+    VolumeAtomic(MappedFile* mapping, const glm::ivec3& dimensions);
+
+    /// Deletes the \a data_ array or releases the mapping
     virtual ~VolumeAtomic();
 
+    /// Returns true, if the voxel data is backed by a memory mapped file.
+    virtual bool isMemoryMapped() const;
+
     virtual std::string getFormat() const;
 
     virtual size_t getBitsAllocated() const;
@@ -72,6 +87,14 @@ namespace tgt {
     */
     T max() const;
 
+    virtual void computeHistogram(float min, float max, std::vector<uint64_t>& buckets) const;
+
+    virtual void computeMinMaxHistogram(std::vector<uint64_t>& buckets) const;
+
+    virtual void computeBrickMinMax(int brickSize, std::vector<float>& minValues, std::vector<float>& maxValues) const;
+
+    virtual VolumeRAM* createDownsampled() const;
+
     virtual void clear();
     virtual const void* getData() const;
     virtual void* getData();
@@ -86,13 +109,14 @@ namespace tgt {
 
   protected:
     // protected default constructor
-    VolumeAtomic() {}
+    VolumeAtomic() : mapping_(0) {}
 
     inline static size_t calcPos(const glm::ivec3& dimensions, size_t x, size_t y, size_t z);
 
     inline static size_t calcPos(const glm::ivec3& dimensions, const glm::ivec3& pos);
 
     T* data_;
+    MappedFile* mapping_;   ///< file mapping backing data_, 0 if data_ has been allocated with new[]
 
     glm::vec2 elementRange_;
 
@@ -110,6 +134,7 @@ namespace tgt {
     throw (std::bad_alloc)
     : VolumeRAM(dimensions)
     , data_(0)
+    , mapping_(0)
     , elementRange_(static_cast<float>(VolumeElement<T>::rangeMinElement()),
     static_cast<float>(VolumeElement<T>::rangeMaxElement()))
     , minMaxValid_(false)
@@ -130,15 +155,37 @@ namespace tgt {
     const glm::ivec3& dimensions)
     : VolumeRAM(dimensions)
     , data_(data)
+    , mapping_(0)
+    , elementRange_(static_cast<float>(VolumeElement<T>::rangeMinElement()),
+    static_cast<float>(VolumeElement<T>::rangeMaxElement()))
+    , minMaxValid_(false)
+  {
+  }
+
+  template<class T>
+  VolumeAtomic<T>::VolumeAtomic(MappedFile* mapping,
+    const glm::ivec3& dimensions)
+    : VolumeRAM(dimensions)
+    , data_(reinterpret_cast<T*>(mapping->getData()))
+    , mapping_(mapping)
     , elementRange_(static_cast<float>(VolumeElement<T>::rangeMinElement()),
     static_cast<float>(VolumeElement<T>::rangeMaxElement()))
     , minMaxValid_(false)
   {
+    assert(mapping->getSize() >= numVoxels_ * sizeof(T));
   }
 
   template<class T>
   VolumeAtomic<T>::~VolumeAtomic() {
-    delete[] data_;
+    if (mapping_)
+      delete mapping_;
+    else
+      delete[] data_;
+  }
+
+  template<class T>
+  bool VolumeAtomic<T>::isMemoryMapped() const {
+    return mapping_ != 0;
   }
 
   template<class T>
@@ -173,9 +220,7 @@ namespace tgt {
 
   template<class T>
   void VolumeAtomic<T>::swapEndianness() {
-    T* v = data_;
-    for (size_t i = 0; i < getNumVoxels(); ++i)
-      v[i] = VolumeElement<T>::swapEndianness(v[i]);
+    VolumeKernels::swapBytes(data_, getNumVoxels(), sizeof(T));
   }
 
   template<class T>
@@ -206,8 +251,7 @@ namespace tgt {
   template<class T>
   T VolumeAtomic<T>::min() const {
     if (!minMaxValid_) {
-      minValue_ = *std::min_element(data_, data_ + getNumVoxels());
-      maxValue_ = *std::max_element(data_, data_ + getNumVoxels());
+      VolumeStatistics::minMax(data_, getNumVoxels(), minValue_, maxValue_);
       minMaxValid_ = true;
     }
     return minValue_;
@@ -216,13 +260,62 @@ namespace tgt {
   template<class T>
   T VolumeAtomic<T>::max() const {
     if (!minMaxValid_) {
-      minValue_ = *std::min_element(data_, data_ + getNumVoxels());
-      maxValue_ = *std::max_element(data_, data_ + getNumVoxels());
+      VolumeStatistics::minMax(data_, getNumVoxels(), minValue_, maxValue_);
       minMaxValid_ = true;
     }
     return maxValue_;
   }
 
+  template<class T>
+  void VolumeAtomic<T>::computeHistogram(float min, float max, std::vector<uint64_t>& buckets) const {
+    VolumeStatistics::histogram(data_, getNumVoxels(), min, max, buckets);
+  }
+
+  template<class T>
+  void VolumeAtomic<T>::computeMinMaxHistogram(std::vector<uint64_t>& buckets) const {
+    VolumeStatistics::minMaxHistogram(data_, getNumVoxels(), minValue_, maxValue_, buckets);
+    minMaxValid_ = true;
+  }
+
+  template<class T>
+  void VolumeAtomic<T>::computeBrickMinMax(int brickSize, std::vector<float>& minValues, std::vector<float>& maxValues) const {
+    VolumeStatistics::brickMinMax(data_, dimensions_, brickSize, minValues, maxValues);
+  }
+
+  template<class T>
+  VolumeRAM* VolumeAtomic<T>::createDownsampled() const {
+    const glm::ivec3 dimensions = (dimensions_ + 1) / 2;
+    VolumeAtomic<T>* result = new VolumeAtomic<T>(dimensions);
+
+    // rows of the result are distributed over the threads
+    const size_t numRows = static_cast<size_t>(dimensions.y) * dimensions.z;
+    size_t numThreads = std::min(VolumeStatistics::getNumThreads(getNumVoxels()), numRows);
+    VolumeStatistics::forEachChunk(numRows, numThreads, [&](size_t begin, size_t end, size_t) {
+      for (size_t row = begin; row < end; ++row) {
+        size_t y = 2 * (row % dimensions.y);
+        size_t z = 2 * (row / dimensions.y);
+        size_t y1 = std::min(y + 1, static_cast<size_t>(dimensions_.y - 1));
+        size_t z1 = std::min(z + 1, static_cast<size_t>(dimensions_.z - 1));
+        const T* src[4] = {
+          data_ + calcPos(dimensions_, 0, y, z), data_ + calcPos(dimensions_, 0, y1, z),
+          data_ + calcPos(dimensions_, 0, y, z1), data_ + calcPos(dimensions_, 0, y1, z1)
+        };
+
+        T* dst = result->data_ + row * dimensions.x;
+        for (int x = 0; x < dimensions.x; ++x) {
+          int x0 = 2 * x;
+          int x1 = std::min(x0 + 1, dimensions_.x - 1);
+          double sum = 0.0;
+          for (int i = 0; i < 4; ++i)
+            sum += static_cast<double>(src[i][x0]) + static_cast<double>(src[i][x1]);
+          dst[x] = static_cast<T>(std::numeric_limits<T>::is_integer ? std::floor(sum / 8.0 + 0.5) : sum / 8.0);
+        }
+      }
+    });
+
+    return result;
+  }
+
   template<class T>
   void VolumeAtomic<T>::clear() {
     memset(data_, 0, getNumBytes());
@@ -0,0 +1,207 @@
+#include "volumebricked.h"
+#include "volumekernels.h"
+
+#include <string.h>
+
+#pragma warning(disable:4996)
+
+namespace tgt {
+
+  const std::string VolumeBricked::loggerCat_("VolumeBricked");
+
+  VolumeBricked::VolumeBricked(const std::string& fileName, uint64_t offset, const glm::ivec3& dimensions,
+    size_t bytesPerVoxel, int brickSize, size_t memoryBudget)
+    throw (IOException)
+    : VolumeRepresentation(dimensions)
+    , bytesPerVoxel_(bytesPerVoxel)
+    , brickSize_(brickSize)
+    , brickDimensions_(VolumeStatistics::getBrickDimensions(dimensions, brickSize))
+    , fileName_(fileName)
+    , offset_(offset)
+    , file_(0)
+    , reverseX_(false)
+    , reverseY_(false)
+    , reverseZ_(false)
+    , swapBytes_(false)
+    , memoryBudget_(memoryBudget)
+    , memoryUsage_(0)
+    , numBrickReads_(0)
+  {
+    assert(brickSize > 0);
+
+    file_ = fopen(fileName.c_str(), "rb");
+    if (!file_)
+      throw IOException("Unable to open raw file for reading", fileName);
+  }
+
+  VolumeBricked::~VolumeBricked() {
+    if (file_)
+      fclose(file_);
+  }
+
+  size_t VolumeBricked::getBytesPerVoxel() const {
+    return bytesPerVoxel_;
+  }
+
+  void VolumeBricked::setReadTransform(bool reverseX, bool reverseY, bool reverseZ, bool swapBytes) {
+    // the flags are read by readBrick() under fileMutex_, which is always locked before mutex_
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    reverseX_ = reverseX;
+    reverseY_ = reverseY;
+    reverseZ_ = reverseZ;
+    swapBytes_ = swapBytes && bytesPerVoxel_ > 1;
+
+    // cached bricks were read with the previous transformation
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+    lru_.clear();
+    memoryUsage_ = 0;
+  }
+
+  int VolumeBricked::getBrickSize() const {
+    return brickSize_;
+  }
+
+  glm::ivec3 VolumeBricked::getBrickDimensions() const {
+    return brickDimensions_;
+  }
+
+  size_t VolumeBricked::getNumBricks() const {
+    return static_cast<size_t>(brickDimensions_.x) * brickDimensions_.y * brickDimensions_.z;
+  }
+
+  size_t VolumeBricked::getBrickIndex(const glm::ivec3& pos) const {
+    glm::ivec3 brick = glm::clamp(pos / brickSize_, glm::ivec3(0), brickDimensions_ - 1);
+    return (static_cast<size_t>(brick.z) * brickDimensions_.y + brick.y) * brickDimensions_.x + brick.x;
+  }
+
+  glm::ivec3 VolumeBricked::getBrickOffset(size_t index) const {
+    glm::ivec3 brick(static_cast<int>(index % brickDimensions_.x),
+      static_cast<int>((index / brickDimensions_.x) % brickDimensions_.y),
+      static_cast<int>(index / (static_cast<size_t>(brickDimensions_.x) * brickDimensions_.y)));
+    return brick * brickSize_;
+  }
+
+  glm::ivec3 VolumeBricked::getBrickVoxels(size_t index) const {
+    glm::ivec3 first = getBrickOffset(index);
+    return glm::min(first + brickSize_, dimensions_ - 1) - first + 1;
+  }
+
+  glm::ivec3 VolumeBricked::getBrickOwnVoxels(size_t index) const {
+    // the last brick of an axis owns its last layer as well
+    glm::ivec3 first = getBrickOffset(index);
+    glm::ivec3 voxels = getBrickVoxels(index);
+    glm::ivec3 own;
+    for (int axis = 0; axis < 3; ++axis)
+      own[axis] = (first[axis] + brickSize_ < dimensions_[axis] - 1) ? brickSize_ : voxels[axis];
+    return own;
+  }
+
+  VolumeBricked::BrickData VolumeBricked::getBrickData(size_t index) const {
+    assert(index < getNumBricks());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::unordered_map<size_t, CacheEntry>::iterator it = cache_.find(index);
+      if (it != cache_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.position);
+        return it->second.data;
+      }
+    }
+
+    // other threads may use the cache while the brick is read
+    std::shared_ptr<std::vector<unsigned char> > data(new std::vector<unsigned char>());
+    readBrick(index, *data);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<size_t, CacheEntry>::iterator it = cache_.find(index);
+    if (it != cache_.end()) {
+      // read concurrently by another thread
+      lru_.splice(lru_.begin(), lru_, it->second.position);
+      return it->second.data;
+    }
+
+    lru_.push_front(index);
+    CacheEntry& entry = cache_[index];
+    entry.data = data;
+    entry.position = lru_.begin();
+    memoryUsage_ += data->size();
+    evict();
+    return data;
+  }
+
+  void VolumeBricked::readBrick(size_t index, std::vector<unsigned char>& data) const {
+    const glm::ivec3 first = getBrickOffset(index);
+    const glm::ivec3 voxels = getBrickVoxels(index);
+    const size_t rowBytes = voxels.x * bytesPerVoxel_;
+    data.resize(rowBytes * voxels.y * voxels.z);
+
+    bool complete = true;
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    std::vector<unsigned char> row(reverseX_ ? rowBytes : 0);
+    const int srcX = reverseX_ ? dimensions_.x - first.x - voxels.x : first.x;
+    for (int z = 0; z < voxels.z; ++z) {
+      for (int y = 0; y < voxels.y; ++y) {
+        int srcY = reverseY_ ? dimensions_.y - 1 - (first.y + y) : first.y + y;
+        int srcZ = reverseZ_ ? dimensions_.z - 1 - (first.z + z) : first.z + z;
+        uint64_t position = offset_
+          + ((static_cast<uint64_t>(srcZ) * dimensions_.y + srcY) * dimensions_.x + srcX) * bytesPerVoxel_;
+
+        unsigned char* dst = &data[(static_cast<size_t>(z) * voxels.y + y) * rowBytes];
+        unsigned char* buffer = reverseX_ ? &row[0] : dst;
+#ifdef _MSC_VER
+        bool valid = _fseeki64(file_, position, SEEK_SET) == 0;
+#else
+        bool valid = fseeko(file_, static_cast<off_t>(position), SEEK_SET) == 0;
+#endif
+        size_t bytesRead = valid ? fread(buffer, 1, rowBytes, file_) : 0;
+        if (bytesRead < rowBytes) {
+          // missing data is zero, as in VolumeReader::read()
+          memset(buffer + bytesRead, 0, rowBytes - bytesRead);
+          complete = false;
+        }
+
+        if (reverseX_)
+          VolumeKernels::reverseCopy(dst, buffer, voxels.x, bytesPerVoxel_);
+        if (swapBytes_)
+          VolumeKernels::swapBytes(dst, voxels.x, bytesPerVoxel_);
+      }
+    }
+    ++numBrickReads_;
+
+    if (!complete)
+      LWARNING("Brick " << index << " of " << fileName_ << " exceeds the end of the file");
+  }
+
+  void VolumeBricked::evict() const {
+    // the most recently used brick always stays, even if it exceeds the budget on its own
+    while (memoryUsage_ > memoryBudget_ && lru_.size() > 1) {
+      std::unordered_map<size_t, CacheEntry>::iterator it = cache_.find(lru_.back());
+      memoryUsage_ -= it->second.data->size();
+      cache_.erase(it);
+      lru_.pop_back();
+    }
+  }
+
+  void VolumeBricked::setMemoryBudget(size_t numBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memoryBudget_ = numBytes;
+    evict();
+  }
+
+  size_t VolumeBricked::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryBudget_;
+  }
+
+  size_t VolumeBricked::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryUsage_;
+  }
+
+  size_t VolumeBricked::getNumBrickReads() const {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return numBrickReads_;
+  }
+
+} // end namespace tgt
@@ -0,0 +1,509 @@
+#pragma once
+
+#include "volumerepresentation.h"
+#include "volumeelement.h"
+#include "volumestatistics.h"
+#include "exception.h"
+#include "logmanager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+namespace tgt {
+
+  /**
+  * Volume representation that keeps only a part of a raw volume file in memory.
+  *
+  * The volume is split into bricks of brickSize^3 voxels, which are read from the file when they are
+  * accessed for the first time. As for VolumeBrickMinMax, neighbouring bricks share one layer of voxels:
+  * brick i covers the voxels [i * brickSize, (i + 1) * brickSize] of each axis, so a trilinear lookup
+  * never needs a second brick. Loaded bricks are kept in an LRU cache limited by the memory budget.
+  * Evicting a brick does not invalidate BrickData handles that still refer to it.
+  *
+  * All functions are thread-safe. Use VolumeBrickedAtomic for typed access.
+  */
+  class VolumeBricked : public VolumeRepresentation {
+  public:
+    /// Voxels of one brick, x-fastest, with the dimensions returned by getBrickVoxels().
+    typedef std::shared_ptr<const std::vector<unsigned char> > BrickData;
+
+    static const int DEFAULT_BRICK_SIZE = 64;
+
+    /**
+    * Opens the raw file, no voxels are read yet.
+    *
+    * @param offset position of the first voxel in the file
+    * @param memoryBudget number of bytes of loaded bricks that are kept in memory
+    * @throw IOException if the file could not be opened
+    */
+    TGT_API VolumeBricked(const std::string& fileName, uint64_t offset, const glm::ivec3& dimensions,
+      size_t bytesPerVoxel, int brickSize, size_t memoryBudget)
+      throw (IOException);
+
+    /// Closes the file.
+    TGT_API virtual ~VolumeBricked();
+
+    TGT_API virtual size_t getBytesPerVoxel() const;
+
+    /// Returns the format of the volume as string (e.g., "uint8" or "float").
+    TGT_API virtual std::string getFormat() const = 0;
+
+    /**
+    * Mirrors the axes and converts the byte order while the bricks are read,
+    * used for slice orders other than +z and big endian files.
+    */
+    TGT_API void setReadTransform(bool reverseX, bool reverseY, bool reverseZ, bool swapBytes);
+
+    /// Edge length of the bricks in voxels, without the shared layer.
+    TGT_API int getBrickSize() const;
+
+    /// Number of bricks along each axis.
+    TGT_API glm::ivec3 getBrickDimensions() const;
+
+    TGT_API size_t getNumBricks() const;
+
+    /// Index of the brick whose own voxels (see getBrickOwnVoxels()) contain pos.
+    TGT_API size_t getBrickIndex(const glm::ivec3& pos) const;
+
+    /// Voxel coordinates of the first voxel of the brick.
+    TGT_API glm::ivec3 getBrickOffset(size_t index) const;
+
+    /// Number of voxels of the brick along each axis, including the layer shared with the next brick.
+    TGT_API glm::ivec3 getBrickVoxels(size_t index) const;
+
+    /// Number of voxels of the brick along each axis that are not part of the next brick.
+    TGT_API glm::ivec3 getBrickOwnVoxels(size_t index) const;
+
+    /**
+    * Returns the voxels of the brick, reading them if they are not cached.
+    * Parts beyond the end of the file are zero.
+    */
+    TGT_API BrickData getBrickData(size_t index) const;
+
+    /// Removes least recently used bricks until the cache fits into the new budget.
+    TGT_API void setMemoryBudget(size_t numBytes);
+    TGT_API size_t getMemoryBudget() const;
+
+    /// Number of bytes of the cached bricks.
+    TGT_API size_t getMemoryUsage() const;
+
+    /// Number of bricks read from the file so far, a measure for the cache misses.
+    TGT_API size_t getNumBrickReads() const;
+
+    /// Returns the data set's minimal and maximal possible element values converted to float.
+    TGT_API virtual glm::vec2 elementRange() const = 0;
+
+    /// Min and max of the voxel values, computed by computeMinMaxHistogram() or on first access.
+    TGT_API virtual float minValue() const = 0;
+    TGT_API virtual float maxValue() const = 0;
+
+    /// See VolumeRAM::computeHistogram().
+    TGT_API virtual void computeHistogram(float min, float max, std::vector<uint64_t>& buckets) const = 0;
+
+    /// See VolumeRAM::computeMinMaxHistogram().
+    TGT_API virtual void computeMinMaxHistogram(std::vector<uint64_t>& buckets) const = 0;
+
+    /// See VolumeRAM::computeBrickMinMax(), \p brickSize has to divide getBrickSize().
+    TGT_API virtual void computeBrickMinMax(int brickSize, std::vector<float>& minValues, std::vector<float>& maxValues) const = 0;
+
+    TGT_API virtual float getVoxel(const glm::ivec3& pos) const = 0;
+    TGT_API virtual float getVoxelNormalized(const glm::ivec3& pos) const = 0;
+
+    /// Trilinear lookup at pos in voxel coordinates, see VolumeRAM::getVoxelNormalizedLinear().
+    TGT_API virtual float getVoxelNormalizedLinear(const glm::vec3& pos) const = 0;
+
+  private:
+    // not copyable
+    VolumeBricked(const VolumeBricked&);
+    VolumeBricked& operator=(const VolumeBricked&);
+
+    void readBrick(size_t index, std::vector<unsigned char>& data) const;
+
+    /// Removes least recently used bricks, mutex_ has to be locked.
+    void evict() const;
+
+    struct CacheEntry {
+      BrickData data;
+      std::list<size_t>::iterator position;  ///< position in lru_
+    };
+
+    size_t bytesPerVoxel_;
+    int brickSize_;
+    glm::ivec3 brickDimensions_;
+
+    std::string fileName_;
+    uint64_t offset_;
+    FILE* file_;
+    bool reverseX_;
+    bool reverseY_;
+    bool reverseZ_;
+    bool swapBytes_;
+
+    size_t memoryBudget_;
+    mutable size_t memoryUsage_;
+    mutable size_t numBrickReads_;
+    mutable std::list<size_t> lru_;                          ///< cached bricks, most recently used first
+    mutable std::unordered_map<size_t, CacheEntry> cache_;
+    mutable std::mutex mutex_;                               ///< guards the cache
+    mutable std::mutex fileMutex_;                           ///< serializes the reads, guards the read transform
+
+    static const std::string loggerCat_;
+  };
+
+  //------------------------------------------------------------------------------
+
+  /**
+  * Typed access to the bricks of a VolumeBricked.
+  *
+  * The statistics sweep over the bricks in parallel, every voxel is counted once although the bricks overlap.
+  */
+  template<class T>
+  class VolumeBrickedAtomic : public VolumeBricked {
+  public:
+    /// A loaded brick, it stays in memory as long as the handle exists.
+    class Brick {
+    public:
+      Brick() : offset_(0), dimensions_(0), ownDimensions_(0) {}
+      Brick(const BrickData& data, const glm::ivec3& offset, const glm::ivec3& dimensions, const glm::ivec3& ownDimensions)
+        : data_(data), offset_(offset), dimensions_(dimensions), ownDimensions_(ownDimensions) {}
+
+      /// Voxels of the brick, x-fastest.
+      const T* getData() const { return reinterpret_cast<const T*>(&(*data_)[0]); }
+
+      /// Voxel coordinates of the first voxel in the volume.
+      glm::ivec3 getOffset() const { return offset_; }
+
+      /// Number of voxels along each axis, including the layer shared with the next brick.
+      glm::ivec3 getDimensions() const { return dimensions_; }
+
+      /// Number of voxels along each axis that are not part of the next brick.
+      glm::ivec3 getOwnDimensions() const { return ownDimensions_; }
+
+      size_t getNumVoxels() const { return static_cast<size_t>(dimensions_.x) * dimensions_.y * dimensions_.z; }
+
+      /// Voxel at pos relative to getOffset().
+      T voxel(const glm::ivec3& pos) const {
+        return getData()[(static_cast<size_t>(pos.z) * dimensions_.y + pos.y) * dimensions_.x + pos.x];
+      }
+
+      /// Copies the own voxels to a contiguous buffer, see getOwnDimensions().
+      void copyOwnVoxels(std::vector<T>& voxels) const;
+
+    private:
+      BrickData data_;
+      glm::ivec3 offset_;
+      glm::ivec3 dimensions_;
+      glm::ivec3 ownDimensions_;
+    };
+
+    VolumeBrickedAtomic(const std::string& fileName, uint64_t offset, const glm::ivec3& dimensions,
+      int brickSize, size_t memoryBudget)
+      throw (IOException);
+
+    Brick getBrick(size_t index) const;
+
+    /**
+    * Calls kernel(brick, thread) for every brick. The bricks are handed out to one thread per core
+    * in file order, \p thread is the zero-based index of the calling thread.
+    */
+    template<class F>
+    void forEachBrick(const F& kernel) const;
+
+    /// Number of threads used by forEachBrick().
+    size_t getNumThreads() const;
+
+    virtual std::string getFormat() const;
+    virtual glm::vec2 elementRange() const;
+    virtual float minValue() const;
+    virtual float maxValue() const;
+    virtual void computeHistogram(float min, float max, std::vector<uint64_t>& buckets) const;
+    virtual void computeMinMaxHistogram(std::vector<uint64_t>& buckets) const;
+    virtual void computeBrickMinMax(int brickSize, std::vector<float>& minValues, std::vector<float>& maxValues) const;
+    virtual float getVoxel(const glm::ivec3& pos) const;
+    virtual float getVoxelNormalized(const glm::ivec3& pos) const;
+    virtual float getVoxelNormalizedLinear(const glm::vec3& pos) const;
+
+  private:
+    typedef std::integral_constant<bool, VolumeStatistics::CountsValues<T>::value> CountsValues;
+
+    /// Histogram of all voxels, either per value (8 and 16 bit integers) or in buckets over [min, max].
+    void countValues(std::vector<uint64_t>& counts) const;
+    void computeMinMax() const;
+    void computeHistogram(float min, float max, std::vector<uint64_t>& buckets, std::true_type) const;
+    void computeHistogram(float min, float max, std::vector<uint64_t>& buckets, std::false_type) const;
+    void computeMinMaxHistogram(std::vector<uint64_t>& buckets, std::true_type) const;
+    void computeMinMaxHistogram(std::vector<uint64_t>& buckets, std::false_type) const;
+
+    mutable T minValue_;
+    mutable T maxValue_;
+    mutable bool minMaxValid_;
+    mutable std::mutex minMaxMutex_;
+  };
+
+  //------------------------------------------------------------------------------
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::Brick::copyOwnVoxels(std::vector<T>& voxels) const {
+    voxels.resize(static_cast<size_t>(ownDimensions_.x) * ownDimensions_.y * ownDimensions_.z);
+    T* dst = voxels.empty() ? 0 : &voxels[0];
+    for (int z = 0; z < ownDimensions_.z; ++z) {
+      for (int y = 0; y < ownDimensions_.y; ++y) {
+        const T* src = getData() + (static_cast<size_t>(z) * dimensions_.y + y) * dimensions_.x;
+        std::copy(src, src + ownDimensions_.x, dst);
+        dst += ownDimensions_.x;
+      }
+    }
+  }
+
+  template<class T>
+  VolumeBrickedAtomic<T>::VolumeBrickedAtomic(const std::string& fileName, uint64_t offset,
+    const glm::ivec3& dimensions, int brickSize, size_t memoryBudget)
+    throw (IOException)
+    : VolumeBricked(fileName, offset, dimensions, sizeof(T), brickSize, memoryBudget)
+    , minValue_(0)
+    , maxValue_(0)
+    , minMaxValid_(false)
+  {}
+
+  template<class T>
+  typename VolumeBrickedAtomic<T>::Brick VolumeBrickedAtomic<T>::getBrick(size_t index) const {
+    return Brick(getBrickData(index), getBrickOffset(index), getBrickVoxels(index), getBrickOwnVoxels(index));
+  }
+
+  template<class T>
+  size_t VolumeBrickedAtomic<T>::getNumThreads() const {
+    return std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), getNumBricks()));
+  }
+
+  template<class T>
+  template<class F>
+  void VolumeBrickedAtomic<T>::forEachBrick(const F& kernel) const {
+    const size_t numBricks = getNumBricks();
+    std::atomic<size_t> nextBrick(0);
+    auto worker = [&](size_t thread) {
+      for (size_t index = nextBrick++; index < numBricks; index = nextBrick++)
+        kernel(getBrick(index), thread);
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t thread = 1; thread < getNumThreads(); ++thread)
+      workers.push_back(std::thread(worker, thread));
+    worker(0);
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+  }
+
+  template<class T>
+  std::string VolumeBrickedAtomic<T>::getFormat() const {
+    return VolumeElement<T>::getFormat();
+  }
+
+  template<class T>
+  glm::vec2 VolumeBrickedAtomic<T>::elementRange() const {
+    return glm::vec2(VolumeElement<T>::rangeMinElement(), VolumeElement<T>::rangeMaxElement());
+  }
+
+  template<class T>
+  float VolumeBrickedAtomic<T>::minValue() const {
+    computeMinMax();
+    return static_cast<float>(minValue_);
+  }
+
+  template<class T>
+  float VolumeBrickedAtomic<T>::maxValue() const {
+    computeMinMax();
+    return static_cast<float>(maxValue_);
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeMinMax() const {
+    std::lock_guard<std::mutex> lock(minMaxMutex_);
+    if (minMaxValid_)
+      return;
+
+    std::vector<T> mins(getNumThreads(), std::numeric_limits<T>::max());
+    std::vector<T> maxs(getNumThreads(), std::numeric_limits<T>::lowest());
+    forEachBrick([&](const Brick& brick, size_t thread) {
+      T min, max;
+      VolumeKernels::minMax(brick.getData(), brick.getNumVoxels(), min, max);
+      mins[thread] = std::min(mins[thread], min);
+      maxs[thread] = std::max(maxs[thread], max);
+    });
+    minValue_ = *std::min_element(mins.begin(), mins.end());
+    maxValue_ = *std::max_element(maxs.begin(), maxs.end());
+    minMaxValid_ = true;
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::countValues(std::vector<uint64_t>& counts) const {
+    const size_t numValues = size_t(1) << (8 * sizeof(T));
+    std::vector<std::vector<uint64_t> > partial(getNumThreads(), std::vector<uint64_t>(numValues, 0));
+    forEachBrick([&](const Brick& brick, size_t thread) {
+      std::vector<uint64_t>& local = partial[thread];
+      glm::ivec3 own = brick.getOwnDimensions();
+      glm::ivec3 dims = brick.getDimensions();
+      for (int z = 0; z < own.z; ++z) {
+        for (int y = 0; y < own.y; ++y) {
+          const T* row = brick.getData() + (static_cast<size_t>(z) * dims.y + y) * dims.x;
+          for (int x = 0; x < own.x; ++x)
+            ++local[static_cast<size_t>(static_cast<int>(row[x]) - std::numeric_limits<T>::min())];
+        }
+      }
+    });
+
+    counts.swap(partial[0]);
+    for (size_t t = 1; t < partial.size(); ++t)
+      for (size_t v = 0; v < numValues; ++v)
+        counts[v] += partial[t][v];
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeHistogram(float min, float max, std::vector<uint64_t>& buckets) const {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    if (!buckets.empty())
+      computeHistogram(min, max, buckets, CountsValues());
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeHistogram(float min, float max, std::vector<uint64_t>& buckets, std::true_type) const {
+    std::vector<uint64_t> counts;
+    countValues(counts);
+    VolumeStatistics::bucketValues<T>(counts, min, max, buckets);
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeHistogram(float min, float max, std::vector<uint64_t>& buckets, std::false_type) const {
+    std::vector<std::vector<uint64_t> > partial(getNumThreads(), std::vector<uint64_t>(buckets.size(), 0));
+    forEachBrick([&](const Brick& brick, size_t thread) {
+      std::vector<T> voxels;
+      brick.copyOwnVoxels(voxels);
+      if (!voxels.empty())
+        VolumeStatistics::bucketVoxels(&voxels[0], voxels.size(), min, max, partial[thread]);
+    });
+
+    for (size_t t = 0; t < partial.size(); ++t)
+      for (size_t b = 0; b < buckets.size(); ++b)
+        buckets[b] += partial[t][b];
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeMinMaxHistogram(std::vector<uint64_t>& buckets) const {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    computeMinMaxHistogram(buckets, CountsValues());
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeMinMaxHistogram(std::vector<uint64_t>& buckets, std::true_type) const {
+    // a single sweep over the file
+    std::vector<uint64_t> counts;
+    countValues(counts);
+
+    std::lock_guard<std::mutex> lock(minMaxMutex_);
+    VolumeStatistics::minMaxOfCounts(counts, minValue_, maxValue_);
+    minMaxValid_ = true;
+    VolumeStatistics::bucketValues<T>(counts, static_cast<float>(minValue_), static_cast<float>(maxValue_), buckets);
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeMinMaxHistogram(std::vector<uint64_t>& buckets, std::false_type) const {
+    // the bucket range is only known after a first sweep
+    computeMinMax();
+    if (!buckets.empty())
+      computeHistogram(static_cast<float>(minValue_), static_cast<float>(maxValue_), buckets, std::false_type());
+  }
+
+  template<class T>
+  void VolumeBrickedAtomic<T>::computeBrickMinMax(int brickSize, std::vector<float>& minValues, std::vector<float>& maxValues) const {
+    const glm::ivec3 bricks = VolumeStatistics::getBrickDimensions(dimensions_, brickSize);
+    const size_t numBricks = static_cast<size_t>(bricks.x) * bricks.y * bricks.z;
+    if (brickSize <= 0 || getBrickSize() % brickSize != 0) {
+      // every brick spans the whole value range, which is conservative for empty space skipping
+      LERRORC("VolumeBricked", "Brick size " << brickSize << " does not divide the storage brick size " << getBrickSize());
+      minValues.assign(numBricks, elementRange().x);
+      maxValues.assign(numBricks, elementRange().y);
+      return;
+    }
+
+    // both kinds of bricks share their border voxels, so every small brick lies inside one storage brick
+    const int ratio = getBrickSize() / brickSize;
+    minValues.resize(numBricks);
+    maxValues.resize(numBricks);
+    forEachBrick([&](const Brick& brick, size_t) {
+      std::vector<float> localMin, localMax;
+      VolumeStatistics::brickMinMax(brick.getData(), brick.getDimensions(), brickSize, localMin, localMax);
+
+      glm::ivec3 first = brick.getOffset() / brickSize;
+      glm::ivec3 local = VolumeStatistics::getBrickDimensions(brick.getDimensions(), brickSize);
+      assert(glm::all(glm::lessThanEqual(local, glm::ivec3(ratio))));
+      for (int z = 0; z < local.z; ++z) {
+        for (int y = 0; y < local.y; ++y) {
+          for (int x = 0; x < local.x; ++x) {
+            size_t src = (static_cast<size_t>(z) * local.y + y) * local.x + x;
+            size_t dst = (static_cast<size_t>(first.z + z) * bricks.y + first.y + y) * bricks.x + first.x + x;
+            minValues[dst] = localMin[src];
+            maxValues[dst] = localMax[src];
+          }
+        }
+      }
+    });
+  }
+
+  template<class T>
+  float VolumeBrickedAtomic<T>::getVoxel(const glm::ivec3& pos) const {
+    Brick brick = getBrick(getBrickIndex(pos));
+    return static_cast<float>(brick.voxel(pos - brick.getOffset()));
+  }
+
+  template<class T>
+  float VolumeBrickedAtomic<T>::getVoxelNormalized(const glm::ivec3& pos) const {
+    Brick brick = getBrick(getBrickIndex(pos));
+    return VolumeElement<T>::getTypeAsFloat(brick.voxel(pos - brick.getOffset()));
+  }
+
+  template<class T>
+  float VolumeBrickedAtomic<T>::getVoxelNormalizedLinear(const glm::vec3& pos) const {
+    glm::vec3 posAbs = glm::max(pos - 0.5f, glm::vec3(0.0f));
+    glm::vec3 p = posAbs - glm::floor(posAbs);
+    glm::ivec3 llb = glm::min(glm::ivec3(posAbs), dimensions_ - glm::ivec3(1));
+    glm::ivec3 urf = glm::min(glm::ivec3(glm::ceil(posAbs)), dimensions_ - glm::ivec3(1));
+
+    // the brick of llb also contains urf
+    Brick brick = getBrick(getBrickIndex(llb));
+    llb -= brick.getOffset();
+    urf -= brick.getOffset();
+    // same weighting as VolumeRAM::getVoxelNormalizedLinear()
+    return  VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(llb.x, llb.y, llb.z))) * (1.f-p.x)*(1.f-p.y)*(1.f-p.z) // llB
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(urf.x, llb.y, llb.z))) * (    p.x)*(1.f-p.y)*(1.f-p.z) // lrB
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(urf.x, urf.y, llb.z))) * (    p.x)*(    p.y)*(1.f-p.z) // urB
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(llb.x, urf.y, llb.z))) * (1.f-p.x)*(    p.y)*(1.f-p.z) // ulB
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(llb.x, llb.y, urf.z))) * (1.f-p.x)*(1.f-p.y)*(    p.z) // llF
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(urf.x, llb.y, urf.z))) * (    p.x)*(1.f-p.y)*(    p.z) // lrF
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(urf.x, urf.y, urf.z))) * (    p.x)*(    p.y)*(    p.z) // urF
+          + VolumeElement<T>::getTypeAsFloat(brick.voxel(glm::ivec3(llb.x, urf.y, urf.z))) * (1.f-p.x)*(    p.y)*(    p.z);// ulF
+  }
+
+  //------------------------------------------------------------------------------
+
+  typedef VolumeBrickedAtomic<uint8_t>   VolumeBricked_UInt8;
+  typedef VolumeBrickedAtomic<uint16_t>  VolumeBricked_UInt16;
+  typedef VolumeBrickedAtomic<uint32_t>  VolumeBricked_UInt32;
+  typedef VolumeBrickedAtomic<uint64_t>  VolumeBricked_UInt64;
+
+  typedef VolumeBrickedAtomic<int8_t>    VolumeBricked_Int8;
+  typedef VolumeBrickedAtomic<int16_t>   VolumeBricked_Int16;
+  typedef VolumeBrickedAtomic<int32_t>   VolumeBricked_Int32;
+  typedef VolumeBrickedAtomic<int64_t>   VolumeBricked_Int64;
+
+  typedef VolumeBrickedAtomic<float>     VolumeBricked_Float;
+  typedef VolumeBrickedAtomic<double>    VolumeBricked_Double;
+
+} // end namespace tgt
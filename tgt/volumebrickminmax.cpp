@@ -0,0 +1,56 @@
+#include "volumebrickminmax.h"
+#include "volume.h"
+#include "volumeram.h"
+#include "volumebricked.h"
+#include "volumestatistics.h"
+
+namespace tgt {
+
+  VolumeBrickMinMax::VolumeBrickMinMax()
+    : VolumeDerivedData()
+    , brickDimensions_(0)
+  {}
+
+  VolumeBrickMinMax::VolumeBrickMinMax(const glm::ivec3& brickDimensions,
+    const std::vector<float>& minValues, const std::vector<float>& maxValues)
+    : VolumeDerivedData()
+    , brickDimensions_(brickDimensions)
+    , minValues_(minValues)
+    , maxValues_(maxValues)
+  {}
+
+  VolumeDerivedData* VolumeBrickMinMax::createFrom(Volume* handle) const {
+    assert(handle);
+
+    const VolumeBricked* volumeBricked = handle->hasRepresentation<VolumeRAM>() ? 0 : handle->hasRepresentation<VolumeBricked>();
+    const VolumeRAM* volumeRam = volumeBricked ? 0 : handle->getRepresentation<VolumeRAM>();
+    assert(volumeRam || volumeBricked);
+
+    VolumeBrickMinMax* result = new VolumeBrickMinMax();
+    result->brickDimensions_ = VolumeStatistics::getBrickDimensions(handle->getDimensions(), BRICK_SIZE);
+    if (volumeRam)
+      volumeRam->computeBrickMinMax(BRICK_SIZE, result->minValues_, result->maxValues_);
+    else
+      volumeBricked->computeBrickMinMax(BRICK_SIZE, result->minValues_, result->maxValues_);
+    assert(result->minValues_.size() == result->getNumBricks());
+
+    return result;
+  }
+
+  glm::ivec3 VolumeBrickMinMax::getBrickDimensions() const {
+    return brickDimensions_;
+  }
+
+  size_t VolumeBrickMinMax::getNumBricks() const {
+    return static_cast<size_t>(brickDimensions_.x) * brickDimensions_.y * brickDimensions_.z;
+  }
+
+  const std::vector<float>& VolumeBrickMinMax::getMinValues() const {
+    return minValues_;
+  }
+
+  const std::vector<float>& VolumeBrickMinMax::getMaxValues() const {
+    return maxValues_;
+  }
+
+} // end namespace tgt
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "volumederiveddata.h"
+#include "tgt_math.h"
+
+#include <vector>
+
+namespace tgt {
+
+  /**
+  * Min and max raw voxel value of every brick of BRICK_SIZE^3 voxels.
+  *
+  * Brick i covers the voxel coordinates [i * BRICK_SIZE, (i + 1) * BRICK_SIZE] of each axis, so
+  * neighbouring bricks share one layer of voxels. Every trilinear sample whose voxel coordinate
+  * lies inside a brick is thereby bounded by the brick's min and max, which allows a raycaster
+  * to skip bricks that are transparent for the current transfer function.
+  */
+  class VolumeBrickMinMax : public VolumeDerivedData {
+  public:
+    static const int BRICK_SIZE = 16;
+
+    /// Empty default constructor required by VolumeDerivedData interface.
+    TGT_API VolumeBrickMinMax();
+    TGT_API VolumeBrickMinMax(const glm::ivec3& brickDimensions,
+      const std::vector<float>& minValues, const std::vector<float>& maxValues);
+
+    TGT_API virtual VolumeDerivedData* createFrom(Volume* handle) const;
+
+    /// Number of bricks along each axis.
+    TGT_API glm::ivec3 getBrickDimensions() const;
+
+    TGT_API size_t getNumBricks() const;
+
+    /// Minimum (raw data) of the bricks, x-fastest.
+    TGT_API const std::vector<float>& getMinValues() const;
+
+    /// Maximum (raw data) of the bricks, x-fastest.
+    TGT_API const std::vector<float>& getMaxValues() const;
+
+  protected:
+    glm::ivec3 brickDimensions_;
+    std::vector<float> minValues_;
+    std::vector<float> maxValues_;
+  };
+
+} // end namespace tgt
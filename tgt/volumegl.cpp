@@ -15,6 +15,14 @@ namespace tgt {
     generateTexture(volume);
   }
 
+  VolumeGL::VolumeGL(const VolumeMask* mask) throw (tgt::Exception, std::bad_alloc)
+    : VolumeRepresentation(mask->getDimensions())
+    , texture_(0)
+  {
+    assert(mask);
+    generateTexture(mask);
+  }
+
   VolumeGL::~VolumeGL() {
     destroy();
   }
@@ -191,9 +199,37 @@ namespace tgt {
     LGL_ERROR;
   }
 
+  void VolumeGL::generateTexture(const VolumeMask* mask)
+    throw (tgt::Exception, std::bad_alloc)
+  {
+    if (!GpuCaps.is3DTexturingSupported() || !GpuCaps.isShaderModelSupported(GpuCapabilities::SHADER_MODEL_4)) {
+      std::string message = "Integer 3D textures apparently not supported by the OpenGL driver";
+      LERROR(message);
+      throw Exception(message);
+    }
+
+    // 3D textures need at least two texels along each axis, the padding is never read
+    const glm::ivec3 dims = mask->getDimensions();
+    const glm::ivec3 wordDims(VolumeMask::getNumWords(dims.x), dims.y, dims.z);
+    VolumeTexture* vTex = new VolumeTexture(0, glm::max(wordDims, glm::ivec3(2)),
+      GL_RED_INTEGER, GL_R32UI, GL_UNSIGNED_INT, Texture::NEAREST);
+    vTex->bind();
+    vTex->uploadTexture();
+    vTex->setWrapping(Texture::CLAMP_TO_EDGE);
+
+    std::vector<uint32_t> words;
+    mask->pack(glm::ivec3(0), dims, words);
+    vTex->uploadTextureRegion(reinterpret_cast<const GLubyte*>(&words[0]), wordDims, glm::ivec3(0), wordDims);
+    LGL_ERROR;
+
+    pixelTransferMapping_ = ValueMapping(1.f, 0.f, "");
+    texture_ = vTex;
+  }
+
   size_t VolumeGL::getNumChannels() const {
     switch (getTexture()->getFormat()) {
     case GL_ALPHA: return 1;
+    case GL_RED_INTEGER: return 1;
     case GL_LUMINANCE_ALPHA: return 2;
     case GL_RGB: return 3;
     case GL_RGBA: return 4;
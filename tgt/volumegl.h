@@ -2,6 +2,7 @@
 
 #include "volumerepresentation.h"
 #include "volumeram.h"
+#include "volumemask.h"
 #include "volumetexture.h"
 #include "exception.h"
 #include "valuemapping.h"
@@ -26,6 +27,16 @@ namespace tgt {
     TGT_API VolumeGL(const VolumeRAM* volume)
       throw (tgt::Exception, std::bad_alloc);
 
+    /**
+    * Creates an unsigned integer texture holding 32 voxels of the mask per texel, packed as by
+    * VolumeMask::pack(). Each dimension is padded to at least two texels.
+    *
+    * @throw VoreenException if integer 3D textures are not supported by OpenGL
+    * @throw std::bad_alloc
+    */
+    TGT_API VolumeGL(const VolumeMask* mask)
+      throw (tgt::Exception, std::bad_alloc);
+
     TGT_API virtual ~VolumeGL();
 
     /**
@@ -65,6 +76,10 @@ namespace tgt {
     void generateTexture(const VolumeRAM* vol)
       throw (tgt::Exception, std::bad_alloc);
 
+    /// @overload
+    void generateTexture(const VolumeMask* mask)
+      throw (tgt::Exception, std::bad_alloc);
+
     VolumeTexture* texture_;
 
     /// scale factor and offset used during texture upload (GL_*_SCALE, GL_*_BIAS)
@@ -2,6 +2,7 @@
 #include "volume.h"
 #include "volumeminmax.h"
 #include "volumeram.h"
+#include "volumebricked.h"
 
 namespace tgt {
 
@@ -16,23 +17,48 @@ namespace tgt {
   Histogram1D createHistogram1DFromVolume(Volume *handle, size_t bucketCount, float realWorldMin, float realWorldMax) {
     assert(realWorldMin <= realWorldMax);
 
+    // volumes that do not fit into memory are only available as bricks
+    const VolumeBricked* volumeBricked = handle->hasRepresentation<VolumeRAM>() ? 0 : handle->hasRepresentation<VolumeBricked>();
+    const VolumeRAM* volumeRam = volumeBricked ? 0 : handle->getRepresentation<VolumeRAM>();
+    assert(volumeRam || volumeBricked);
+
+    std::vector<uint64_t> buckets(bucketCount);
+    if (volumeRam)
+      volumeRam->computeHistogram(realWorldMin, realWorldMax, buckets);
+    else
+      volumeBricked->computeHistogram(realWorldMin, realWorldMax, buckets);
+
     Histogram1D h(realWorldMin, realWorldMax, (int)bucketCount);
+    for (size_t b = 0; b < bucketCount; ++b) {
+      if (buckets[b] > 0)
+        h.increaseBucket(b, buckets[b]);
+    }
+    return h;
+  }
 
-    const VolumeRAM* volumeRam = handle->getRepresentation<VolumeRAM>();
-    assert(volumeRam);
-
-    // iterate over slices
-    glm::ivec3 dims = handle->getDimensions();
-    glm::ivec3 pos;
-    for (pos.z = 0; pos.z < dims.z; ++pos.z) {
-      for (pos.y = 0; pos.y < dims.y; ++pos.y) {
-        for (pos.x = 0; pos.x < dims.x; ++pos.x) {
-          float val = volumeRam->getVoxel(pos);
-          h.addSample(val);
-        }
-      }
+  Histogram1D createHistogram1DAndMinMaxFromVolume(Volume *handle, size_t bucketCount, float& min, float& max) {
+    // volumes that do not fit into memory are only available as bricks
+    const VolumeBricked* volumeBricked = handle->hasRepresentation<VolumeRAM>() ? 0 : handle->hasRepresentation<VolumeBricked>();
+    const VolumeRAM* volumeRam = volumeBricked ? 0 : handle->getRepresentation<VolumeRAM>();
+    assert(volumeRam || volumeBricked);
+
+    std::vector<uint64_t> buckets(bucketCount);
+    if (volumeRam) {
+      volumeRam->computeMinMaxHistogram(buckets);
+      min = volumeRam->minValue();
+      max = volumeRam->maxValue();
+    }
+    else {
+      volumeBricked->computeMinMaxHistogram(buckets);
+      min = volumeBricked->minValue();
+      max = volumeBricked->maxValue();
     }
 
+    Histogram1D h(min, max, (int)bucketCount);
+    for (size_t b = 0; b < bucketCount; ++b) {
+      if (buckets[b] > 0)
+        h.increaseBucket(b, buckets[b]);
+    }
     return h;
   }
 
@@ -103,7 +129,17 @@ namespace tgt {
   VolumeDerivedData* VolumeHistogramIntensity::createFrom(Volume* handle) const {
     assert(handle);
     VolumeHistogramIntensity* h = new VolumeHistogramIntensity();
-    h->histogram_ = createHistogram1DFromVolume(handle, static_cast<size_t>(256));
+    if (handle->hasDerivedData<VolumeMinMax>()) {
+      h->histogram_ = createHistogram1DFromVolume(handle, static_cast<size_t>(256));
+      return h;
+    }
+
+    // min/max come out of the same sweep, so keep them as well
+    float min = 0.f;
+    float max = 0.f;
+    h->histogram_ = createHistogram1DAndMinMaxFromVolume(handle, static_cast<size_t>(256), min, max);
+    handle->addMissingDerivedDataInternal(new VolumeMinMax(min, max,
+      handle->getRescaleMapping().map(min), handle->getRescaleMapping().map(max)));
     return h;
   }
 
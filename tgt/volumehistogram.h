@@ -233,6 +233,11 @@ namespace tgt {
   Histogram1D createHistogram1DFromVolume(Volume *handle, size_t bucketCount, float realWorldMin, float realWorldMax);
   Histogram1D createHistogram1DFromVolume(Volume *handle, size_t bucketCount);
 
+  /**
+  * Determines min/max of the volume and its histogram over [min, max] in one sweep over the voxel data.
+  */
+  Histogram1D createHistogram1DAndMinMaxFromVolume(Volume *handle, size_t bucketCount, float& min, float& max);
+
   //------------------------------------------------------------------------------
 
   template <typename T>
@@ -0,0 +1,687 @@
+#include "volumekernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// MSVC accepts AVX2 intrinsics in any translation unit, other compilers need -mavx2
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define TGT_AVX2_KERNELS
+#endif
+
+// anonymous namespace
+namespace {
+
+  using tgt::VolumeKernels;
+
+  template<size_t E> struct Element;
+  template<> struct Element<1> { typedef uint8_t Type; };
+  template<> struct Element<2> { typedef uint16_t Type; };
+  template<> struct Element<4> { typedef uint32_t Type; };
+  template<> struct Element<8> { typedef uint64_t Type; };
+
+  inline uint8_t byteSwap(uint8_t v) {
+    return v;
+  }
+
+  inline uint16_t byteSwap(uint16_t v) {
+    return static_cast<uint16_t>((v >> 8) | (v << 8));
+  }
+
+  inline uint32_t byteSwap(uint32_t v) {
+    return (v >> 24) | ((v << 8) & 0x00FF0000) | ((v >> 8) & 0x0000FF00) | (v << 24);
+  }
+
+  inline uint64_t byteSwap(uint64_t v) {
+    return (static_cast<uint64_t>(byteSwap(static_cast<uint32_t>(v))) << 32) | byteSwap(static_cast<uint32_t>(v >> 32));
+  }
+
+  //------------------------------------------------------------------------------
+  // scalar kernels, also used for the remainders of the vectorized loops
+
+  template<size_t E>
+  void swapBytesScalar(unsigned char* data, size_t numElements) {
+    typedef typename Element<E>::Type T;
+    for (size_t i = 0; i < numElements; ++i) {
+      T v;
+      memcpy(&v, data + i * E, E);
+      v = byteSwap(v);
+      memcpy(data + i * E, &v, E);
+    }
+  }
+
+  template<size_t E>
+  void reverseScalar(unsigned char* data, size_t numElements) {
+    typedef typename Element<E>::Type T;
+    if (numElements < 2)
+      return;
+    for (size_t i = 0, j = numElements - 1; i < j; ++i, --j) {
+      T a, b;
+      memcpy(&a, data + i * E, E);
+      memcpy(&b, data + j * E, E);
+      memcpy(data + i * E, &b, E);
+      memcpy(data + j * E, &a, E);
+    }
+  }
+
+  template<size_t E>
+  void reverseCopyScalar(unsigned char* dst, const unsigned char* src, size_t numElements) {
+    for (size_t i = 0; i < numElements; ++i)
+      memcpy(dst + (numElements - 1 - i) * E, src + i * E, E);
+  }
+
+  // element sizes without a typed kernel
+  void swapBytesGeneric(unsigned char* data, size_t numElements, size_t elementSize) {
+    for (size_t i = 0; i < numElements; ++i)
+      std::reverse(data + i * elementSize, data + (i + 1) * elementSize);
+  }
+
+  void reverseGeneric(unsigned char* data, size_t numElements, size_t elementSize) {
+    if (numElements < 2)
+      return;
+    for (size_t i = 0, j = numElements - 1; i < j; ++i, --j)
+      std::swap_ranges(data + i * elementSize, data + (i + 1) * elementSize, data + j * elementSize);
+  }
+
+  void reverseCopyGeneric(unsigned char* dst, const unsigned char* src, size_t numElements, size_t elementSize) {
+    for (size_t i = 0; i < numElements; ++i)
+      memcpy(dst + (numElements - 1 - i) * elementSize, src + i * elementSize, elementSize);
+  }
+
+  //------------------------------------------------------------------------------
+  // register operations of the instruction sets
+
+  struct Sse2 {
+    typedef __m128i Reg;
+    enum { WIDTH = 16 };
+
+    static Reg load(const unsigned char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(unsigned char* p, Reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+    template<size_t E> static Reg swap(Reg v);
+    template<size_t E> static Reg reverse(Reg v);
+  };
+
+  template<> inline __m128i Sse2::swap<2>(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  }
+
+  template<> inline __m128i Sse2::swap<4>(__m128i v) {
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return swap<2>(v);
+  }
+
+  template<> inline __m128i Sse2::swap<8>(__m128i v) {
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return swap<2>(v);
+  }
+
+  template<> inline __m128i Sse2::reverse<8>(__m128i v) {
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  }
+
+  template<> inline __m128i Sse2::reverse<4>(__m128i v) {
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+  }
+
+  template<> inline __m128i Sse2::reverse<2>(__m128i v) {
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return reverse<8>(v);
+  }
+
+  template<> inline __m128i Sse2::reverse<1>(__m128i v) {
+    return reverse<2>(swap<2>(v));
+  }
+
+#ifdef TGT_AVX2_KERNELS
+  struct Avx2 {
+    typedef __m256i Reg;
+    enum { WIDTH = 32 };
+
+    static Reg load(const unsigned char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(unsigned char* p, Reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+    template<size_t E> static Reg swap(Reg v);
+    template<size_t E> static Reg reverse(Reg v);
+  };
+
+  template<> inline __m256i Avx2::swap<2>(__m256i v) {
+    return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+      1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+      1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+  }
+
+  template<> inline __m256i Avx2::swap<4>(__m256i v) {
+    return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+  }
+
+  template<> inline __m256i Avx2::swap<8>(__m256i v) {
+    return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+      7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+      7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+  }
+
+  template<> inline __m256i Avx2::reverse<8>(__m256i v) {
+    return _mm256_permute4x64_epi64(v, _MM_SHUFFLE(0, 1, 2, 3));
+  }
+
+  template<> inline __m256i Avx2::reverse<4>(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+  }
+
+  template<> inline __m256i Avx2::reverse<2>(__m256i v) {
+    // reverse within the 128 bit lanes, then exchange the lanes
+    v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+      14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+      14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+    return _mm256_permute2x128_si256(v, v, 0x01);
+  }
+
+  template<> inline __m256i Avx2::reverse<1>(__m256i v) {
+    v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+    return _mm256_permute2x128_si256(v, v, 0x01);
+  }
+#endif
+
+  //------------------------------------------------------------------------------
+  // vectorized loops
+
+  template<class Isa, size_t E>
+  void swapBytesVector(unsigned char* data, size_t numElements) {
+    size_t numBytes = numElements * E;
+    size_t i = 0;
+    for (; i + Isa::WIDTH <= numBytes; i += Isa::WIDTH)
+      Isa::store(data + i, Isa::template swap<E>(Isa::load(data + i)));
+    swapBytesScalar<E>(data + i, (numBytes - i) / E);
+  }
+
+  template<class Isa, size_t E>
+  void reverseVector(unsigned char* data, size_t numElements) {
+    unsigned char* front = data;
+    unsigned char* back = data + numElements * E;
+    while (static_cast<size_t>(back - front) >= 2 * Isa::WIDTH) {
+      back -= Isa::WIDTH;
+      typename Isa::Reg a = Isa::load(front);
+      typename Isa::Reg b = Isa::load(back);
+      Isa::store(front, Isa::template reverse<E>(b));
+      Isa::store(back, Isa::template reverse<E>(a));
+      front += Isa::WIDTH;
+    }
+    reverseScalar<E>(front, (back - front) / E);
+  }
+
+  template<class Isa, size_t E>
+  void reverseCopyVector(unsigned char* dst, const unsigned char* src, size_t numElements) {
+    size_t numBytes = numElements * E;
+    size_t i = 0;
+    for (; i + Isa::WIDTH <= numBytes; i += Isa::WIDTH)
+      Isa::store(dst + numBytes - i - Isa::WIDTH, Isa::template reverse<E>(Isa::load(src + i)));
+    reverseCopyScalar<E>(dst, src + i, (numBytes - i) / E);
+  }
+
+  template<class Isa>
+  void swapRangesVector(unsigned char* a, unsigned char* b, size_t numBytes) {
+    size_t i = 0;
+    for (; i + Isa::WIDTH <= numBytes; i += Isa::WIDTH) {
+      typename Isa::Reg va = Isa::load(a + i);
+      typename Isa::Reg vb = Isa::load(b + i);
+      Isa::store(a + i, vb);
+      Isa::store(b + i, va);
+    }
+    std::swap_ranges(a + i, a + numBytes, b + i);
+  }
+
+  //------------------------------------------------------------------------------
+  // dispatch on element size
+
+  template<class Isa>
+  struct Kernels {
+    static void swapBytes(unsigned char* data, size_t numElements, size_t elementSize) {
+      switch (elementSize) {
+      case 1: break;
+      case 2: swapBytesVector<Isa, 2>(data, numElements); break;
+      case 4: swapBytesVector<Isa, 4>(data, numElements); break;
+      case 8: swapBytesVector<Isa, 8>(data, numElements); break;
+      default: swapBytesGeneric(data, numElements, elementSize);
+      }
+    }
+
+    static void reverse(unsigned char* data, size_t numElements, size_t elementSize) {
+      switch (elementSize) {
+      case 1: reverseVector<Isa, 1>(data, numElements); break;
+      case 2: reverseVector<Isa, 2>(data, numElements); break;
+      case 4: reverseVector<Isa, 4>(data, numElements); break;
+      case 8: reverseVector<Isa, 8>(data, numElements); break;
+      default: reverseGeneric(data, numElements, elementSize);
+      }
+    }
+
+    static void reverseCopy(unsigned char* dst, const unsigned char* src, size_t numElements, size_t elementSize) {
+      switch (elementSize) {
+      case 1: reverseCopyVector<Isa, 1>(dst, src, numElements); break;
+      case 2: reverseCopyVector<Isa, 2>(dst, src, numElements); break;
+      case 4: reverseCopyVector<Isa, 4>(dst, src, numElements); break;
+      case 8: reverseCopyVector<Isa, 8>(dst, src, numElements); break;
+      default: reverseCopyGeneric(dst, src, numElements, elementSize);
+      }
+    }
+
+    static void swapRanges(unsigned char* a, unsigned char* b, size_t numBytes) {
+      swapRangesVector<Isa>(a, b, numBytes);
+    }
+  };
+
+  struct Scalar {};
+
+  template<>
+  struct Kernels<Scalar> {
+    static void swapBytes(unsigned char* data, size_t numElements, size_t elementSize) {
+      switch (elementSize) {
+      case 1: break;
+      case 2: swapBytesScalar<2>(data, numElements); break;
+      case 4: swapBytesScalar<4>(data, numElements); break;
+      case 8: swapBytesScalar<8>(data, numElements); break;
+      default: swapBytesGeneric(data, numElements, elementSize);
+      }
+    }
+
+    static void reverse(unsigned char* data, size_t numElements, size_t elementSize) {
+      switch (elementSize) {
+      case 1: reverseScalar<1>(data, numElements); break;
+      case 2: reverseScalar<2>(data, numElements); break;
+      case 4: reverseScalar<4>(data, numElements); break;
+      case 8: reverseScalar<8>(data, numElements); break;
+      default: reverseGeneric(data, numElements, elementSize);
+      }
+    }
+
+    static void reverseCopy(unsigned char* dst, const unsigned char* src, size_t numElements, size_t elementSize) {
+      switch (elementSize) {
+      case 1: reverseCopyScalar<1>(dst, src, numElements); break;
+      case 2: reverseCopyScalar<2>(dst, src, numElements); break;
+      case 4: reverseCopyScalar<4>(dst, src, numElements); break;
+      case 8: reverseCopyScalar<8>(dst, src, numElements); break;
+      default: reverseCopyGeneric(dst, src, numElements, elementSize);
+      }
+    }
+
+    static void swapRanges(unsigned char* a, unsigned char* b, size_t numBytes) {
+      std::swap_ranges(a, a + numBytes, b);
+    }
+  };
+
+  //------------------------------------------------------------------------------
+  // min/max reduction, one operations struct per instruction set and voxel type.
+  // Types without native min/max instructions are biased into a type that has them.
+
+  template<class T>
+  void minMaxScalar(const T* data, size_t n, T& min, T& max) {
+    T lo = data[0];
+    T hi = data[0];
+    for (size_t i = 1; i < n; ++i) {
+      if (data[i] < lo)
+        lo = data[i];
+      if (data[i] > hi)
+        hi = data[i];
+    }
+    min = lo;
+    max = hi;
+  }
+
+  template<class T>
+  struct Sse2IntOps {
+    typedef T Type;
+    typedef __m128i Reg;
+    enum { WIDTH = 16 };
+    static Reg load(const T* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(T* p, Reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+  };
+
+  struct Sse2U8 : Sse2IntOps<uint8_t> {
+    static Reg min(Reg a, Reg b) { return _mm_min_epu8(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm_max_epu8(a, b); }
+  };
+
+  struct Sse2I8 : Sse2IntOps<int8_t> {
+    static Reg bias(Reg v) { return _mm_xor_si128(v, _mm_set1_epi8(-128)); }
+    static Reg load(const int8_t* p) { return bias(Sse2IntOps<int8_t>::load(p)); }
+    static void store(int8_t* p, Reg v) { Sse2IntOps<int8_t>::store(p, bias(v)); }
+    static Reg min(Reg a, Reg b) { return _mm_min_epu8(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm_max_epu8(a, b); }
+  };
+
+  struct Sse2I16 : Sse2IntOps<int16_t> {
+    static Reg min(Reg a, Reg b) { return _mm_min_epi16(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm_max_epi16(a, b); }
+  };
+
+  struct Sse2U16 : Sse2IntOps<uint16_t> {
+    static Reg bias(Reg v) { return _mm_xor_si128(v, _mm_set1_epi16(-32768)); }
+    static Reg load(const uint16_t* p) { return bias(Sse2IntOps<uint16_t>::load(p)); }
+    static void store(uint16_t* p, Reg v) { Sse2IntOps<uint16_t>::store(p, bias(v)); }
+    static Reg min(Reg a, Reg b) { return _mm_min_epi16(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm_max_epi16(a, b); }
+  };
+
+  struct Sse2F32 {
+    typedef float Type;
+    typedef __m128 Reg;
+    enum { WIDTH = 16 };
+    static Reg load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Reg v) { _mm_storeu_ps(p, v); }
+    static Reg min(Reg a, Reg b) { return _mm_min_ps(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm_max_ps(a, b); }
+  };
+
+  struct Sse2F64 {
+    typedef double Type;
+    typedef __m128d Reg;
+    enum { WIDTH = 16 };
+    static Reg load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, Reg v) { _mm_storeu_pd(p, v); }
+    static Reg min(Reg a, Reg b) { return _mm_min_pd(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm_max_pd(a, b); }
+  };
+
+#ifdef TGT_AVX2_KERNELS
+  template<class T>
+  struct Avx2IntOps {
+    typedef T Type;
+    typedef __m256i Reg;
+    enum { WIDTH = 32 };
+    static Reg load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(T* p, Reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+  };
+
+  struct Avx2U8 : Avx2IntOps<uint8_t> {
+    static Reg min(Reg a, Reg b) { return _mm256_min_epu8(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_epu8(a, b); }
+  };
+
+  struct Avx2I8 : Avx2IntOps<int8_t> {
+    static Reg min(Reg a, Reg b) { return _mm256_min_epi8(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_epi8(a, b); }
+  };
+
+  struct Avx2U16 : Avx2IntOps<uint16_t> {
+    static Reg min(Reg a, Reg b) { return _mm256_min_epu16(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_epu16(a, b); }
+  };
+
+  struct Avx2I16 : Avx2IntOps<int16_t> {
+    static Reg min(Reg a, Reg b) { return _mm256_min_epi16(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_epi16(a, b); }
+  };
+
+  struct Avx2U32 : Avx2IntOps<uint32_t> {
+    static Reg min(Reg a, Reg b) { return _mm256_min_epu32(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_epu32(a, b); }
+  };
+
+  struct Avx2I32 : Avx2IntOps<int32_t> {
+    static Reg min(Reg a, Reg b) { return _mm256_min_epi32(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_epi32(a, b); }
+  };
+
+  struct Avx2F32 {
+    typedef float Type;
+    typedef __m256 Reg;
+    enum { WIDTH = 32 };
+    static Reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+    static Reg min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+  };
+
+  struct Avx2F64 {
+    typedef double Type;
+    typedef __m256d Reg;
+    enum { WIDTH = 32 };
+    static Reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+    static Reg min(Reg a, Reg b) { return _mm256_min_pd(a, b); }
+    static Reg max(Reg a, Reg b) { return _mm256_max_pd(a, b); }
+  };
+#endif
+
+  template<class Ops>
+  void minMaxVector(const typename Ops::Type* data, size_t n, typename Ops::Type& min, typename Ops::Type& max) {
+    typedef typename Ops::Type T;
+    const size_t lanes = Ops::WIDTH / sizeof(T);
+    if (n < 2 * lanes) {
+      minMaxScalar(data, n, min, max);
+      return;
+    }
+
+    typename Ops::Reg lo = Ops::load(data);
+    typename Ops::Reg hi = lo;
+    size_t i = lanes;
+    for (; i + lanes <= n; i += lanes) {
+      typename Ops::Reg v = Ops::load(data + i);
+      lo = Ops::min(lo, v);
+      hi = Ops::max(hi, v);
+    }
+
+    // reduce the lanes and the remainder
+    T los[Ops::WIDTH / sizeof(T)];
+    T his[Ops::WIDTH / sizeof(T)];
+    Ops::store(los, lo);
+    Ops::store(his, hi);
+    T minLanes, maxLanes, unused;
+    minMaxScalar(los, lanes, minLanes, unused);
+    minMaxScalar(his, lanes, unused, maxLanes);
+    if (i < n) {
+      T minRest, maxRest;
+      minMaxScalar(data + i, n - i, minRest, maxRest);
+      minLanes = std::min(minLanes, minRest);
+      maxLanes = std::max(maxLanes, maxRest);
+    }
+    min = minLanes;
+    max = maxLanes;
+  }
+
+  /// Type without SSE2 or AVX2 kernel, reduced by the scalar code.
+  template<class T>
+  struct NoOps {};
+
+  template<class T, class AvxOps, class SseOps>
+  struct MinMax {
+    static void run(const T* data, size_t n, T& min, T& max, VolumeKernels::InstructionSet set) {
+      if (set == VolumeKernels::AVX2)
+        minMaxVector<AvxOps>(data, n, min, max);
+      else if (set == VolumeKernels::SSE2)
+        MinMax<T, NoOps<T>, SseOps>::run(data, n, min, max, set);
+      else
+        minMaxScalar(data, n, min, max);
+    }
+  };
+
+  template<class T, class SseOps>
+  struct MinMax<T, NoOps<T>, SseOps> {
+    static void run(const T* data, size_t n, T& min, T& max, VolumeKernels::InstructionSet set) {
+      if (set >= VolumeKernels::SSE2)
+        minMaxVector<SseOps>(data, n, min, max);
+      else
+        minMaxScalar(data, n, min, max);
+    }
+  };
+
+  template<class T>
+  struct MinMax<T, NoOps<T>, NoOps<T> > {
+    static void run(const T* data, size_t n, T& min, T& max, VolumeKernels::InstructionSet) {
+      minMaxScalar(data, n, min, max);
+    }
+  };
+
+#ifndef TGT_AVX2_KERNELS
+  // without AVX2 kernels the SSE2 ones are the best available
+  typedef NoOps<uint8_t> Avx2U8;
+  typedef NoOps<int8_t> Avx2I8;
+  typedef NoOps<uint16_t> Avx2U16;
+  typedef NoOps<int16_t> Avx2I16;
+  typedef NoOps<uint32_t> Avx2U32;
+  typedef NoOps<int32_t> Avx2I32;
+  typedef NoOps<float> Avx2F32;
+  typedef NoOps<double> Avx2F64;
+#endif
+
+  //------------------------------------------------------------------------------
+
+  VolumeKernels::InstructionSet detectInstructionSet() {
+    bool sse2 = false;
+    bool avx2 = false;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // the OS has to save the ymm registers on context switches
+    if (osxsave && avx && (maxLeaf >= 7) && ((_xgetbv(0) & 6) == 6)) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    sse2 = __builtin_cpu_supports("sse2") != 0;
+    avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+
+#ifdef TGT_AVX2_KERNELS
+    if (avx2)
+      return VolumeKernels::AVX2;
+#endif
+    if (sse2)
+      return VolumeKernels::SSE2;
+    return VolumeKernels::SCALAR;
+  }
+
+  const VolumeKernels::InstructionSet supportedSet = detectInstructionSet();
+  VolumeKernels::InstructionSet currentSet = supportedSet;
+
+} // namespace anonymous
+
+namespace tgt {
+
+  VolumeKernels::InstructionSet VolumeKernels::getSupportedInstructionSet() {
+    return supportedSet;
+  }
+
+  VolumeKernels::InstructionSet VolumeKernels::getInstructionSet() {
+    return currentSet;
+  }
+
+  void VolumeKernels::setInstructionSet(InstructionSet set) {
+    currentSet = std::min(set, supportedSet);
+  }
+
+  const char* VolumeKernels::getInstructionSetName(InstructionSet set) {
+    switch (set) {
+    case SSE2: return "SSE2";
+    case AVX2: return "AVX2";
+    default: return "scalar";
+    }
+  }
+
+  void VolumeKernels::swapBytes(void* data, size_t numElements, size_t elementSize) {
+    unsigned char* d = static_cast<unsigned char*>(data);
+    switch (currentSet) {
+#ifdef TGT_AVX2_KERNELS
+    case AVX2: Kernels<Avx2>::swapBytes(d, numElements, elementSize); break;
+#endif
+    case SSE2: Kernels<Sse2>::swapBytes(d, numElements, elementSize); break;
+    default: Kernels<Scalar>::swapBytes(d, numElements, elementSize);
+    }
+  }
+
+  void VolumeKernels::reverse(void* data, size_t numElements, size_t elementSize) {
+    unsigned char* d = static_cast<unsigned char*>(data);
+    switch (currentSet) {
+#ifdef TGT_AVX2_KERNELS
+    case AVX2: Kernels<Avx2>::reverse(d, numElements, elementSize); break;
+#endif
+    case SSE2: Kernels<Sse2>::reverse(d, numElements, elementSize); break;
+    default: Kernels<Scalar>::reverse(d, numElements, elementSize);
+    }
+  }
+
+  void VolumeKernels::reverseCopy(void* dst, const void* src, size_t numElements, size_t elementSize) {
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    switch (currentSet) {
+#ifdef TGT_AVX2_KERNELS
+    case AVX2: Kernels<Avx2>::reverseCopy(d, s, numElements, elementSize); break;
+#endif
+    case SSE2: Kernels<Sse2>::reverseCopy(d, s, numElements, elementSize); break;
+    default: Kernels<Scalar>::reverseCopy(d, s, numElements, elementSize);
+    }
+  }
+
+  void VolumeKernels::swapRanges(void* a, void* b, size_t numBytes) {
+    unsigned char* pa = static_cast<unsigned char*>(a);
+    unsigned char* pb = static_cast<unsigned char*>(b);
+    switch (currentSet) {
+#ifdef TGT_AVX2_KERNELS
+    case AVX2: Kernels<Avx2>::swapRanges(pa, pb, numBytes); break;
+#endif
+    case SSE2: Kernels<Sse2>::swapRanges(pa, pb, numBytes); break;
+    default: Kernels<Scalar>::swapRanges(pa, pb, numBytes);
+    }
+  }
+
+  void VolumeKernels::minMax(const uint8_t* data, size_t n, uint8_t& min, uint8_t& max) {
+    MinMax<uint8_t, Avx2U8, Sse2U8>::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const int8_t* data, size_t n, int8_t& min, int8_t& max) {
+    MinMax<int8_t, Avx2I8, Sse2I8>::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const uint16_t* data, size_t n, uint16_t& min, uint16_t& max) {
+    MinMax<uint16_t, Avx2U16, Sse2U16>::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const int16_t* data, size_t n, int16_t& min, int16_t& max) {
+    MinMax<int16_t, Avx2I16, Sse2I16>::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const uint32_t* data, size_t n, uint32_t& min, uint32_t& max) {
+    MinMax<uint32_t, Avx2U32, NoOps<uint32_t> >::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const int32_t* data, size_t n, int32_t& min, int32_t& max) {
+    MinMax<int32_t, Avx2I32, NoOps<int32_t> >::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const uint64_t* data, size_t n, uint64_t& min, uint64_t& max) {
+    MinMax<uint64_t, NoOps<uint64_t>, NoOps<uint64_t> >::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const int64_t* data, size_t n, int64_t& min, int64_t& max) {
+    MinMax<int64_t, NoOps<int64_t>, NoOps<int64_t> >::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const float* data, size_t n, float& min, float& max) {
+    MinMax<float, Avx2F32, Sse2F32>::run(data, n, min, max, currentSet);
+  }
+
+  void VolumeKernels::minMax(const double* data, size_t n, double& min, double& max) {
+    MinMax<double, Avx2F64, Sse2F64>::run(data, n, min, max, currentSet);
+  }
+
+} // end namespace tgt
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tgt {
+
+  /**
+  * Byte swap, axis reversal and min/max kernels for raw voxel buffers.
+  *
+  * Every kernel has a scalar, an SSE2 and an AVX2 implementation. The fastest instruction set
+  * supported by the CPU is selected at startup, it can be lowered with setInstructionSet(),
+  * e.g. for benchmarking. Element sizes of 1, 2, 4 and 8 bytes are vectorized, other sizes
+  * are handled by the scalar code.
+  */
+  class VolumeKernels {
+  public:
+    enum InstructionSet {
+      SCALAR,
+      SSE2,
+      AVX2
+    };
+
+    /// Returns the best instruction set supported by CPU and operating system.
+    TGT_API static InstructionSet getSupportedInstructionSet();
+
+    /// Returns the instruction set currently used by the kernels.
+    TGT_API static InstructionSet getInstructionSet();
+
+    /**
+    * Selects the instruction set used by the kernels. Sets that are not supported
+    * are reduced to the best supported one.
+    */
+    TGT_API static void setInstructionSet(InstructionSet set);
+
+    TGT_API static const char* getInstructionSetName(InstructionSet set);
+
+    /// Reverses the byte order of each of the \p numElements elements in place.
+    TGT_API static void swapBytes(void* data, size_t numElements, size_t elementSize);
+
+    /// Reverses the order of \p numElements elements in place, e.g. one row of a volume.
+    TGT_API static void reverse(void* data, size_t numElements, size_t elementSize);
+
+    /// Copies \p numElements elements from \p src to \p dst in reversed order. The buffers must not overlap.
+    TGT_API static void reverseCopy(void* dst, const void* src, size_t numElements, size_t elementSize);
+
+    /// Exchanges the contents of two non-overlapping buffers, e.g. two rows or slices of a volume.
+    TGT_API static void swapRanges(void* a, void* b, size_t numBytes);
+
+    /**
+    * Determines minimum and maximum of \p n values in a single pass. \p n must be greater than zero.
+    * The 64 bit integer types are always reduced by the scalar code.
+    */
+    TGT_API static void minMax(const uint8_t* data, size_t n, uint8_t& min, uint8_t& max);
+    TGT_API static void minMax(const int8_t* data, size_t n, int8_t& min, int8_t& max);
+    TGT_API static void minMax(const uint16_t* data, size_t n, uint16_t& min, uint16_t& max);
+    TGT_API static void minMax(const int16_t* data, size_t n, int16_t& min, int16_t& max);
+    TGT_API static void minMax(const uint32_t* data, size_t n, uint32_t& min, uint32_t& max);
+    TGT_API static void minMax(const int32_t* data, size_t n, int32_t& min, int32_t& max);
+    TGT_API static void minMax(const uint64_t* data, size_t n, uint64_t& min, uint64_t& max);
+    TGT_API static void minMax(const int64_t* data, size_t n, int64_t& min, int64_t& max);
+    TGT_API static void minMax(const float* data, size_t n, float& min, float& max);
+    TGT_API static void minMax(const double* data, size_t n, double& min, double& max);
+  };
+
+} // end namespace tgt
@@ -0,0 +1,336 @@
+#include "volumemask.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace tgt {
+
+  VolumeMaskDelta::VolumeMaskDelta()
+  {}
+
+  void VolumeMaskDelta::addBrick(size_t index, const uint32_t* xorRows) {
+    const int numRows = VolumeMask::BRICK_SIZE * VolumeMask::BRICK_SIZE;
+    const int numChanged = static_cast<int>(numRows - std::count(xorRows, xorRows + numRows, 0u));
+    if (numChanged == 0)
+      return;
+
+    Brick brick;
+    brick.index_ = index;
+    brick.firstRow_ = rows_.size();
+    brick.firstRowIndex_ = rowIndices_.size();
+
+    // a row index and a word per changed row, unless that takes more than all rows
+    if (numChanged * (sizeof(uint16_t) + sizeof(uint32_t)) < numRows * sizeof(uint32_t)) {
+      brick.numRows_ = numChanged;
+      for (int i = 0; i < numRows; ++i) {
+        if (xorRows[i]) {
+          rowIndices_.push_back(static_cast<uint16_t>(i));
+          rows_.push_back(xorRows[i]);
+        }
+      }
+    }
+    else {
+      brick.numRows_ = numRows;
+      rows_.insert(rows_.end(), xorRows, xorRows + numRows);
+    }
+    bricks_.push_back(brick);
+  }
+
+  void VolumeMaskDelta::addInvertedBrick(size_t index) {
+    Brick brick;
+    brick.index_ = index;
+    brick.numRows_ = 0;
+    brick.firstRow_ = rows_.size();
+    brick.firstRowIndex_ = rowIndices_.size();
+    bricks_.push_back(brick);
+  }
+
+  void VolumeMaskDelta::append(const VolumeMaskDelta& delta) {
+    for (size_t i = 0; i < delta.bricks_.size(); ++i) {
+      Brick brick = delta.bricks_[i];
+      brick.firstRow_ += rows_.size();
+      brick.firstRowIndex_ += rowIndices_.size();
+      bricks_.push_back(brick);
+    }
+    rowIndices_.insert(rowIndices_.end(), delta.rowIndices_.begin(), delta.rowIndices_.end());
+    rows_.insert(rows_.end(), delta.rows_.begin(), delta.rows_.end());
+  }
+
+  bool VolumeMaskDelta::isEmpty() const {
+    return bricks_.empty();
+  }
+
+  size_t VolumeMaskDelta::getNumBricks() const {
+    return bricks_.size();
+  }
+
+  size_t VolumeMaskDelta::getNumBytes() const {
+    return bricks_.capacity() * sizeof(Brick) + rowIndices_.capacity() * sizeof(uint16_t)
+      + rows_.capacity() * sizeof(uint32_t);
+  }
+
+  VolumeMask::VolumeMask(const glm::ivec3& dimensions)
+    : VolumeRepresentation(dimensions)
+  {
+    const int brickSize = BRICK_SIZE;
+    numBricks_ = (dimensions_ + brickSize - 1) / brickSize;
+    const size_t numBricks = static_cast<size_t>(numBricks_.x) * numBricks_.y * numBricks_.z;
+    states_.assign(numBricks, EMPTY);
+    bits_.resize(numBricks);
+    dirtyBricks_.assign(numBricks, 0);
+  }
+
+  size_t VolumeMask::getBytesPerVoxel() const {
+    return 1;
+  }
+
+  size_t VolumeMask::getNumBytes() const {
+    size_t bytes = states_.size() + dirtyBricks_.size() + bits_.size() * sizeof(bits_[0]);
+    for (size_t i = 0; i < bits_.size(); ++i)
+      bytes += bits_[i].size() * sizeof(uint32_t);
+    return bytes;
+  }
+
+  void VolumeMask::set(const glm::ivec3& pos) {
+    const int brickSize = BRICK_SIZE;
+    size_t brick = getBrickIndex(pos / brickSize);
+    if (states_[brick] == FULL)
+      return;
+
+    uint32_t* rows = editBrickRows(brick);
+    rows[(pos.z % BRICK_SIZE) * BRICK_SIZE + pos.y % BRICK_SIZE] |= 1u << (pos.x % BRICK_SIZE);
+  }
+
+  void VolumeMask::clear() {
+    for (size_t i = 0; i < states_.size(); ++i)
+      fillBrick(i, EMPTY);
+  }
+
+  bool VolumeMask::isEmpty() const {
+    for (size_t i = 0; i < states_.size(); ++i) {
+      if (states_[i] != EMPTY)
+        return false;
+    }
+    return true;
+  }
+
+  glm::ivec3 VolumeMask::getNumBricks() const {
+    return numBricks_;
+  }
+
+  glm::ivec3 VolumeMask::getBrickOffset(size_t index) const {
+    const int brickSize = BRICK_SIZE;
+    const int brick = static_cast<int>(index);
+    return glm::ivec3(brick % numBricks_.x, (brick / numBricks_.x) % numBricks_.y, brick / (numBricks_.x * numBricks_.y))
+      * brickSize;
+  }
+
+  VolumeMask::BrickState VolumeMask::getBrickState(size_t index) const {
+    return static_cast<BrickState>(states_[index]);
+  }
+
+  const uint32_t* VolumeMask::getBrickRows(size_t index) const {
+    return states_[index] == MIXED ? &bits_[index][0] : 0;
+  }
+
+  uint32_t* VolumeMask::editBrickRows(size_t index) {
+    std::vector<uint32_t>& rows = bits_[index];
+    if (states_[index] != MIXED) {
+      rows.assign(BRICK_SIZE * BRICK_SIZE, 0);
+      if (states_[index] == FULL) {
+        const uint32_t rowMask = getRowMask(index);
+        const glm::ivec2 extent = getRowExtent(index);
+        for (int z = 0; z < extent.y; ++z)
+          std::fill(rows.begin() + z * BRICK_SIZE, rows.begin() + z * BRICK_SIZE + extent.x, rowMask);
+      }
+      states_[index] = MIXED;
+    }
+    dirtyBricks_[index] = 1;
+    return &rows[0];
+  }
+
+  void VolumeMask::fillBrick(size_t index, BrickState state) {
+    assert(state != MIXED);
+    if (states_[index] == state)
+      return;
+
+    std::vector<uint32_t>().swap(bits_[index]);
+    states_[index] = static_cast<unsigned char>(state);
+    dirtyBricks_[index] = 1;
+  }
+
+  void VolumeMask::compactBrick(size_t index) {
+    if (states_[index] != MIXED)
+      return;
+
+    const std::vector<uint32_t>& rows = bits_[index];
+    const uint32_t rowMask = getRowMask(index);
+    const glm::ivec2 extent = getRowExtent(index);
+    bool empty = true;
+    bool full = true;
+    for (int z = 0; z < extent.y && (empty || full); ++z) {
+      for (int y = 0; y < extent.x; ++y) {
+        const uint32_t row = rows[z * BRICK_SIZE + y];
+        empty &= row == 0;
+        full &= row == rowMask;
+      }
+    }
+
+    if (empty || full) {
+      std::vector<uint32_t>().swap(bits_[index]);
+      states_[index] = static_cast<unsigned char>(empty ? EMPTY : FULL);
+    }
+  }
+
+  void VolumeMask::invertBrick(size_t index) {
+    if (states_[index] != MIXED) {
+      fillBrick(index, states_[index] == EMPTY ? FULL : EMPTY);
+      return;
+    }
+
+    uint32_t* rows = editBrickRows(index);
+    const uint32_t rowMask = getRowMask(index);
+    const glm::ivec2 extent = getRowExtent(index);
+    for (int z = 0; z < extent.y; ++z) {
+      for (int y = 0; y < extent.x; ++y)
+        rows[z * BRICK_SIZE + y] ^= rowMask;
+    }
+    compactBrick(index);
+  }
+
+  void VolumeMask::applyDelta(const VolumeMaskDelta& delta) {
+    for (size_t i = 0; i < delta.bricks_.size(); ++i) {
+      const VolumeMaskDelta::Brick& brick = delta.bricks_[i];
+      if (brick.numRows_ == 0) {
+        invertBrick(brick.index_);
+        continue;
+      }
+
+      uint32_t* rows = editBrickRows(brick.index_);
+      const uint32_t* xorRows = &delta.rows_[brick.firstRow_];
+      if (brick.numRows_ == BRICK_SIZE * BRICK_SIZE) {
+        for (int row = 0; row < brick.numRows_; ++row)
+          rows[row] ^= xorRows[row];
+      }
+      else {
+        const uint16_t* rowIndices = &delta.rowIndices_[brick.firstRowIndex_];
+        for (int row = 0; row < brick.numRows_; ++row)
+          rows[rowIndices[row]] ^= xorRows[row];
+      }
+      compactBrick(brick.index_);
+    }
+  }
+
+  void VolumeMask::pack(const glm::ivec3& llf, const glm::ivec3& urb, std::vector<uint32_t>& words) const {
+    assert(llf.x % BRICK_SIZE == 0);
+    const glm::ivec3 size = urb - llf;
+    const int numWords = getNumWords(size.x);
+    words.assign(static_cast<size_t>(numWords) * size.y * size.z, 0);
+
+    size_t i = 0;
+    for (int z = llf.z; z < urb.z; ++z) {
+      for (int y = llf.y; y < urb.y; ++y) {
+        for (int w = 0; w < numWords; ++w, ++i) {
+          size_t brick = getBrickIndex(glm::ivec3(llf.x / BRICK_SIZE + w, y / BRICK_SIZE, z / BRICK_SIZE));
+          if (states_[brick] == FULL)
+            words[i] = getRowMask(brick);
+          else if (states_[brick] == MIXED)
+            words[i] = bits_[brick][(z % BRICK_SIZE) * BRICK_SIZE + y % BRICK_SIZE];
+        }
+      }
+    }
+  }
+
+  void VolumeMask::unpack(const uint32_t* words, const glm::ivec3& wordDimensions, VolumeMaskDelta* delta) {
+    assert(wordDimensions.x >= getNumWords(dimensions_.x));
+    unpackBricks(words, wordDimensions, glm::ivec3(0), numBricks_, delta);
+  }
+
+  void VolumeMask::unpackBricks(const uint32_t* words, const glm::ivec3& wordDimensions,
+    const glm::ivec3& firstBrick, const glm::ivec3& endBrick, VolumeMaskDelta* delta) {
+    const int brickSize = BRICK_SIZE;
+    const glm::ivec3 origin = firstBrick * brickSize;
+    std::vector<uint32_t> rows;
+    for (int bz = firstBrick.z; bz < endBrick.z; ++bz) {
+      for (int by = firstBrick.y; by < endBrick.y; ++by) {
+        for (int bx = firstBrick.x; bx < endBrick.x; ++bx) {
+          const size_t brick = getBrickIndex(glm::ivec3(bx, by, bz));
+          const glm::ivec3 offset = getBrickOffset(brick) - origin;
+          const glm::ivec2 extent = getRowExtent(brick);
+          const uint32_t rowMask = getRowMask(brick);
+
+          rows.assign(BRICK_SIZE * BRICK_SIZE, 0);
+          for (int z = 0; z < extent.y; ++z) {
+            for (int y = 0; y < extent.x; ++y) {
+              size_t word = (static_cast<size_t>(offset.z + z) * wordDimensions.y + offset.y + y) * wordDimensions.x
+                + offset.x / BRICK_SIZE;
+              rows[z * BRICK_SIZE + y] = words[word] & rowMask;
+            }
+          }
+          replaceBrick(brick, rows, delta);
+        }
+      }
+    }
+  }
+
+  void VolumeMask::replaceBrick(size_t brick, std::vector<uint32_t>& rows, VolumeMaskDelta* delta) {
+    const glm::ivec2 extent = getRowExtent(brick);
+    const uint32_t rowMask = getRowMask(brick);
+
+    // only bricks whose content changed are marked as modified
+    const unsigned char previousState = states_[brick];
+    bits_[brick].swap(rows);
+    states_[brick] = MIXED;
+    compactBrick(brick);
+    if (states_[brick] == previousState && bits_[brick] == rows)
+      return;
+    dirtyBricks_[brick] = 1;
+
+    if (!delta)
+      return;
+
+    if (previousState != MIXED && states_[brick] != MIXED) {
+      delta->addInvertedBrick(brick);
+      return;
+    }
+
+    // rows holds the previous bits now, expanded if the brick was uniform
+    if (previousState != MIXED)
+      rows.assign(BRICK_SIZE * BRICK_SIZE, 0);
+    if (previousState == FULL) {
+      for (int z = 0; z < extent.y; ++z)
+        std::fill(rows.begin() + z * BRICK_SIZE, rows.begin() + z * BRICK_SIZE + extent.x, rowMask);
+    }
+    if (states_[brick] == MIXED) {
+      for (size_t i = 0; i < rows.size(); ++i)
+        rows[i] ^= bits_[brick][i];
+    }
+    else if (states_[brick] == FULL) {
+      for (int z = 0; z < extent.y; ++z) {
+        for (int y = 0; y < extent.x; ++y)
+          rows[z * BRICK_SIZE + y] ^= rowMask;
+      }
+    }
+    delta->addBrick(brick, &rows[0]);
+  }
+
+  bool VolumeMask::isDirty() const {
+    return std::find(dirtyBricks_.begin(), dirtyBricks_.end(), 1) != dirtyBricks_.end();
+  }
+
+  std::vector<VolumeMask::Region> VolumeMask::takeDirtyRegions() {
+    return takeBrickRegions(dirtyBricks_, BRICK_SIZE);
+  }
+
+  uint32_t VolumeMask::getRowMask(size_t index) const {
+    const int voxels = std::min(dimensions_.x - getBrickOffset(index).x, static_cast<int>(BRICK_SIZE));
+    return voxels >= 32 ? 0xffffffffu : (1u << voxels) - 1u;
+  }
+
+  glm::ivec2 VolumeMask::getRowExtent(size_t index) const {
+    const int brickSize = BRICK_SIZE;
+    const glm::ivec3 offset = getBrickOffset(index);
+    return glm::min(glm::ivec2(dimensions_.y - offset.y, dimensions_.z - offset.z), glm::ivec2(brickSize));
+  }
+
+} // end namespace tgt
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "volumerepresentation.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace tgt {
+
+  /**
+  * Changes of a VolumeMask, recorded per brick as the XOR of the bits before and after the change.
+  * Applying a delta with VolumeMask::applyDelta() toggles the recorded bits, so the same delta both
+  * reverts and repeats the change. Bricks that switched between EMPTY and FULL are stored without bits,
+  * of the others only the changed rows are kept unless most rows changed.
+  */
+  class VolumeMaskDelta {
+  public:
+    TGT_API VolumeMaskDelta();
+
+    /// Records the brick \p index whose bits changed by \p xorRows, BRICK_SIZE^2 rows as in VolumeMask.
+    TGT_API void addBrick(size_t index, const uint32_t* xorRows);
+
+    /// Records that the brick \p index switched between EMPTY and FULL.
+    TGT_API void addInvertedBrick(size_t index);
+
+    /// Appends the bricks of \p delta, which must not contain bricks of this delta.
+    TGT_API void append(const VolumeMaskDelta& delta);
+
+    TGT_API bool isEmpty() const;
+
+    /// Number of recorded bricks.
+    TGT_API size_t getNumBricks() const;
+
+    /// Number of bytes allocated for the recorded bricks.
+    TGT_API size_t getNumBytes() const;
+
+  private:
+    friend class VolumeMask;
+
+    struct Brick {
+      size_t index_;
+      int numRows_;       ///< 0 for inverted bricks, BRICK_SIZE^2 if all rows are stored
+      size_t firstRow_;       ///< into rows_
+      size_t firstRowIndex_;  ///< into rowIndices_, only used if not all rows are stored
+    };
+
+    std::vector<Brick> bricks_;
+    std::vector<uint16_t> rowIndices_;  ///< rows stored for sparse bricks
+    std::vector<uint32_t> rows_;
+  };
+
+  /**
+  * Binary volume with one bit per voxel, used as the sculpting mask: a set bit marks a removed voxel.
+  *
+  * The voxels are grouped into bricks of BRICK_SIZE^3 voxels. Bricks without removed voxels (EMPTY)
+  * or with all voxels removed (FULL) are stored as a single state, only MIXED bricks hold their bits,
+  * one 32 bit word per row of a brick. Bit i of a row is voxel x = brick.x * BRICK_SIZE + i.
+  *
+  * Different bricks may be modified by different threads at the same time.
+  */
+  class VolumeMask : public VolumeRepresentation {
+  public:
+    /// Edge length of the bricks, a brick row fits into one 32 bit word.
+    static const int BRICK_SIZE = 32;
+
+    enum BrickState {
+      EMPTY = 0,    ///< no voxel of the brick is set
+      FULL,         ///< all voxels of the brick are set
+      MIXED         ///< the voxels are stored as bits
+    };
+
+    /// Creates a mask without set voxels.
+    TGT_API VolumeMask(const glm::ivec3& dimensions);
+
+    /// The bits do not fill whole bytes, the voxel size is rounded up to one byte.
+    TGT_API virtual size_t getBytesPerVoxel() const;
+
+    /// Number of bytes currently allocated for the brick states and the bits of the mixed bricks.
+    TGT_API size_t getNumBytes() const;
+
+    /// Returns whether the voxel at \p pos is set.
+    bool test(const glm::ivec3& pos) const {
+      const int brickSize = BRICK_SIZE;
+      size_t brick = getBrickIndex(pos / brickSize);
+      if (states_[brick] != MIXED)
+        return states_[brick] == FULL;
+      const uint32_t row = bits_[brick][(pos.z % BRICK_SIZE) * BRICK_SIZE + pos.y % BRICK_SIZE];
+      return ((row >> (pos.x % BRICK_SIZE)) & 1u) != 0;
+    }
+
+    /// Sets the voxel at \p pos and marks its brick as modified.
+    TGT_API void set(const glm::ivec3& pos);
+
+    /// Resets all voxels and marks the whole mask as modified.
+    TGT_API void clear();
+
+    /// Returns whether no voxel is set.
+    TGT_API bool isEmpty() const;
+
+    /// Number of bricks along each axis, bricks at the upper borders may be partial.
+    TGT_API glm::ivec3 getNumBricks() const;
+
+    /// Index of the brick with brick coordinates \p brick, x-fastest.
+    size_t getBrickIndex(const glm::ivec3& brick) const {
+      return (static_cast<size_t>(brick.z) * numBricks_.y + brick.y) * numBricks_.x + brick.x;
+    }
+
+    /// Returns the first voxel of the brick \p index.
+    TGT_API glm::ivec3 getBrickOffset(size_t index) const;
+
+    TGT_API BrickState getBrickState(size_t index) const;
+
+    /// Returns the BRICK_SIZE^2 rows of the brick \p index (y-fastest) or null if the brick is EMPTY or FULL.
+    TGT_API const uint32_t* getBrickRows(size_t index) const;
+
+    /**
+    * Returns the rows of the brick \p index for modification. A uniform brick is expanded to MIXED first,
+    * bits of voxels beyond the volume border stay zero. Marks the brick as modified, call compactBrick()
+    * when done.
+    */
+    TGT_API uint32_t* editBrickRows(size_t index);
+
+    /// Sets the brick \p index to EMPTY or FULL and marks it as modified.
+    TGT_API void fillBrick(size_t index, BrickState state);
+
+    /// Turns the MIXED brick \p index into an EMPTY or FULL brick if its bits allow it.
+    TGT_API void compactBrick(size_t index);
+
+    /// Toggles all voxels of the brick \p index inside the volume.
+    TGT_API void invertBrick(size_t index);
+
+    /**
+    * Toggles the bits recorded by \p delta, which takes time proportional to the size of the delta.
+    * Marks the bricks as modified.
+    */
+    TGT_API void applyDelta(const VolumeMaskDelta& delta);
+
+    /// Number of 32 bit words needed for \p numVoxels voxels of a row, see pack().
+    static int getNumWords(int numVoxels) {
+      return (numVoxels + 31) / 32;
+    }
+
+    /**
+    * Packs the voxels of the box [llf, urb) into 32 bit words for the upload into an integer texture,
+    * bit i of word w of row (y, z) is voxel (llf.x + 32 * w + i, llf.y + y, llf.z + z). \p llf.x has
+    * to be a multiple of BRICK_SIZE. The rows of the box are stored consecutively.
+    */
+    TGT_API void pack(const glm::ivec3& llf, const glm::ivec3& urb, std::vector<uint32_t>& words) const;
+
+    /**
+    * Replaces the mask by the words of the whole volume, packed as by pack(). Rows are strided by
+    * \p wordDimensions.x words and slices by \p wordDimensions.y rows, e.g. for a downloaded texture.
+    * The changed bricks are marked as modified and, if \p delta is given, recorded in it.
+    */
+    TGT_API void unpack(const uint32_t* words, const glm::ivec3& wordDimensions, VolumeMaskDelta* delta = 0);
+
+    /**
+    * Replaces the bricks [firstBrick, endBrick) like unpack(), \p words holds their box only and starts
+    * with the first row of \p firstBrick, e.g. for a region downloaded from the texture.
+    */
+    TGT_API void unpackBricks(const uint32_t* words, const glm::ivec3& wordDimensions,
+      const glm::ivec3& firstBrick, const glm::ivec3& endBrick, VolumeMaskDelta* delta = 0);
+
+    TGT_API bool isDirty() const;
+
+    /// Returns the modified bricks merged into boxes and clears the record.
+    TGT_API std::vector<Region> takeDirtyRegions();
+
+  private:
+    /// Word of a brick row with the bits of the voxels inside the volume set.
+    uint32_t getRowMask(size_t index) const;
+
+    /// Number of rows along y and z of the brick \p index inside the volume.
+    glm::ivec2 getRowExtent(size_t index) const;
+
+    /// Sets the rows of \p brick, which receives its previous rows, and records a change in \p delta.
+    void replaceBrick(size_t brick, std::vector<uint32_t>& rows, VolumeMaskDelta* delta);
+
+    glm::ivec3 numBricks_;
+    std::vector<unsigned char> states_;         ///< BrickState of every brick
+    std::vector<std::vector<uint32_t> > bits_;  ///< rows of the MIXED bricks, empty for the others
+    std::vector<unsigned char> dirtyBricks_;    ///< modified bricks, see takeDirtyRegions()
+  };
+
+} // end namespace tgt
@@ -1,7 +1,9 @@
 #include "volumeminmax.h"
 #include "volume.h"
 #include "volumeram.h"
+#include "volumebricked.h"
 #include "valuemapping.h"
+#include "volumehistogram.h"
 
 namespace tgt {
 
@@ -19,11 +21,19 @@ namespace tgt {
 
     float min = 0.f;
     float max = 1.f;
-    const VolumeRAM* v = handle->getRepresentation<VolumeRAM>();
-    assert(v);
-
-    min = v->minValue();
-    max = v->maxValue();
+    const VolumeBricked* volumeBricked = handle->hasRepresentation<VolumeRAM>() ? 0 : handle->hasRepresentation<VolumeBricked>();
+    const VolumeRAM* volumeRam = volumeBricked ? 0 : handle->getRepresentation<VolumeRAM>();
+    assert(volumeRam || volumeBricked);
+
+    if (handle->hasDerivedData<VolumeHistogramIntensity>()) {
+      min = volumeRam ? volumeRam->minValue() : volumeBricked->minValue();
+      max = volumeRam ? volumeRam->maxValue() : volumeBricked->maxValue();
+    }
+    else {
+      // the intensity histogram comes out of the same sweep, so keep it as well
+      Histogram1D histogram = createHistogram1DAndMinMaxFromVolume(handle, static_cast<size_t>(256), min, max);
+      handle->addMissingDerivedDataInternal(new VolumeHistogramIntensity(histogram));
+    }
 
     assert(min <= max);
 
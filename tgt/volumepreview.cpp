@@ -1,6 +1,7 @@
 #include "volumepreview.h"
 #include "volume.h"
 #include "volumeram.h"
+#include "volumebricked.h"
 
 #include <algorithm>
 
@@ -49,16 +50,18 @@ namespace tgt {
     float maxVal, minVal;
     std::vector<float> prevData = std::vector<float>(internHeight * internHeight);
 
-    const VolumeRAM* volumeRam = 0;
-    volumeRam = handle->getRepresentation<VolumeRAM>();
-    assert(volumeRam);
+    // volumes that do not fit into memory are only available as bricks
+    const VolumeBricked* volumeBricked = handle->hasRepresentation<VolumeRAM>() ? 0 : handle->hasRepresentation<VolumeBricked>();
+    const VolumeRAM* volumeRam = volumeBricked ? 0 : handle->getRepresentation<VolumeRAM>();
+    assert(volumeRam || volumeBricked);
 
     glm::vec3 position;
     position.z = glm::floor((handle->getDimensions().z - 1) / 2.0f);
 
     // generate preview in float buffer
-    minVal = volumeRam->elementRange().y;
-    maxVal = volumeRam->elementRange().x;
+    glm::vec2 range = volumeRam ? volumeRam->elementRange() : volumeBricked->elementRange();
+    minVal = range.y;
+    maxVal = range.x;
     for (int y = 0; y < internHeight; y++){
       for (int x = 0; x < internHeight; x++){
         position.x = ((x - xOffset) / (internHeight - 1)) * xScale * (xDimension - 1.f);
@@ -66,7 +69,7 @@ namespace tgt {
         int previewIndex = y*internHeight + x;
         float val = 0.f;
         if (position.x >= 0 && position.y >= 0 && position.x < xDimension && position.y < yDimension)
-          val = volumeRam->getVoxelNormalizedLinear(position);
+          val = volumeRam ? volumeRam->getVoxelNormalizedLinear(position) : volumeBricked->getVoxelNormalizedLinear(position);
         prevData[previewIndex] = val;
         minVal = std::min(minVal, val);
         maxVal = std::max(maxVal, val);
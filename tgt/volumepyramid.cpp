@@ -0,0 +1,95 @@
+#include "volumepyramid.h"
+#include "volume.h"
+#include "volumeram.h"
+#include "logmanager.h"
+
+#include <new>
+
+namespace tgt {
+
+  const std::string VolumePyramid::loggerCat_("VolumePyramid");
+
+  VolumePyramid::VolumePyramid()
+    : VolumeDerivedData()
+  {}
+
+  VolumePyramid::~VolumePyramid() {
+    for (size_t i = 0; i < levels_.size(); ++i)
+      delete levels_[i];
+  }
+
+  VolumeDerivedData* VolumePyramid::createFrom(Volume* handle) const {
+    assert(handle);
+
+    const VolumeRAM* source = handle->hasRepresentation<VolumeRAM>();
+    if (!source)
+      return 0;
+
+    VolumePyramid* result = new VolumePyramid();
+    try {
+      for (int level = 1; level <= MAX_LEVEL; ++level) {
+        if (glm::hmax((source->getDimensions() + 1) / 2) < MIN_LEVEL_SIZE)
+          break;
+
+        VolumeRAM* downsampled = source->createDownsampled();
+        result->levels_.push_back(new Volume(downsampled, glm::vec3(1.f), glm::vec3(0.f)));
+        source = downsampled;
+      }
+    }
+    catch (std::bad_alloc&) {
+      LWARNING("Not enough memory for all levels, keeping " << result->levels_.size());
+    }
+
+    result->updateMetaData(handle);
+    return result;
+  }
+
+  int VolumePyramid::getNumLevels() const {
+    return static_cast<int>(levels_.size());
+  }
+
+  Volume* VolumePyramid::getLevel(int level) const {
+    assert(level >= 1 && level <= getNumLevels());
+    return levels_[level - 1];
+  }
+
+  int VolumePyramid::selectLevel(const glm::ivec2& imageSize) const {
+    const int pixels = glm::hmax(imageSize);
+    int result = 0;
+    for (int level = 1; level <= getNumLevels(); ++level) {
+      if (glm::hmax(getLevel(level)->getDimensions()) < pixels)
+        break;
+      result = level;
+    }
+    return result;
+  }
+
+  void VolumePyramid::updateMetaData(Volume* handle) const {
+    for (size_t i = 0; i < levels_.size(); ++i) {
+      Volume* level = levels_[i];
+      level->setSpacing(handle->getCubeSize() / glm::vec3(level->getDimensions()));
+      level->setOffset(handle->getOffset());
+      level->setPhysicalToWorldMatrix(handle->getPhysicalToWorldMatrix());
+      level->setRescaleIntercept(handle->getRescaleIntercept());
+      level->setRescaleSlope(handle->getRescaleSlope());
+      level->setWindowCenter(handle->getWindowCenter());
+      level->setWindowWidth(handle->getWindowWidth());
+    }
+  }
+
+  bool VolumePyramid::isMetaDataCurrent(Volume* handle) const {
+    // all levels are updated together, so the first one stands for the others
+    if (levels_.empty())
+      return true;
+
+    Volume* level = levels_[0];
+    return level->getSpacing() == handle->getCubeSize() / glm::vec3(level->getDimensions())
+      && level->getOffset() == handle->getOffset()
+      && level->getPhysicalToWorldMatrix() == handle->getPhysicalToWorldMatrix()
+      && level->getRescaleIntercept() == handle->getRescaleIntercept()
+      && level->getRescaleSlope() == handle->getRescaleSlope()
+      && level->getWindowCenter() == handle->getWindowCenter()
+      && level->getWindowWidth() == handle->getWindowWidth();
+  }
+
+} // end namespace tgt
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "volumederiveddata.h"
+#include "tgt_math.h"
+
+#include <vector>
+
+namespace tgt {
+
+  /**
+  * Downsampled copies of a volume for rendering during interaction.
+  *
+  * Level i has 1/2^i of the resolution of the volume along each axis, each level is box filtered
+  * from the previous one by VolumeRAM::createDownsampled(). Every level is a Volume of its own that
+  * covers the same physical extent as the source, so it can be bound in place of the source with
+  * a correspondingly larger sampling step. Levels are only built while their largest dimension
+  * is at least MIN_LEVEL_SIZE.
+  */
+  class VolumePyramid : public VolumeDerivedData {
+  public:
+    static const int MAX_LEVEL = 3;
+    static const int MIN_LEVEL_SIZE = 32;
+
+    /// Empty default constructor required by VolumeDerivedData interface.
+    TGT_API VolumePyramid();
+
+    /// Deletes the level volumes.
+    TGT_API virtual ~VolumePyramid();
+
+    /// Returns null if the volume is not available in RAM.
+    TGT_API virtual VolumeDerivedData* createFrom(Volume* handle) const;
+
+    /// Number of downsampled levels, level 0 (the volume itself) is not counted.
+    TGT_API int getNumLevels() const;
+
+    /// Returns the volume of level 1 to getNumLevels().
+    TGT_API Volume* getLevel(int level) const;
+
+    /**
+    * Selects the coarsest level that still has at least one voxel per pixel along the largest
+    * dimension when the volume fills \p imageSize, 0 if the volume itself should be used.
+    */
+    TGT_API int selectLevel(const glm::ivec2& imageSize) const;
+
+    /**
+    * Copies spacing, offset, transformation and value mapping of \p handle to the levels,
+    * with the spacing scaled so that every level covers the physical extent of \p handle.
+    */
+    TGT_API void updateMetaData(Volume* handle) const;
+
+    /// Returns true if the levels carry the current meta data of \p handle, see updateMetaData().
+    TGT_API bool isMetaDataCurrent(Volume* handle) const;
+
+  private:
+    // not copyable
+    VolumePyramid(const VolumePyramid&);
+    VolumePyramid& operator=(const VolumePyramid&);
+
+    std::vector<Volume*> levels_;  ///< level i + 1 at index i
+
+    static const std::string loggerCat_;
+  };
+
+} // end namespace tgt
@@ -1,9 +1,12 @@
 #include "volumeram.h"
 
+#include <algorithm>
+
 namespace tgt {
 
   VolumeRAM::VolumeRAM(const glm::ivec3& dimensions)
     : VolumeRepresentation(dimensions)
+    , dirty_(false)
   {}
 
     float VolumeRAM::getVoxelNormalizedLinear(const glm::vec3& pos) const {
@@ -27,4 +30,42 @@ namespace tgt {
           + getVoxelNormalized(glm::ivec3(llb.x, urf.y, urf.z)) * (1.f-p.x)*(    p.y)*(    p.z);// ulF
   }
 
+  void VolumeRAM::markDirty(const glm::ivec3& llf, const glm::ivec3& urb) {
+    glm::ivec3 first = glm::max(llf, glm::ivec3(0));
+    glm::ivec3 end = glm::min(urb, dimensions_);
+    if (glm::any(glm::greaterThanEqual(first, end)))
+      return;
+
+    const int brickSize = DIRTY_BRICK_SIZE;
+    const glm::ivec3 bricks = (dimensions_ + brickSize - 1) / brickSize;
+    if (dirtyBricks_.empty())
+      dirtyBricks_.assign(static_cast<size_t>(bricks.x) * bricks.y * bricks.z, 0);
+
+    first /= brickSize;
+    end = (end + brickSize - 1) / brickSize;
+    for (int z = first.z; z < end.z; ++z) {
+      for (int y = first.y; y < end.y; ++y) {
+        size_t row = (static_cast<size_t>(z) * bricks.y + y) * bricks.x;
+        std::fill(dirtyBricks_.begin() + row + first.x, dirtyBricks_.begin() + row + end.x, 1);
+      }
+    }
+    dirty_ = true;
+  }
+
+  void VolumeRAM::markDirty() {
+    markDirty(glm::ivec3(0), dimensions_);
+  }
+
+  bool VolumeRAM::isDirty() const {
+    return dirty_;
+  }
+
+  std::vector<VolumeRAM::Region> VolumeRAM::takeDirtyRegions() {
+    if (!dirty_)
+      return std::vector<Region>();
+
+    dirty_ = false;
+    return takeBrickRegions(dirtyBricks_, DIRTY_BRICK_SIZE);
+  }
+
 } // end namespace tgt
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include "volumerepresentation.h"
 
+#include <vector>
+#include <stdint.h>
+
 namespace tgt {
 
   /**
@@ -14,6 +17,9 @@ namespace tgt {
   */
   class VolumeRAM : public VolumeRepresentation {
   public:
+    /// Edge length of the bricks modifications are tracked with.
+    static const int DIRTY_BRICK_SIZE = 16;
+
     TGT_API VolumeRAM(const glm::ivec3& dimensions);
 
     TGT_API virtual ~VolumeRAM() {}
@@ -53,16 +59,63 @@ namespace tgt {
     TGT_API virtual const void* getData() const = 0;
     TGT_API virtual void* getData() = 0;
 
+    /// Returns true, if the voxel data is backed by a memory mapped file, i.e. only read from disk when touched.
+    TGT_API virtual bool isMemoryMapped() const = 0;
+
     TGT_API virtual float minValue() const = 0;
     TGT_API virtual float maxValue() const = 0;
 
+    /**
+    * Fills \p buckets with the histogram of all voxel values over [min, max], the size
+    * of \p buckets determines the bucket count. Values outside the range are counted
+    * in the first or last bucket.
+    */
+    TGT_API virtual void computeHistogram(float min, float max, std::vector<uint64_t>& buckets) const = 0;
+
+    /**
+    * Determines min and max of the voxel values, which are then returned by minValue() and maxValue(),
+    * and fills \p buckets with the histogram over [min, max] in the same sweep.
+    */
+    TGT_API virtual void computeMinMaxHistogram(std::vector<uint64_t>& buckets) const = 0;
+
+    /**
+    * Determines min and max of the voxel values of every brick of \p brickSize^3 voxels.
+    * Neighbouring bricks share one layer of voxels, see VolumeBrickMinMax.
+    */
+    TGT_API virtual void computeBrickMinMax(int brickSize, std::vector<float>& minValues, std::vector<float>& maxValues) const = 0;
+
+    /**
+    * Returns a new volume of the same type with half the resolution, rounded up. Each voxel is the
+    * average of 2x2x2 voxels, voxels beyond the upper border of odd dimensions are clamped to the border.
+    */
+    TGT_API virtual VolumeRAM* createDownsampled() const = 0;
+
     TGT_API virtual float getVoxelNormalized(const glm::ivec3& pos) const = 0;
     TGT_API virtual float getVoxel(const glm::ivec3& pos) const = 0;
     TGT_API virtual float getVoxelNormalizedLinear(const glm::vec3& pos) const;
 
+    /**
+    * Records that the voxels in [llf, urb) have been modified, so copies of the data like a
+    * VolumeGL can be updated partially, see Volume::SyncData(). The box is extended to whole
+    * bricks of DIRTY_BRICK_SIZE^3 voxels. Not thread-safe.
+    */
+    TGT_API void markDirty(const glm::ivec3& llf, const glm::ivec3& urb);
+
+    /// Records that the whole volume has been modified.
+    TGT_API void markDirty();
+
+    TGT_API bool isDirty() const;
+
+    /// Returns the modified bricks merged into boxes and clears the record.
+    TGT_API std::vector<Region> takeDirtyRegions();
+
   protected:
     // protected default constructor
-    VolumeRAM() {}
+    VolumeRAM() : dirty_(false) {}
+
+  private:
+    std::vector<unsigned char> dirtyBricks_;  ///< modified bricks, x-fastest, allocated on first use
+    bool dirty_;
   };
 
 } // end namespace tgt
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "logmanager.h"
 #include "volumeram.h"
+#include "volumekernels.h"
 
 namespace tgt {
 
@@ -22,26 +23,13 @@ namespace tgt {
 
     size_t bytesPerVoxel = volume->getBytesPerVoxel();
     const glm::ivec3 dim = volume->getDimensions();
+    size_t rowSize = dim.x * bytesPerVoxel;
 
     typedef unsigned char BYTE;
     BYTE* const data = reinterpret_cast<BYTE* const>(volume->getData());
-    BYTE* aux = new BYTE[bytesPerVoxel];
-
-    for (int x = 0; x < (dim.x / 2); ++x) {
-      int _x = (dim.x - (x + 1));
-      for (int z = 0; z < dim.z; ++z) {
-        int a = (z * (dim.x * dim.y));
-        for (int y = 0; y < dim.y; ++y) {
-          int b = (y * dim.x);
-          int l = a + b + x;
-          int r = a + b + _x;
-          memcpy(aux, (data + (l * bytesPerVoxel)), bytesPerVoxel);
-          memcpy((data + (l * bytesPerVoxel)), (data + (r * bytesPerVoxel)), bytesPerVoxel);
-          memcpy((data + (r * bytesPerVoxel)), aux, bytesPerVoxel);
-        }
-      }
-    }
-    delete[] aux;
+    size_t numRows = static_cast<size_t>(dim.y) * dim.z;
+    for (size_t row = 0; row < numRows; ++row)
+      VolumeKernels::reverse(data + row * rowSize, dim.x, bytesPerVoxel);
   }
 
   void VolumeReader::reverseYSliceOrder(VolumeRAM* const volume) const {
@@ -50,27 +38,16 @@ namespace tgt {
 
     size_t bytesPerVoxel = volume->getBytesPerVoxel();
     const glm::ivec3 dim = volume->getDimensions();
+    size_t rowSize = dim.x * bytesPerVoxel;
+    size_t sliceSize = dim.y * rowSize;
 
     typedef unsigned char BYTE;
     BYTE* const data = reinterpret_cast<BYTE* const>(volume->getData());
-    BYTE* aux = new BYTE[bytesPerVoxel];
-
-    for (int y = 0; y < (dim.y / 2); ++y) {
-      int _y = (dim.y - (y + 1));
-      int b = (y * dim.x);
-      int _b = (_y * dim.x);
-      for (int z = 0; z < dim.z; ++z) {
-        int a = (z * (dim.x * dim.y));
-        for (int x = 0; x < dim.x; ++x) {
-          int l = a + b + x;
-          int r = a + _b + x;
-          memcpy(aux, (data + (l * bytesPerVoxel)), bytesPerVoxel);
-          memcpy((data + (l * bytesPerVoxel)), (data + (r * bytesPerVoxel)), bytesPerVoxel);
-          memcpy((data + (r * bytesPerVoxel)), aux, bytesPerVoxel);
-        }
-      }
+    for (int z = 0; z < dim.z; ++z) {
+      BYTE* slice = data + z * sliceSize;
+      for (int y = 0; y < (dim.y / 2); ++y)
+        VolumeKernels::swapRanges(slice + y * rowSize, slice + (dim.y - (y + 1)) * rowSize, rowSize);
     }
-    delete[] aux;
   }
 
   void VolumeReader::reverseZSliceOrder(VolumeRAM* const volume) const {
@@ -83,22 +60,8 @@ namespace tgt {
 
     typedef unsigned char BYTE;
     BYTE* const data = reinterpret_cast<BYTE* const>(volume->getData());
-    BYTE* aux = new BYTE[sliceSize];
-    for (int z = 0; z < dim.z / 2; ++z) {
-      // copy slice i to auxiliary buffer
-      //
-      memcpy(aux, (data + (z * sliceSize)), sliceSize);
-
-      // copy slice r = (dim.z - 1 - i) to position i
-      //
-      int r = (dim.z - (z + 1));
-      memcpy((data + (z * sliceSize)), (data + (r * sliceSize)), sliceSize);
-
-      // copy auxiliary buffer back to position r
-      //
-      memcpy((data + (r * sliceSize)), aux, sliceSize);
-    }
-    delete[] aux;
+    for (int z = 0; z < dim.z / 2; ++z)
+      VolumeKernels::swapRanges(data + z * sliceSize, data + (dim.z - (z + 1)) * sliceSize, sliceSize);
   }
 
   const std::vector<std::string>& VolumeReader::getSupportedProtocols() const {
@@ -1,5 +1,7 @@
 #include "volumerepresentation.h"
 
+#include <algorithm>
+
 namespace tgt {
 
   VolumeRepresentation::VolumeRepresentation(const glm::ivec3& dimensions)
@@ -16,4 +18,74 @@ namespace tgt {
     return numVoxels_;
   }
 
+  std::vector<VolumeRepresentation::Region> VolumeRepresentation::takeBrickRegions(std::vector<unsigned char>& bricks,
+    int brickSize) const
+  {
+    const glm::ivec3 numBricks = (dimensions_ + brickSize - 1) / brickSize;
+    if (bricks.size() != static_cast<size_t>(numBricks.x) * numBricks.y * numBricks.z)
+      return std::vector<Region>();
+
+    // bricks to voxels, the last bricks may be cut off by the volume
+    std::vector<Region> regions = mergeBricks(bricks, numBricks);
+    for (size_t i = 0; i < regions.size(); ++i) {
+      regions[i].llf_ *= brickSize;
+      regions[i].urb_ = glm::min(regions[i].urb_ * brickSize, dimensions_);
+    }
+    return regions;
+  }
+
+  std::vector<VolumeRepresentation::Region> mergeBricks(std::vector<unsigned char>& bricks,
+    const glm::ivec3& numBricks)
+  {
+    std::vector<VolumeRepresentation::Region> regions;
+
+    auto isSet = [&](int x, int y, int z) {
+      return bricks[(static_cast<size_t>(z) * numBricks.y + y) * numBricks.x + x] != 0;
+    };
+
+    // bricks are cleared as soon as they are part of a box
+    for (int z = 0; z < numBricks.z; ++z) {
+      for (int y = 0; y < numBricks.y; ++y) {
+        for (int x = 0; x < numBricks.x; ++x) {
+          if (!isSet(x, y, z))
+            continue;
+
+          glm::ivec3 last(x + 1, y + 1, z + 1);
+          while (last.x < numBricks.x && isSet(last.x, y, z))
+            ++last.x;
+
+          for (bool grow = true; grow && last.y < numBricks.y;) {
+            for (int i = x; i < last.x && grow; ++i)
+              grow = isSet(i, last.y, z);
+            if (grow)
+              ++last.y;
+          }
+
+          for (bool grow = true; grow && last.z < numBricks.z;) {
+            for (int j = y; j < last.y && grow; ++j) {
+              for (int i = x; i < last.x && grow; ++i)
+                grow = isSet(i, j, last.z);
+            }
+            if (grow)
+              ++last.z;
+          }
+
+          for (int k = z; k < last.z; ++k) {
+            for (int j = y; j < last.y; ++j) {
+              size_t row = (static_cast<size_t>(k) * numBricks.y + j) * numBricks.x;
+              std::fill(bricks.begin() + row + x, bricks.begin() + row + last.x, 0);
+            }
+          }
+
+          VolumeRepresentation::Region region;
+          region.llf_ = glm::ivec3(x, y, z);
+          region.urb_ = last;
+          regions.push_back(region);
+        }
+      }
+    }
+
+    return regions;
+  }
+
 } // end namespace tgt
\ No newline at end of file
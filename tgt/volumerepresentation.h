@@ -3,6 +3,8 @@
 #include "tgt_math.h"
 #include "config.h"
 
+#include <vector>
+
 namespace tgt {
 
   /*
@@ -11,6 +13,12 @@ namespace tgt {
   */
   class VolumeRepresentation {
   public:
+    /// Box of voxels [llf_, urb_).
+    struct Region {
+      glm::ivec3 llf_;
+      glm::ivec3 urb_;
+    };
+
     TGT_API VolumeRepresentation(const glm::ivec3& dimensions);
     TGT_API virtual ~VolumeRepresentation() {}
 
@@ -26,8 +34,22 @@ namespace tgt {
     // protected default constructor
     VolumeRepresentation() {}
 
+    /**
+    * Merges the set flags of a grid of bricks of \p brickSize^3 voxels (x-fastest) into boxes of
+    * voxels and clears the flags. Used to upload only the modified parts of a representation.
+    */
+    std::vector<Region> takeBrickRegions(std::vector<unsigned char>& bricks, int brickSize) const;
+
     glm::ivec3  dimensions_;
     size_t      numVoxels_;
   };
 
+  /**
+  * Greedily merges the set flags of a grid of \p numBricks (x-fastest) into boxes of bricks and
+  * clears the flags. Every box is grown along x first, then by whole rows along y and whole slices
+  * along z. The regions are given in bricks.
+  */
+  TGT_API std::vector<VolumeRepresentation::Region> mergeBricks(std::vector<unsigned char>& bricks,
+    const glm::ivec3& numBricks);
+
 } // end namespace tgt
\ No newline at end of file
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "volumekernels.h"
+#include "tgt_math.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <stdint.h>
+
+namespace tgt {
+
+  /**
+  * Parallel min/max and histogram sweeps over the typed voxel buffer of a VolumeAtomic.
+  *
+  * The buffer is split into one contiguous chunk per hardware thread. Each thread reduces its
+  * chunk with VolumeKernels::minMax() and fills a private histogram, the partial results are merged
+  * afterwards. 8 and 16 bit integer volumes are counted per value, so min, max and histogram
+  * come out of a single pass over the data.
+  */
+  namespace VolumeStatistics {
+
+    /// Volumes below this number of voxels are processed by the calling thread only.
+    const size_t PARALLEL_THRESHOLD = 1 << 20;
+
+    inline size_t getNumThreads(size_t numVoxels) {
+      if (numVoxels < PARALLEL_THRESHOLD)
+        return 1;
+      return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+    * Runs kernel(begin, end, chunk) for numChunks contiguous chunks of [0, n),
+    * chunk 0 on the calling thread and the others on worker threads.
+    */
+    template<class F>
+    void forEachChunk(size_t n, size_t numChunks, const F& kernel) {
+      size_t chunkSize = (n + numChunks - 1) / numChunks;
+      std::vector<std::thread> workers;
+      for (size_t chunk = 1; chunk < numChunks; ++chunk) {
+        size_t begin = std::min(n, chunk * chunkSize);
+        size_t end = std::min(n, begin + chunkSize);
+        workers.push_back(std::thread([&kernel, begin, end, chunk]() { kernel(begin, end, chunk); }));
+      }
+      kernel(0, std::min(n, chunkSize), 0);
+      for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    }
+
+    /**
+    * Maps a value to one of bucketCount buckets spanning [min, max].
+    * Values outside the range (and NaN) are clamped to the first/last bucket.
+    */
+    inline size_t getBucket(float value, float min, float max, size_t bucketCount) {
+      if (!(value > min))
+        return 0;
+      if (value >= max)
+        return bucketCount - 1;
+      size_t bucket = static_cast<size_t>(bucketCount * ((value - min) / (max - min)));
+      return std::min(bucket, bucketCount - 1);
+    }
+
+    template<class T>
+    void minMax(const T* data, size_t n, T& min, T& max) {
+      if (n == 0) {
+        min = max = T(0);
+        return;
+      }
+
+      size_t numThreads = getNumThreads(n);
+      std::vector<T> mins(numThreads, data[0]);
+      std::vector<T> maxs(numThreads, data[0]);
+      forEachChunk(n, numThreads, [&](size_t begin, size_t end, size_t chunk) {
+        if (begin < end)
+          VolumeKernels::minMax(data + begin, end - begin, mins[chunk], maxs[chunk]);
+      });
+      min = *std::min_element(mins.begin(), mins.end());
+      max = *std::max_element(maxs.begin(), maxs.end());
+    }
+
+    /// Number of occurrences of every value of an 8 or 16 bit integer type, indexed by value - numeric_limits<T>::min()
+    template<class T>
+    void countValues(const T* data, size_t n, std::vector<uint64_t>& counts) {
+      const size_t numValues = size_t(1) << (8 * sizeof(T));
+      size_t numThreads = getNumThreads(n);
+      std::vector<std::vector<uint64_t> > partial(numThreads);
+      forEachChunk(n, numThreads, [&](size_t begin, size_t end, size_t chunk) {
+        std::vector<uint64_t>& local = partial[chunk];
+        local.assign(numValues, 0);
+        for (size_t i = begin; i < end; ++i)
+          ++local[static_cast<size_t>(static_cast<int>(data[i]) - std::numeric_limits<T>::min())];
+      });
+
+      counts.swap(partial[0]);
+      for (size_t t = 1; t < numThreads; ++t)
+        for (size_t v = 0; v < numValues; ++v)
+          counts[v] += partial[t][v];
+    }
+
+    /// Distributes the per-value counts into the buckets.
+    template<class T>
+    void bucketValues(const std::vector<uint64_t>& counts, float min, float max, std::vector<uint64_t>& buckets) {
+      for (size_t v = 0; v < counts.size(); ++v) {
+        if (counts[v] == 0)
+          continue;
+        float value = static_cast<float>(static_cast<int>(v) + std::numeric_limits<T>::min());
+        buckets[getBucket(value, min, max, buckets.size())] += counts[v];
+      }
+    }
+
+    template<class T>
+    void bucketVoxels(const T* data, size_t n, float min, float max, std::vector<uint64_t>& buckets) {
+      const size_t bucketCount = buckets.size();
+      size_t numThreads = getNumThreads(n);
+      std::vector<std::vector<uint64_t> > partial(numThreads);
+      forEachChunk(n, numThreads, [&](size_t begin, size_t end, size_t chunk) {
+        std::vector<uint64_t>& local = partial[chunk];
+        local.assign(bucketCount, 0);
+        for (size_t i = begin; i < end; ++i)
+          ++local[getBucket(static_cast<float>(data[i]), min, max, bucketCount)];
+      });
+
+      for (size_t t = 0; t < numThreads; ++t)
+        for (size_t b = 0; b < bucketCount; ++b)
+          buckets[b] += partial[t][b];
+    }
+
+    template<class T>
+    struct CountsValues {
+      enum { value = std::numeric_limits<T>::is_integer && (sizeof(T) <= 2) };
+    };
+
+    // 8 and 16 bit integers: a single counting pass
+    template<class T>
+    void histogram(const T* data, size_t n, float min, float max, std::vector<uint64_t>& buckets, std::true_type) {
+      std::vector<uint64_t> counts;
+      countValues(data, n, counts);
+      bucketValues<T>(counts, min, max, buckets);
+    }
+
+    template<class T>
+    void histogram(const T* data, size_t n, float min, float max, std::vector<uint64_t>& buckets, std::false_type) {
+      bucketVoxels(data, n, min, max, buckets);
+    }
+
+    /**
+    * Fills buckets (whose size is the bucket count) with the histogram of the n values over [min, max].
+    */
+    template<class T>
+    void histogram(const T* data, size_t n, float min, float max, std::vector<uint64_t>& buckets) {
+      std::fill(buckets.begin(), buckets.end(), 0);
+      if (n == 0 || buckets.empty())
+        return;
+      histogram(data, n, min, max, buckets, std::integral_constant<bool, CountsValues<T>::value>());
+    }
+
+    /// Smallest and largest value with a non-zero count, the counts must not be all zero.
+    template<class T>
+    void minMaxOfCounts(const std::vector<uint64_t>& counts, T& min, T& max) {
+      size_t first = 0;
+      while (counts[first] == 0)
+        ++first;
+      size_t last = counts.size() - 1;
+      while (counts[last] == 0)
+        --last;
+      min = static_cast<T>(static_cast<int>(first) + std::numeric_limits<T>::min());
+      max = static_cast<T>(static_cast<int>(last) + std::numeric_limits<T>::min());
+    }
+
+    template<class T>
+    void minMaxHistogram(const T* data, size_t n, T& min, T& max, std::vector<uint64_t>& buckets, std::true_type) {
+      std::vector<uint64_t> counts;
+      countValues(data, n, counts);
+      minMaxOfCounts(counts, min, max);
+      bucketValues<T>(counts, static_cast<float>(min), static_cast<float>(max), buckets);
+    }
+
+    template<class T>
+    void minMaxHistogram(const T* data, size_t n, T& min, T& max, std::vector<uint64_t>& buckets, std::false_type) {
+      minMax(data, n, min, max);
+      bucketVoxels(data, n, static_cast<float>(min), static_cast<float>(max), buckets);
+    }
+
+    /**
+    * Determines min and max of the n values and fills buckets with their histogram over [min, max].
+    */
+    template<class T>
+    void minMaxHistogram(const T* data, size_t n, T& min, T& max, std::vector<uint64_t>& buckets) {
+      std::fill(buckets.begin(), buckets.end(), 0);
+      if (n == 0 || buckets.empty()) {
+        minMax(data, n, min, max);
+        return;
+      }
+      minMaxHistogram(data, n, min, max, buckets, std::integral_constant<bool, CountsValues<T>::value>());
+    }
+
+    /**
+    * Number of bricks of brickSize^3 voxels along each axis. Neighbouring bricks share a layer of
+    * voxels, so brick i covers the voxels [i * brickSize, (i + 1) * brickSize] of each axis.
+    */
+    inline glm::ivec3 getBrickDimensions(const glm::ivec3& dimensions, int brickSize) {
+      return glm::max((dimensions - 1 + brickSize - 1) / brickSize, glm::ivec3(1));
+    }
+
+    /**
+    * Determines min and max of every brick of a volume, see getBrickDimensions(). The bricks
+    * are stored x-fastest in \p minValues and \p maxValues. Rows of bricks are distributed over the threads.
+    */
+    template<class T>
+    void brickMinMax(const T* data, const glm::ivec3& dimensions, int brickSize,
+      std::vector<float>& minValues, std::vector<float>& maxValues)
+    {
+      const glm::ivec3 bricks = getBrickDimensions(dimensions, brickSize);
+      const size_t numRows = static_cast<size_t>(bricks.y) * bricks.z;
+      minValues.resize(numRows * bricks.x);
+      maxValues.resize(numRows * bricks.x);
+
+      size_t numVoxels = static_cast<size_t>(dimensions.x) * dimensions.y * dimensions.z;
+      size_t numThreads = std::min(getNumThreads(numVoxels), numRows);
+      forEachChunk(numRows, numThreads, [&](size_t begin, size_t end, size_t) {
+        std::vector<T> rowMin(bricks.x);
+        std::vector<T> rowMax(bricks.x);
+        for (size_t row = begin; row < end; ++row) {
+          int y0 = static_cast<int>(row % bricks.y) * brickSize;
+          int z0 = static_cast<int>(row / bricks.y) * brickSize;
+          int y1 = std::min(y0 + brickSize, dimensions.y - 1);
+          int z1 = std::min(z0 + brickSize, dimensions.z - 1);
+
+          for (int z = z0; z <= z1; ++z) {
+            for (int y = y0; y <= y1; ++y) {
+              const T* line = data + (static_cast<size_t>(z) * dimensions.y + y) * dimensions.x;
+              for (int bx = 0; bx < bricks.x; ++bx) {
+                int x0 = bx * brickSize;
+                int x1 = std::min(x0 + brickSize, dimensions.x - 1);
+                T min = line[x0];
+                T max = line[x0];
+                for (int x = x0 + 1; x <= x1; ++x) {
+                  min = std::min(min, line[x]);
+                  max = std::max(max, line[x]);
+                }
+                if (z == z0 && y == y0) {
+                  rowMin[bx] = min;
+                  rowMax[bx] = max;
+                }
+                else {
+                  rowMin[bx] = std::min(rowMin[bx], min);
+                  rowMax[bx] = std::max(rowMax[bx], max);
+                }
+              }
+            }
+          }
+
+          for (int bx = 0; bx < bricks.x; ++bx) {
+            minValues[row * bricks.x + bx] = static_cast<float>(rowMin[bx]);
+            maxValues[row * bricks.x + bx] = static_cast<float>(rowMax[bx]);
+          }
+        }
+      });
+    }
+
+  } // end namespace VolumeStatistics
+
+} // end namespace tgt